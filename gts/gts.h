@@ -46,6 +46,16 @@ extern "C" {
 #  define GTS_C_VAR extern
 #endif /* not NATIVE_WIN32 */
 
+/* The gts_allow_floating_* switches are per thread where the compiler
+ * allows it, so that separate surfaces may be built by separate threads.
+ */
+#if defined (__GNUC__) && !defined (NATIVE_WIN32)
+#  define GTS_THREAD_LOCAL __thread
+#  define GTS_HAVE_THREAD_LOCAL 1
+#else
+#  define GTS_THREAD_LOCAL
+#endif
+
 GTS_C_VAR const guint gts_major_version;
 GTS_C_VAR const guint gts_minor_version;
 GTS_C_VAR const guint gts_micro_version;
@@ -316,6 +326,9 @@ void             gts_object_init                (GtsObject * object,
 						 GtsObjectClass * klass);
 void             gts_object_reset_reserved      (GtsObject * object);
 void             gts_object_destroy             (GtsObject * object);
+void             gts_object_memory_stats        (gsize * live,
+						 gsize * peak);
+void             gts_object_memory_reset_peak   (void);
 void             gts_finalize                   (void);
 
 /* Ranges: surface.c */
@@ -450,7 +463,7 @@ struct _GtsVertexClass {
 					   GtsObject *);
 };
 
-GTS_C_VAR 
+GTS_C_VAR GTS_THREAD_LOCAL
 gboolean      gts_allow_floating_vertices;
 
 GtsVertexClass * gts_vertex_class          (void);
@@ -589,7 +602,7 @@ struct _GtsEdgeClass {
   GtsSegmentClass parent_class;
 };
 
-GTS_C_VAR 
+GTS_C_VAR GTS_THREAD_LOCAL
 gboolean      gts_allow_floating_edges;
 
 GtsEdgeClass * gts_edge_class                     (void);
@@ -742,7 +755,7 @@ struct _GtsFaceClass {
   GtsTriangleClass parent_class;
 };
 
-GTS_C_VAR 
+GTS_C_VAR GTS_THREAD_LOCAL
 gboolean      gts_allow_floating_faces;
 
 GtsFaceClass * gts_face_class                       (void);
@@ -2121,7 +2134,7 @@ gfloat          gts_gnode_move_cost            (GtsGNode * n,
 						GtsGraph * dst);
 gfloat          gts_gnode_weight               (GtsGNode * n);
 
-GTS_C_VAR
+GTS_C_VAR GTS_THREAD_LOCAL
 gboolean        gts_allow_floating_gnodes;
 
 /* GtsNGNode: graph.c */
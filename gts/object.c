@@ -23,6 +23,42 @@
 
 static GHashTable * class_table = NULL;
 
+/* Objects are carved from g_slice, which keeps free blocks per thread
+ * and size instead of going to malloc () for every vertex, edge and
+ * face.  The block size is kept in front of each object because some
+ * objects change class, and so apparent size, during their life (see
+ * split.c and refine.c).
+ */
+typedef union {
+  gsize size;
+  gdouble align;
+} ObjectHeader;
+
+static volatile gsize memory_live = 0, memory_peak = 0;
+
+static gpointer object_alloc (gsize size)
+{
+  ObjectHeader * h = g_slice_alloc0 (sizeof (ObjectHeader) + size);
+  gsize live, peak;
+
+  h->size = size;
+  live = (gsize) g_atomic_pointer_add (&memory_live, size) + size;
+  while ((peak = (gsize) g_atomic_pointer_get (&memory_peak)) < live &&
+	 !g_atomic_pointer_compare_and_exchange (&memory_peak,
+						 (gpointer) peak,
+						 (gpointer) live))
+    ;
+  return h + 1;
+}
+
+static void object_free (gpointer object)
+{
+  ObjectHeader * h = (ObjectHeader *) object - 1;
+
+  g_atomic_pointer_add (&memory_live, - (gssize) h->size);
+  g_slice_free1 (sizeof (ObjectHeader) + h->size, h);
+}
+
 static void gts_object_class_init (GtsObjectClass * klass,
 				   GtsObjectClass * parent_class)
 {
@@ -94,7 +130,7 @@ static void object_destroy (GtsObject * object)
   id_remove (object);
 #endif
   object->klass = NULL;
-  g_free (object);
+  object_free (object);
 }
 
 static void object_clone (GtsObject * clone, GtsObject * object)
@@ -234,7 +270,7 @@ GtsObject * gts_object_new (GtsObjectClass * klass)
 
   g_return_val_if_fail (klass != NULL, NULL);
 
-  object = g_malloc0 (klass->info.object_size);
+  object = object_alloc (klass->info.object_size);
   object->klass = klass;
   gts_object_init (object, klass);
 
@@ -266,7 +302,7 @@ GtsObject * gts_object_clone (GtsObject * object)
   g_return_val_if_fail (object != NULL, NULL);
   g_return_val_if_fail (object->klass->clone, NULL);
 
-  clone = g_malloc0 (object->klass->info.object_size);
+  clone = object_alloc (object->klass->info.object_size);
   clone->klass = object->klass;
   object_init (clone);
   (* object->klass->clone) (clone, object);
@@ -296,6 +332,32 @@ void gts_object_destroy (GtsObject * object)
   (* object->klass->destroy) (object);
 }
 
+/**
+ * gts_object_memory_stats:
+ * @live: where to store the number of bytes used by objects now, or %NULL.
+ * @peak: where to store the largest number of bytes used by objects since
+ * gts_object_memory_reset_peak() or the start of the program, or %NULL.
+ */
+void gts_object_memory_stats (gsize * live, gsize * peak)
+{
+  if (live)
+    *live = (gsize) g_atomic_pointer_get (&memory_live);
+  if (peak)
+    *peak = (gsize) g_atomic_pointer_get (&memory_peak);
+}
+
+/**
+ * gts_object_memory_reset_peak:
+ *
+ * Starts the peak reported by gts_object_memory_stats() over from the
+ * number of bytes used by objects now.
+ */
+void gts_object_memory_reset_peak (void)
+{
+  g_atomic_pointer_set (&memory_peak,
+			g_atomic_pointer_get (&memory_live));
+}
+
 /**
  * gts_object_reset_reserved:
  * @object: a #GtsObject.
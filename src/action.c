@@ -161,6 +161,7 @@ typedef enum
   F_Revert,
   F_Remove,
   F_RemoveSelected,
+  F_Replay,
   F_Report,
   F_Reset,
   F_ResetLinesAndPolygons,
@@ -398,6 +399,7 @@ static FunctionType Functions[] = {
   {"Release", F_Release},
   {"Remove", F_Remove},
   {"RemoveSelected", F_RemoveSelected},
+  {"Replay", F_Replay},
   {"Report", F_Report},
   {"Reset", F_Reset},
   {"ResetLinesAndPolygons", F_ResetLinesAndPolygons},
@@ -3924,6 +3926,9 @@ static const char autoplace_help[] = N_("Auto-place selected components.");
 Attempts to re-arrange the selected components such that the nets
 connecting them are minimized.  Note that you cannot undo this.
 
+With @code{--autoplace-chains} greater than one, several chains search
+at once by parallel tempering instead of a single annealing run.
+
 %end-doc */
 
 static int
@@ -3941,7 +3946,9 @@ ActionAutoPlaceSelected (int argc, char **argv, Coord x, Coord y)
 
 /* --------------------------------------------------------------------------- */
 
-static const char autoroute_syntax[] = N_("AutoRoute(AllRats|SelectedRats)");
+static const char autoroute_syntax[] =
+  N_("AutoRoute(AllRats|SelectedRats)\n"
+  "AutoRoute(Replay, pin, [runs])");
 
 static const char autoroute_help[] = N_("Auto-route some or all rat lines.");
 
@@ -3955,6 +3962,11 @@ Attempt to autoroute all rats.
 @item SelectedRats
 Attempt to autoroute the selected rats.
 
+@item Replay
+Route the net with the given pin (like @code{U1-3}) on its own,
+@code{runs} times, and report how long it took.  The board is not
+changed; save it at the state you want to replay from.
+
 @end table
 
 Before autorouting, it's important to set up a few things.  First,
@@ -3964,7 +3976,11 @@ styles are set accordingly.  Last, make sure "new lines clear
 polygons" is set, in case you eventually want to add a copper pour.
 
 Autorouting takes a while.  During this time, the program may not be
-responsive.
+responsive.  The @code{--autoroute-jobs} option lets the autorouter
+route nets which do not overlap in parallel, and
+@code{--autoroute-profile} writes where the time went to a file.
+@code{--autoroute-attempts} makes several differently weighted attempts
+at once and keeps the best, within @code{--autoroute-time-limit}.
 
 %end-doc */
 
@@ -3986,6 +4002,9 @@ ActionAutoRoute (int argc, char **argv, Coord x, Coord y)
 	  if (AutoRoute (true))
 	    SetChangedFlag (true);
 	  break;
+	case F_Replay:
+	  AutoRouteReplay (ARG (1), ARG (2) ? atoi (ARG (2)) : 1);
+	  break;
 	}
     }
   return 0;
@@ -6436,7 +6455,7 @@ ActionRedo (int argc, char **argv, Coord x, Coord y)
       if (Settings.Mode == LINE_MODE &&
 	  Crosshair.AttachedLine.State != STATE_FIRST)
 	{
-	  LineType *line = g_list_last (CURRENT->Line)->data;
+	  LineType *line = (LineType *) LastObjectInList (&CURRENT->Line);
 	  Crosshair.AttachedLine.Point1.X =
 	    Crosshair.AttachedLine.Point2.X = line->Point2.X;
 	  Crosshair.AttachedLine.Point1.Y =
@@ -7196,7 +7215,7 @@ ActionElementList (int argc, char **argv, Coord x, Coord y)
 	}
 
       er = ElementOrientation (e);
-      pe = PASTEBUFFER->Data->Element->data;
+      pe = (ElementType *) FirstObjectInList (&PASTEBUFFER->Data->Element);
       if (!FRONT (e))
 	MirrorElementCoordinates (PASTEBUFFER->Data, pe, pe->MarkY*2 - PCB->MaxHeight);
       pr = ElementOrientation (pe);
@@ -41,10 +41,21 @@
 #endif
 
 #include <assert.h>
+#include <errno.h>
 #include <math.h>
 #include <memory.h>
+#include <signal.h>
 #include <stdlib.h>
 
+/* for fork() and friends */
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/wait.h>
+#endif
+
 #include "global.h"
 
 #include "autoplace.h"
@@ -103,6 +114,9 @@ const struct
   bool fast;			/* ignore SMD/pin conflicts */
   Coord large_grid_size;	/* snap perturbations to this grid when T is high */
   Coord small_grid_size;	/* snap to this grid when T is small. */
+  double chain_T_min;		/* coldest tempering chain */
+  int chain_stall;		/* tempering rounds without a better cost */
+  int chain_rounds;		/* most tempering rounds */
 }
 /*!
  * \brief Wire cost is manhattan distance (in mils), thus 1 inch = 1000.
@@ -124,6 +138,9 @@ CostParameter =
     false,			/* don't ignore SMD/pin conflicts */
     MIL_TO_COORD (100),		/* coarse grid is 100 mils */
     MIL_TO_COORD (10),		/* fine grid is 10 mils */
+    5,				/* coldest chain runs where annealing halts */
+    10,				/* halt after 10 rounds without a better cost */
+    200,			/* and after 200 rounds anyhow */
 };
 
 typedef struct
@@ -150,6 +167,38 @@ PerturbationType;
  * some local identifiers
  */
 
+/*!
+ * \brief Update the X, Y and group position information stored in one
+ * net after its elements have possibly been moved, rotated, flipped,
+ * etc.
+ */
+static void
+UpdateNetXY (NetType *Net, Cardinal top_group, Cardinal bottom_group)
+{
+  Cardinal j;
+  for (j = 0; j < Net->ConnectionN; j++)
+    {
+      ConnectionType *c = &(Net->Connection[j]);
+      switch (c->type)
+	{
+	case PAD_TYPE:
+	  c->group = TEST_FLAG (ONSOLDERFLAG, (ElementType *) c->ptr1)
+	              ? bottom_group : top_group;
+	  c->X = ((PadType *) c->ptr2)->Point1.X;
+	  c->Y = ((PadType *) c->ptr2)->Point1.Y;
+	  break;
+	case PIN_TYPE:
+	  c->group = bottom_group;  /* any layer will do */
+	  c->X = ((PinType *) c->ptr2)->X;
+	  c->Y = ((PinType *) c->ptr2)->Y;
+	  break;
+	default:
+	  Message ("Odd connection type encountered in " "UpdateXY");
+	  break;
+	}
+    }
+}
+
 /*!
  * \brief Update the X, Y and group position information stored in the
  * NetList after elements have possibly been moved, rotated, flipped,
@@ -159,35 +208,13 @@ static void
 UpdateXY (NetListType *Nets)
 {
   Cardinal top_group, bottom_group;
-  Cardinal i, j;
+  Cardinal i;
   /* find layer groups of the top and bottom sides */
   top_group = GetLayerGroupNumberBySide (TOP_SIDE);
   bottom_group = GetLayerGroupNumberBySide (BOTTOM_SIDE);
   /* update all nets */
   for (i = 0; i < Nets->NetN; i++)
-    {
-      for (j = 0; j < Nets->Net[i].ConnectionN; j++)
-	{
-	  ConnectionType *c = &(Nets->Net[i].Connection[j]);
-	  switch (c->type)
-	    {
-	    case PAD_TYPE:
-	      c->group = TEST_FLAG (ONSOLDERFLAG, (ElementType *) c->ptr1)
-	                  ? bottom_group : top_group;
-	      c->X = ((PadType *) c->ptr2)->Point1.X;
-	      c->Y = ((PadType *) c->ptr2)->Point1.Y;
-	      break;
-	    case PIN_TYPE:
-	      c->group = bottom_group;  /* any layer will do */
-	      c->X = ((PinType *) c->ptr2)->X;
-	      c->Y = ((PinType *) c->ptr2)->Y;
-	      break;
-	    default:
-	      Message ("Odd connection type encountered in " "UpdateXY");
-	      break;
-	    }
-	}
-    }
+    UpdateNetXY (&Nets->Net[i], top_group, bottom_group);
 }
 
 /*!
@@ -310,36 +337,273 @@ __r_find_neighbor_rect_in_reg (const BoxType * box, void *cl)
 }
 
 /*!
- * \brief main r_find_neighbor routine.
- *
- * Returns NULL if no neighbor in the requested direction.
+ * \brief Set up the trapezoid searched for the neighbor of \p box in
+ * \p search_direction.
  */
-static const BoxType *
-r_find_neighbor (rtree_t * rtree, const BoxType * box,
-		 direction_t search_direction)
+static void
+init_neighbor_trap (struct r_neighbor_info *ni, const BoxType * box,
+		    direction_t search_direction)
 {
-  struct r_neighbor_info ni;
   BoxType bbox;
 
-  ni.neighbor = NULL;
-  ni.trap = *box;
-  ni.search_dir = search_direction;
+  ni->neighbor = NULL;
+  ni->trap = *box;
+  ni->search_dir = search_direction;
 
   bbox.X1 = bbox.Y1 = 0;
   bbox.X2 = PCB->MaxWidth;
   bbox.Y2 = PCB->MaxHeight;
   /* rotate so that we can use the 'north' case for everything */
   ROTATEBOX_TO_NORTH (bbox, search_direction);
-  ROTATEBOX_TO_NORTH (ni.trap, search_direction);
+  ROTATEBOX_TO_NORTH (ni->trap, search_direction);
   /* shift Y's such that trap contains full bounds of trapezoid */
-  ni.trap.Y2 = ni.trap.Y1;
-  ni.trap.Y1 = bbox.Y1;
+  ni->trap.Y2 = ni->trap.Y1;
+  ni->trap.Y1 = bbox.Y1;
+}
+
+/*!
+ * \brief main r_find_neighbor routine.
+ *
+ * Returns NULL if no neighbor in the requested direction.
+ */
+static const BoxType *
+r_find_neighbor (rtree_t * rtree, const BoxType * box,
+		 direction_t search_direction)
+{
+  struct r_neighbor_info ni;
+
+  init_neighbor_trap (&ni, box, search_direction);
   /* do the search! */
   r_search (rtree, NULL,
 	    __r_find_neighbor_reg_in_sea, __r_find_neighbor_rect_in_reg, &ni);
   return ni.neighbor;
 }
 
+/*!
+ * \brief Could \p other be the neighbor of \p box in
+ * \p search_direction?
+ *
+ * Boxes outside the trapezoid never are, whatever else is around.
+ */
+static bool
+in_neighbor_trap (const BoxType * box, const BoxType * other,
+		  direction_t search_direction)
+{
+  struct r_neighbor_info ni;
+
+  init_neighbor_trap (&ni, box, search_direction);
+  return __r_find_neighbor_reg_in_sea (other, &ni);
+}
+
+/*!
+ * \brief Collect the module areas of an element: the bounding rect of
+ * its pins and pads goes to \p thisside, a box for each pin to
+ * \p otherside.
+ *
+ * Surface mount components can't sit on top of pins.
+ */
+static void
+ModuleBoxes (ElementType *element, BoxListType *thisside,
+	     BoxListType *otherside)
+{
+  BoxType *box;
+  Cardinal lastbox = 0;
+  bool have_last = false;
+  Coord thickness;
+  Coord clearance;
+  /* protect against elements with no pins/pads */
+  if (element->PinN == 0 && element->PadN == 0)
+    return;
+  box = GetBoxMemory (thisside);
+  /* initialize box so that it will take the dimensions of
+   * the first pin/pad */
+  box->X1 = MAX_COORD;
+  box->Y1 = MAX_COORD;
+  box->X2 = -MAX_COORD;
+  box->Y2 = -MAX_COORD;
+  PIN_LOOP (element);
+  {
+    thickness = pin->Thickness / 2;
+    clearance = pin->Clearance * 2;
+  EXPANDRECTXY (box,
+		  pin->X - (thickness + clearance),
+		  pin->Y - (thickness + clearance),
+		  pin->X + (thickness + clearance),
+		  pin->Y + (thickness + clearance))}
+  END_LOOP;
+  PAD_LOOP (element);
+  {
+    thickness = pad->Thickness / 2;
+    clearance = pad->Clearance * 2;
+  EXPANDRECTXY (box,
+		  MIN (pad->Point1.X,
+			 pad->Point2.X) - (thickness +
+					     clearance),
+		  MIN (pad->Point1.Y,
+			 pad->Point2.Y) - (thickness +
+					     clearance),
+		  MAX (pad->Point1.X,
+			 pad->Point2.X) + (thickness +
+					     clearance),
+		  MAX (pad->Point1.Y,
+			 pad->Point2.Y) + (thickness + clearance))}
+  END_LOOP;
+  /* add a box for each pin to the "opposite side" */
+  if (!CostParameter.fast)
+    PIN_LOOP (element);
+  {
+    BoxType *last;
+    box = GetBoxMemory (otherside);
+    thickness = pin->Thickness / 2;
+    clearance = pin->Clearance * 2;
+    /* we ignore clearance here */
+    /* (otherwise pins don't fit next to each other) */
+    box->X1 = pin->X - thickness;
+    box->Y1 = pin->Y - thickness;
+    box->X2 = pin->X + thickness;
+    box->Y2 = pin->Y + thickness;
+    /* speed hack! coalesce with last box if we can.  (the last box is
+     * kept by index: GetBoxMemory may have moved the list) */
+    last = have_last ? &otherside->Box[lastbox] : NULL;
+    if (last != NULL &&
+	((last->X1 == box->X1 &&
+	  last->X2 == box->X2 &&
+	  MIN (abs (last->Y1 - box->Y2),
+	       abs (box->Y1 - last->Y2)) <
+	  clearance) || (last->Y1 == box->Y1
+			 && last->Y2 == box->Y2
+			 &&
+			 MIN (abs
+			      (last->X1 -
+			       box->X2),
+			      abs (box->X1 - last->X2)) < clearance)))
+      {
+	EXPANDRECT (last, box);
+	otherside->BoxN--;
+      }
+    else
+      {
+	lastbox = box - otherside->Box;
+	have_last = true;
+      }
+  }
+  END_LOOP;
+}
+
+/*!
+ * \brief Out of bounds penalty of an element.
+ */
+static double
+OutOfBounds (ElementType *element)
+{
+  if (element->VBox.X1 < 0 ||
+      element->VBox.Y1 < 0 ||
+      element->VBox.X2 > PCB->MaxWidth || element->VBox.Y2 > PCB->MaxHeight)
+    return CostParameter.out_of_bounds_penalty;
+  return 0;
+}
+
+/*!
+ * \brief Alignment bonus of \p element for having \p other as a
+ * neighbor.
+ *
+ * Score higher if pins/pads belong to same *type* of component.
+ */
+static double
+NeighborBonus (ElementType *element, ElementType *other)
+{
+  double bonus = 0;
+  int factor = 1;
+  if (element->Name[0].TextString &&
+      other->Name[0].TextString &&
+      0 == NSTRCMP (element->Name[0].TextString,
+		    other->Name[0].TextString))
+    {
+      bonus += CostParameter.matching_neighbor_bonus;
+      factor++;
+    }
+  if (element->Name[0].Direction == other->Name[0].Direction)
+    bonus += factor * CostParameter.oriented_neighbor_bonus;
+  if (element->VBox.X1 == other->VBox.X1 ||
+      element->VBox.X1 == other->VBox.X2 ||
+      element->VBox.X2 == other->VBox.X1 ||
+      element->VBox.X2 == other->VBox.X2 ||
+      element->VBox.Y1 == other->VBox.Y1 ||
+      element->VBox.Y1 == other->VBox.Y2 ||
+      element->VBox.Y2 == other->VBox.Y1 ||
+      element->VBox.Y2 == other->VBox.Y2)
+    bonus += factor * CostParameter.aligned_neighbor_bonus;
+  return bonus;
+}
+
+/*!
+ * \brief Weight of the module overlap penalty, which grows as the
+ * annealing cools.
+ */
+static double
+OverlapWeight (double T0, double T)
+{
+  return CostParameter.overlap_penalty_min +
+    (1 - (T / T0)) * CostParameter.overlap_penalty_max;
+}
+
+/*!
+ * \brief Wire length term of one net.
+ *
+ * Approximated by half-perimeter of minimum rectangle enclosing the
+ * net, which is saved in \p bounds.  Note that we penalize vias in
+ * all-SMD nets by making the rectangle a cube and weighting the "layer
+ * height" of the net.  Returns false for nets with no cost.
+ */
+static bool
+NetWireCost (NetType *n, BoxType *bounds, double *cost)
+{
+  Coord minx, maxx, miny, maxy;
+  bool allpads, allsameside;
+  Cardinal thegroup;
+  Cardinal j;
+  if (n->ConnectionN < 2)
+    return false;		/* no cost to go nowhere */
+  minx = maxx = n->Connection[0].X;
+  miny = maxy = n->Connection[0].Y;
+  thegroup = n->Connection[0].group;
+  allpads = (n->Connection[0].type == PAD_TYPE);
+  allsameside = true;
+  for (j = 1; j < n->ConnectionN; j++)
+    {
+      ConnectionType *c = &(n->Connection[j]);
+      MAKEMIN (minx, c->X);
+      MAKEMAX (maxx, c->X);
+      MAKEMIN (miny, c->Y);
+      MAKEMAX (maxy, c->Y);
+      if (c->type != PAD_TYPE)
+	allpads = false;
+      if (c->group != thegroup)
+	allsameside = false;
+    }
+  /* save bounding rectangle */
+  bounds->X1 = minx;
+  bounds->Y1 = miny;
+  bounds->X2 = maxx;
+  bounds->Y2 = maxy;
+  /* okay, half-perimeter is the cost! */
+  *cost = COORD_TO_MIL(maxx - minx) + COORD_TO_MIL(maxy - miny) +
+    ((allpads && !allsameside) ? CostParameter.via_cost : 0);
+  return true;
+}
+
+/*!
+ * \brief Penalty for the total area used by the layout.
+ */
+static double
+AreaPenalty (Coord minX, Coord minY, Coord maxX, Coord maxY)
+{
+  if (minX < maxX && minY < maxY)
+    return CostParameter.overall_area_penalty *
+      sqrt (COORD_TO_MIL (maxX - minX) * COORD_TO_MIL (maxY - minY));
+  return 0;
+}
+
 /*!
  * \brief Compute cost function.
  *
@@ -349,6 +613,9 @@ r_find_neighbor (rtree_t * rtree, const BoxType * box,
  * Algorithms follow those described in sections 4.1 of
  * "Placement and Routing of Electronic Modules" edited by Michael Pecht
  * Marcel Dekker, Inc. 1993.  ISBN: 0-8247-8916-4 TK7868.P7.P57 1993
+ *
+ * This computes every term from scratch; see PlaceState for the cost
+ * the annealing loop keeps up to date as elements move.
  */
 static double
 ComputeCost (NetListType *Nets, double T0, double T)
@@ -359,52 +626,21 @@ ComputeCost (NetListType *Nets, double T0, double T)
   double delta3 = 0;		/* out of bounds penalty */
   double delta4 = 0;		/* alignment bonus */
   double delta5 = 0;		/* total area penalty */
-  Cardinal i, j;
-  Coord minx, maxx, miny, maxy;
-  bool allpads, allsameside;
-  Cardinal thegroup;
+  Cardinal i;
   BoxListType bounds = { 0, 0, NULL };	/* save bounding rectangles here */
   BoxListType solderside = { 0, 0, NULL };	/* solder side component bounds */
   BoxListType componentside = { 0, 0, NULL };	/* component side bounds */
   /* make sure the NetList have the proper updated X and Y coords */
   UpdateXY (Nets);
-  /* wire length term.  approximated by half-perimeter of minimum
-   * rectangle enclosing the net.  Note that we penalize vias in
-   * all-SMD nets by making the rectangle a cube and weighting
-   * the "layer height" of the net. */
+  /* wire length term. */
   for (i = 0; i < Nets->NetN; i++)
     {
-      NetType *n = &Nets->Net[i];
-      if (n->ConnectionN < 2)
-	continue;		/* no cost to go nowhere */
-      minx = maxx = n->Connection[0].X;
-      miny = maxy = n->Connection[0].Y;
-      thegroup = n->Connection[0].group;
-      allpads = (n->Connection[0].type == PAD_TYPE);
-      allsameside = true;
-      for (j = 1; j < n->ConnectionN; j++)
-	{
-	  ConnectionType *c = &(n->Connection[j]);
-	  MAKEMIN (minx, c->X);
-	  MAKEMAX (maxx, c->X);
-	  MAKEMIN (miny, c->Y);
-	  MAKEMAX (maxy, c->Y);
-	  if (c->type != PAD_TYPE)
-	    allpads = false;
-	  if (c->group != thegroup)
-	    allsameside = false;
-	}
-      /* save bounding rectangle */
-      {
-	BoxType *box = GetBoxMemory (&bounds);
-	box->X1 = minx;
-	box->Y1 = miny;
-	box->X2 = maxx;
-	box->Y2 = maxy;
-      }
-      /* okay, add half-perimeter to cost! */
-      W += COORD_TO_MIL(maxx - minx) + COORD_TO_MIL(maxy - miny) +
-	((allpads && !allsameside) ? CostParameter.via_cost : 0);
+      BoxType box;
+      double cost;
+      if (!NetWireCost (&Nets->Net[i], &box, &cost))
+	continue;
+      *GetBoxMemory (&bounds) = box;
+      W += cost;
     }
   /* now compute penalty function Wc which is proportional to
    * amount of overlap and congestion. */
@@ -421,106 +657,18 @@ ComputeCost (NetListType *Nets, double T0, double T)
 
   ELEMENT_LOOP (PCB->Data);
   {
-    BoxListType *thisside;
-    BoxListType *otherside;
-    BoxType *box;
-    BoxType *lastbox = NULL;
-    Coord thickness;
-    Coord clearance;
     if (TEST_FLAG (ONSOLDERFLAG, element))
-      {
-	thisside = &solderside;
-	otherside = &componentside;
-      }
+      ModuleBoxes (element, &solderside, &componentside);
     else
-      {
-	thisside = &componentside;
-	otherside = &solderside;
-      }
-    box = GetBoxMemory (thisside);
-    /* protect against elements with no pins/pads */
-    if (element->PinN == 0 && element->PadN == 0)
-      continue;
-    /* initialize box so that it will take the dimensions of
-     * the first pin/pad */
-    box->X1 = MAX_COORD;
-    box->Y1 = MAX_COORD;
-    box->X2 = -MAX_COORD;
-    box->Y2 = -MAX_COORD;
-    PIN_LOOP (element);
-    {
-      thickness = pin->Thickness / 2;
-      clearance = pin->Clearance * 2;
-    EXPANDRECTXY (box,
-		    pin->X - (thickness + clearance),
-		    pin->Y - (thickness + clearance),
-		    pin->X + (thickness + clearance),
-		    pin->Y + (thickness + clearance))}
-    END_LOOP;
-    PAD_LOOP (element);
-    {
-      thickness = pad->Thickness / 2;
-      clearance = pad->Clearance * 2;
-    EXPANDRECTXY (box,
-		    MIN (pad->Point1.X,
-			   pad->Point2.X) - (thickness +
-					       clearance),
-		    MIN (pad->Point1.Y,
-			   pad->Point2.Y) - (thickness +
-					       clearance),
-		    MAX (pad->Point1.X,
-			   pad->Point2.X) + (thickness +
-					       clearance),
-		    MAX (pad->Point1.Y,
-			   pad->Point2.Y) + (thickness + clearance))}
-    END_LOOP;
-    /* add a box for each pin to the "opposite side":
-     * surface mount components can't sit on top of pins */
-    if (!CostParameter.fast)
-      PIN_LOOP (element);
-    {
-      box = GetBoxMemory (otherside);
-      thickness = pin->Thickness / 2;
-      clearance = pin->Clearance * 2;
-      /* we ignore clearance here */
-      /* (otherwise pins don't fit next to each other) */
-      box->X1 = pin->X - thickness;
-      box->Y1 = pin->Y - thickness;
-      box->X2 = pin->X + thickness;
-      box->Y2 = pin->Y + thickness;
-      /* speed hack! coalesce with last box if we can */
-      if (lastbox != NULL &&
-	  ((lastbox->X1 == box->X1 &&
-	    lastbox->X2 == box->X2 &&
-	    MIN (abs (lastbox->Y1 - box->Y2),
-		 abs (box->Y1 - lastbox->Y2)) <
-	    clearance) || (lastbox->Y1 == box->Y1
-			   && lastbox->Y2 == box->Y2
-			   &&
-			   MIN (abs
-				(lastbox->X1 -
-				 box->X2),
-				abs (box->X1 - lastbox->X2)) < clearance)))
-	{
-	  EXPANDRECT (lastbox, box);
-	  otherside->BoxN--;
-	}
-      else
-	lastbox = box;
-    }
-    END_LOOP;
+      ModuleBoxes (element, &componentside, &solderside);
     /* assess out of bounds penalty */
-    if (element->VBox.X1 < 0 ||
-	element->VBox.Y1 < 0 ||
-	element->VBox.X2 > PCB->MaxWidth || element->VBox.Y2 > PCB->MaxHeight)
-      delta3 += CostParameter.out_of_bounds_penalty;
+    delta3 += OutOfBounds (element);
   }
   END_LOOP;
   /* compute intersection area of module areas box list */
   delta2 = sqrt (fabs (ComputeIntersectionArea (&solderside) +
 		       ComputeIntersectionArea (&componentside))) *
-    (CostParameter.overlap_penalty_min +
-     (1 - (T / T0)) * CostParameter.overlap_penalty_max);
+    OverlapWeight (T0, T);
 #if 0
   printf ("Module Overlap Area (solder): %f\n",
 	  ComputeIntersectionArea (&solderside));
@@ -530,7 +678,6 @@ ComputeCost (NetListType *Nets, double T0, double T)
   FreeBoxListMemory (&solderside);
   FreeBoxListMemory (&componentside);
   /* reward pin/pad x/y alignment */
-  /* score higher if pins/pads belong to same *type* of component */
   /* XXX: subkey should be *distance* from thing aligned with, so that
    * aligning to something far away isn't profitable */
   {
@@ -547,7 +694,6 @@ ComputeCost (NetListType *Nets, double T0, double T)
     direction_t dir[4] = { NORTH, EAST, SOUTH, WEST };
     struct ebox **boxpp, *boxp;
     rtree_t *rt_s, *rt_c;
-    int factor;
     ELEMENT_LOOP (PCB->Data);
     {
       boxpp = (struct ebox **)
@@ -577,28 +723,8 @@ ComputeCost (NetListType *Nets, double T0, double T)
 	r_find_neighbor (TEST_FLAG (ONSOLDERFLAG, element) ?
 			 rt_s : rt_c, &element->VBox, dir[i]);
       /* score bounding box alignments */
-      if (!boxp)
-	continue;
-      factor = 1;
-      if (element->Name[0].TextString &&
-	  boxp->element->Name[0].TextString &&
-	  0 == NSTRCMP (element->Name[0].TextString,
-			boxp->element->Name[0].TextString))
-	{
-	  delta4 += CostParameter.matching_neighbor_bonus;
-	  factor++;
-	}
-      if (element->Name[0].Direction == boxp->element->Name[0].Direction)
-	delta4 += factor * CostParameter.oriented_neighbor_bonus;
-      if (element->VBox.X1 == boxp->element->VBox.X1 ||
-	  element->VBox.X1 == boxp->element->VBox.X2 ||
-	  element->VBox.X2 == boxp->element->VBox.X1 ||
-	  element->VBox.X2 == boxp->element->VBox.X2 ||
-	  element->VBox.Y1 == boxp->element->VBox.Y1 ||
-	  element->VBox.Y1 == boxp->element->VBox.Y2 ||
-	  element->VBox.Y2 == boxp->element->VBox.Y1 ||
-	  element->VBox.Y2 == boxp->element->VBox.Y2)
-	delta4 += factor * CostParameter.aligned_neighbor_bonus;
+      if (boxp)
+	delta4 += NeighborBonus (element, boxp->element);
     }
     END_LOOP;
     /* free k-d tree memory */
@@ -617,9 +743,7 @@ ComputeCost (NetListType *Nets, double T0, double T)
       MAKEMAX (maxY, element->VBox.Y2);
     }
     END_LOOP;
-    if (minX < maxX && minY < maxY)
-      delta5 = CostParameter.overall_area_penalty *
-	sqrt (COORD_TO_MIL (maxX - minX) * COORD_TO_MIL (maxY - minY));
+    delta5 = AreaPenalty (minX, minY, maxX, maxY);
   }
   if (T == 5)
     {
@@ -632,6 +756,365 @@ ComputeCost (NetListType *Nets, double T0, double T)
   return W + (delta1 + delta2 + delta3 - delta4 + delta5);
 }
 
+/* ---------------------------------------------------------------------------
+ * incremental cost.
+ *
+ * A perturbation moves one or two elements, but ComputeCost () scores
+ * the whole board again.  PlaceState keeps every term of the cost and,
+ * after a perturbation, re-scores only the nets of the moved elements
+ * and the neighbors whose alignment they can change.
+ *
+ * The congestion and overlap terms are intersection areas: the area
+ * covered by more than one box, counted once per extra box.  Adding a
+ * box B grows that by the area of B covered by the boxes already there,
+ * and removing it shrinks it by the same, so each box of a moved
+ * element or net costs one local union area instead of a sweep over
+ * the whole board.
+ */
+
+/*!
+ * \brief The wire length term of a net.
+ */
+typedef struct
+{
+  BoxType box;			/* bounding rectangle; first, for the r-tree */
+  bool used;			/* false for nets with no cost */
+  double cost;
+  unsigned stamp;		/* last PlaceUpdate () it was re-scored in */
+} NetCostType;
+
+/*!
+ * \brief The terms an element adds to the cost.
+ */
+typedef struct
+{
+  BoxType box;			/* VBox; first, for the r-tree */
+  ElementType *element;
+  int side;			/* 0 component side, 1 solder side */
+  GArray *nets;			/* indices of the nets it is on */
+  BoxListType own;		/* module box, on its side */
+  BoxListType under;		/* pin boxes, on the other side */
+  double oob;			/* out of bounds penalty */
+  double bonus[4];		/* alignment bonus, per direction */
+  unsigned stamp;		/* last PlaceUpdate () it moved in */
+} PlaceElementType;
+
+typedef struct
+{
+  NetListType *Nets;
+  NetCostType *net;
+  PlaceElementType *elem;
+  Cardinal elemN;
+  GHashTable *index;		/* ElementType * -> PlaceElementType * */
+  Cardinal top_group, bottom_group;
+  rtree_t *net_tree;		/* net bounding rectangles */
+  rtree_t *module_tree[2];	/* module boxes, per side */
+  rtree_t *element_tree[2];	/* element VBoxes, per side */
+  double wire;			/* W */
+  double congestion;		/* intersection area of net rectangles */
+  double overlap;		/* intersection area of module boxes */
+  double oob;			/* out of bounds penalties */
+  double bonus;			/* alignment bonuses */
+  unsigned stamp;
+} PlaceState;
+
+static const direction_t place_dir[4] = { NORTH, EAST, SOUTH, WEST };
+
+struct covered_info
+{
+  const BoxType *box;
+  BoxListType clipped;
+};
+
+static int
+covered_cb (const BoxType * b, void *cl)
+{
+  struct covered_info *ci = (struct covered_info *) cl;
+  BoxType *c;
+  if (b->X2 <= ci->box->X1 || b->X1 >= ci->box->X2 ||
+      b->Y2 <= ci->box->Y1 || b->Y1 >= ci->box->Y2)
+    return 0;
+  c = GetBoxMemory (&ci->clipped);
+  c->X1 = MAX (b->X1, ci->box->X1);
+  c->Y1 = MAX (b->Y1, ci->box->Y1);
+  c->X2 = MIN (b->X2, ci->box->X2);
+  c->Y2 = MIN (b->Y2, ci->box->Y2);
+  return 1;
+}
+
+/*!
+ * \brief Area of \p box covered by the boxes in \p tree, in the units
+ * of ComputeIntersectionArea ().
+ */
+static double
+CoveredArea (rtree_t * tree, const BoxType * box)
+{
+  struct covered_info ci;
+  double area = 0;
+  if (box->X1 >= box->X2 || box->Y1 >= box->Y2)
+    return 0;
+  ci.box = box;
+  ci.clipped.BoxN = ci.clipped.BoxMax = 0;
+  ci.clipped.Box = NULL;
+  if (r_search (tree, box, NULL, covered_cb, &ci))
+    area = ComputeUnionArea (&ci.clipped);
+  FreeBoxListMemory (&ci.clipped);
+  return area;
+}
+
+static void
+AddArea (rtree_t * tree, const BoxType * box, double *area)
+{
+  *area += CoveredArea (tree, box);
+  r_insert_entry (tree, box, 0);
+}
+
+static void
+RemoveArea (rtree_t * tree, const BoxType * box, double *area)
+{
+  r_delete_entry (tree, box);
+  *area -= CoveredArea (tree, box);
+}
+
+/*!
+ * \brief Re-score the wire length and congestion of a net.
+ */
+static void
+PlaceNet (PlaceState *ps, Cardinal i)
+{
+  NetCostType *nc = &ps->net[i];
+  if (nc->used)
+    {
+      RemoveArea (ps->net_tree, &nc->box, &ps->congestion);
+      ps->wire -= nc->cost;
+    }
+  UpdateNetXY (&ps->Nets->Net[i], ps->top_group, ps->bottom_group);
+  nc->used = NetWireCost (&ps->Nets->Net[i], &nc->box, &nc->cost);
+  if (nc->used)
+    {
+      ps->wire += nc->cost;
+      AddArea (ps->net_tree, &nc->box, &ps->congestion);
+    }
+}
+
+/*!
+ * \brief Take the boxes of an element out of the state.
+ */
+static void
+PlaceRemove (PlaceState *ps, PlaceElementType *pe)
+{
+  Cardinal i;
+  r_delete_entry (ps->element_tree[pe->side], &pe->box);
+  for (i = 0; i < pe->own.BoxN; i++)
+    RemoveArea (ps->module_tree[pe->side], &pe->own.Box[i], &ps->overlap);
+  for (i = 0; i < pe->under.BoxN; i++)
+    RemoveArea (ps->module_tree[1 - pe->side], &pe->under.Box[i],
+		&ps->overlap);
+  FreeBoxListMemory (&pe->own);
+  FreeBoxListMemory (&pe->under);
+  ps->oob -= pe->oob;
+}
+
+/*!
+ * \brief Put the boxes of an element, where it is now, into the state.
+ */
+static void
+PlaceInsert (PlaceState *ps, PlaceElementType *pe)
+{
+  Cardinal i;
+  pe->box = pe->element->VBox;
+  pe->side = TEST_FLAG (ONSOLDERFLAG, pe->element) ? 1 : 0;
+  ModuleBoxes (pe->element, &pe->own, &pe->under);
+  for (i = 0; i < pe->own.BoxN; i++)
+    AddArea (ps->module_tree[pe->side], &pe->own.Box[i], &ps->overlap);
+  for (i = 0; i < pe->under.BoxN; i++)
+    AddArea (ps->module_tree[1 - pe->side], &pe->under.Box[i],
+	     &ps->overlap);
+  pe->oob = OutOfBounds (pe->element);
+  ps->oob += pe->oob;
+  r_insert_entry (ps->element_tree[pe->side], &pe->box, 0);
+}
+
+/*!
+ * \brief Re-score the alignment bonus of an element in one direction.
+ */
+static void
+PlaceBonus (PlaceState *ps, PlaceElementType *pe, int d)
+{
+  const PlaceElementType *n = (const PlaceElementType *)
+    r_find_neighbor (ps->element_tree[pe->side], &pe->box, place_dir[d]);
+  ps->bonus -= pe->bonus[d];
+  pe->bonus[d] = n ? NeighborBonus (pe->element, n->element) : 0;
+  ps->bonus += pe->bonus[d];
+}
+
+/*!
+ * \brief Set up the cost terms of the board as it is now.
+ */
+static void
+PlaceInit (PlaceState *ps, NetListType *Nets)
+{
+  Cardinal i, j;
+  int d;
+
+  memset (ps, 0, sizeof (*ps));
+  ps->Nets = Nets;
+  ps->top_group = GetLayerGroupNumberBySide (TOP_SIDE);
+  ps->bottom_group = GetLayerGroupNumberBySide (BOTTOM_SIDE);
+  ps->net_tree = r_create_tree (NULL, 0, 0);
+  for (d = 0; d < 2; d++)
+    {
+      ps->module_tree[d] = r_create_tree (NULL, 0, 0);
+      ps->element_tree[d] = r_create_tree (NULL, 0, 0);
+    }
+  ps->index = g_hash_table_new (NULL, NULL);
+  ps->elemN = PCB->Data->ElementN;
+  ps->elem = g_new0 (PlaceElementType, MAX (ps->elemN, 1));
+  i = 0;
+  ELEMENT_LOOP (PCB->Data);
+  {
+    PlaceElementType *pe = &ps->elem[i++];
+    pe->element = element;
+    pe->nets = g_array_new (FALSE, FALSE, sizeof (Cardinal));
+    g_hash_table_insert (ps->index, element, pe);
+    PlaceInsert (ps, pe);
+  }
+  END_LOOP;
+
+  ps->net = g_new0 (NetCostType, MAX (Nets->NetN, 1));
+  for (i = 0; i < Nets->NetN; i++)
+    {
+      for (j = 0; j < Nets->Net[i].ConnectionN; j++)
+	{
+	  PlaceElementType *pe = (PlaceElementType *)
+	    g_hash_table_lookup (ps->index, Nets->Net[i].Connection[j].ptr1);
+	  if (pe && (pe->nets->len == 0
+		     || g_array_index (pe->nets, Cardinal,
+				       pe->nets->len - 1) != i))
+	    g_array_append_val (pe->nets, i);
+	}
+      PlaceNet (ps, i);
+    }
+
+  for (i = 0; i < ps->elemN; i++)
+    for (d = 0; d < 4; d++)
+      PlaceBonus (ps, &ps->elem[i], d);
+}
+
+static void
+PlaceFree (PlaceState *ps)
+{
+  Cardinal i;
+  int d;
+  for (i = 0; i < ps->elemN; i++)
+    {
+      FreeBoxListMemory (&ps->elem[i].own);
+      FreeBoxListMemory (&ps->elem[i].under);
+      g_array_free (ps->elem[i].nets, TRUE);
+    }
+  g_free (ps->elem);
+  g_free (ps->net);
+  g_hash_table_destroy (ps->index);
+  r_destroy_tree (&ps->net_tree);
+  for (d = 0; d < 2; d++)
+    {
+      r_destroy_tree (&ps->module_tree[d]);
+      r_destroy_tree (&ps->element_tree[d]);
+    }
+}
+
+/*!
+ * \brief Bring the cost terms up to date after \p n elements moved.
+ */
+static void
+PlaceUpdate (PlaceState *ps, ElementType **moved, int n)
+{
+  PlaceElementType *pe[2];
+  BoxType old_box[2];
+  int old_side[2];
+  Cardinal i, k;
+  int m, d;
+
+  assert (n <= 2);
+  ps->stamp++;
+  for (m = 0; m < n; m++)
+    {
+      pe[m] = (PlaceElementType *) g_hash_table_lookup (ps->index, moved[m]);
+      old_box[m] = pe[m]->box;
+      old_side[m] = pe[m]->side;
+      pe[m]->stamp = ps->stamp;
+      PlaceRemove (ps, pe[m]);
+    }
+  for (m = 0; m < n; m++)
+    PlaceInsert (ps, pe[m]);
+
+  /* wire length and congestion of their nets */
+  for (m = 0; m < n; m++)
+    for (k = 0; k < pe[m]->nets->len; k++)
+      {
+	i = g_array_index (pe[m]->nets, Cardinal, k);
+	if (ps->net[i].stamp == ps->stamp)
+	  continue;
+	ps->net[i].stamp = ps->stamp;
+	PlaceNet (ps, i);
+      }
+
+  /* alignment: the moved elements, and everything that had or may now
+   * have one of them as a neighbor */
+  for (i = 0; i < ps->elemN; i++)
+    {
+      PlaceElementType *e = &ps->elem[i];
+      for (d = 0; d < 4; d++)
+	{
+	  bool redo = e->stamp == ps->stamp;
+	  for (m = 0; !redo && m < n; m++)
+	    redo = (old_side[m] == e->side
+		    && in_neighbor_trap (&e->box, &old_box[m], place_dir[d]))
+	      || (pe[m]->side == e->side
+		  && in_neighbor_trap (&e->box, &pe[m]->box, place_dir[d]));
+	  if (redo)
+	    PlaceBonus (ps, e, d);
+	}
+    }
+}
+
+/*!
+ * \brief The cost of the placement, from the terms kept up to date, as
+ * the part that does not depend on the temperature and the square root
+ * of the module overlap area, which is weighted by OverlapWeight ().
+ */
+static void
+PlaceTerms (PlaceState *ps, double *base, double *overlap)
+{
+  Coord minX = MAX_COORD, minY = MAX_COORD;
+  Coord maxX = -MAX_COORD, maxY = -MAX_COORD;
+  Cardinal i;
+  for (i = 0; i < ps->elemN; i++)
+    {
+      MAKEMIN (minX, ps->elem[i].box.X1);
+      MAKEMIN (minY, ps->elem[i].box.Y1);
+      MAKEMAX (maxX, ps->elem[i].box.X2);
+      MAKEMAX (maxY, ps->elem[i].box.Y2);
+    }
+  *base = ps->wire +
+    CostParameter.congestion_penalty * sqrt (fabs (ps->congestion)) +
+    ps->oob - ps->bonus + AreaPenalty (minX, minY, maxX, maxY);
+  *overlap = sqrt (fabs (ps->overlap));
+}
+
+/*!
+ * \brief The cost of the placement at temperature \p T.
+ *
+ * Same as ComputeCost () up to rounding.
+ */
+static double
+PlaceCost (PlaceState *ps, double T0, double T)
+{
+  double base, overlap;
+  PlaceTerms (ps, &base, &overlap);
+  return base + overlap * OverlapWeight (T0, T);
+}
+
 /*!
  * \brief .
  *
@@ -772,6 +1255,305 @@ doPerturb (PerturbationType * pt, bool undo)
     }
 }
 
+/*!
+ * \brief Perturb the placement, or undo a perturbation, and bring the
+ * cost terms up to date.
+ */
+static void
+PlacePerturb (PlaceState *ps, PerturbationType * pt, bool undo)
+{
+  ElementType *moved[2];
+  doPerturb (pt, undo);
+  moved[0] = pt->element;
+  moved[1] = pt->other;
+  PlaceUpdate (ps, moved, pt->which == EXCHANGE ? 2 : 1);
+}
+
+/*!
+ * \brief Metropolis criterion: keep a move from cost \p C0 to
+ * \p Cprime at temperature \p T?
+ */
+static bool
+AcceptMove (double C0, double Cprime, double T)
+{
+  return Cprime < C0 ||
+    (random () / (double) RAND_MAX) <
+    exp (MIN (MAX (-20, (C0 - Cprime) / T), 20));
+}
+
+#ifdef HAVE_FORK
+/* ---------------------------------------------------------------------------
+ * parallel tempering.
+ *
+ * With --autoplace-chains, several child processes each run a Metropolis
+ * chain at a fixed temperature, from T0 down to the temperature where
+ * annealing halts.  After every round of moves the parent may swap the
+ * temperatures of neighboring chains, so good placements found while
+ * hot get cooled down and stuck ones get heated up again.  The chains
+ * are processes rather than threads because the placement is the board
+ * itself; swapping temperatures rather than placements means nothing
+ * but costs goes over the pipes until the end, when the best chain
+ * sends the moves that led to its best placement.
+ */
+
+/*!
+ * \brief What a chain reports after a round.
+ */
+struct chain_report
+{
+  double base;			/* cost, less the overlap term */
+  double overlap;		/* weighted by OverlapWeight () */
+  double best;			/* lowest cost at the coldest T so far */
+  long moves;
+};
+
+struct chain_job
+{
+  pid_t pid;
+  int to, from;			/* command and report pipes */
+  FILE *fp;			/* journal of kept moves */
+  struct chain_report r;
+};
+
+static bool
+read_full (int fd, void *buf, size_t len)
+{
+  char *p = (char *) buf;
+  while (len > 0)
+    {
+      ssize_t n = read (fd, p, len);
+      if (n < 0 && errno == EINTR)
+	continue;
+      if (n <= 0)
+	return false;
+      p += n;
+      len -= n;
+    }
+  return true;
+}
+
+/*!
+ * \brief Cost of a chain's placement at temperature \p T.
+ */
+static double
+ChainCost (const struct chain_report *r, double T0, double T)
+{
+  return r->base + r->overlap * OverlapWeight (T0, T);
+}
+
+/*!
+ * \brief Run a tempering chain in a child process.
+ *
+ * Each temperature read from \p in runs a round of \p moves moves and
+ * writes a chain_report to \p out.  A negative temperature writes the
+ * kept moves up to the best placement to \p fp and exits.
+ */
+static void
+chain_child (PlaceState *ps, PointerListType *Selected, double T0,
+	     int moves, int seed, int in, int out, FILE * fp)
+{
+  GArray *journal = g_array_new (FALSE, FALSE, sizeof (PerturbationType));
+  struct chain_report r;
+  guint best_len = 0;
+  double T;
+  int i;
+
+  srandom (seed);
+  PlaceTerms (ps, &r.base, &r.overlap);
+  r.best = ChainCost (&r, T0, CostParameter.chain_T_min);
+  r.moves = 0;
+  while (read_full (in, &T, sizeof (T)))
+    {
+      double C0;
+      if (T < 0)
+	{
+	  /* the child is a fork of the parent, so the element pointers
+	   * in the journal are good there too */
+	  if (fwrite (journal->data, sizeof (PerturbationType), best_len,
+		      fp) == best_len && fflush (fp) == 0)
+	    _exit (0);
+	  _exit (1);
+	}
+      C0 = PlaceCost (ps, T0, T);
+      for (i = 0; i < moves; i++)
+	{
+	  PerturbationType pt = createPerturbation (Selected, T);
+	  double Cprime;
+	  PlacePerturb (ps, &pt, false);
+	  Cprime = PlaceCost (ps, T0, T);
+	  r.moves++;
+	  if (!AcceptMove (C0, Cprime, T))
+	    {
+	      PlacePerturb (ps, &pt, true);
+	      continue;
+	    }
+	  C0 = Cprime;
+	  g_array_append_val (journal, pt);
+	  PlaceTerms (ps, &r.base, &r.overlap);
+	  if (ChainCost (&r, T0, CostParameter.chain_T_min) < r.best)
+	    {
+	      r.best = ChainCost (&r, T0, CostParameter.chain_T_min);
+	      best_len = journal->len;
+	    }
+	}
+      /* start the next round from exact terms */
+      PlaceFree (ps);
+      PlaceInit (ps, ps->Nets);
+      PlaceTerms (ps, &r.base, &r.overlap);
+      if (write (out, &r, sizeof (r)) != sizeof (r))
+	break;
+    }
+  _exit (1);
+}
+
+/*!
+ * \brief Place the selected elements by parallel tempering with
+ * \p chains chains.
+ *
+ * Returns true if the best chain's placement was put on the board.
+ */
+static bool
+PlaceTempering (PlaceState *ps, PointerListType *Selected, double T0,
+		int chains, int moves, GTimer *timer, long *perturbations)
+{
+  struct chain_job *job = g_new0 (struct chain_job, chains);
+  int *level = g_new (int, chains);	/* chain running at each T */
+  double *T = g_new (double, chains);
+  double best = 0;
+  int k, round, stall = 0, status;
+  bool ok = true, changed = false;
+  struct chain_job *winner = NULL;
+
+  fflush (stdout);
+  for (k = 0; k < chains; k++)
+    {
+      int to[2], from[2];
+      T[k] = T0 * pow (CostParameter.chain_T_min / T0,
+		       (double) k / (chains - 1));
+      level[k] = k;
+      job[k].pid = -1;
+      if ((job[k].fp = tmpfile ()) == NULL || pipe (to) < 0)
+	{
+	  ok = false;
+	  break;
+	}
+      if (pipe (from) < 0)
+	{
+	  close (to[0]);
+	  close (to[1]);
+	  ok = false;
+	  break;
+	}
+      job[k].pid = fork ();
+      if (job[k].pid == 0)
+	{
+	  close (to[1]);
+	  close (from[0]);
+	  chain_child (ps, Selected, T0, moves, random () + k, to[0],
+		       from[1], job[k].fp);
+	}
+      close (to[0]);
+      close (from[1]);
+      job[k].to = to[1];
+      job[k].from = from[0];
+      if (job[k].pid < 0)
+	{
+	  close (job[k].to);
+	  close (job[k].from);
+	  ok = false;
+	  break;
+	}
+    }
+
+  for (round = 0; ok && round < CostParameter.chain_rounds; round++)
+    {
+      double coldest;
+      for (k = 0; ok && k < chains; k++)
+	ok = write (job[level[k]].to, &T[k], sizeof (T[k])) == sizeof (T[k]);
+      for (k = 0; ok && k < chains; k++)
+	ok = read_full (job[k].from, &job[k].r, sizeof (job[k].r));
+      if (!ok)
+	break;
+      /* offer swaps between neighboring temperatures, the even pairs
+       * on even rounds and the odd ones on odd rounds */
+      for (k = round & 1; k + 1 < chains; k += 2)
+	{
+	  struct chain_report *a = &job[level[k]].r;
+	  struct chain_report *b = &job[level[k + 1]].r;
+	  double x = (ChainCost (a, T0, T[k]) - ChainCost (b, T0, T[k])) / T[k]
+	    + (ChainCost (b, T0, T[k + 1])
+	       - ChainCost (a, T0, T[k + 1])) / T[k + 1];
+	  if (x >= 0 || (random () / (double) RAND_MAX) < exp (MAX (x, -20)))
+	    {
+	      int t = level[k];
+	      level[k] = level[k + 1];
+	      level[k + 1] = t;
+	    }
+	}
+      *perturbations = 0;
+      for (k = 0; k < chains; k++)
+	{
+	  *perturbations += job[k].r.moves;
+	  if (winner == NULL || job[k].r.best < winner->r.best)
+	    winner = &job[k];
+	}
+      coldest = ChainCost (&job[level[chains - 1]].r, T0, T[chains - 1]);
+      printf ("ROUND %d: BEST %.0f\tCOLDEST %.0f\tMOVES %ld\t"
+	      "TIME %.2f s\n", round, winner->r.best, coldest,
+	      *perturbations, g_timer_elapsed (timer, NULL));
+      if (round == 0 || winner->r.best < best)
+	{
+	  best = winner->r.best;
+	  stall = 0;
+	}
+      else if (++stall >= CostParameter.chain_stall)
+	break;
+    }
+
+  if (ok && winner)
+    {
+      double Tend = -1;
+      ok = write (winner->to, &Tend, sizeof (Tend)) == sizeof (Tend);
+    }
+  for (k = 0; k < chains; k++)
+    {
+      if (job[k].pid <= 0)
+	continue;
+      close (job[k].to);
+      close (job[k].from);
+      if (!ok || &job[k] != winner)
+	kill (job[k].pid, SIGKILL);
+      while (waitpid (job[k].pid, &status, 0) < 0 && errno == EINTR)
+	;
+      if (&job[k] == winner)
+	ok = ok && WIFEXITED (status) && WEXITSTATUS (status) == 0;
+    }
+
+  if (ok && winner)
+    {
+      PerturbationType pt;
+      rewind (winner->fp);
+      while (fread (&pt, sizeof (pt), 1, winner->fp) == 1)
+	{
+	  doPerturb (&pt, false);
+	  changed = true;
+	}
+      Message (_("Tempering with %d chains: chain %d found cost %.0f.\n"),
+	       chains, (int) (winner - job) + 1, winner->r.best);
+    }
+  else
+    Message (_("Tempering chains failed; the placement is unchanged.\n"));
+
+  for (k = 0; k < chains; k++)
+    if (job[k].fp)
+      fclose (job[k].fp);
+  g_free (job);
+  g_free (level);
+  g_free (T);
+  return changed;
+}
+#endif /* HAVE_FORK */
+
 /*!
  * \brief Auto-place selected components.
  */
@@ -781,7 +1563,10 @@ AutoPlaceSelected (void)
   NetListType *Nets;
   PointerListType Selected = { 0, 0, NULL };
   PerturbationType pt;
-  double C0, T0;
+  PlaceState ps;
+  GTimer *timer = NULL;
+  long perturbations = 0;
+  double C0, T0, Cstart = 0;
   bool changed = false;
 
   /* (initial netlist processing copied from AddAllRats) */
@@ -804,23 +1589,36 @@ AutoPlaceSelected (void)
       goto done;
     }
 
+  timer = g_timer_new ();
+  PlaceInit (&ps, Nets);
   /* simulated annealing */
   {				/* compute T0 by doing a random series of moves. */
     const int TRIALS = 10;
     const double Tx = MIL_TO_COORD (300), P = 0.95;
     double Cs = 0.0;
     int i;
-    C0 = ComputeCost (Nets, Tx, Tx);
+    C0 = PlaceCost (&ps, Tx, Tx);
     for (i = 0; i < TRIALS; i++)
       {
 	pt = createPerturbation (&Selected, INCH_TO_COORD (1));
-	doPerturb (&pt, false);
-	Cs += fabs (ComputeCost (Nets, Tx, Tx) - C0);
-	doPerturb (&pt, true);
+	PlacePerturb (&ps, &pt, false);
+	Cs += fabs (PlaceCost (&ps, Tx, Tx) - C0);
+	PlacePerturb (&ps, &pt, true);
       }
     T0 = -(Cs / TRIALS) / log (P);
     printf ("Initial T: %f\n", T0);
   }
+  printf ("Starting cost is %.0f\n", Cstart = ComputeCost (Nets, T0, 5));
+#ifdef HAVE_FORK
+  if (Settings.AutoplaceChains > 1)
+    {
+      changed = PlaceTempering (&ps, &Selected, T0, Settings.AutoplaceChains,
+				2 * CostParameter.m * Selected.PtrN, timer,
+				&perturbations);
+      C0 = ComputeCost (Nets, T0, CostParameter.chain_T_min);
+      goto report;
+    }
+#endif
   /* now anneal in earnest */
   {
     double T = T0;
@@ -828,48 +1626,62 @@ AutoPlaceSelected (void)
     int good_moves = 0, moves = 0;
     const int good_move_cutoff = CostParameter.m * Selected.PtrN;
     const int move_cutoff = 2 * good_move_cutoff;
-    printf ("Starting cost is %.0f\n", ComputeCost (Nets, T0, 5));
-    C0 = ComputeCost (Nets, T0, T);
+    C0 = PlaceCost (&ps, T0, T);
     while (1)
       {
 	double Cprime;
 	pt = createPerturbation (&Selected, T);
-	doPerturb (&pt, false);
-	Cprime = ComputeCost (Nets, T0, T);
+	PlacePerturb (&ps, &pt, false);
+	Cprime = PlaceCost (&ps, T0, T);
+	perturbations++;
 	if (Cprime < C0)
 	  {			/* good move! */
 	    C0 = Cprime;
 	    good_moves++;
 	    steps++;
 	  }
-	else if ((random () / (double) RAND_MAX) <
-		 exp (MIN (MAX (-20, (C0 - Cprime) / T), 20)))
+	else if (AcceptMove (C0, Cprime, T))
 	  {
 	    /* not good but keep it anyway */
 	    C0 = Cprime;
 	    steps++;
 	  }
 	else
-	  doPerturb (&pt, true);	/* undo last change */
+	  PlacePerturb (&ps, &pt, true);	/* undo last change */
 	moves++;
 	/* are we at the end of a stage? */
 	if (good_moves >= good_move_cutoff || moves >= move_cutoff)
 	  {
 	    printf ("END OF STAGE: COST %.0f\t"
 		    "GOOD_MOVES %d\tMOVES %d\t"
-		    "T: %.1f\n", C0, good_moves, moves, T);
+		    "T: %.1f\tTIME %.2f s\n", C0, good_moves, moves, T,
+		    g_timer_elapsed (timer, NULL));
 	    /* is this the end? */
 	    if (T < 5 || good_moves < moves / CostParameter.good_ratio)
 	      break;
 	    /* nope, adjust T and continue */
 	    moves = good_moves = 0;
 	    T *= CostParameter.gamma;
-	    /* cost is T dependent, so recompute */
-	    C0 = ComputeCost (Nets, T0, T);
+	    /* start the stage from exact terms; cost is T dependent, so
+	     * recompute */
+	    PlaceFree (&ps);
+	    PlaceInit (&ps, Nets);
+	    C0 = PlaceCost (&ps, T0, T);
 	  }
       }
     changed = (steps > 0);
+    C0 = ComputeCost (Nets, T0, T);
+  }
+#ifdef HAVE_FORK
+report:
+#endif
+  {
+    double elapsed = g_timer_elapsed (timer, NULL);
+    Message (_("Autoplace: %ld perturbations in %.2f s (%.0f per second), "
+	       "cost %.0f to %.0f.\n"), perturbations, elapsed,
+	     elapsed > 0 ? perturbations / elapsed : 0.0, Cstart, C0);
   }
+  PlaceFree (&ps);
 done:
   if (changed)
     {
@@ -877,6 +1689,8 @@ done:
       AddAllRats (false, NULL);
       Redraw ();
     }
+  if (timer)
+    g_timer_destroy (timer);
   FreePointerListMemory (&Selected);
   return (changed);
 }
@@ -65,7 +65,18 @@
 #include "global.h"
 
 #include <assert.h>
+#include <errno.h>
 #include <setjmp.h>
+#include <signal.h>
+
+/* for fork() and friends */
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/wait.h>
+#endif
 
 #include "data.h"
 #include "macro.h"
@@ -405,6 +416,135 @@ struct routeone_state
   cost_t best_cost;
 };
 
+/* ---------------------------------------------------------------------------
+ * fixed-size object pools.
+ *
+ * The search creates and throws away edges and expansion areas by the
+ * million, so they are carved out of large blocks and recycled through
+ * a free list instead of going through malloc one at a time.  A pool is
+ * rewound in one step when all of its objects die together (at the end
+ * of RouteOne).  The search pools give their blocks back once a net is
+ * done, so one big net doesn't pin its peak for the rest of the run;
+ * the route boxes live until pool_release in DestroyRouteData.
+ *
+ * Like the rest of the router's state the pools are file-static: there
+ * is only ever one routedata, and the parallel passes work in forked
+ * children with their own copy.
+ */
+#define POOL_BLOCK_OBJECTS 1024
+
+typedef union pool_block
+{
+  union pool_block *next;
+  double align;			/* objects following the header hold doubles */
+}
+pool_block_t;
+
+typedef struct pool
+{
+  size_t size;			/* size of one object */
+  pool_block_t *blocks;		/* every block owned by the pool */
+  pool_block_t *current;	/* block objects are being carved from */
+  int used;			/* objects carved from current */
+  void *free_list;		/* objects returned by pool_free */
+  unsigned long objects;	/* objects handed out so far */
+  unsigned long mallocs;	/* blocks malloc'd so far */
+}
+pool_t;
+
+/* route boxes of the board and of the routes found; live as long as the
+ * routedata */
+static pool_t routebox_pool = { sizeof (routebox_t) };
+/* expansion areas and edges of the search in progress */
+static pool_t expansion_pool = { sizeof (routebox_t) };
+static pool_t edge_pool = { sizeof (edge_t) };
+
+/*!
+ * \brief Get a zeroed object from a pool.
+ */
+static void *
+pool_alloc (pool_t * p)
+{
+  void *obj;
+  if (p->free_list)
+    {
+      obj = p->free_list;
+      p->free_list = *(void **) obj;
+    }
+  else
+    {
+      if (!p->current || p->used == POOL_BLOCK_OBJECTS)
+	{
+	  /* reuse the blocks left over from before the last rewind first */
+	  pool_block_t *next = p->current ? p->current->next : p->blocks;
+	  if (!next)
+	    {
+	      next = (pool_block_t *)malloc (sizeof (pool_block_t) +
+					     POOL_BLOCK_OBJECTS * p->size);
+	      next->next = NULL;
+	      if (p->current)
+		p->current->next = next;
+	      else
+		p->blocks = next;
+	      p->mallocs++;
+	    }
+	  p->current = next;
+	  p->used = 0;
+	}
+      obj = (char *) (p->current + 1) + p->used++ * p->size;
+    }
+  memset (obj, 0, p->size);
+  p->objects++;
+  return obj;
+}
+
+/*!
+ * \brief Give an object back to its pool for reuse.
+ */
+static void
+pool_free (pool_t * p, void *obj)
+{
+  *(void **) obj = p->free_list;
+  p->free_list = obj;
+}
+
+/*!
+ * \brief Forget every object of a pool at once, keeping its blocks.
+ */
+static void
+pool_reset (pool_t * p)
+{
+  p->current = NULL;
+  p->used = 0;
+  p->free_list = NULL;
+}
+
+/*!
+ * \brief Free the blocks of a rewound pool, keeping its statistics.
+ */
+static void
+pool_trim (pool_t * p)
+{
+  assert (!p->current && !p->free_list);
+  while (p->blocks)
+    {
+      pool_block_t *next = p->blocks->next;
+      free (p->blocks);
+      p->blocks = next;
+    }
+}
+
+/*!
+ * \brief Free the blocks of a pool and clear its statistics.
+ */
+static void
+pool_release (pool_t * p)
+{
+  pool_reset (p);
+  pool_trim (p);
+  p->objects = p->mallocs = 0;
+}
+
 
 /* ---------------------------------------------------------------------------
  * some local prototypes
@@ -658,8 +798,7 @@ AddPin (PointerListType layergroupboxes[], PinType *pin, bool is_via,
   for (i = 0; i < max_group; i++)
     {
       rbpp = (routebox_t **) GetPointerMemory (&layergroupboxes[i]);
-      *rbpp = (routebox_t *)malloc (sizeof (**rbpp));
-      memset ((void *) *rbpp, 0, sizeof (**rbpp));
+      *rbpp = (routebox_t *) pool_alloc (&routebox_pool);
       (*rbpp)->group = i;
       ht = HALF_THICK (MAX (pin->Thickness, pin->DrillingHole));
       init_const_box (*rbpp,
@@ -706,9 +845,7 @@ AddPad (PointerListType layergroupboxes[],
   assert (PCB->LayerGroups.Number[layergroup] > 0);
   rbpp = (routebox_t **) GetPointerMemory (&layergroupboxes[layergroup]);
   assert (rbpp);
-  *rbpp = (routebox_t *)malloc (sizeof (**rbpp));
-  assert (*rbpp);
-  memset (*rbpp, 0, sizeof (**rbpp));
+  *rbpp = (routebox_t *) pool_alloc (&routebox_pool);
   (*rbpp)->group = layergroup;
   halfthick = HALF_THICK (pad->Thickness);
   init_const_box (*rbpp,
@@ -740,8 +877,7 @@ AddLine (PointerListType layergroupboxes[], int layergroup, LineType *line,
   assert (PCB->LayerGroups.Number[layergroup] > 0);
 
   rbpp = (routebox_t **) GetPointerMemory (&layergroupboxes[layergroup]);
-  *rbpp = (routebox_t *)malloc (sizeof (**rbpp));
-  memset (*rbpp, 0, sizeof (**rbpp));
+  *rbpp = (routebox_t *) pool_alloc (&routebox_pool);
   (*rbpp)->group = layergroup;
   init_const_box (*rbpp,
 		  /*X1 */ MIN (line->Point1.X,
@@ -788,8 +924,7 @@ AddIrregularObstacle (PointerListType layergroupboxes[],
   assert (PCB->LayerGroups.Number[layergroup] > 0);
 
   rbpp = (routebox_t **) GetPointerMemory (&layergroupboxes[layergroup]);
-  *rbpp = (routebox_t *)malloc (sizeof (**rbpp));
-  memset (*rbpp, 0, sizeof (**rbpp));
+  *rbpp = (routebox_t *) pool_alloc (&routebox_pool);
   (*rbpp)->group = layergroup;
   init_const_box (*rbpp, X1, Y1, X2, Y2, keep);
   (*rbpp)->flags.nonstraight = 1;
@@ -1258,7 +1393,7 @@ CreateRouteData ()
       /* create the r-tree */
       rd->layergrouptree[i] =
 	r_create_tree ((const BoxType **) layergroupboxes[i].Ptr,
-		       layergroupboxes[i].PtrN, 1);
+		       layergroupboxes[i].PtrN, 0);
     }
 
   if (AutoRouteParameters.use_vias)
@@ -1293,6 +1428,9 @@ DestroyRouteData (routedata_t ** rd)
     r_destroy_tree (&(*rd)->layergrouptree[i]);
   if (AutoRouteParameters.use_vias)
     mtspace_destroy (&(*rd)->mtspace);
+  pool_release (&routebox_pool);
+  pool_release (&expansion_pool);
+  pool_release (&edge_pool);
   free (*rd);
   *rd = NULL;
 }
@@ -1325,7 +1463,7 @@ RB_down_count (routebox_t * rb)
     {
       if (rb->parent.expansion_area->flags.homeless)
 	RB_down_count (rb->parent.expansion_area);
-      free (rb);
+      pool_free (&expansion_pool, rb);
     }
 }
 
@@ -1753,9 +1891,7 @@ CreateEdge (routebox_t * rb,
 {
   edge_t *e;
   assert (__routebox_is_good (rb));
-  e = (edge_t *)malloc (sizeof (*e));
-  memset ((void *) e, 0, sizeof (*e));
-  assert (e);
+  e = (edge_t *) pool_alloc (&edge_pool);
   e->rb = rb;
   if (rb->flags.homeless)
     RB_up_count (rb);
@@ -1952,7 +2088,7 @@ KillEdge (void *edge)
     RB_down_count (e->rb);
   if (e->flags.via_search)
     mtsFreeWork (&e->work);
-  free (e);
+  pool_free (&edge_pool, e);
 }
 
 static void
@@ -2089,8 +2225,7 @@ CreateExpansionArea (const BoxType * area, Cardinal group,
 		     routebox_t * parent,
 		     bool relax_edge_requirements, edge_t * src_edge)
 {
-  routebox_t *rb = (routebox_t *) malloc (sizeof (*rb));
-  memset ((void *) rb, 0, sizeof (*rb));
+  routebox_t *rb = (routebox_t *) pool_alloc (&expansion_pool);
   assert (area && parent);
   init_const_box (rb, area->X1, area->Y1, area->X2, area->Y2, 0);
   rb->group = group;
@@ -2498,8 +2633,7 @@ blocker_to_heap (heap_t * heap, routebox_t * rb,
 static routebox_t *
 CreateBridge (const BoxType * area, routebox_t * parent, direction_t dir)
 {
-  routebox_t *rb = (routebox_t *) malloc (sizeof (*rb));
-  memset ((void *) rb, 0, sizeof (*rb));
+  routebox_t *rb = (routebox_t *) pool_alloc (&expansion_pool);
   assert (area && parent);
   init_const_box (rb, area->X1, area->Y1, area->X2, area->Y2, 0);
   rb->group = parent->group;
@@ -2656,7 +2790,7 @@ moveable_edge (vector_t * result, const BoxType * box, direction_t dir,
       if (!box_is_good (&b))
 	return;			/* how did this happen ? */
       nrb = CreateBridge (&b, rb, dir);
-      r_insert_entry (tree, &nrb->box, 1);
+      r_insert_entry (tree, &nrb->box, 0);
       vector_append (area_vec, nrb);
       nrb->flags.homeless = 0;	/* not homeless any more */
       /* mark this one as conflicted */
@@ -2720,7 +2854,7 @@ moveable_edge (vector_t * result, const BoxType * box, direction_t dir,
       assert (box_intersect (&b, &blocker->sbox));
       b = shrink_box (&b, 1);
       nrb = CreateBridge (&b, rb, dir);
-      r_insert_entry (tree, &nrb->box, 1);
+      r_insert_entry (tree, &nrb->box, 0);
       vector_append (area_vec, nrb);
       nrb->flags.homeless = 0;	/* not homeless any more */
       ne = CreateEdge (nrb, nrb->cost_point.X, nrb->cost_point.Y,
@@ -3231,6 +3365,98 @@ FindThermable (rtree_t * rtree, routebox_t * rb)
   return info.plane;
 }
 
+/* ---------------------------------------------------------------------------
+ * speculative routing
+ *
+ * When routing nets in parallel, each net is routed by a child process
+ * against a copy-on-write snapshot of the routing data.  The child logs
+ * every change it makes to the routing data (the RD_Draw* calls, subnet
+ * merges and conflict marks) and sends the log back to the parent,
+ * which replays it.  Routeboxes which existed at the time of the fork
+ * have the same address in both processes; those created by the child
+ * are referred to by their creation order, which the replay reproduces.
+ */
+enum spec_kind
+{ SPEC_LINE, SPEC_VIA, SPEC_THERMAL, SPEC_MERGE, SPEC_BAD };
+
+struct spec_ref
+{
+  routebox_t *old;		/* routebox existing before the fork, or */
+  int created;			/* index into spec_created, or -1 */
+};
+
+struct spec_record
+{
+  enum spec_kind kind;
+  Coord X1, Y1, X2, Y2, size;
+  Cardinal group, layer;
+  bool is_bad, is_45;
+  struct spec_ref a, b;
+};
+
+/* log of the changes made while routing a net in a child process */
+static GArray *spec_log = NULL;
+/* routeboxes created while routing, or replaying, a net */
+static GPtrArray *spec_created = NULL;
+
+static struct spec_ref
+spec_ref (routebox_t * rb)
+{
+  struct spec_ref r;
+  int i;
+
+  r.old = rb;
+  r.created = -1;
+  for (i = spec_created->len - 1; rb != NULL && i >= 0; i--)
+    if (g_ptr_array_index (spec_created, i) == rb)
+      {
+	r.old = NULL;
+	r.created = i;
+	break;
+      }
+  return r;
+}
+
+static routebox_t *
+spec_deref (struct spec_ref r)
+{
+  if (r.created >= 0)
+    return (routebox_t *) g_ptr_array_index (spec_created, r.created);
+  return r.old;
+}
+
+static void
+spec_record (enum spec_kind kind, Coord X1, Coord Y1, Coord X2, Coord Y2,
+	     Coord size, Cardinal group, Cardinal layer, routebox_t * a,
+	     routebox_t * b, bool is_bad, bool is_45)
+{
+  struct spec_record rec;
+
+  if (spec_log == NULL)
+    return;
+  memset (&rec, 0, sizeof (rec));
+  rec.kind = kind;
+  rec.X1 = X1;
+  rec.Y1 = Y1;
+  rec.X2 = X2;
+  rec.Y2 = Y2;
+  rec.size = size;
+  rec.group = group;
+  rec.layer = layer;
+  rec.a = spec_ref (a);
+  rec.b = spec_ref (b);
+  rec.is_bad = is_bad;
+  rec.is_45 = is_45;
+  g_array_append_val (spec_log, rec);
+}
+
+static void
+spec_note_created (routebox_t * rb)
+{
+  if (spec_created != NULL)
+    g_ptr_array_add (spec_created, rb);
+}
+
 /*!
  * \brief Route-tracing code: once we've got a path of expansion boxes,
  * trace a line through them to actually create the connection.
@@ -3241,8 +3467,9 @@ RD_DrawThermal (routedata_t * rd, Coord X, Coord Y,
 		bool is_bad)
 {
   routebox_t *rb;
-  rb = (routebox_t *) malloc (sizeof (*rb));
-  memset ((void *) rb, 0, sizeof (*rb));
+  spec_record (SPEC_THERMAL, X, Y, 0, 0, 0, group, layer, subnet, NULL,
+	       is_bad, false);
+  rb = (routebox_t *) pool_alloc (&routebox_pool);
   init_const_box (rb, X, Y, X + 1, Y + 1, 0);
   rb->group = group;
   rb->layer = layer;
@@ -3256,8 +3483,9 @@ RD_DrawThermal (routedata_t * rd, Coord X, Coord Y,
   MergeNets (rb, subnet, NET);
   MergeNets (rb, subnet, SUBNET);
   /* add it to the r-tree, this may be the whole route! */
-  r_insert_entry (rd->layergrouptree[rb->group], &rb->box, 1);
+  r_insert_entry (rd->layergrouptree[rb->group], &rb->box, 0);
   rb->flags.homeless = 0;
+  spec_note_created (rb);
 }
 
 static void
@@ -3269,6 +3497,8 @@ RD_DrawVia (routedata_t * rd, Coord X, Coord Y,
   int ka = AutoRouteParameters.style->Keepaway;
   PinType *live_via = NULL;
 
+  spec_record (SPEC_VIA, X, Y, 0, 0, radius, 0, 0, subnet, NULL,
+	       is_bad, false);
   if (TEST_FLAG (LIVEROUTEFLAG, PCB))
     {
        live_via = CreateNewVia (PCB->Data, X, Y, radius * 2,
@@ -3284,8 +3514,7 @@ RD_DrawVia (routedata_t * rd, Coord X, Coord Y,
     {
       if (!is_layer_group_active[i])
 	continue;
-      rb = (routebox_t *) malloc (sizeof (*rb));
-      memset ((void *) rb, 0, sizeof (*rb));
+      rb = (routebox_t *) pool_alloc (&routebox_pool);
       init_const_box (rb,
 		      /*X1 */ X - radius, /*Y1 */ Y - radius,
 		      /*X2 */ X + radius + 1, /*Y2 */ Y + radius + 1, ka);
@@ -3317,9 +3546,10 @@ RD_DrawVia (routedata_t * rd, Coord X, Coord Y,
       MergeNets (rb, subnet, SUBNET);
       assert (__routebox_is_good (rb));
       /* and add it to the r-tree! */
-      r_insert_entry (rd->layergrouptree[rb->group], &rb->box, 1);
+      r_insert_entry (rd->layergrouptree[rb->group], &rb->box, 0);
       rb->flags.homeless = 0;	/* not homeless anymore */
       rb->livedraw_obj.via = live_via;
+      spec_note_created (rb);
     }
 }
 static void
@@ -3342,6 +3572,8 @@ RD_DrawLine (routedata_t * rd,
   routebox_t *rb;
   Coord ka = AutoRouteParameters.style->Keepaway;
 
+  spec_record (SPEC_LINE, X1, Y1, X2, Y2, halfthick, group, 0, subnet, NULL,
+	       is_bad, is_45);
   /* don't draw zero-length segments. */
   if (X1 == X2 && Y1 == Y2)
     return;
@@ -3377,8 +3609,7 @@ RD_DrawLine (routedata_t * rd,
   /* dump the queue, no match here */
   if (qX1 == -1)
     return;			/* but not this! */
-  rb = (routebox_t *) malloc (sizeof (*rb));
-  memset ((void *) rb, 0, sizeof (*rb));
+  rb = (routebox_t *) pool_alloc (&routebox_pool);
   assert (is_45 ? (ABS (qX2 - qX1) == ABS (qY2 - qY1))	/* line must be 45-degrees */
 	  : (qX1 == qX2 || qY1 == qY2) /* line must be ortho */ );
   init_const_box (rb,
@@ -3405,7 +3636,8 @@ RD_DrawLine (routedata_t * rd,
   MergeNets (rb, qsn, SUBNET);
   assert (__routebox_is_good (rb));
   /* and add it to the r-tree! */
-  r_insert_entry (rd->layergrouptree[rb->group], &rb->box, 1);
+  r_insert_entry (rd->layergrouptree[rb->group], &rb->box, 0);
+  spec_note_created (rb);
 
   if (TEST_FLAG (LIVEROUTEFLAG, PCB))
     {
@@ -3772,9 +4004,7 @@ CreateSearchEdge (struct routeone_state *s, vetting_t * work, edge_t * parent,
   if (cost < s->best_cost)
     {
       edge_t *ne;
-      ne = (edge_t *)malloc (sizeof (*ne));
-      memset ((void *) ne, 0, sizeof (*ne));
-      assert (ne);
+      ne = (edge_t *) pool_alloc (&edge_pool);
       ne->flags.via_search = 1;
       ne->flags.in_plane = in_plane;
       ne->rb = rb;
@@ -3942,6 +4172,9 @@ do_via_search (edge_t * search, struct routeone_state *s,
  */
 vector_t *area_vec;
 
+/* time spent in do_via_search, for the RouteAll report */
+static double via_search_time;
+
 /* some routines for use in gdb while debugging */
 #if defined(ROUTE_DEBUG)
 static void
@@ -4064,6 +4297,9 @@ struct routeone_status
   int route_had_conflicts;
   cost_t best_route_cost;
   bool net_completely_routed;
+  /* for the profile */
+  int edges_expanded;
+  int heap_peak;
 };
 
 
@@ -4086,6 +4322,7 @@ RouteOne (routedata_t * rd, routebox_t * from, routebox_t * to, int max_edges)
 
   assert (rd && from);
   result.route_had_conflicts = 0;
+  result.edges_expanded = result.heap_peak = 0;
   /* no targets on to/from net need keepaway areas */
   LIST_LOOP (from, same_net, p);
   p->flags.nobloat = 1;
@@ -4219,8 +4456,9 @@ RouteOne (routedata_t * rd, routebox_t * from, routebox_t * to, int max_edges)
       edge_t *e = (edge_t *)vector_remove_last (source_vec);
       assert (is_layer_group_active[e->rb->group]);
       e->cost = edge_cost (e, EXPENSIVE);
-      heap_insert (s.workheap, e->cost, e);
+      heap_append (s.workheap, e->cost, e);
     }
+  heap_build (s.workheap);
   vector_destroy (&source_vec);
   /* okay, process items from heap until it is empty! */
   s.best_path = NULL;
@@ -4232,7 +4470,10 @@ RouteOne (routedata_t * rd, routebox_t * from, routebox_t * to, int max_edges)
   vss.hi_conflict_space_vec = vector_create ();
   while (!heap_is_empty (s.workheap))
     {
-      edge_t *e = (edge_t *)heap_remove_smallest (s.workheap);
+      edge_t *e;
+      MAKEMAX (result.heap_peak, heap_size (s.workheap));
+      e = (edge_t *)heap_remove_smallest (s.workheap);
+      result.edges_expanded++;
 #ifdef ROUTE_DEBUG
       if (aabort)
 	goto dontexpand;
@@ -4255,7 +4496,10 @@ RouteOne (routedata_t * rd, routebox_t * from, routebox_t * to, int max_edges)
       touch_conflicts (e->rb->conflicts_with, 1);
       if (e->flags.via_search)
 	{
+	  gint64 start = g_get_monotonic_time ();
 	  do_via_search (e, &s, &vss, rd->mtspace, targets);
+	  via_search_time += (g_get_monotonic_time () - start)
+	    / (double) G_USEC_PER_SEC;
 	  goto dontexpand;
 	}
       /* we should never add edges on inactive layer groups to the heap. */
@@ -4345,7 +4589,7 @@ RouteOne (routedata_t * rd, routebox_t * from, routebox_t * to, int max_edges)
 	         &e->rb->box, NULL, no_planes,0));
 	       */
 	      r_insert_entry (rd->layergrouptree[e->rb->group], &e->rb->box,
-			      1);
+			      0);
 	      e->rb->flags.homeless = 0;	/* not homeless any more */
 	      /* add to vector of all expansion areas in r-tree */
 	      vector_append (area_vec, e->rb);
@@ -4500,7 +4744,7 @@ RouteOne (routedata_t * rd, routebox_t * from, routebox_t * to, int max_edges)
 	    goto dontexpand;
 	  nrb = CreateExpansionArea (&ans->inflated, e->rb->group, e->rb,
 				     true, e);
-	  r_insert_entry (rd->layergrouptree[nrb->group], &nrb->box, 1);
+	  r_insert_entry (rd->layergrouptree[nrb->group], &nrb->box, 0);
 	  vector_append (area_vec, nrb);
 	  nrb->flags.homeless = 0;	/* not homeless any more */
 	  broken =
@@ -4546,6 +4790,8 @@ RouteOne (routedata_t * rd, routebox_t * from, routebox_t * to, int max_edges)
 	  while (!vector_is_empty (s.best_path->conflicts_with))
 	    {
 	      rb = (routebox_t *)vector_remove_last (s.best_path->conflicts_with);
+	      spec_record (SPEC_BAD, 0, 0, 0, 0, 0, 0, 0, rb, NULL,
+			   false, false);
 	      rb->flags.is_bad = 1;
 	      result.route_had_conflicts++;
 	    }
@@ -4559,6 +4805,8 @@ RouteOne (routedata_t * rd, routebox_t * from, routebox_t * to, int max_edges)
 	  /* back-trace the path and add lines/vias to r-tree */
 	  TracePath (rd, s.best_path, s.best_target, from,
 		     result.route_had_conflicts);
+	  spec_record (SPEC_MERGE, 0, 0, 0, 0, 0, 0, 0, from, s.best_target,
+		       false, false);
 	  MergeNets (from, s.best_target, SUBNET);
 	}
       else
@@ -4591,6 +4839,9 @@ RouteOne (routedata_t * rd, routebox_t * from, routebox_t * to, int max_edges)
       r_delete_entry (rd->layergrouptree[rb->group], &rb->box);
     }
   vector_destroy (&area_vec);
+  /* every edge and expansion area of this search is dead now */
+  pool_reset (&edge_pool);
+  pool_reset (&expansion_pool);
   /* clean up; remove all 'source', 'target', and 'nobloat' flags */
   LIST_LOOP (from, same_net, p);
   if (p->flags.source && p->conflicts_with)
@@ -4605,6 +4856,15 @@ RouteOne (routedata_t * rd, routebox_t * from, routebox_t * to, int max_edges)
   return result;
 }
 
+/* set in a child process making one of several routing attempts, see
+ * route_attempts () */
+static struct
+{
+  double via, conflict, jog;	/* factors on the costs */
+  GRand *order;			/* jitters the net order if set */
+}
+perturbation = { 1, 1, 1, NULL };
+
 static void
 InitAutoRouteParameters (int pass,
 			 RouteStyleType * style,
@@ -4616,13 +4876,14 @@ InitAutoRouteParameters (int pass,
   AutoRouteParameters.style = style;
   AutoRouteParameters.bloat = style->Keepaway + HALF_THICK (style->Thick);
   /* costs */
-  AutoRouteParameters.ViaCost =
-    INCH_TO_COORD (3.5) + style->Diameter * (is_smoothing ? 80 : 30);
+  AutoRouteParameters.ViaCost = perturbation.via *
+    (INCH_TO_COORD (3.5) + style->Diameter * (is_smoothing ? 80 : 30));
   AutoRouteParameters.LastConflictPenalty =
     (400 * pass / passes + 2) / (pass + 1);
   AutoRouteParameters.ConflictPenalty =
-    4 * AutoRouteParameters.LastConflictPenalty;
-  AutoRouteParameters.JogPenalty = 1000 * (is_smoothing ? 20 : 4);
+    4 * perturbation.conflict * AutoRouteParameters.LastConflictPenalty;
+  AutoRouteParameters.JogPenalty =
+    perturbation.jog * 1000 * (is_smoothing ? 20 : 4);
   AutoRouteParameters.CongestionPenalty = 1e6;
   AutoRouteParameters.MinPenalty = EXPENSIVE;
   for (i = 0; i < max_group; i++)
@@ -4715,6 +4976,10 @@ struct routeall_status
   /* net was ripped */
   int ripped;
   int total_nets_routed;
+  /* routes found in all passes, for the routes per second figure */
+  int routes_found;
+  /* total cost of the routes of the last pass */
+  cost_t cost;
 };
 
 static double
@@ -4731,265 +4996,962 @@ calculate_progress (double this_heap_item, double this_heap_size,
   return process_fraction;
 }
 
-struct routeall_status
-RouteAll (routedata_t * rd)
+/* set in a child process routing a net speculatively */
+static bool speculating = false;
+
+/* ---------------------------------------------------------------------------
+ * profiling.
+ *
+ * With --autoroute-profile, RouteAll writes what every pass and every
+ * net cost to a JSON file.
+ */
+struct net_profile
 {
-  struct routeall_status ras;
-  struct routeone_status ros;
-  bool rip;
-  int request_cancel;
-#ifdef NET_HEAP
-  heap_t *net_heap;
-#endif
-  heap_t *this_pass, *next_pass, *tmp;
-  routebox_t *net, *p, *pp;
-  cost_t total_net_cost, last_cost = 0, this_cost = 0;
-  int i;
-  int this_heap_size;
-  int this_heap_item;
+  double seconds;
+  int routes, conflicts, failed;
+  long edges;
+  int heap_peak;
+  unsigned long blocker_lookups;
+};
 
-  /* initialize heap for first pass; 
-   * do smallest area first; that makes
-   * the subsequent costs more representative */
-  this_pass = heap_create ();
-  next_pass = heap_create ();
-#ifdef NET_HEAP
-  net_heap = heap_create ();
-#endif
-  LIST_LOOP (rd->first_net, different_net, net);
+/* the net route_net () is working on */
+static struct net_profile net_prof;
+/* the profile being written, NULL if not profiling */
+static GString *profile;
+static bool profile_first;
+
+/*!
+ * \brief Name the pin or pad of a routebox like "U1-3", or return
+ * NULL for other routeboxes.
+ */
+static char *
+pin_label (routebox_t * rb)
+{
+  if (rb->type == PIN && rb->parent.pin->Element)
+    return g_strdup_printf ("%s-%s",
+			    UNKNOWN (NAMEONPCB_NAME ((ElementType *)
+						     rb->parent.pin->Element)),
+			    UNKNOWN (rb->parent.pin->Number));
+  if (rb->type == PAD && rb->parent.pad->Element)
+    return g_strdup_printf ("%s-%s",
+			    UNKNOWN (NAMEONPCB_NAME ((ElementType *)
+						     rb->parent.pad->Element)),
+			    UNKNOWN (rb->parent.pad->Number));
+  return NULL;
+}
+
+/*!
+ * \brief Name a net after its first pin or pad.
+ */
+static char *
+net_label (routebox_t * net)
+{
+  routebox_t *p;
+  char *label;
+
+  LIST_LOOP (net, same_net, p);
   {
-    double area;
-    BoxType bb = shrink_routebox (net);
-    LIST_LOOP (net, same_net, p);
-    {
-      MAKEMIN (bb.X1, p->sbox.X1);
-      MAKEMIN (bb.Y1, p->sbox.Y1);
-      MAKEMAX (bb.X2, p->sbox.X2);
-      MAKEMAX (bb.Y2, p->sbox.Y2);
-    }
-    END_LOOP;
-    area = (double) (bb.X2 - bb.X1) * (bb.Y2 - bb.Y1);
-    heap_insert (this_pass, area, net);
+    if ((label = pin_label (p)) != NULL)
+      return label;
   }
   END_LOOP;
+  return pcb_g_strdup_printf ("%mm,%mm", net->box.X1, net->box.Y1);
+}
 
-  ras.total_nets_routed = 0;
-  /* refinement/finishing passes */
-  for (i = 0; i <= passes + smoothes; i++)
+static void
+profile_append_string (const char *str)
+{
+  g_string_append_c (profile, '"');
+  for (; *str; str++)
+    if (*str == '"' || *str == '\\')
+      g_string_append_printf (profile, "\\%c", *str);
+    else if ((unsigned char) *str < ' ')
+      g_string_append_printf (profile, "\\u%04x", *str);
+    else
+      g_string_append_c (profile, *str);
+  g_string_append_c (profile, '"');
+}
+
+static void
+profile_begin_pass (int pass)
+{
+  if (!profile)
+    return;
+  g_string_append_printf (profile, "%s\n    { \"pass\": %d, \"nets\": [",
+			  pass ? "," : "", pass);
+  profile_first = true;
+}
+
+static void
+profile_net (routebox_t * net, const struct net_profile *np)
+{
+  char *label;
+
+  if (!profile)
+    return;
+  label = net_label (net);
+  g_string_append_printf (profile, "%s\n      { \"net\": ",
+			  profile_first ? "" : ",");
+  profile_append_string (label);
+  g_string_append_printf (profile, ", \"seconds\": %.6f, \"routes\": %d, "
+			  "\"conflicts\": %d, \"failed\": %d, "
+			  "\"edges\": %ld, \"heap_peak\": %d, "
+			  "\"blocker_lookups\": %lu }",
+			  np->seconds, np->routes, np->conflicts, np->failed,
+			  np->edges, np->heap_peak, np->blocker_lookups);
+  profile_first = false;
+  g_free (label);
+}
+
+static void
+profile_end_pass (struct routeall_status *ras, cost_t cost, double seconds)
+{
+  if (!profile)
+    return;
+  g_string_append_printf (profile, "\n      ],\n      \"seconds\": %.6f, "
+			  "\"subnets\": %d, \"routed\": %d, "
+			  "\"conflicts\": %d, \"failed\": %d, "
+			  "\"ripped\": %d, \"cost\": %.0f }",
+			  seconds, ras->total_subnets, ras->routed_subnets,
+			  ras->conflict_subnets, ras->failed, ras->ripped,
+			  cost);
+}
+
+/*!
+ * \brief Start a profile if --autoroute-profile asks for one.
+ */
+static void
+profile_start (const char *what)
+{
+  if (!Settings.AutorouteProfile || !*Settings.AutorouteProfile
+      || speculating)
+    return;
+  profile = g_string_new ("{\n  \"board\": ");
+  profile_append_string (EMPTY (PCB->Filename));
+  g_string_append (profile, ", \"run\": ");
+  profile_append_string (what);
+  g_string_append_printf (profile, ", \"jobs\": %d,\n  \"passes\": [",
+			  Settings.AutorouteJobs);
+}
+
+/*!
+ * \brief Write the profile out, unless \p complete is false, and stop
+ * profiling.
+ */
+static void
+profile_finish (bool complete)
+{
+  FILE *fp;
+
+  if (!profile)
+    return;
+  if (complete)
     {
-#ifdef ROUTE_VERBOSE
-      if (i > 0 && i <= passes)
-	printf ("--------- STARTING REFINEMENT PASS %d ------------\n", i);
-      else if (i > passes)
-	printf ("--------- STARTING SMOOTHING PASS %d -------------\n",
-		i - passes);
-#endif
-      ras.total_subnets = ras.routed_subnets = ras.conflict_subnets =
-	ras.failed = ras.ripped = 0;
-      assert (heap_is_empty (next_pass));
+      g_string_append (profile, "\n}\n");
+      if ((fp = fopen (Settings.AutorouteProfile, "w")) == NULL)
+	OpenErrorMessage (Settings.AutorouteProfile);
+      else
+	{
+	  fputs (profile->str, fp);
+	  fclose (fp);
+	}
+    }
+  g_string_free (profile, TRUE);
+  profile = NULL;
+}
+
+static unsigned long
+blocker_lookups (routedata_t * rd)
+{
+  unsigned long lookups = 0, hits;
+
+  if (rd->mtspace)
+    mtspace_memo_stats (rd->mtspace, &lookups, &hits);
+  return lookups;
+}
+
+/*!
+ * \brief Get a net ready for routing in the given pass.
+ *
+ * Rips up the unfixed traces of the net if needed.  Returns false if
+ * the net needs no routing in this pass.
+ */
+static bool
+prepare_net (routedata_t * rd, routebox_t * net, int pass,
+	     struct routeall_status *ras)
+{
+  routebox_t *p;
+  bool rip;
 
-      this_heap_size = heap_size (this_pass);
-      for (this_heap_item = 0; !heap_is_empty (this_pass); this_heap_item++)
+  InitAutoRouteParameters (pass, net->style, pass < passes, pass > passes,
+			   pass == passes + smoothes);
+  if (pass > 0)
+    {
+      /* rip up all unfixed traces in this net ? */
+      if (AutoRouteParameters.rip_always)
+	rip = true;
+      else
 	{
-#ifdef ROUTE_DEBUG
-	  if (aabort)
-	    break;
-#endif
-	  net = (routebox_t *) heap_remove_smallest (this_pass);
-	  InitAutoRouteParameters (i, net->style, i < passes, i > passes,
-				   i == passes + smoothes);
-	  if (i > 0)
+	  rip = false;
+	  LIST_LOOP (net, same_net, p);
+	  if (p->flags.is_bad)
 	    {
-	      /* rip up all unfixed traces in this net ? */
-	      if (AutoRouteParameters.rip_always)
-		rip = true;
-	      else
-		{
-		  rip = false;
-		  LIST_LOOP (net, same_net, p);
-		  if (p->flags.is_bad)
-		    {
-		      rip = true;
-		      break;
-		    }
-		  END_LOOP;
-		}
+	      rip = true;
+	      break;
+	    }
+	  END_LOOP;
+	}
 
-	      LIST_LOOP (net, same_net, p);
-	      p->flags.is_bad = 0;
-	      if (!p->flags.fixed)
-		{
+      LIST_LOOP (net, same_net, p);
+      p->flags.is_bad = 0;
+      if (!p->flags.fixed)
+	{
 #ifndef NDEBUG
-		  bool del;
+	  bool del;
 #endif
-		  assert (!p->flags.homeless);
-		  if (rip)
-		    {
-		      RemoveFromNet (p, NET);
-		      RemoveFromNet (p, SUBNET);
-		    }
-		  if (AutoRouteParameters.use_vias && p->type != VIA_SHADOW
-		      && p->type != PLANE)
-		    {
-		      mtspace_remove (rd->mtspace, &p->box,
-				      p->flags.is_odd ? ODD : EVEN,
-				      p->style->Keepaway);
-		      if (!rip)
-			mtspace_add (rd->mtspace, &p->box,
-				     p->flags.is_odd ? EVEN : ODD,
-				     p->style->Keepaway);
-		    }
-		  if (rip)
-		    {
-		      if (TEST_FLAG (LIVEROUTEFLAG, PCB))
-			ripout_livedraw_obj (p);
+	  assert (!p->flags.homeless);
+	  if (rip)
+	    {
+	      RemoveFromNet (p, NET);
+	      RemoveFromNet (p, SUBNET);
+	    }
+	  if (AutoRouteParameters.use_vias && p->type != VIA_SHADOW
+	      && p->type != PLANE)
+	    {
+	      mtspace_remove (rd->mtspace, &p->box,
+			      p->flags.is_odd ? ODD : EVEN,
+			      p->style->Keepaway);
+	      if (!rip)
+		mtspace_add (rd->mtspace, &p->box,
+			     p->flags.is_odd ? EVEN : ODD,
+			     p->style->Keepaway);
+	    }
+	  if (rip)
+	    {
+	      if (TEST_FLAG (LIVEROUTEFLAG, PCB))
+		ripout_livedraw_obj (p);
 #ifndef NDEBUG
-		      del =
+	      del =
 #endif
-			r_delete_entry (rd->layergrouptree[p->group],
-					&p->box);
+		r_delete_entry (rd->layergrouptree[p->group], &p->box);
 #ifndef NDEBUG
-		      assert (del);
+	      assert (del);
 #endif
-		    }
-		  else
-		    {
-		      p->flags.is_odd = AutoRouteParameters.is_odd;
-		    }
-		}
-	      END_LOOP;
-	      if (TEST_FLAG (LIVEROUTEFLAG, PCB))
-		Draw ();
-	      /* reset to original connectivity */
-	      if (rip)
-		{
-		  ras.ripped++;
-		  ResetSubnet (net);
-		}
-	      else
-		{
-		  heap_insert (next_pass, 0, net);
-		  continue;
-		}
+	      pool_free (&routebox_pool, p);
 	    }
-	  /* count number of subnets */
-	  FOREACH_SUBNET (net, p);
-	  ras.total_subnets++;
-	  END_FOREACH (net, p);
-	  /* the first subnet doesn't require routing. */
-	  ras.total_subnets--;
-	  /* and re-route! */
-	  total_net_cost = 0;
-	  /* only route that which isn't fully routed */
-#ifdef ROUTE_DEBUG
-	  if (ras.total_subnets == 0 || aabort)
-#else
-	  if (ras.total_subnets == 0)
-#endif
+	  else
 	    {
-	      heap_insert (next_pass, 0, net);
-	      continue;
+	      p->flags.is_odd = AutoRouteParameters.is_odd;
 	    }
+	}
+      END_LOOP;
+      if (TEST_FLAG (LIVEROUTEFLAG, PCB))
+	Draw ();
+      /* reset to original connectivity */
+      if (rip)
+	{
+	  ras->ripped++;
+	  ResetSubnet (net);
+	}
+      else
+	return false;
+    }
+  /* count number of subnets */
+  FOREACH_SUBNET (net, p);
+  ras->total_subnets++;
+  END_FOREACH (net, p);
+  /* the first subnet doesn't require routing. */
+  ras->total_subnets--;
+  /* only route that which isn't fully routed */
+#ifdef ROUTE_DEBUG
+  if (ras->total_subnets == 0 || aabort)
+#else
+  if (ras->total_subnets == 0)
+#endif
+    return false;
+  return true;
+}
 
-	  /* the loop here ensures that we get to all subnets even if
-	   * some of them are unreachable from the first subnet. */
-	  LIST_LOOP (net, same_net, p);
-	  {
+/*!
+ * \brief Route all subnets of a net prepared by prepare_net().
+ *
+ * Returns false if the user cancelled the autorouter.
+ */
+static bool
+route_net (routedata_t * rd, routebox_t * net, int pass,
+	   struct routeall_status *ras, cost_t * total_net_cost,
+	   bool * completely_routed, int this_heap_item, int this_heap_size)
+{
+  struct routeone_status ros;
+  routebox_t *p, *pp;
+  int request_cancel;
+  GTimer *timer = g_timer_new ();
+  unsigned long lookups = blocker_lookups (rd);
 #ifdef NET_HEAP
-	    BoxType b = shrink_routebox (p);
-	    /* using a heap allows us to start from smaller objects and
-	     * end at bigger ones. also prefer to start at planes, then pads */
-	    heap_insert (net_heap, (float) (b.X2 - b.X1) *
+  heap_t *net_heap = heap_create ();
+#endif
+
+  memset (&net_prof, 0, sizeof (net_prof));
+  *total_net_cost = 0;
+  ros.net_completely_routed = 0;
+  /* the loop here ensures that we get to all subnets even if
+   * some of them are unreachable from the first subnet. */
+  LIST_LOOP (net, same_net, p);
+  {
+#ifdef NET_HEAP
+    BoxType b = shrink_routebox (p);
+    /* using a heap allows us to start from smaller objects and
+     * end at bigger ones. also prefer to start at planes, then pads */
+    heap_append (net_heap, (float) (b.X2 - b.X1) *
 #if defined(ROUTE_RANDOMIZED)
-			 (0.3 + rand () / (RAND_MAX + 1.0)) *
+		 (0.3 + rand () / (RAND_MAX + 1.0)) *
 #endif
-			 (b.Y2 - b.Y1) * (p->type == PLANE ?
-					  -1 : (p->type ==
-						PAD ? 1 : 10)), p);
-	  }
-	  END_LOOP;
-	  ros.net_completely_routed = 0;
-	  while (!heap_is_empty (net_heap))
-	    {
-	      p = (routebox_t *) heap_remove_smallest (net_heap);
+		 (b.Y2 - b.Y1) * (p->type == PLANE ?
+				  -1 : (p->type ==
+					PAD ? 1 : 10)), p);
+  }
+  END_LOOP;
+  heap_build (net_heap);
+  while (!heap_is_empty (net_heap))
+    {
+      p = (routebox_t *) heap_remove_smallest (net_heap);
 #endif
-	      if (!p->flags.fixed || p->flags.subnet_processed ||
-		  p->type == OTHER)
-		continue;
+      if (!p->flags.fixed || p->flags.subnet_processed ||
+	  p->type == OTHER)
+	continue;
 
-	      while (!ros.net_completely_routed)
-		{
-		  double percent;
+      while (!ros.net_completely_routed)
+	{
+	  double percent;
 
-		  assert (no_expansion_boxes (rd));
-		  /* FIX ME: the number of edges to examine should be in autoroute parameters
-		   * i.e. the 2000 and 800 hard-coded below should be controllable by the user
-		   */
-		  ros =
-		    RouteOne (rd, p, NULL,
-			      ((AutoRouteParameters.
-				is_smoothing ? 2000 : 800) * (i +
-							      1)) *
-			      routing_layers);
-		  total_net_cost += ros.best_route_cost;
-		  if (ros.found_route)
-		    {
-		      if (ros.route_had_conflicts)
-			ras.conflict_subnets++;
-		      else
-			{
-			  ras.routed_subnets++;
-			  ras.total_nets_routed++;
-			}
-		    }
-		  else
-		    {
-		      if (!ros.net_completely_routed)
-			ras.failed++;
-		      /* don't bother trying any other source in this subnet */
-		      LIST_LOOP (p, same_subnet, pp);
-		      pp->flags.subnet_processed = 1;
-		      END_LOOP;
-		      break;
-		    }
-		  /* note that we can infer nothing about ras.total_subnets based
-		   * on the number of calls to RouteOne, because we may be unable
-		   * to route a net from a particular starting point, but perfectly
-		   * able to route it from some other. */
-		  percent = calculate_progress (this_heap_item, this_heap_size, &ras);
-		  request_cancel = gui->progress (percent * 100., 100,
-						  _("Autorouting tracks"));
-		  if (request_cancel)
-		    {
-		      ras.total_nets_routed = 0;
-		      ras.conflict_subnets = 0;
-		      Message ("Autorouting cancelled\n");
-		      goto out;
-		    }
+	  assert (no_expansion_boxes (rd));
+	  /* FIX ME: the number of edges to examine should be in autoroute parameters
+	   * i.e. the 2000 and 800 hard-coded below should be controllable by the user
+	   */
+	  ros =
+	    RouteOne (rd, p, NULL,
+		      ((AutoRouteParameters.
+			is_smoothing ? 2000 : 800) * (pass +
+						      1)) *
+		      routing_layers);
+	  *total_net_cost += ros.best_route_cost;
+	  net_prof.edges += ros.edges_expanded;
+	  MAKEMAX (net_prof.heap_peak, ros.heap_peak);
+	  if (ros.found_route)
+	    {
+	      ras->routes_found++;
+	      net_prof.routes++;
+	      if (ros.route_had_conflicts)
+		{
+		  ras->conflict_subnets++;
+		  net_prof.conflicts++;
+		}
+	      else
+		{
+		  ras->routed_subnets++;
+		  ras->total_nets_routed++;
 		}
 	    }
+	  else
+	    {
+	      if (!ros.net_completely_routed)
+		{
+		  ras->failed++;
+		  net_prof.failed++;
+		}
+	      /* don't bother trying any other source in this subnet */
+	      LIST_LOOP (p, same_subnet, pp);
+	      pp->flags.subnet_processed = 1;
+	      END_LOOP;
+	      break;
+	    }
+	  /* note that we can infer nothing about ras->total_subnets based
+	   * on the number of calls to RouteOne, because we may be unable
+	   * to route a net from a particular starting point, but perfectly
+	   * able to route it from some other. */
+	  if (speculating)
+	    continue;		/* the parent reports progress */
+	  percent = calculate_progress (this_heap_item, this_heap_size, ras);
+	  request_cancel = gui->progress (percent * 100., 100,
+					  _("Autorouting tracks"));
+	  if (request_cancel)
+	    {
+	      ras->total_nets_routed = 0;
+	      ras->conflict_subnets = 0;
+	      Message ("Autorouting cancelled\n");
+#ifdef NET_HEAP
+	      heap_destroy (&net_heap);
+#endif
+	      g_timer_destroy (timer);
+	      return false;
+	    }
+	}
+    }
 #ifndef NET_HEAP
-	  END_LOOP;
+  END_LOOP;
+#else
+  heap_destroy (&net_heap);
 #endif
-	  if (!ros.net_completely_routed)
-	    net->flags.is_bad = 1;	/* don't skip this the next round */
-
-	  /* Route easiest nets from this pass first on next pass.
-	   * This works best because it's likely that the hardest
-	   * is the last one routed (since it has the most obstacles)
-	   * but it will do no good to rip it up and try it again
-	   * without first changing any of the other routes
-	   */
-	  heap_insert (next_pass, total_net_cost, net);
-	  if (total_net_cost < EXPENSIVE)
-	    this_cost += total_net_cost;
-	  /* reset subnet_processed flags */
-	  LIST_LOOP (net, same_net, p);
+  if (!ros.net_completely_routed)
+    net->flags.is_bad = 1;	/* don't skip this the next round */
+  *completely_routed = ros.net_completely_routed;
+
+  /* reset subnet_processed flags */
+  LIST_LOOP (net, same_net, p);
+  {
+    p->flags.subnet_processed = 0;
+  }
+  END_LOOP;
+  /* every RouteOne rewound the search pools; let their blocks go */
+  pool_trim (&expansion_pool);
+  pool_trim (&edge_pool);
+
+  net_prof.seconds = g_timer_elapsed (timer, NULL);
+  net_prof.blocker_lookups = blocker_lookups (rd) - lookups;
+  g_timer_destroy (timer);
+  /* a child process sends its profile to the parent instead */
+  if (!speculating)
+    profile_net (net, &net_prof);
+  return true;
+}
+
+/*!
+ * \brief Queue a routed net for the next pass.
+ */
+static void
+finish_net (heap_t * next_pass, routebox_t * net, cost_t total_net_cost,
+	    cost_t * this_cost)
+{
+  /* Route easiest nets from this pass first on next pass.
+   * This works best because it's likely that the hardest
+   * is the last one routed (since it has the most obstacles)
+   * but it will do no good to rip it up and try it again
+   * without first changing any of the other routes
+   */
+  heap_insert (next_pass, total_net_cost, net);
+  if (total_net_cost < EXPENSIVE)
+    *this_cost += total_net_cost;
+}
+
+#ifdef HAVE_FORK
+/* Nets are routed speculatively in batches of at most SPEC_MAX_BATCH
+ * nets, picked from the next SPEC_LOOKAHEAD nets of the pass.  Neither
+ * depends on the number of jobs, so neither does the routing result.
+ */
+#define SPEC_MAX_BATCH 64
+#define SPEC_LOOKAHEAD 256
+
+/*!
+ * \brief What a child process sends back, followed by the change log
+ * and the boxes of the routeboxes it created.
+ */
+struct spec_header
+{
+  struct routeall_status ras;
+  cost_t total_net_cost;
+  bool completely_routed;
+  struct net_profile prof;
+  int n_records;
+  int n_boxes;
+};
+
+struct spec_job
+{
+  routebox_t *net;
+  pid_t pid;
+  int fd;
+  GByteArray *data;
+};
+
+static struct
+{
+  int batches;
+  int speculated;
+  int committed;
+  int rerouted;
+}
+spec_stats;
+
+static BoxType
+net_bounds (routedata_t * rd, routebox_t * net)
+{
+  BoxType bb = net->box;
+  routebox_t *p;
+
+  LIST_LOOP (net, same_net, p);
+  {
+    MAKEMIN (bb.X1, p->box.X1);
+    MAKEMIN (bb.Y1, p->box.Y1);
+    MAKEMAX (bb.X2, p->box.X2);
+    MAKEMAX (bb.Y2, p->box.Y2);
+  }
+  END_LOOP;
+  return bloat_box (&bb, rd->max_bloat);
+}
+
+static bool
+overlaps_any (GArray * boxes, const BoxType * b)
+{
+  int i;
+
+  for (i = 0; i < boxes->len; i++)
+    if (box_intersect (&g_array_index (boxes, BoxType, i), b))
+      return true;
+  return false;
+}
+
+/*!
+ * \brief Pick the next batch of nets to route speculatively.
+ *
+ * Nets are taken in pass order, skipping every net whose bounds overlap
+ * those of a net taken or skipped before it, so that nets which may
+ * interact keep their relative order.  Skipped nets are left on the
+ * pending queue, ahead of the rest of the pass.
+ */
+static void
+collect_batch (routedata_t * rd, int pass, heap_t * this_pass,
+	       heap_t * next_pass, GQueue * pending, GPtrArray * batch,
+	       struct routeall_status *ras, int *this_heap_item)
+{
+  GArray *blocked = g_array_new (FALSE, FALSE, sizeof (BoxType));
+  GList *l = pending->head;
+  int scanned;
+
+  for (scanned = 0;
+       batch->len < SPEC_MAX_BATCH && scanned < SPEC_LOOKAHEAD; scanned++)
+    {
+      routebox_t *net;
+      GList *next;
+      BoxType bb;
+
+      if (l == NULL)
+	{
+	  if (heap_is_empty (this_pass))
+	    break;
+	  g_queue_push_tail (pending, heap_remove_smallest (this_pass));
+	  l = pending->tail;
+	}
+      net = (routebox_t *) l->data;
+      next = l->next;
+      bb = net_bounds (rd, net);
+      if (!overlaps_any (blocked, &bb))
+	{
+	  g_queue_delete_link (pending, l);
+	  (*this_heap_item)++;
+	  if (!prepare_net (rd, net, pass, ras))
+	    {
+	      heap_insert (next_pass, 0, net);
+	      l = next;
+	      continue;
+	    }
+	  g_ptr_array_add (batch, net);
+	}
+      g_array_append_val (blocked, bb);
+      l = next;
+    }
+  g_array_free (blocked, TRUE);
+}
+
+static bool
+write_all (int fd, const void *buf, size_t len)
+{
+  const char *p = (const char *) buf;
+
+  while (len > 0)
+    {
+      ssize_t n = write (fd, p, len);
+      if (n < 0 && errno == EINTR)
+	continue;
+      if (n <= 0)
+	return false;
+      p += n;
+      len -= n;
+    }
+  return true;
+}
+
+/*!
+ * \brief Route a net in a child process and send the log to the parent.
+ */
+static void
+spec_child (routedata_t * rd, routebox_t * net, int pass, int fd)
+{
+  struct spec_header h;
+  int i;
+
+  speculating = true;
+  /* the child must not draw anything */
+  CLEAR_FLAG (LIVEROUTEFLAG, PCB);
+  spec_log = g_array_new (FALSE, FALSE, sizeof (struct spec_record));
+  spec_created = g_ptr_array_new ();
+
+  memset (&h, 0, sizeof (h));
+  InitAutoRouteParameters (pass, net->style, pass < passes, pass > passes,
+			   pass == passes + smoothes);
+  route_net (rd, net, pass, &h.ras, &h.total_net_cost, &h.completely_routed,
+	     0, 0);
+  h.prof = net_prof;
+  h.n_records = spec_log->len;
+  h.n_boxes = spec_created->len;
+
+  if (write_all (fd, &h, sizeof (h))
+      && write_all (fd, spec_log->data,
+		    h.n_records * sizeof (struct spec_record)))
+    for (i = 0; i < h.n_boxes; i++)
+      {
+	routebox_t *rb = (routebox_t *) g_ptr_array_index (spec_created, i);
+	if (!write_all (fd, &rb->box, sizeof (BoxType)))
+	  break;
+      }
+  close (fd);
+  _exit (0);
+}
+
+static void
+spec_start (struct spec_job *job, routedata_t * rd, int pass)
+{
+  int fds[2];
+
+  job->pid = -1;
+  if (pipe (fds) != 0)
+    return;
+  job->pid = fork ();
+  if (job->pid == 0)
+    {
+      close (fds[0]);
+      spec_child (rd, job->net, pass, fds[1]);
+    }
+  close (fds[1]);
+  if (job->pid < 0)
+    close (fds[0]);
+  else
+    job->fd = fds[0];
+}
+
+/*!
+ * \brief Collect the log of a child process, or kill it.
+ *
+ * The log of a child which failed is discarded, so that the net gets
+ * routed again.
+ */
+static void
+spec_finish (struct spec_job *job, bool kill_it)
+{
+  guint8 buf[4096];
+  ssize_t n;
+  pid_t r;
+  int status;
+
+  if (job->pid < 0)
+    return;
+  if (kill_it)
+    kill (job->pid, SIGKILL);
+  else
+    while ((n = read (job->fd, buf, sizeof (buf))) != 0)
+      {
+	if (n < 0)
 	  {
-	    p->flags.subnet_processed = 0;
+	    if (errno == EINTR)
+	      continue;
+	    break;
 	  }
-	  END_LOOP;
+	g_byte_array_append (job->data, buf, n);
+      }
+  close (job->fd);
+  do
+    r = waitpid (job->pid, &status, 0);
+  while (r < 0 && errno == EINTR);
+  if (r != job->pid || !WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    g_byte_array_set_size (job->data, 0);
+  job->pid = -1;
+}
+
+/*!
+ * \brief Replay the log of a speculatively routed net, unless its new
+ * routeboxes overlap those committed before it from the same batch.
+ *
+ * Returns false if the net has to be routed again.
+ */
+static bool
+spec_commit (routedata_t * rd, struct spec_job *job, int pass,
+	     rtree_t * committed, struct routeall_status *ras,
+	     heap_t * next_pass, cost_t * this_cost)
+{
+  struct spec_header h;
+  struct spec_record *rec;
+  BoxType *boxes;
+  int i;
+
+  if (job->data->len < sizeof (h))
+    return false;
+  memcpy (&h, job->data->data, sizeof (h));
+  if (job->data->len != sizeof (h) + h.n_records * sizeof (*rec)
+      + h.n_boxes * sizeof (BoxType))
+    return false;
+  rec = (struct spec_record *) (job->data->data + sizeof (h));
+  boxes = (BoxType *) (rec + h.n_records);
+
+  for (i = 0; i < h.n_boxes; i++)
+    if (!r_region_is_empty (committed, &boxes[i]))
+      return false;
+
+  InitAutoRouteParameters (pass, job->net->style, pass < passes,
+			   pass > passes, pass == passes + smoothes);
+  spec_created = g_ptr_array_new ();
+  for (i = 0; i < h.n_records; i++)
+    switch (rec[i].kind)
+      {
+      case SPEC_LINE:
+	RD_DrawLine (rd, rec[i].X1, rec[i].Y1, rec[i].X2, rec[i].Y2,
+		     rec[i].size, rec[i].group, spec_deref (rec[i].a),
+		     rec[i].is_bad, rec[i].is_45);
+	break;
+      case SPEC_VIA:
+	RD_DrawVia (rd, rec[i].X1, rec[i].Y1, rec[i].size,
+		    spec_deref (rec[i].a), rec[i].is_bad);
+	break;
+      case SPEC_THERMAL:
+	RD_DrawThermal (rd, rec[i].X1, rec[i].Y1, rec[i].group,
+			rec[i].layer, spec_deref (rec[i].a), rec[i].is_bad);
+	break;
+      case SPEC_MERGE:
+	MergeNets (spec_deref (rec[i].a), spec_deref (rec[i].b), SUBNET);
+	break;
+      case SPEC_BAD:
+	spec_deref (rec[i].a)->flags.is_bad = 1;
+	break;
+      }
+  assert (spec_created->len == h.n_boxes);
+  g_ptr_array_free (spec_created, TRUE);
+  spec_created = NULL;
+  if (TEST_FLAG (LIVEROUTEFLAG, PCB))
+    Draw ();
+
+  for (i = 0; i < h.n_boxes; i++)
+    {
+      BoxType *b = (BoxType *) malloc (sizeof (BoxType));
+      *b = boxes[i];
+      r_insert_entry (committed, b, 1);
+    }
+
+  ras->routed_subnets += h.ras.routed_subnets;
+  ras->conflict_subnets += h.ras.conflict_subnets;
+  ras->failed += h.ras.failed;
+  ras->total_nets_routed += h.ras.total_nets_routed;
+  ras->routes_found += h.ras.routes_found;
+  if (!h.completely_routed)
+    job->net->flags.is_bad = 1;
+  profile_net (job->net, &h.prof);
+  finish_net (next_pass, job->net, h.total_net_cost, this_cost);
+  return true;
+}
+
+/*!
+ * \brief Route a pass with up to 'jobs' nets routed in parallel.
+ *
+ * Each batch of nets is routed in child processes against the state
+ * at the start of the batch.  The results are committed in pass order;
+ * nets whose new routes would overlap those of a net committed before
+ * them are routed again, serially, after the batch.
+ *
+ * Returns false if the user cancelled the autorouter.
+ */
+static bool
+route_pass_parallel (routedata_t * rd, int pass, heap_t * this_pass,
+		     heap_t * next_pass, struct routeall_status *ras,
+		     cost_t * this_cost, int jobs)
+{
+  GQueue pending = G_QUEUE_INIT;
+  int this_heap_size = heap_size (this_pass);
+  int this_heap_item = 0;
+  bool ok = true;
+
+  while (ok && (!g_queue_is_empty (&pending) || !heap_is_empty (this_pass)))
+    {
+      GPtrArray *batch = g_ptr_array_new ();
+      GPtrArray *reroute = g_ptr_array_new ();
+      struct spec_job *job;
+      int n, started, finished, k;
+
+      collect_batch (rd, pass, this_pass, next_pass, &pending, batch, ras,
+		     &this_heap_item);
+      /* a lone net gains nothing from a child process */
+      n = batch->len > 1 ? batch->len : 0;
+      if (n == 0)
+	for (k = 0; k < batch->len; k++)
+	  g_ptr_array_add (reroute, g_ptr_array_index (batch, k));
+
+      job = g_new0 (struct spec_job, MAX (n, 1));
+      for (k = 0; k < n; k++)
+	{
+	  job[k].net = (routebox_t *) g_ptr_array_index (batch, k);
+	  job[k].pid = -1;
+	  job[k].data = g_byte_array_new ();
+	}
+      for (started = finished = 0; finished < n; finished++)
+	{
+	  while (started < n && started - finished < jobs)
+	    spec_start (&job[started++], rd, pass);
+	  spec_finish (&job[finished], false);
+	  if (gui->progress (calculate_progress (this_heap_item,
+						 this_heap_size, ras) * 100.,
+			     100, _("Autorouting tracks")))
+	    {
+	      ras->total_nets_routed = 0;
+	      ras->conflict_subnets = 0;
+	      Message ("Autorouting cancelled\n");
+	      for (k = finished + 1; k < started; k++)
+		spec_finish (&job[k], true);
+	      ok = false;
+	      break;
+	    }
 	}
+
+      if (ok && n > 0)
+	{
+	  rtree_t *committed = r_create_tree (NULL, 0, 0);
+
+	  for (k = 0; k < n; k++)
+	    {
+	      if (spec_commit (rd, &job[k], pass, committed, ras, next_pass,
+			       this_cost))
+		spec_stats.committed++;
+	      else
+		g_ptr_array_add (reroute, job[k].net);
+	    }
+	  r_destroy_tree (&committed);
+	  spec_stats.batches++;
+	  spec_stats.speculated += n;
+	  spec_stats.rerouted += reroute->len;
+	}
+
+      /* route serially whatever could not be committed */
+      for (k = 0; ok && k < reroute->len; k++)
+	{
+	  routebox_t *net = (routebox_t *) g_ptr_array_index (reroute, k);
+	  cost_t total_net_cost;
+	  bool completely_routed;
+
+	  InitAutoRouteParameters (pass, net->style, pass < passes,
+				   pass > passes, pass == passes + smoothes);
+	  ok = route_net (rd, net, pass, ras, &total_net_cost,
+			  &completely_routed, this_heap_item, this_heap_size);
+	  if (ok)
+	    finish_net (next_pass, net, total_net_cost, this_cost);
+	}
+
+      for (k = 0; k < n; k++)
+	g_byte_array_free (job[k].data, TRUE);
+      g_free (job);
+      g_ptr_array_free (batch, TRUE);
+      g_ptr_array_free (reroute, TRUE);
+    }
+  g_queue_clear (&pending);
+  return ok;
+}
+#endif /* HAVE_FORK */
+
+struct routeall_status
+RouteAll (routedata_t * rd)
+{
+  struct routeall_status ras;
+  heap_t *this_pass, *next_pass, *tmp;
+  routebox_t *net, *p;
+  cost_t total_net_cost, last_cost = 0, this_cost = 0;
+  bool completely_routed;
+  int i;
+  int this_heap_size;
+  int this_heap_item;
+  int jobs = Settings.AutorouteJobs;
+  GTimer *timer = g_timer_new ();
+  double elapsed, pass_start;
+  bool done = false;
+
+  via_search_time = 0;
+  profile_start ("autoroute");
+#ifdef HAVE_FORK
+  memset (&spec_stats, 0, sizeof (spec_stats));
+#else
+  jobs = 1;
+#endif
+
+  /* initialize heap for first pass; 
+   * do smallest area first; that makes
+   * the subsequent costs more representative */
+  this_pass = heap_create ();
+  next_pass = heap_create ();
+  LIST_LOOP (rd->first_net, different_net, net);
+  {
+    double area;
+    BoxType bb = shrink_routebox (net);
+    LIST_LOOP (net, same_net, p);
+    {
+      MAKEMIN (bb.X1, p->sbox.X1);
+      MAKEMIN (bb.Y1, p->sbox.Y1);
+      MAKEMAX (bb.X2, p->sbox.X2);
+      MAKEMAX (bb.Y2, p->sbox.Y2);
+    }
+    END_LOOP;
+    area = (double) (bb.X2 - bb.X1) * (bb.Y2 - bb.Y1);
+    if (perturbation.order)
+      area *= g_rand_double_range (perturbation.order, 0.5, 2.0);
+    heap_append (this_pass, area, net);
+  }
+  END_LOOP;
+  heap_build (this_pass);
+
+  ras.total_nets_routed = 0;
+  ras.routes_found = 0;
+  /* refinement/finishing passes */
+  for (i = 0; i <= passes + smoothes; i++)
+    {
+#ifdef ROUTE_VERBOSE
+      if (i > 0 && i <= passes)
+	printf ("--------- STARTING REFINEMENT PASS %d ------------\n", i);
+      else if (i > passes)
+	printf ("--------- STARTING SMOOTHING PASS %d -------------\n",
+		i - passes);
+#endif
+      ras.total_subnets = ras.routed_subnets = ras.conflict_subnets =
+	ras.failed = ras.ripped = 0;
+      assert (heap_is_empty (next_pass));
+      profile_begin_pass (i);
+      pass_start = g_timer_elapsed (timer, NULL);
+
+#ifdef HAVE_FORK
+      if (jobs > 1)
+	{
+	  if (!route_pass_parallel (rd, i, this_pass, next_pass, &ras,
+				    &this_cost, jobs))
+	    goto out;
+	}
+      else
+#endif
+	{
+	  this_heap_size = heap_size (this_pass);
+	  for (this_heap_item = 0; !heap_is_empty (this_pass);
+	       this_heap_item++)
+	    {
+#ifdef ROUTE_DEBUG
+	      if (aabort)
+		break;
+#endif
+	      net = (routebox_t *) heap_remove_smallest (this_pass);
+	      if (!prepare_net (rd, net, i, &ras))
+		{
+		  heap_insert (next_pass, 0, net);
+		  continue;
+		}
+	      /* and re-route! */
+	      if (!route_net (rd, net, i, &ras, &total_net_cost,
+			      &completely_routed, this_heap_item,
+			      this_heap_size))
+		goto out;
+	      finish_net (next_pass, net, total_net_cost, &this_cost);
+	    }
+	}
+      profile_end_pass (&ras, this_cost,
+			g_timer_elapsed (timer, NULL) - pass_start);
       /* swap this_pass and next_pass and do it all over again! */
       ro = 0;
       assert (heap_is_empty (this_pass));
@@ -5017,15 +5979,49 @@ RouteAll (routedata_t * rd)
       this_cost = 0;
     }
 
+  ras.cost = last_cost;
+  /* a child process making a routing attempt reports to the parent */
+  if (speculating)
+    goto out;
+
   Message ("%d of %d nets successfully routed.\n",
 	   ras.routed_subnets, ras.total_subnets);
 
+  elapsed = g_timer_elapsed (timer, NULL);
+  if (profile)
+    g_string_append_printf (profile, "\n  ],\n  \"seconds\": %.6f, "
+			    "\"routes\": %d, \"via_search_seconds\": %.6f",
+			    elapsed, ras.routes_found, via_search_time);
+  Message (_("Autorouting took %.2f s, %d routes found (%.1f routes/s).\n"),
+	   elapsed, ras.routes_found,
+	   elapsed > 0 ? ras.routes_found / elapsed : 0.);
+  Message (_("%lu route boxes and %lu edges allocated "
+	     "with %lu calls to malloc.\n"),
+	   routebox_pool.objects + expansion_pool.objects,
+	   edge_pool.objects,
+	   routebox_pool.mallocs + expansion_pool.mallocs + edge_pool.mallocs);
+  if (rd->mtspace)
+    {
+      unsigned long lookups, hits;
+      mtspace_memo_stats (rd->mtspace, &lookups, &hits);
+      Message (_("Via search took %.2f s; %lu of %lu blocker "
+		 "lookups answered from the cache.\n"),
+	       via_search_time, hits, lookups);
+    }
+#ifdef HAVE_FORK
+  if (jobs > 1)
+    Message (_("%d jobs: %d nets in %d batches routed in parallel, "
+	       "%d committed, %d routed again.\n"),
+	     jobs, spec_stats.speculated, spec_stats.batches,
+	     spec_stats.committed, spec_stats.rerouted);
+#endif
+  done = true;
+
 out:
+  profile_finish (done);
+  g_timer_destroy (timer);
   heap_destroy (&this_pass);
   heap_destroy (&next_pass);
-#ifdef NET_HEAP
-  heap_destroy (&net_heap);
-#endif
 
   /* no conflicts should be left at the end of the process. */
   assert (ras.conflict_subnets == 0);
@@ -5080,6 +6076,102 @@ FindPin (const BoxType * box, PinType ** pin)
 }
 
 
+/*!
+ * \brief Put a routed line on the first 'on' layer of its group.
+ *
+ * \p sbox is the line's routebox, bloated by half its thickness.
+ */
+static LineType *
+iron_line (Cardinal group, const BoxType * sbox, bool bl_to_ur,
+	   Coord thick, Coord keepaway)
+{
+  LayerType *layer;
+  LineType *line;
+  Coord halfwidth = HALF_THICK (thick);
+  double th = halfwidth * 2 + 1;
+  BoxType b;
+  int i;
+
+  /* find first on layer in this group */
+  for (i = 0, layer = NULL; i < PCB->LayerGroups.Number[group]; i++)
+    {
+      layer = LAYER_PTR (PCB->LayerGroups.Entries[group][i]);
+      if (layer->On)
+	break;
+    }
+  assert (layer && layer->On);	/*at least one layer must be on in this group! */
+  /* orthogonal; thickness is 2*halfwidth */
+  /* flip coordinates, if bl_to_ur */
+  b = *sbox;
+  total_wire_length += hypot (b.X2 - b.X1 - th, b.Y2 - b.Y1 - th);
+  b = shrink_box (&b, halfwidth);
+  if (b.X2 == b.X1 + 1)
+    b.X2 = b.X1;
+  if (b.Y2 == b.Y1 + 1)
+    b.Y2 = b.Y1;
+  if (bl_to_ur)
+    {
+      Coord t;
+      t = b.X1;
+      b.X1 = b.X2;
+      b.X2 = t;
+    }
+  /* using CreateDrawn instead of CreateNew concatenates sequential lines */
+  line = CreateDrawnLineOnLayer
+    (layer, b.X1, b.Y1, b.X2, b.Y2, thick, keepaway * 2,
+     MakeFlags (AUTOFLAG |
+		(TEST_FLAG (CLEARNEWFLAG, PCB) ? CLEARLINEFLAG : 0)));
+  if (line)
+    AddObjectToCreateUndoList (LINE_TYPE, layer, line, line);
+  return line;
+}
+
+/*!
+ * \brief Put a routed via on the board.
+ *
+ * \p b is the via's routebox without keepaway.
+ */
+static PinType *
+iron_via (const BoxType * b, Coord diameter, Coord keepaway, Coord hole)
+{
+  Coord radius = HALF_THICK (diameter);
+  PinType *via;
+
+  assert (b->X1 + radius == b->X2 - radius);
+  assert (b->Y1 + radius == b->Y2 - radius);
+  via = CreateNewVia (PCB->Data, b->X1 + radius, b->Y1 + radius,
+		      diameter, 2 * keepaway, 0, hole, NULL,
+		      MakeFlags (AUTOFLAG));
+  assert (via);
+  if (via)
+    AddObjectToCreateUndoList (VIA_TYPE, via, via, via);
+  return via;
+}
+
+/*!
+ * \brief Give the pin or via at a routed thermal a thermal on \p layer.
+ */
+static bool
+iron_thermal (const BoxType * box, Cardinal layer)
+{
+  PinType *pin = NULL;
+  /* thermals are alread a single point search, no need to shrink */
+  int type = FindPin (box, &pin);
+
+  if (!pin)
+    return false;
+  AddObjectToClearPolyUndoList (type, pin->Element ? pin->Element : pin,
+				pin, pin, false);
+  RestoreToPolygon (PCB->Data, VIA_TYPE, LAYER_PTR (layer), pin);
+  AddObjectToFlagUndoList (type, pin->Element ? pin->Element : pin, pin,
+			   pin);
+  ASSIGN_THERM (layer, PCB->ThermStyle, pin);
+  AddObjectToClearPolyUndoList (type, pin->Element ? pin->Element : pin,
+				pin, pin, true);
+  ClearFromPolygon (PCB->Data, VIA_TYPE, LAYER_PTR (layer), pin);
+  return true;
+}
+
 /*!
  * \brief Paths go on first 'on' layer in group.
  *
@@ -5089,93 +6181,39 @@ bool
 IronDownAllUnfixedPaths (routedata_t * rd)
 {
   bool changed = false;
-  LayerType *layer;
   routebox_t *net, *p;
-  int i;
   LIST_LOOP (rd->first_net, different_net, net);
   {
     LIST_LOOP (net, same_net, p);
     {
       if (!p->flags.fixed)
 	{
-	  /* find first on layer in this group */
 	  assert (PCB->LayerGroups.Number[p->group] > 0);
 	  assert (is_layer_group_active[p->group]);
-	  for (i = 0, layer = NULL; i < PCB->LayerGroups.Number[p->group];
-	       i++)
-	    {
-	      layer = LAYER_PTR (PCB->LayerGroups.Entries[p->group][i]);
-	      if (layer->On)
-		break;
-	    }
-	  assert (layer && layer->On);	/*at least one layer must be on in this group! */
 	  assert (p->type != EXPANSION_AREA);
 	  if (p->type == LINE)
 	    {
-	      Coord halfwidth = HALF_THICK (p->style->Thick);
-	      double th = halfwidth * 2 + 1;
-	      BoxType b;
 	      assert (p->parent.line == NULL);
-	      /* orthogonal; thickness is 2*halfwidth */
-	      /* flip coordinates, if bl_to_ur */
-	      b = p->sbox;
-	      total_wire_length += hypot (b.X2 - b.X1 - th, b.Y2 - b.Y1 - th);
-	      b = shrink_box (&b, halfwidth);
-	      if (b.X2 == b.X1 + 1)
-		b.X2 = b.X1;
-	      if (b.Y2 == b.Y1 + 1)
-		b.Y2 = b.Y1;
-	      if (p->flags.bl_to_ur)
-		{
-		  Coord t;
-		  t = b.X1;
-		  b.X1 = b.X2;
-		  b.X2 = t;
-		}
-	      /* using CreateDrawn instead of CreateNew concatenates sequential lines */
-	      p->parent.line = CreateDrawnLineOnLayer
-		(layer, b.X1, b.Y1, b.X2, b.Y2,
-		 p->style->Thick,
-		 p->style->Keepaway * 2,
-		 MakeFlags (AUTOFLAG |
-			    (TEST_FLAG (CLEARNEWFLAG, PCB) ? CLEARLINEFLAG :
-			     0)));
-
+	      p->parent.line = iron_line (p->group, &p->sbox,
+					  p->flags.bl_to_ur, p->style->Thick,
+					  p->style->Keepaway);
 	      if (p->parent.line)
-		{
-		  AddObjectToCreateUndoList (LINE_TYPE, layer,
-					     p->parent.line, p->parent.line);
-		  changed = true;
-		}
+		changed = true;
 	    }
 	  else if (p->type == VIA || p->type == VIA_SHADOW)
 	    {
 	      routebox_t *pp =
 		(p->type == VIA_SHADOW) ? p->parent.via_shadow : p;
-	      Coord radius = HALF_THICK (pp->style->Diameter);
 	      BoxType b = shrink_routebox (p);
 	      total_via_count++;
 	      assert (pp->type == VIA);
 	      if (pp->parent.via == NULL)
 		{
-		  assert (b.X1 + radius == b.X2 - radius);
-		  assert (b.Y1 + radius == b.Y2 - radius);
-		  pp->parent.via =
-		    CreateNewVia (PCB->Data, b.X1 + radius,
-				  b.Y1 + radius,
-				  pp->style->Diameter,
-				  2 * pp->style->Keepaway,
-				  0, pp->style->Hole, NULL,
-				  MakeFlags (AUTOFLAG));
-		  assert (pp->parent.via);
+		  pp->parent.via = iron_via (&b, pp->style->Diameter,
+					     pp->style->Keepaway,
+					     pp->style->Hole);
 		  if (pp->parent.via)
-		    {
-		      AddObjectToCreateUndoList (VIA_TYPE,
-						 pp->parent.via,
-						 pp->parent.via,
-						 pp->parent.via);
-		      changed = true;
-		    }
+		    changed = true;
 		}
 	      assert (pp->parent.via);
 	      if (p->type == VIA_SHADOW)
@@ -5194,43 +6232,367 @@ IronDownAllUnfixedPaths (routedata_t * rd)
     /* loop again to place all the thermals now that the vias are down */
     LIST_LOOP (net, same_net, p);
     {
-      if (p->type == THERMAL)
+      if (p->type == THERMAL && iron_thermal (&p->box, p->layer))
+	changed = true;
+    }
+    END_LOOP;
+  }
+  END_LOOP;
+  return changed;
+}
+
+#ifdef HAVE_FORK
+/* ---------------------------------------------------------------------------
+ * multi-start routing.
+ *
+ * With --autoroute-attempts, several child processes route the board at
+ * once, each with its own net order and cost factors, and the parent
+ * irons down the best of their results.
+ */
+
+/*!
+ * \brief What a child process sends back about one routed object.
+ */
+struct iron_record
+{
+  etype type;			/* LINE, VIA or THERMAL */
+  Cardinal group, layer;
+  BoxType box;
+  bool bl_to_ur;
+  Coord thick, keepaway, diameter, hole;
+};
+
+/*!
+ * \brief What a child process sends back, followed by the records.
+ */
+struct attempt_header
+{
+  int failed;			/* subnets not routed without conflicts */
+  cost_t cost;
+  int n_records;
+};
+
+struct attempt_job
+{
+  pid_t pid;
+  FILE *fp;
+  bool finished;
+  struct attempt_header h;
+};
+
+/*!
+ * \brief Make a routing attempt in a child process.
+ *
+ * The first attempt routes as usual; the others scale the via, conflict
+ * and jog costs and jitter the net order by a random factor of up to 2
+ * either way.  The routed objects are written to \p fp.
+ */
+static void
+attempt_child (routedata_t * rd, int attempt, FILE * fp)
+{
+  struct routeall_status ras;
+  struct attempt_header h;
+  struct iron_record r;
+  routebox_t *net, *p;
+  GArray *records = g_array_new (FALSE, FALSE, sizeof (struct iron_record));
+
+  speculating = true;
+  /* the child must not draw anything */
+  CLEAR_FLAG (LIVEROUTEFLAG, PCB);
+  Settings.AutorouteJobs = 1;
+  if (attempt > 0)
+    {
+      GRand *rand = g_rand_new_with_seed (attempt);
+      perturbation.via = g_rand_double_range (rand, 0.5, 2.0);
+      perturbation.conflict = g_rand_double_range (rand, 0.5, 2.0);
+      perturbation.jog = g_rand_double_range (rand, 0.5, 2.0);
+      perturbation.order = rand;
+    }
+
+  ras = RouteAll (rd);
+  LIST_LOOP (rd->first_net, different_net, net);
+  {
+    LIST_LOOP (net, same_net, p);
+    {
+      if (p->flags.fixed
+	  || (p->type != LINE && p->type != VIA && p->type != THERMAL))
+	continue;
+      memset (&r, 0, sizeof (r));
+      r.type = p->type;
+      r.group = p->group;
+      r.layer = p->layer;
+      r.box = p->type == LINE ? p->sbox
+	: p->type == VIA ? shrink_routebox (p) : p->box;
+      r.bl_to_ur = p->flags.bl_to_ur;
+      r.thick = p->style->Thick;
+      r.keepaway = p->style->Keepaway;
+      r.diameter = p->style->Diameter;
+      r.hole = p->style->Hole;
+      g_array_append_val (records, r);
+    }
+    END_LOOP;
+  }
+  END_LOOP;
+
+  h.failed = ras.total_subnets - ras.routed_subnets;
+  h.cost = ras.cost;
+  h.n_records = records->len;
+  if (fwrite (&h, sizeof (h), 1, fp) == 1
+      && fwrite (records->data, sizeof (r), h.n_records, fp) == h.n_records
+      && fflush (fp) == 0)
+    _exit (0);
+  _exit (1);
+}
+
+/*!
+ * \brief Iron down the routed objects of an attempt.
+ */
+static bool
+iron_attempt (struct attempt_job *job)
+{
+  struct iron_record r;
+  bool changed = false;
+  int i, pass;
+
+  /* thermals go last, once the vias are down */
+  for (pass = 0; pass < 2; pass++)
+    {
+      rewind (job->fp);
+      if (fread (&job->h, sizeof (job->h), 1, job->fp) != 1)
+	return changed;
+      for (i = 0; i < job->h.n_records; i++)
 	{
-	  PinType *pin = NULL;
-	  /* thermals are alread a single point search, no need to shrink */
-	  int type = FindPin (&p->box, &pin);
-	  if (pin)
+	  if (fread (&r, sizeof (r), 1, job->fp) != 1)
+	    return changed;
+	  if ((r.type == THERMAL) != (pass == 1))
+	    continue;
+	  if (r.type == LINE)
+	    changed |= iron_line (r.group, &r.box, r.bl_to_ur, r.thick,
+				  r.keepaway) != NULL;
+	  else if (r.type == VIA)
+	    {
+	      total_via_count++;
+	      changed |= iron_via (&r.box, r.diameter, r.keepaway,
+				   r.hole) != NULL;
+	    }
+	  else
+	    changed |= iron_thermal (&r.box, r.layer);
+	}
+    }
+  return changed;
+}
+
+/*!
+ * \brief Make several routing attempts in parallel and iron down the
+ * one with the fewest failed subnets, and of those the lowest cost.
+ *
+ * Attempts still running when --autoroute-time-limit runs out are
+ * killed.  Returns true if anything was added to the board.
+ */
+static bool
+route_attempts (routedata_t * rd, int attempts)
+{
+  struct attempt_job *job = g_new0 (struct attempt_job, attempts);
+  struct attempt_job *best = NULL;
+  GTimer *timer = g_timer_new ();
+  double limit = Settings.AutorouteTimeLimit;
+  bool changed = false, cancel = false;
+  int k, running = 0, finished = 0, status;
+
+  for (k = 0; k < attempts; k++)
+    {
+      job[k].pid = -1;
+      if ((job[k].fp = tmpfile ()) == NULL)
+	continue;
+      job[k].pid = fork ();
+      if (job[k].pid == 0)
+	attempt_child (rd, k, job[k].fp);
+      if (job[k].pid > 0)
+	running++;
+    }
+
+  while (running > 0)
+    {
+      double elapsed = g_timer_elapsed (timer, NULL);
+      double percent = limit > 0 ? MAX (elapsed / limit,
+					(double) finished / attempts)
+	: (double) finished / attempts;
+      if (gui->progress (percent * 100., 100, _("Autorouting attempts")))
+	{
+	  Message ("Autorouting cancelled\n");
+	  cancel = true;
+	}
+      for (k = 0; k < attempts; k++)
+	{
+	  pid_t r;
+	  if (job[k].pid <= 0)
+	    continue;
+	  if (cancel || (limit > 0 && elapsed > limit))
+	    kill (job[k].pid, SIGKILL);
+	  r = waitpid (job[k].pid, &status, cancel ? 0 : WNOHANG);
+	  if (r == 0 || (r < 0 && errno == EINTR))
+	    continue;
+	  if (r == job[k].pid && WIFEXITED (status)
+	      && WEXITSTATUS (status) == 0)
 	    {
-	      AddObjectToClearPolyUndoList (type,
-					    pin->Element ? pin->Element : pin,
-					    pin, pin, false);
-	      RestoreToPolygon (PCB->Data, VIA_TYPE, LAYER_PTR (p->layer),
-				pin);
-	      AddObjectToFlagUndoList (type,
-				       pin->Element ? pin->Element : pin, pin,
-				       pin);
-	      ASSIGN_THERM (p->layer, PCB->ThermStyle, pin);
-	      AddObjectToClearPolyUndoList (type,
-					    pin->Element ? pin->Element : pin,
-					    pin, pin, true);
-	      ClearFromPolygon (PCB->Data, VIA_TYPE, LAYER_PTR (p->layer),
-				pin);
-	      changed = true;
+	      rewind (job[k].fp);
+	      job[k].finished =
+		fread (&job[k].h, sizeof (job[k].h), 1, job[k].fp) == 1;
 	    }
+	  if (job[k].finished)
+	    finished++;
+	  job[k].pid = -1;
+	  running--;
+	}
+      if (running > 0)
+	g_usleep (G_USEC_PER_SEC / 20);
+    }
+
+  for (k = 0; !cancel && k < attempts; k++)
+    if (job[k].finished
+	&& (best == NULL || job[k].h.failed < best->h.failed
+	    || (job[k].h.failed == best->h.failed
+		&& job[k].h.cost < best->h.cost)))
+      best = &job[k];
+  if (best)
+    {
+      Message (_("%d of %d routing attempts finished in %.2f s; "
+		 "attempt %d has %d failed subnets at cost %.0f.\n"),
+	       finished, attempts, g_timer_elapsed (timer, NULL),
+	       (int) (best - job) + 1, best->h.failed, best->h.cost);
+      changed = iron_attempt (best);
+    }
+  else if (!cancel)
+    Message (_("No routing attempt finished in time.\n"));
+
+  for (k = 0; k < attempts; k++)
+    if (job[k].fp)
+      fclose (job[k].fp);
+  g_free (job);
+  g_timer_destroy (timer);
+  return changed;
+}
+#endif /* HAVE_FORK */
+
+/*!
+ * \brief Munge the netlists of the route data so that only the
+ * selected rats (or all of them) get connected.
+ *
+ * Returns false if the rats nest is stale.
+ */
+static bool
+select_rat_nets (routedata_t * rd, bool selected)
+{
+  routebox_t *net, *rb, *last;
+
+  /* first, separate all sub nets into separate nets */
+  /* note that this code works because LIST_LOOP is clever enough not to
+   * be fooled when the list is changing out from under it. */
+  last = NULL;
+  LIST_LOOP (rd->first_net, different_net, net);
+  {
+    FOREACH_SUBNET (net, rb);
+    {
+      if (last)
+	{
+	  last->different_net.next = rb;
+	  rb->different_net.prev = last;
 	}
+      last = rb;
+    }
+    END_FOREACH (net, rb);
+    LIST_LOOP (net, same_net, rb);
+    {
+      rb->same_net = rb->same_subnet;
     }
     END_LOOP;
+    /* at this point all nets are equal to their subnets */
   }
   END_LOOP;
-  return changed;
+  if (last)
+    {
+      last->different_net.next = rd->first_net;
+      rd->first_net->different_net.prev = last;
+    }
+
+  /* now merge only those subnets connected by a rat line */
+  RAT_LOOP (PCB->Data);
+  if (!selected || TEST_FLAG (SELECTEDFLAG, line))
+    {
+      /* look up the end points of this rat line */
+      routebox_t *a;
+      routebox_t *b;
+      a =
+	FindRouteBoxOnLayerGroup (rd, line->Point1.X,
+				  line->Point1.Y, line->group1);
+      b =
+	FindRouteBoxOnLayerGroup (rd, line->Point2.X,
+				  line->Point2.Y, line->group2);
+      if (!a || !b)
+	{
+#ifdef DEBUG_STALE_RATS
+	  AddObjectToFlagUndoList (RATLINE_TYPE, line, line, line);
+	  ASSIGN_FLAG (SELECTEDFLAG, true, line);
+	  DrawRat (line, 0);
+#endif /* DEBUG_STALE_RATS */
+	  Message ("The rats nest is stale! Aborting autoroute...\n");
+	  return false;
+	}
+      /* merge subnets into a net! */
+      MergeNets (a, b, NET);
+    }
+  END_LOOP;
+  /* now 'different_net' may point to too many different nets.  Reset. */
+  LIST_LOOP (rd->first_net, different_net, net);
+  {
+    if (!net->flags.touched)
+      {
+	LIST_LOOP (net, same_net, rb);
+	rb->flags.touched = 1;
+	END_LOOP;
+      }
+    else			/* this is not a "different net"! */
+      RemoveFromNet (net, DIFFERENT_NET);
+  }
+  END_LOOP;
+  /* reset "touched" flag */
+  LIST_LOOP (rd->first_net, different_net, net);
+  {
+    LIST_LOOP (net, same_net, rb);
+    {
+      assert (rb->flags.touched);
+      rb->flags.touched = 0;
+    }
+    END_LOOP;
+  }
+  END_LOOP;
+  return true;
+}
+
+static bool
+route_styles_ok (void)
+{
+  int i;
+
+  for (i = 0; i < NUM_STYLES; i++)
+    {
+      if (PCB->RouteStyle[i].Thick == 0 ||
+	  PCB->RouteStyle[i].Diameter == 0 ||
+	  PCB->RouteStyle[i].Hole == 0 || PCB->RouteStyle[i].Keepaway == 0)
+	{
+	  Message ("You must define proper routing styles\n"
+		   "before auto-routing.\n");
+	  return false;
+	}
+    }
+  return true;
 }
 
 bool
 AutoRoute (bool selected)
 {
-  bool changed = false;
+  bool changed = false, ironed = false;
   routedata_t *rd;
-  int i;
 
   total_wire_length = 0;
   total_via_count = 0;
@@ -5244,24 +6606,14 @@ AutoRoute (bool selected)
     }
 #endif
 
-  for (i = 0; i < NUM_STYLES; i++)
-    {
-      if (PCB->RouteStyle[i].Thick == 0 ||
-	  PCB->RouteStyle[i].Diameter == 0 ||
-	  PCB->RouteStyle[i].Hole == 0 || PCB->RouteStyle[i].Keepaway == 0)
-	{
-	  Message ("You must define proper routing styles\n"
-		   "before auto-routing.\n");
-	  return (false);
-	}
-    }
+  if (!route_styles_ok ())
+    return (false);
   if (PCB->Data->RatN == 0)
     return (false);
   rd = CreateRouteData ();
 
   if (1)
     {
-      routebox_t *net, *rb, *last;
       int i = 0;
       /* count number of rats selected */
       RAT_LOOP (PCB->Data);
@@ -5307,91 +6659,20 @@ AutoRoute (bool selected)
 	}
       /* otherwise, munge the netlists so that only the selected rats
        * get connected. */
-      /* first, separate all sub nets into separate nets */
-      /* note that this code works because LIST_LOOP is clever enough not to
-       * be fooled when the list is changing out from under it. */
-      last = NULL;
-      LIST_LOOP (rd->first_net, different_net, net);
-      {
-	FOREACH_SUBNET (net, rb);
-	{
-	  if (last)
-	    {
-	      last->different_net.next = rb;
-	      rb->different_net.prev = last;
-	    }
-	  last = rb;
-	}
-	END_FOREACH (net, rb);
-	LIST_LOOP (net, same_net, rb);
-	{
-	  rb->same_net = rb->same_subnet;
-	}
-	END_LOOP;
-	/* at this point all nets are equal to their subnets */
-      }
-      END_LOOP;
-      if (last)
-	{
-	  last->different_net.next = rd->first_net;
-	  rd->first_net->different_net.prev = last;
-	}
-
-      /* now merge only those subnets connected by a rat line */
-      RAT_LOOP (PCB->Data);
-      if (!selected || TEST_FLAG (SELECTEDFLAG, line))
-	{
-	  /* look up the end points of this rat line */
-	  routebox_t *a;
-	  routebox_t *b;
-	  a =
-	    FindRouteBoxOnLayerGroup (rd, line->Point1.X,
-				      line->Point1.Y, line->group1);
-	  b =
-	    FindRouteBoxOnLayerGroup (rd, line->Point2.X,
-				      line->Point2.Y, line->group2);
-	  if (!a || !b)
-	    {
-#ifdef DEBUG_STALE_RATS
-	      AddObjectToFlagUndoList (RATLINE_TYPE, line, line, line);
-	      ASSIGN_FLAG (SELECTEDFLAG, true, line);
-	      DrawRat (line, 0);
-#endif /* DEBUG_STALE_RATS */
-	      Message ("The rats nest is stale! Aborting autoroute...\n");
-	      goto donerouting;
-	    }
-	  /* merge subnets into a net! */
-	  MergeNets (a, b, NET);
-	}
-      END_LOOP;
-      /* now 'different_net' may point to too many different nets.  Reset. */
-      LIST_LOOP (rd->first_net, different_net, net);
-      {
-	if (!net->flags.touched)
-	  {
-	    LIST_LOOP (net, same_net, rb);
-	    rb->flags.touched = 1;
-	    END_LOOP;
-	  }
-	else			/* this is not a "different net"! */
-	  RemoveFromNet (net, DIFFERENT_NET);
-      }
-      END_LOOP;
-      /* reset "touched" flag */
-      LIST_LOOP (rd->first_net, different_net, net);
-      {
-	LIST_LOOP (net, same_net, rb);
-	{
-	  assert (rb->flags.touched);
-	  rb->flags.touched = 0;
-	}
-	END_LOOP;
-      }
-      END_LOOP;
+      if (!select_rat_nets (rd, selected))
+	goto donerouting;
     }
   /* okay, rd's idea of netlist now corresponds to what we want routed */
   /* auto-route all nets */
-  changed = (RouteAll (rd).total_nets_routed > 0) || changed;
+#ifdef HAVE_FORK
+  if (Settings.AutorouteAttempts > 1)
+    {
+      changed = route_attempts (rd, Settings.AutorouteAttempts) || changed;
+      ironed = true;
+    }
+  else
+#endif
+    changed = (RouteAll (rd).total_nets_routed > 0) || changed;
 donerouting:
   gui->progress (0, 0, NULL);
   if (TEST_FLAG (LIVEROUTEFLAG, PCB))
@@ -5411,7 +6692,7 @@ donerouting:
     }
 #endif
 
-  if (changed)
+  if (changed && !ironed)
     changed = IronDownAllUnfixedPaths (rd);
   Message ("Total added wire length = %$mS, %d vias added\n",
 	   (Coord) total_wire_length, total_via_count);
@@ -5435,3 +6716,106 @@ donerouting:
 #endif
   return (changed);
 }
+
+/*!
+ * \brief Find the net of the route data which has the named pin.
+ */
+static routebox_t *
+find_net_by_pin (routedata_t * rd, const char *pin)
+{
+  routebox_t *net, *p;
+  char *label;
+
+  LIST_LOOP (rd->first_net, different_net, net);
+  {
+    LIST_LOOP (net, same_net, p);
+    {
+      if ((label = pin_label (p)) != NULL)
+	{
+	  bool match = strcmp (label, pin) == 0;
+	  g_free (label);
+	  if (match)
+	    return net;
+	}
+    }
+    END_LOOP;
+  }
+  END_LOOP;
+  return NULL;
+}
+
+/*!
+ * \brief Route a single net of the board, for benchmarking the router
+ * on that net alone.
+ *
+ * The net is named by one of its pins, like "U1-3".  Every run starts
+ * from route data built afresh from the board, so a board saved part
+ * way through routing replays the net in that state.  The board is
+ * never changed.
+ */
+void
+AutoRouteReplay (const char *pin, int runs)
+{
+  routedata_t *rd;
+  routebox_t *net;
+  struct routeall_status ras;
+  cost_t total_net_cost;
+  bool completely_routed, live = TEST_FLAG (LIVEROUTEFLAG, PCB);
+  double seconds = 0;
+  int run, routes = 0;
+
+  if (pin == NULL)
+    {
+      Message (_("AutoRoute(Replay) needs a pin of the net to route.\n"));
+      return;
+    }
+  if (!route_styles_ok () || PCB->Data->RatN == 0)
+    return;
+  if (runs < 1)
+    runs = 1;
+  CLEAR_FLAG (LIVEROUTEFLAG, PCB);
+  profile_start ("replay");
+  for (run = 0; run < runs; run++)
+    {
+      rd = CreateRouteData ();
+      net = select_rat_nets (rd, false) ? find_net_by_pin (rd, pin) : NULL;
+      if (net == NULL)
+	{
+	  Message (_("No net with pin %s to replay.\n"), pin);
+	  DestroyRouteData (&rd);
+	  break;
+	}
+      memset (&ras, 0, sizeof (ras));
+      total_net_cost = 0;
+      /* route_net () is what fills in net_prof, so without it there is
+       * nothing to report; every other run would find the same */
+      if (!prepare_net (rd, net, 0, &ras))
+	{
+	  Message (_("Nothing is left to route on the net with pin %s.\n"),
+		   pin);
+	  DestroyRouteData (&rd);
+	  break;
+	}
+      profile_begin_pass (run);
+      if (!route_net (rd, net, 0, &ras, &total_net_cost,
+		      &completely_routed, 0, 1))
+	{
+	  DestroyRouteData (&rd);
+	  break;
+	}
+      profile_end_pass (&ras, total_net_cost, net_prof.seconds);
+      Message (_("Replay %d: %d of %d subnets of %s routed in %.3f s, "
+		 "%ld edges expanded.\n"), run + 1, ras.routed_subnets,
+	       ras.total_subnets, pin, net_prof.seconds, net_prof.edges);
+      seconds += net_prof.seconds;
+      routes += ras.routes_found;
+      DestroyRouteData (&rd);
+    }
+  gui->progress (0, 0, NULL);
+  if (profile)
+    g_string_append_printf (profile, "\n  ],\n  \"seconds\": %.6f, "
+			    "\"routes\": %d", seconds, routes);
+  profile_finish (run == runs);
+  if (live)
+    SET_FLAG (LIVEROUTEFLAG, PCB);
+}
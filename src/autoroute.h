@@ -40,5 +40,6 @@
 #include "global.h"
 
 bool AutoRoute (bool);
+void AutoRouteReplay (const char *, int);
 
 #endif
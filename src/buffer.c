@@ -227,9 +227,9 @@ MoveViaToBuffer (PinType *via)
   RestoreToPolygon (Source, VIA_TYPE, via, via);
 
   r_delete_entry (Source->via_tree, (BoxType *) via);
-  Source->Via = g_list_remove (Source->Via, via);
+  RemoveObjectFromList (&Source->Via, via);
   Source->ViaN --;
-  Dest->Via = g_list_append (Dest->Via, via);
+  AddObjectToList (&Dest->Via, via);
   Dest->ViaN ++;
 
   CLEAR_FLAG (WARNFLAG | NOCOPY_FLAGS, via);
@@ -249,9 +249,9 @@ MoveRatToBuffer (RatType *rat)
 {
   r_delete_entry (Source->rat_tree, (BoxType *)rat);
 
-  Source->Rat = g_list_remove (Source->Rat, rat);
+  RemoveObjectFromList (&Source->Rat, rat);
   Source->RatN --;
-  Dest->Rat = g_list_append (Dest->Rat, rat);
+  AddObjectToList (&Dest->Rat, rat);
   Dest->RatN ++;
 
   CLEAR_FLAG (NOCOPY_FLAGS, rat);
@@ -273,9 +273,9 @@ MoveLineToBuffer (LayerType *layer, LineType *line)
   RestoreToPolygon (Source, LINE_TYPE, layer, line);
   r_delete_entry (layer->line_tree, (BoxType *)line);
 
-  layer->Line = g_list_remove (layer->Line, line);
+  RemoveObjectFromList (&layer->Line, line);
   layer->LineN --;
-  lay->Line = g_list_append (lay->Line, line);
+  AddObjectToList (&lay->Line, line);
   lay->LineN ++;
 
   CLEAR_FLAG (NOCOPY_FLAGS, line);
@@ -298,9 +298,9 @@ MoveArcToBuffer (LayerType *layer, ArcType *arc)
   RestoreToPolygon (Source, ARC_TYPE, layer, arc);
   r_delete_entry (layer->arc_tree, (BoxType *)arc);
 
-  layer->Arc = g_list_remove (layer->Arc, arc);
+  RemoveObjectFromList (&layer->Arc, arc);
   layer->ArcN --;
-  lay->Arc = g_list_append (lay->Arc, arc);
+  AddObjectToList (&lay->Arc, arc);
   lay->ArcN ++;
 
   CLEAR_FLAG (NOCOPY_FLAGS, arc);
@@ -323,9 +323,9 @@ MoveTextToBuffer (LayerType *layer, TextType *text)
   r_delete_entry (layer->text_tree, (BoxType *)text);
   RestoreToPolygon (Source, TEXT_TYPE, layer, text);
 
-  layer->Text = g_list_remove (layer->Text, text);
+  RemoveObjectFromList (&layer->Text, text);
   layer->TextN --;
-  lay->Text = g_list_append (lay->Text, text);
+  AddObjectToList (&lay->Text, text);
   lay->TextN ++;
 
   if (!lay->text_tree)
@@ -347,9 +347,9 @@ MovePolygonToBuffer (LayerType *layer, PolygonType *polygon)
 
   r_delete_entry (layer->polygon_tree, (BoxType *)polygon);
 
-  layer->Polygon = g_list_remove (layer->Polygon, polygon);
+  RemoveObjectFromList (&layer->Polygon, polygon);
   layer->PolygonN --;
-  lay->Polygon = g_list_append (lay->Polygon, polygon);
+  AddObjectToList (&lay->Polygon, polygon);
   lay->PolygonN ++;
 
   CLEAR_FLAG (NOCOPY_FLAGS, polygon);
@@ -373,9 +373,9 @@ MoveElementToBuffer (ElementType *element)
    */
   r_delete_element (Source, element);
 
-  Source->Element = g_list_remove (Source->Element, element);
+  RemoveObjectFromList (&Source->Element, element);
   Source->ElementN --;
-  Dest->Element = g_list_append (Dest->Element, element);
+  AddObjectToList (&Dest->Element, element);
   Dest->ElementN ++;
 
   PIN_LOOP (element);
@@ -430,6 +430,7 @@ ClearBuffer (BufferType *Buffer)
     {
       FreeDataMemory (Buffer->Data);
       Buffer->Data->pcb = PCB;
+      crosshair_outlines_changed ();
     }
 }
 
@@ -462,6 +463,7 @@ AddSelectedToBuffer (BufferType *Buffer, Coord X, Coord Y, bool LeaveSelected)
       Buffer->X = Crosshair.X;
       Buffer->Y = Crosshair.Y;
     }
+  crosshair_outlines_changed ();
   notify_crosshair_change (true);
   ExtraFlag = 0;
 }
@@ -489,7 +491,7 @@ LoadElementToBuffer (BufferType *Buffer, char *Name, bool FromFile)
 	  SetBufferBoundingBox (Buffer);
 	  if (Buffer->Data->ElementN)
 	    {
-	      element = Buffer->Data->Element->data;
+	      element = (ElementType *) FirstObjectInList (&Buffer->Data->Element);
 	      Buffer->X = element->MarkX;
 	      Buffer->Y = element->MarkY;
 	    }
@@ -498,6 +500,7 @@ LoadElementToBuffer (BufferType *Buffer, char *Name, bool FromFile)
 	      Buffer->X = 0;
 	      Buffer->Y = 0;
 	    }
+	  crosshair_outlines_changed ();
 	  return (true);
 	}
     }
@@ -506,7 +509,7 @@ LoadElementToBuffer (BufferType *Buffer, char *Name, bool FromFile)
       if (!ParseLibraryEntry (Buffer->Data, Name)
 	  && Buffer->Data->ElementN != 0)
 	{
-	  element = Buffer->Data->Element->data;
+	  element = (ElementType *) FirstObjectInList (&Buffer->Data->Element);
 
 	  /* always add elements using top-side coordinates */
 	  if (Settings.ShowBottomSide)
@@ -517,6 +520,7 @@ LoadElementToBuffer (BufferType *Buffer, char *Name, bool FromFile)
 	  Buffer->X = element->MarkX;
 	  Buffer->Y = element->MarkY;
 	  SetBufferBoundingBox (Buffer);
+	  crosshair_outlines_changed ();
 	  return (true);
 	}
     }
@@ -833,7 +837,7 @@ LoadFootprint (int argc, char **argv, Coord x, Coord y)
       return 1;
     }
 
-  e = PASTEBUFFER->Data->Element->data;
+  e = (ElementType *) FirstObjectInList (&PASTEBUFFER->Data->Element);
 
   if (e->Name[0].TextString)
     free (e->Name[0].TextString);
@@ -874,8 +878,8 @@ SmashBufferElement (BufferType *Buffer)
    * around for us to smash bits off it.  It then becomes our responsibility,
    * however, to free the single element when we're finished with it.
    */
-  element = Buffer->Data->Element->data;
-  Buffer->Data->Element = NULL;
+  element = (ElementType *) FirstObjectInList (&Buffer->Data->Element);
+  RemoveObjectFromList (&Buffer->Data->Element, element);
   Buffer->Data->ElementN = 0;
   ClearBuffer (Buffer);
   ELEMENTLINE_LOOP (element);
@@ -924,6 +928,7 @@ SmashBufferElement (BufferType *Buffer)
   END_LOOP;
   FreeElementMemory (element);
   g_slice_free (ElementType, element);
+  crosshair_outlines_changed ();
   return (true);
 }
 
@@ -1154,6 +1159,7 @@ LoadLayoutToBuffer (BufferType *Buffer, char *Filename)
       Buffer->Y = newPCB->CursorY;
       RemovePCB (newPCB);
       Buffer->Data->pcb = PCB;
+      crosshair_outlines_changed ();
       return (true);
     }
 
@@ -1220,6 +1226,7 @@ RotateBuffer (BufferType *Buffer, BYTE Number)
   /* finally the origin and the bounding box */
   ROTATE (Buffer->X, Buffer->Y, Buffer->X, Buffer->Y, Number);
   RotateBoxLowLevel (&Buffer->BoundingBox, Buffer->X, Buffer->Y, Number);
+  crosshair_outlines_changed ();
   crosshair_update_range();
 }
 
@@ -1355,6 +1362,7 @@ FreeRotateBuffer (BufferType *Buffer, Angle angle)
   ENDALL_LOOP;
 
   SetBufferBoundingBox (Buffer);
+  crosshair_outlines_changed ();
   crosshair_update_range();
 }
 
@@ -1413,6 +1421,7 @@ UninitBuffers (void)
     {
       ClearBuffer (Buffers+i);
       free (Buffers[i].Data);
+      Buffers[i].Data = NULL;
     }
 }
 
@@ -1487,6 +1496,7 @@ MirrorBuffer (BufferType *Buffer)
   }
   ENDALL_LOOP;
   SetBufferBoundingBox (Buffer);
+  crosshair_outlines_changed ();
   crosshair_update_range();
 }
 
@@ -1614,6 +1624,7 @@ SwapBuffer (BufferType *Buffer)
 	}
     }
   SetBufferBoundingBox (Buffer);
+  crosshair_outlines_changed ();
   crosshair_update_range();
 }
 
@@ -1628,6 +1639,7 @@ MoveObjectToBuffer (DataType *Destination, DataType *Src,
   /* setup local identifiers used by move operations */
   Dest = Destination;
   Source = Src;
+  crosshair_outlines_changed ();
   return (ObjectOperation (&MoveBufferFunctions, Type, Ptr1, Ptr2, Ptr3));
 }
 
@@ -1641,6 +1653,7 @@ CopyObjectToBuffer (DataType *Destination, DataType *Src,
   /* setup local identifiers used by Add operations */
   Dest = Destination;
   Source = Src;
+  crosshair_outlines_changed ();
   return (ObjectOperation (&AddBufferFunctions, Type, Ptr1, Ptr2, Ptr3));
 }
 
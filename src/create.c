@@ -775,7 +775,7 @@ CreateNewArcInElement (ElementType *Element,
   ArcType *arc;
 
   arc = g_slice_new0 (ArcType);
-  Element->Arc = g_list_append (Element->Arc, arc);
+  AddObjectToList (&Element->Arc, arc);
   Element->ArcN ++;
 
   /* set Delta (0,360], StartAngle in [0,360) */
@@ -816,7 +816,7 @@ CreateNewLineInElement (ElementType *Element,
     return NULL;
 
   line = g_slice_new0 (LineType);
-  Element->Line = g_list_append (Element->Line, line);
+  AddObjectToList (&Element->Line, line);
   Element->LineN ++;
 
   /* copy values */
@@ -49,8 +49,10 @@
 #include "line.h"
 #include "misc.h"
 #include "mymem.h"
+#include "pcb-printf.h"
 #include "search.h"
 #include "polygon.h"
+#include "rtree.h"
 
 #ifdef HAVE_LIBDMALLOC
 #include <dmalloc.h>
@@ -236,118 +238,257 @@ XORDrawAttachedLine (hidGC gc, Coord x1, Coord y1, Coord x2, Coord y2, Coord thi
     }
 }
 
+/* XOR preview outlines
+ *
+ * While an element or the paste buffer follows the crosshair, its
+ * outline is XOR drawn twice per motion event, once to erase it and
+ * once at its new place.  Walking thousands of objects for that makes
+ * dragging choppy, so the outline is collected once into an array of
+ * drawing primitives relative to the object's own coordinates, and
+ * each move just replays the array with an offset.  Past
+ * XOR_PREVIEW_MAX_PRIMS primitives, only the bounding box and the
+ * convex hull are drawn.
+ *
+ * An outline is rebuilt when its source changes, which shows in the
+ * r-tree modification count, or when the visibility settings that
+ * decide what is drawn do.
+ */
+
+#define XOR_PREVIEW_MAX_PRIMS 2000
+
+typedef enum
+{
+  XOR_LINE,
+  XOR_ARC,
+  XOR_RECT,
+  XOR_PV,
+  XOR_PAD
+} xor_prim_type;
+
+typedef struct
+{
+  xor_prim_type type;
+  union
+  {
+    struct { Coord x1, y1, x2, y2; } line; /*!< also used by XOR_RECT */
+    struct { Coord x, y, width, height; Angle start, delta; } arc;
+    PinType pv;
+    PadType pad;
+  } u;
+} xor_prim;
+
+typedef struct
+{
+  bool layer_on[MAX_ALL_LAYER];
+  bool pin_on, element_on, via_on;
+  bool invisible_on, bottom_side;
+} xor_view;
+
+typedef struct
+{
+  const void *source;
+  guint rtree_count;
+  guint serial;    /*!< outline_serial when it was built */
+  xor_view view;
+  GArray *prims;   /*!< xor_prim */
+  GArray *points;  /*!< PointType, corners of every primitive */
+  GArray *hull;    /*!< PointType, convex hull of points */
+  BoxType box;
+} xor_outline;
+
+static xor_outline element_outline;
+static xor_outline buffer_outline;
+
+/* bumped by changes the r-tree count doesn't see, see
+ * crosshair_outlines_changed ().
+ */
+static guint outline_serial = 0;
+
+static void
+get_xor_view (xor_view *view)
+{
+  int i;
+
+  /* Zeroed as a whole, so views compare with memcmp */
+  memset (view, 0, sizeof (*view));
+  for (i = 0; i < max_copper_layer + SILK_LAYER; i++)
+    view->layer_on[i] = PCB->Data->Layer[i].On;
+  view->pin_on = PCB->PinOn;
+  view->element_on = PCB->ElementOn;
+  view->via_on = PCB->ViaOn;
+  view->invisible_on = PCB->InvisibleObjectsOn;
+  view->bottom_side = Settings.ShowBottomSide;
+}
+
+static void
+outline_add_corners (xor_outline *outline,
+                     Coord x1, Coord y1, Coord x2, Coord y2)
+{
+  PointType pt;
+
+  pt.X = x1; pt.Y = y1; g_array_append_val (outline->points, pt);
+  pt.X = x2;            g_array_append_val (outline->points, pt);
+  pt.Y = y2;            g_array_append_val (outline->points, pt);
+  pt.X = x1;            g_array_append_val (outline->points, pt);
+
+  outline->box.X1 = MIN (outline->box.X1, MIN (x1, x2));
+  outline->box.Y1 = MIN (outline->box.Y1, MIN (y1, y2));
+  outline->box.X2 = MAX (outline->box.X2, MAX (x1, x2));
+  outline->box.Y2 = MAX (outline->box.Y2, MAX (y1, y2));
+}
+
+static void
+outline_add_line (xor_outline *outline, Coord x1, Coord y1, Coord x2, Coord y2)
+{
+  xor_prim prim;
+
+  prim.type = XOR_LINE;
+  prim.u.line.x1 = x1;
+  prim.u.line.y1 = y1;
+  prim.u.line.x2 = x2;
+  prim.u.line.y2 = y2;
+  g_array_append_val (outline->prims, prim);
+  outline_add_corners (outline, x1, y1, x2, y2);
+}
+
+static void
+outline_add_rect (xor_outline *outline, const BoxType *box)
+{
+  xor_prim prim;
+
+  prim.type = XOR_RECT;
+  prim.u.line.x1 = box->X1;
+  prim.u.line.y1 = box->Y1;
+  prim.u.line.x2 = box->X2;
+  prim.u.line.y2 = box->Y2;
+  g_array_append_val (outline->prims, prim);
+  outline_add_corners (outline, box->X1, box->Y1, box->X2, box->Y2);
+}
+
+static void
+outline_add_arc (xor_outline *outline, ArcType *arc)
+{
+  xor_prim prim;
+
+  prim.type = XOR_ARC;
+  prim.u.arc.x = arc->X;
+  prim.u.arc.y = arc->Y;
+  prim.u.arc.width = arc->Width;
+  prim.u.arc.height = arc->Height;
+  prim.u.arc.start = arc->StartAngle;
+  prim.u.arc.delta = arc->Delta;
+  g_array_append_val (outline->prims, prim);
+  outline_add_corners (outline, arc->X - arc->Width, arc->Y - arc->Height,
+                       arc->X + arc->Width, arc->Y + arc->Height);
+}
+
+static void
+outline_add_pv (xor_outline *outline, PinType *pv)
+{
+  xor_prim prim;
+  Coord r = pv->Thickness / 2;
+
+  prim.type = XOR_PV;
+  prim.u.pv = *pv;
+  g_array_append_val (outline->prims, prim);
+  outline_add_corners (outline, pv->X - r, pv->Y - r, pv->X + r, pv->Y + r);
+}
+
+static void
+outline_add_pad (xor_outline *outline, PadType *pad)
+{
+  xor_prim prim;
+  Coord r = pad->Thickness / 2;
+
+  prim.type = XOR_PAD;
+  prim.u.pad = *pad;
+  g_array_append_val (outline->prims, prim);
+  outline_add_corners (outline,
+                       MIN (pad->Point1.X, pad->Point2.X) - r,
+                       MIN (pad->Point1.Y, pad->Point2.Y) - r,
+                       MAX (pad->Point1.X, pad->Point2.X) + r,
+                       MAX (pad->Point1.Y, pad->Point2.Y) + r);
+}
+
 /*!
- * \brief Draws the elements of a loaded circuit which is to be merged
- * in.
+ * \brief Same contour lines as XORPolygon () without a dashed one.
  */
 static void
-XORDrawElement (hidGC gc, ElementType *Element, Coord DX, Coord DY)
+outline_add_polygon (xor_outline *outline, PolygonType *polygon)
 {
-  /* if no silkscreen, draw the bounding box */
-  if (Element->ArcN == 0 && Element->LineN == 0)
+  Cardinal i;
+
+  for (i = 0; i < polygon->PointN; i++)
     {
-      gui->graphics->draw_line (gc,
-                                DX + Element->BoundingBox.X1,
-                                DY + Element->BoundingBox.Y1,
-                                DX + Element->BoundingBox.X1,
-                                DY + Element->BoundingBox.Y2);
-      gui->graphics->draw_line (gc,
-                                DX + Element->BoundingBox.X1,
-                                DY + Element->BoundingBox.Y2,
-                                DX + Element->BoundingBox.X2,
-                                DY + Element->BoundingBox.Y2);
-      gui->graphics->draw_line (gc,
-                                DX + Element->BoundingBox.X2,
-                                DY + Element->BoundingBox.Y2,
-                                DX + Element->BoundingBox.X2,
-                                DY + Element->BoundingBox.Y1);
-      gui->graphics->draw_line (gc,
-                                DX + Element->BoundingBox.X2,
-                                DY + Element->BoundingBox.Y1,
-                                DX + Element->BoundingBox.X1,
-                                DY + Element->BoundingBox.Y1);
+      Cardinal next = next_contour_point (polygon, i);
+
+      if (next == 0 && i == 1)
+        continue;
+
+      outline_add_line (outline,
+                        polygon->Points[i].X, polygon->Points[i].Y,
+                        polygon->Points[next].X, polygon->Points[next].Y);
     }
+}
+
+/*!
+ * \brief Collect the outline of an element.
+ */
+static void
+outline_add_element (xor_outline *outline, ElementType *Element)
+{
+  /* if no silkscreen, draw the bounding box */
+  if (Element->ArcN == 0 && Element->LineN == 0)
+    outline_add_rect (outline, &Element->BoundingBox);
   else
     {
       ELEMENTLINE_LOOP (Element);
       {
-        gui->graphics->draw_line (gc,
-                                  DX + line->Point1.X,
-                                  DY + line->Point1.Y,
-                                  DX + line->Point2.X,
-                                  DY + line->Point2.Y);
+        outline_add_line (outline, line->Point1.X, line->Point1.Y,
+                          line->Point2.X, line->Point2.Y);
       }
       END_LOOP;
 
-      /* arc coordinates and angles have to be converted to X11 notation */
       ARC_LOOP (Element);
       {
-        gui->graphics->draw_arc (gc,
-                                 DX + arc->X,
-                                 DY + arc->Y,
-                                 arc->Width, arc->Height, arc->StartAngle, arc->Delta);
+        outline_add_arc (outline, arc);
       }
       END_LOOP;
     }
-  /* pin coordinates and angles have to be converted to X11 notation */
+
   PIN_LOOP (Element);
   {
-    thindraw_moved_pv (gc, pin, DX, DY);
+    outline_add_pv (outline, pin);
   }
   END_LOOP;
 
-  /* pads */
   PAD_LOOP (Element);
   {
     if (PCB->InvisibleObjectsOn ||
         (TEST_FLAG (ONSOLDERFLAG, pad) != 0) == Settings.ShowBottomSide)
-      {
-        /* Make a copy of the pad structure, moved to the correct position */
-        PadType moved_pad = *pad;
-        moved_pad.Point1.X += DX; moved_pad.Point1.Y += DY;
-        moved_pad.Point2.X += DX; moved_pad.Point2.Y += DY;
-
-        gui->graphics->thindraw_pcb_pad (gc, &moved_pad, false, false);
-      }
+      outline_add_pad (outline, pad);
   }
   END_LOOP;
+
   /* mark */
-  gui->graphics->draw_line (gc,
-                            Element->MarkX + DX - EMARK_SIZE,
-                            Element->MarkY + DY,
-                            Element->MarkX + DX,
-                            Element->MarkY + DY - EMARK_SIZE);
-  gui->graphics->draw_line (gc,
-                            Element->MarkX + DX + EMARK_SIZE,
-                            Element->MarkY + DY,
-                            Element->MarkX + DX,
-                            Element->MarkY + DY - EMARK_SIZE);
-  gui->graphics->draw_line (gc,
-                            Element->MarkX + DX - EMARK_SIZE,
-                            Element->MarkY + DY,
-                            Element->MarkX + DX,
-                            Element->MarkY + DY + EMARK_SIZE);
-  gui->graphics->draw_line (gc,
-                            Element->MarkX + DX + EMARK_SIZE,
-                            Element->MarkY + DY,
-                            Element->MarkX + DX,
-                            Element->MarkY + DY + EMARK_SIZE);
+  outline_add_line (outline, Element->MarkX - EMARK_SIZE, Element->MarkY,
+                    Element->MarkX, Element->MarkY - EMARK_SIZE);
+  outline_add_line (outline, Element->MarkX + EMARK_SIZE, Element->MarkY,
+                    Element->MarkX, Element->MarkY - EMARK_SIZE);
+  outline_add_line (outline, Element->MarkX - EMARK_SIZE, Element->MarkY,
+                    Element->MarkX, Element->MarkY + EMARK_SIZE);
+  outline_add_line (outline, Element->MarkX + EMARK_SIZE, Element->MarkY,
+                    Element->MarkX, Element->MarkY + EMARK_SIZE);
 }
 
 /*!
- * \brief Draws all visible and attached objects of the pastebuffer.
+ * \brief Collect the visible objects of a paste buffer.
  */
 static void
-XORDrawBuffer (hidGC gc, BufferType *Buffer)
+outline_add_buffer (xor_outline *outline, BufferType *Buffer)
 {
   Cardinal i;
-  Coord x, y;
-
-  /* set offset */
-  x = Crosshair.X - Buffer->X;
-  y = Crosshair.Y - Buffer->Y;
 
-  /* draw all visible layers */
   for (i = 0; i < max_copper_layer + SILK_LAYER; i++)
     if (PCB->Data->Layer[i].On)
       {
@@ -355,60 +496,275 @@ XORDrawBuffer (hidGC gc, BufferType *Buffer)
 
 	LINE_LOOP (layer);
 	{
-/*
-				XORDrawAttachedLine(x +line->Point1.X,
-					y +line->Point1.Y, x +line->Point2.X,
-					y +line->Point2.Y, line->Thickness);
-*/
-	gui->graphics->draw_line (gc,
-	                          x + line->Point1.X, y + line->Point1.Y,
-	                          x + line->Point2.X, y + line->Point2.Y);
+	  outline_add_line (outline, line->Point1.X, line->Point1.Y,
+	                    line->Point2.X, line->Point2.Y);
 	}
 	END_LOOP;
 	ARC_LOOP (layer);
 	{
-	  gui->graphics->draw_arc (gc,
-	                           x + arc->X,
-	                           y + arc->Y,
-	                           arc->Width,
-	                           arc->Height, arc->StartAngle, arc->Delta);
+	  outline_add_arc (outline, arc);
 	}
 	END_LOOP;
 	TEXT_LOOP (layer);
 	{
-	  BoxType *box = &text->BoundingBox;
-	  gui->graphics->draw_rect (gc,
-	                            x + box->X1, y + box->Y1, x + box->X2, y + box->Y2);
+	  outline_add_rect (outline, &text->BoundingBox);
 	}
 	END_LOOP;
-	/* the tmp polygon has n+1 points because the first
-	 * and the last one are set to the same coordinates
-	 */
 	POLYGON_LOOP (layer);
 	{
-	  XORPolygon (gc, polygon, x, y, 0);
+	  outline_add_polygon (outline, polygon);
 	}
 	END_LOOP;
       }
 
-  /* draw elements if visible */
   if (PCB->PinOn && PCB->ElementOn)
     ELEMENT_LOOP (Buffer->Data);
   {
     if (FRONT (element) || PCB->InvisibleObjectsOn)
-      XORDrawElement (gc, element, x, y);
+      outline_add_element (outline, element);
   }
   END_LOOP;
 
-  /* and the vias */
   if (PCB->ViaOn)
     VIA_LOOP (Buffer->Data);
   {
-    thindraw_moved_pv (gc, via, x, y);
+    outline_add_pv (outline, via);
   }
   END_LOOP;
 }
 
+static double
+hull_cross (const PointType *o, const PointType *a, const PointType *b)
+{
+  return (double)(a->X - o->X) * (double)(b->Y - o->Y) -
+         (double)(a->Y - o->Y) * (double)(b->X - o->X);
+}
+
+static int
+point_compare (const void *a, const void *b)
+{
+  const PointType *pa = a, *pb = b;
+
+  if (pa->X != pb->X)
+    return pa->X < pb->X ? -1 : 1;
+  if (pa->Y != pb->Y)
+    return pa->Y < pb->Y ? -1 : 1;
+  return 0;
+}
+
+/*!
+ * \brief Convex hull of the outline's corner points, by Andrew's
+ * monotone chain.
+ */
+static void
+outline_compute_hull (xor_outline *outline)
+{
+  PointType *pts = (PointType *)outline->points->data;
+  int n = outline->points->len;
+  PointType *hull;
+  int i, k = 0, lower;
+
+  g_array_set_size (outline->hull, 2 * n);
+  if (n < 3)
+    {
+      g_array_set_size (outline->hull, 0);
+      return;
+    }
+
+  hull = (PointType *)outline->hull->data;
+  qsort (pts, n, sizeof (PointType), point_compare);
+
+  for (i = 0; i < n; i++)
+    {
+      while (k >= 2 && hull_cross (&hull[k - 2], &hull[k - 1], &pts[i]) <= 0)
+        k--;
+      hull[k++] = pts[i];
+    }
+  for (i = n - 2, lower = k + 1; i >= 0; i--)
+    {
+      while (k >= lower && hull_cross (&hull[k - 2], &hull[k - 1], &pts[i]) <= 0)
+        k--;
+      hull[k++] = pts[i];
+    }
+
+  /* The last point repeats the first one */
+  g_array_set_size (outline->hull, k);
+}
+
+/*!
+ * \brief Make sure the outline describes a source in the current view.
+ *
+ * \return true if the outline has to be built again.
+ */
+static bool
+outline_reset (xor_outline *outline, const void *source)
+{
+  xor_view view;
+
+  get_xor_view (&view);
+
+  if (outline->prims != NULL &&
+      outline->source == source &&
+      outline->rtree_count == r_modification_count () &&
+      outline->serial == outline_serial &&
+      memcmp (&outline->view, &view, sizeof (view)) == 0)
+    return false;
+
+  if (outline->prims == NULL)
+    {
+      outline->prims = g_array_new (FALSE, FALSE, sizeof (xor_prim));
+      outline->points = g_array_new (FALSE, FALSE, sizeof (PointType));
+      outline->hull = g_array_new (FALSE, FALSE, sizeof (PointType));
+    }
+
+  g_array_set_size (outline->prims, 0);
+  g_array_set_size (outline->points, 0);
+  g_array_set_size (outline->hull, 0);
+  outline->box.X1 = outline->box.Y1 = G_MAXINT;
+  outline->box.X2 = outline->box.Y2 = -G_MAXINT;
+  outline->source = source;
+  outline->rtree_count = r_modification_count ();
+  outline->serial = outline_serial;
+  outline->view = view;
+
+  return true;
+}
+
+/*!
+ * \brief Note that the paste buffer or an element changed in place.
+ *
+ * The outlines notice anything that goes through the r-trees by
+ * themselves, but objects can also be moved without leaving their tree,
+ * as MirrorBuffer () does with lines and vias.  Whatever changes the
+ * buffer or an element that way calls this, and the previews are built
+ * again the next time they are drawn.
+ */
+void
+crosshair_outlines_changed (void)
+{
+  outline_serial++;
+}
+
+static void
+outline_finish (xor_outline *outline)
+{
+  if (outline->prims->len > XOR_PREVIEW_MAX_PRIMS)
+    outline_compute_hull (outline);
+
+  /* Only needed for the hull */
+  g_array_set_size (outline->points, 0);
+}
+
+/*!
+ * \brief XOR draw an outline moved by dx, dy.
+ */
+static void
+draw_outline (hidGC gc, xor_outline *outline, Coord dx, Coord dy)
+{
+  guint i;
+
+  if (outline->prims->len == 0)
+    return;
+
+  if (outline->prims->len > XOR_PREVIEW_MAX_PRIMS)
+    {
+      PointType *hull = (PointType *)outline->hull->data;
+
+      gui->graphics->draw_rect (gc,
+                                outline->box.X1 + dx, outline->box.Y1 + dy,
+                                outline->box.X2 + dx, outline->box.Y2 + dy);
+      for (i = 1; i < outline->hull->len; i++)
+        gui->graphics->draw_line (gc,
+                                  hull[i - 1].X + dx, hull[i - 1].Y + dy,
+                                  hull[i].X + dx, hull[i].Y + dy);
+      return;
+    }
+
+  for (i = 0; i < outline->prims->len; i++)
+    {
+      xor_prim *prim = &g_array_index (outline->prims, xor_prim, i);
+
+      switch (prim->type)
+        {
+        case XOR_LINE:
+          gui->graphics->draw_line (gc,
+                                    prim->u.line.x1 + dx, prim->u.line.y1 + dy,
+                                    prim->u.line.x2 + dx, prim->u.line.y2 + dy);
+          break;
+
+        case XOR_RECT:
+          gui->graphics->draw_rect (gc,
+                                    prim->u.line.x1 + dx, prim->u.line.y1 + dy,
+                                    prim->u.line.x2 + dx, prim->u.line.y2 + dy);
+          break;
+
+        case XOR_ARC:
+          gui->graphics->draw_arc (gc,
+                                   prim->u.arc.x + dx, prim->u.arc.y + dy,
+                                   prim->u.arc.width, prim->u.arc.height,
+                                   prim->u.arc.start, prim->u.arc.delta);
+          break;
+
+        case XOR_PV:
+          thindraw_moved_pv (gc, &prim->u.pv, dx, dy);
+          break;
+
+        case XOR_PAD:
+          {
+            /* Make a copy of the pad structure, moved to the correct position */
+            PadType moved_pad = prim->u.pad;
+            moved_pad.Point1.X += dx; moved_pad.Point1.Y += dy;
+            moved_pad.Point2.X += dx; moved_pad.Point2.Y += dy;
+
+            gui->graphics->thindraw_pcb_pad (gc, &moved_pad, false, false);
+            break;
+          }
+        }
+    }
+}
+
+/*!
+ * \brief Make the buffer outline describe the current buffer contents.
+ */
+static void
+buffer_outline_update (BufferType *Buffer)
+{
+  if (outline_reset (&buffer_outline, Buffer->Data))
+    {
+      outline_add_buffer (&buffer_outline, Buffer);
+      outline_finish (&buffer_outline);
+    }
+}
+
+/*!
+ * \brief Draws the elements of a loaded circuit which is to be merged
+ * in.
+ */
+static void
+XORDrawElement (hidGC gc, ElementType *Element, Coord DX, Coord DY)
+{
+  if (outline_reset (&element_outline, Element))
+    {
+      outline_add_element (&element_outline, Element);
+      outline_finish (&element_outline);
+    }
+
+  draw_outline (gc, &element_outline, DX, DY);
+}
+
+/*!
+ * \brief Draws all visible and attached objects of the pastebuffer.
+ */
+static void
+XORDrawBuffer (hidGC gc, BufferType *Buffer)
+{
+  buffer_outline_update (Buffer);
+
+  /* set offset */
+  draw_outline (gc, &buffer_outline,
+                Crosshair.X - Buffer->X, Crosshair.Y - Buffer->Y);
+}
+
 /*!
  * \brief Draws the rubberband to insert points into polygons/lines/...
  */
@@ -897,8 +1253,178 @@ check_snap_object (struct snap_data *snap_data, Coord x, Coord y,
     }
 }
 
+/* Snap target cache
+ *
+ * Most pointer motion happens away from anything the crosshair could
+ * snap to, yet FitCrosshairIntoGrid () runs a handful of searches for
+ * every event.  The board is divided into grid sized cells, and for
+ * each cell visited we remember which kinds of object lie close enough
+ * to be found by a search from inside it.  Searches for kinds absent
+ * from the crosshair's cell are skipped, the others run as before, so
+ * the snapping itself is unchanged.  The cache is emptied whenever an
+ * r-tree changes, and when the board or the grid does.
+ */
+
+#define SNAP_CACHE_SIZE 4096 /* must be a power of two */
+
+struct snap_cell {
+  long ix, iy;
+  unsigned int types;
+  bool valid;
+};
+
+static struct snap_cell snap_cache[SNAP_CACHE_SIZE];
+static PCBType *snap_cache_pcb = NULL;
+static Coord snap_cache_grid = 0;
+static guint snap_cache_rtree_count = 0;
+
+static struct {
+  unsigned long events;
+  unsigned long searches;
+  unsigned long skipped;
+  unsigned long cell_hits;
+  unsigned long cell_misses;
+  double time_total;
+  double time_max;
+} snap_stats;
+
+static GTimer *snap_timer = NULL;
+
+static bool
+tree_has_objects_in (rtree_t *tree, const BoxType *region)
+{
+  return tree != NULL && !r_region_is_empty (tree, region);
+}
+
+/*!
+ * \brief Find the kinds of snap target a search from a cell can find.
+ *
+ * Every object a search with radius PCB->Grid / 2 can find has its
+ * bounding box within that distance of the search point, so looking
+ * for bounding boxes near the cell gives a superset.
+ */
+static unsigned int
+compute_cell_types (long ix, long iy, Coord cell_size)
+{
+  DataType *data = PCB->Data;
+  unsigned int types = NO_TYPE;
+  BoxType region;
+  Coord bloat = PCB->Grid / 2 + 1;
+  int i;
+
+  region.X1 = ix * cell_size - bloat;
+  region.Y1 = iy * cell_size - bloat;
+  region.X2 = (ix + 1) * cell_size + bloat;
+  region.Y2 = (iy + 1) * cell_size + bloat;
+
+  if (tree_has_objects_in (data->element_tree, &region))
+    types |= ELEMENT_TYPE;
+  if (tree_has_objects_in (data->pad_tree, &region))
+    types |= PAD_TYPE;
+  if (tree_has_objects_in (data->pin_tree, &region))
+    types |= PIN_TYPE;
+  if (tree_has_objects_in (data->via_tree, &region))
+    types |= VIA_TYPE;
+
+  for (i = 0; i < max_copper_layer + SILK_LAYER; i++)
+    {
+      LayerType *layer = &data->Layer[i];
+
+      if (tree_has_objects_in (layer->line_tree, &region))
+        types |= LINE_TYPE | LINEPOINT_TYPE;
+      if (tree_has_objects_in (layer->arc_tree, &region))
+        types |= ARCPOINT_TYPE;
+      if (tree_has_objects_in (layer->polygon_tree, &region))
+        types |= POLYGONPOINT_TYPE;
+    }
+
+  return types;
+}
+
+/*!
+ * \brief Kinds of snap target near a location, see compute_cell_types ().
+ */
+static unsigned int
+snap_cell_types (Coord x, Coord y)
+{
+  Coord cell_size = MAX (PCB->Grid, MIL_TO_COORD (1));
+  struct snap_cell *cell;
+  long ix, iy;
+  int i;
+
+  if (snap_cache_pcb != PCB || snap_cache_grid != PCB->Grid ||
+      snap_cache_rtree_count != r_modification_count ())
+    {
+      for (i = 0; i < SNAP_CACHE_SIZE; i++)
+        snap_cache[i].valid = false;
+      snap_cache_pcb = PCB;
+      snap_cache_grid = PCB->Grid;
+      snap_cache_rtree_count = r_modification_count ();
+    }
+
+  ix = (long)floor ((double)x / cell_size);
+  iy = (long)floor ((double)y / cell_size);
+  cell = &snap_cache[(ix * 73856093L ^ iy * 19349663L) & (SNAP_CACHE_SIZE - 1)];
+
+  if (cell->valid && cell->ix == ix && cell->iy == iy)
+    {
+      snap_stats.cell_hits++;
+      return cell->types;
+    }
+
+  snap_stats.cell_misses++;
+  cell->ix = ix;
+  cell->iy = iy;
+  cell->types = compute_cell_types (ix, iy, cell_size);
+  cell->valid = true;
+
+  return cell->types;
+}
+
+/*!
+ * \brief SearchObjectByLocation () around the crosshair, skipped when
+ * the crosshair's cell has nothing of the requested types.
+ */
+static int
+snap_search (unsigned int cell_types, unsigned int type,
+             void **ptr1, void **ptr2, void **ptr3)
+{
+  snap_stats.searches++;
+
+  if ((cell_types & type) == 0)
+    {
+      snap_stats.skipped++;
+      return NO_TYPE;
+    }
+
+  return SearchObjectByLocation (type, ptr1, ptr2, ptr3,
+                                 Crosshair.X, Crosshair.Y, PCB->Grid / 2);
+}
+
+/*!
+ * \brief Report the snapping statistics gathered since the last call.
+ */
+void
+ReportSnapStats (void)
+{
+  if (snap_stats.events == 0)
+    Message (_("No crosshair motion since the last report\n"));
+  else
+    Message (_("%lu crosshair moves, %.3f ms average, %.3f ms worst\n"
+               "%lu of %lu snap searches skipped, "
+               "snap cells: %lu reused, %lu computed\n"),
+             snap_stats.events,
+             1000. * snap_stats.time_total / snap_stats.events,
+             1000. * snap_stats.time_max,
+             snap_stats.skipped, snap_stats.searches,
+             snap_stats.cell_hits, snap_stats.cell_misses);
+
+  memset (&snap_stats, 0, sizeof (snap_stats));
+}
+
 static void
 check_snap_offgrid_line (struct snap_data *snap_data,
+                         unsigned int cell_types,
                          Coord nearest_grid_x,
                          Coord nearest_grid_y)
 {
@@ -916,9 +1442,7 @@ check_snap_offgrid_line (struct snap_data *snap_data,
   /* Pick the nearest grid-point in the x or y direction
    * to align with, then adjust until we hit the line
    */
-  ans = SearchObjectByLocation (LINE_TYPE, &ptr1, &ptr2, &ptr3,
-                                Crosshair.X, Crosshair.Y, PCB->Grid / 2);
-
+  ans = snap_search (cell_types, LINE_TYPE, &ptr1, &ptr2, &ptr3);
 
   if (ans == NO_TYPE)
     return;
@@ -999,8 +1523,14 @@ FitCrosshairIntoGrid (Coord X, Coord Y)
   Coord nearest_grid_x, nearest_grid_y;
   void *ptr1, *ptr2, *ptr3;
   struct snap_data snap_data;
+  unsigned int cell_types;
+  double elapsed;
   int ans;
 
+  if (snap_timer == NULL)
+    snap_timer = g_timer_new ();
+  g_timer_start (snap_timer);
+
   /* limit the crosshair location to the board area */
   Crosshair.X = CLAMP (X, Crosshair.MinX, Crosshair.MaxX);
   Crosshair.Y = CLAMP (Y, Crosshair.MinY, Crosshair.MaxY);
@@ -1052,11 +1582,12 @@ FitCrosshairIntoGrid (Coord X, Coord Y)
   snap_data.x = nearest_grid_x;
   snap_data.y = nearest_grid_y;
 
+  cell_types = snap_cell_types (Crosshair.X, Crosshair.Y);
+
   ans = NO_TYPE;
   /* if we're not drawing rats, check for elements first */
   if (!PCB->RatDraw)
-    ans = SearchObjectByLocation (ELEMENT_TYPE, &ptr1, &ptr2, &ptr3,
-                                  Crosshair.X, Crosshair.Y, PCB->Grid / 2);
+    ans = snap_search (cell_types, ELEMENT_TYPE, &ptr1, &ptr2, &ptr3);
 
   if (ans & ELEMENT_TYPE)
     {
@@ -1068,8 +1599,7 @@ FitCrosshairIntoGrid (Coord X, Coord Y)
   /* try snapping to a pad if we're drawing rats, or pad snapping is turned on */
   ans = NO_TYPE;
   if (PCB->RatDraw || TEST_FLAG (SNAPPINFLAG, PCB))
-    ans = SearchObjectByLocation (PAD_TYPE, &ptr1, &ptr2, &ptr3,
-                                  Crosshair.X, Crosshair.Y, PCB->Grid / 2);
+    ans = snap_search (cell_types, PAD_TYPE, &ptr1, &ptr2, &ptr3);
 
   /* Avoid self-snapping when moving */
   if (ans != NO_TYPE &&
@@ -1137,8 +1667,7 @@ FitCrosshairIntoGrid (Coord X, Coord Y)
    * similar to snapping to a pad, but without the layer restriction */
   ans = NO_TYPE;
   if (PCB->RatDraw || TEST_FLAG (SNAPPINFLAG, PCB))
-    ans = SearchObjectByLocation (PIN_TYPE, &ptr1, &ptr2, &ptr3,
-                                  Crosshair.X, Crosshair.Y, PCB->Grid / 2);
+    ans = snap_search (cell_types, PIN_TYPE, &ptr1, &ptr2, &ptr3);
 
   /* Avoid self-snapping when moving */
   if (ans != NO_TYPE &&
@@ -1157,8 +1686,7 @@ FitCrosshairIntoGrid (Coord X, Coord Y)
   /* if snapping to pins and pads is turned on, try snapping to vias */
   ans = NO_TYPE;
   if (TEST_FLAG (SNAPPINFLAG, PCB))
-    ans = SearchObjectByLocation (VIA_TYPE, &ptr1, &ptr2, &ptr3,
-                                  Crosshair.X, Crosshair.Y, PCB->Grid / 2);
+    ans = snap_search (cell_types, VIA_TYPE, &ptr1, &ptr2, &ptr3);
 
   /* Avoid snapping vias to any other vias */
   if (Settings.Mode == MOVE_MODE &&
@@ -1176,9 +1704,8 @@ FitCrosshairIntoGrid (Coord X, Coord Y)
   /* try snapping to the end points of lines and arcs */
   ans = NO_TYPE;
   if (TEST_FLAG (SNAPPINFLAG, PCB))
-    ans = SearchObjectByLocation (LINEPOINT_TYPE | ARCPOINT_TYPE,
-                                  &ptr1, &ptr2, &ptr3,
-                                  Crosshair.X, Crosshair.Y, PCB->Grid / 2);
+    ans = snap_search (cell_types, LINEPOINT_TYPE | ARCPOINT_TYPE,
+                       &ptr1, &ptr2, &ptr3);
 
   if (ans != NO_TYPE)
     {
@@ -1188,13 +1715,13 @@ FitCrosshairIntoGrid (Coord X, Coord Y)
     }
 
   /* try snapping to a point on a line that's not on the grid */
-  check_snap_offgrid_line (&snap_data, nearest_grid_x, nearest_grid_y);
+  check_snap_offgrid_line (&snap_data, cell_types,
+                           nearest_grid_x, nearest_grid_y);
 
   /* try snapping to a point defining a polygon */
   ans = NO_TYPE;
   if (TEST_FLAG (SNAPPINFLAG, PCB))
-    ans = SearchObjectByLocation (POLYGONPOINT_TYPE, &ptr1, &ptr2, &ptr3,
-                                  Crosshair.X, Crosshair.Y, PCB->Grid / 2);
+    ans = snap_search (cell_types, POLYGONPOINT_TYPE, &ptr1, &ptr2, &ptr3);
 
   if (ans != NO_TYPE)
     {
@@ -1216,9 +1743,9 @@ FitCrosshairIntoGrid (Coord X, Coord Y)
    * grab the line endpoint */
   if (Settings.Mode == ARROW_MODE)
     {
-      ans = SearchObjectByLocation (LINEPOINT_TYPE | ARCPOINT_TYPE,
-                                    &ptr1, &ptr2, &ptr3,
-                                    Crosshair.X, Crosshair.Y, PCB->Grid / 2);
+      ans = snap_search (snap_cell_types (Crosshair.X, Crosshair.Y),
+                         LINEPOINT_TYPE | ARCPOINT_TYPE,
+                         &ptr1, &ptr2, &ptr3);
       if (ans == NO_TYPE)
         hid_action("PointCursor");
       else if (!TEST_FLAG(SELECTEDFLAG, (LineType *)ptr2))
@@ -1231,6 +1758,11 @@ FitCrosshairIntoGrid (Coord X, Coord Y)
     EnforceLineDRC ();
 
   gui->set_crosshair (Crosshair.X, Crosshair.Y, HID_SC_DO_NOTHING);
+
+  elapsed = g_timer_elapsed (snap_timer, NULL);
+  snap_stats.events++;
+  snap_stats.time_total += elapsed;
+  snap_stats.time_max = MAX (snap_stats.time_max, elapsed);
 }
 
 /*!
@@ -1351,3 +1883,76 @@ DestroyCrosshair (void)
 {
   FreePolygonMemory (&Crosshair.AttachedPolygon);
 }
+
+/* DumpPreview([Output file]) is not a user action and has no entry in
+ * the manual.  It writes the outline the paste buffer is previewed
+ * with, relative to the buffer's origin, through the same cache as the
+ * drawing uses, so the test suite can check that the preview follows
+ * changes to the buffer.
+ */
+static int
+ActionDumpPreview (int argc, char **argv, Coord x, Coord y)
+{
+  FILE *fp = stdout;
+  guint i;
+
+  if (argc == 1 && (fp = fopen (argv[0], "w")) == NULL)
+    {
+      Message (_("Can't open %s for writing\n"), argv[0]);
+      return 1;
+    }
+
+  buffer_outline_update (PASTEBUFFER);
+  pcb_fprintf (fp, "box %ml %ml %ml %ml, %u primitives\n",
+               buffer_outline.box.X1 - PASTEBUFFER->X,
+               buffer_outline.box.Y1 - PASTEBUFFER->Y,
+               buffer_outline.box.X2 - PASTEBUFFER->X,
+               buffer_outline.box.Y2 - PASTEBUFFER->Y,
+               buffer_outline.prims->len);
+  for (i = 0; i < buffer_outline.prims->len; i++)
+    {
+      xor_prim *prim = &g_array_index (buffer_outline.prims, xor_prim, i);
+      Coord dx = -PASTEBUFFER->X, dy = -PASTEBUFFER->Y;
+
+      switch (prim->type)
+        {
+        case XOR_LINE:
+        case XOR_RECT:
+          pcb_fprintf (fp, "%s %ml %ml %ml %ml\n",
+                       prim->type == XOR_LINE ? "line" : "rect",
+                       prim->u.line.x1 + dx, prim->u.line.y1 + dy,
+                       prim->u.line.x2 + dx, prim->u.line.y2 + dy);
+          break;
+
+        case XOR_ARC:
+          pcb_fprintf (fp, "arc %ml %ml %ml %ml %ma %ma\n",
+                       prim->u.arc.x + dx, prim->u.arc.y + dy,
+                       prim->u.arc.width, prim->u.arc.height,
+                       prim->u.arc.start, prim->u.arc.delta);
+          break;
+
+        case XOR_PV:
+          pcb_fprintf (fp, "pv %ml %ml %ml %ml\n",
+                       prim->u.pv.X + dx, prim->u.pv.Y + dy,
+                       prim->u.pv.Thickness, prim->u.pv.DrillingHole);
+          break;
+
+        case XOR_PAD:
+          pcb_fprintf (fp, "pad %ml %ml %ml %ml %ml\n",
+                       prim->u.pad.Point1.X + dx, prim->u.pad.Point1.Y + dy,
+                       prim->u.pad.Point2.X + dx, prim->u.pad.Point2.Y + dy,
+                       prim->u.pad.Thickness);
+          break;
+        }
+    }
+
+  if (fp != stdout)
+    fclose (fp);
+  return 0;
+}
+
+HID_Action crosshair_test_action_list[] = {
+  {"DumpPreview", 0, ActionDumpPreview}
+};
+
+REGISTER_ACTIONS (crosshair_test_action_list)
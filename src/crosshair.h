@@ -54,6 +54,8 @@ void SetCrosshairRange (Coord, Coord, Coord, Coord);
 void InitCrosshair (void);
 void DestroyCrosshair (void);
 void FitCrosshairIntoGrid (Coord, Coord);
+void ReportSnapStats (void);
 void crosshair_update_range(void);
+void crosshair_outlines_changed (void);
 
 #endif
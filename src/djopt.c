@@ -48,6 +48,7 @@
 #include "undo.h"
 #include "strflags.h"
 #include "find.h"
+#include "rtree.h"
 #include "pcb-printf.h"
 
 #ifdef HAVE_LIBDMALLOC
@@ -85,20 +86,24 @@ struct line_s;
 
 typedef struct corner_s
 {
+  BoxType box;			/*!< Must be first, for the corner R-tree. */
   int layer;
   struct corner_s *next;
+  struct corner_s *hnext;	/*!< Next corner at the same location. */
   int x, y;
   int net;
   PinType *via;
   PadType *pad;
   PinType *pin;
   int miter;
+  int mark;			/*!< See work_corners (). */
   int n_lines;
   struct line_s **lines;
 } corner_s;
 
 typedef struct line_s
 {
+  BoxType box;			/*!< Must be first, for the line R-tree. */
   int layer;
   struct line_s *next;
   corner_s *s, *e;
@@ -117,6 +122,20 @@ typedef struct rect_s
 static corner_s *corners, *next_corner = 0;
 static line_s *lines;
 
+/*! Corners by location; corners sharing one are chained by hnext. */
+static GHashTable *corner_hash = NULL;
+/*! Lines by bounding box. */
+static rtree_t *line_tree = NULL;
+/*! Corners by location, for looking up those near a spot. */
+static rtree_t *corner_tree = NULL;
+/*! The thickest line or pad indexed, bounding how far one reaches. */
+static int max_line_thick = 0;
+/*! The thickest pin or via, with max_line_thick bounding corner_radius (). */
+static int max_pv_thick = 0;
+/*! Corners in the order they were changed, see touch_corner (). */
+static GPtrArray *touched = NULL;
+static int work_mark = 0;
+
 static int layer_groupings[MAX_LAYER];
 static char layer_type[MAX_LAYER];
 #define LT_TOP 1
@@ -465,37 +484,238 @@ other_corner (line_s * l, corner_s * c)
   return NULL;
 }
 
+static guint
+corner_hash_func (gconstpointer p)
+{
+  const corner_s *c = (const corner_s *) p;
+  return c->x * 31 + c->y;
+}
+
+static gboolean
+corner_equal (gconstpointer a, gconstpointer b)
+{
+  const corner_s *ca = (const corner_s *) a;
+  const corner_s *cb = (const corner_s *) b;
+  return ca->x == cb->x && ca->y == cb->y;
+}
+
+/*!
+ * \brief Return the first of the corners at x,y.
+ */
 static corner_s *
-find_corner_if (int x, int y, int l)
+corners_at (int x, int y)
+{
+  corner_s key;
+  key.x = x;
+  key.y = y;
+  return (corner_s *) g_hash_table_lookup (corner_hash, &key);
+}
+
+static void
+hash_corner (corner_s * c)
+{
+  corner_s *head = corners_at (c->x, c->y);
+  if (head)
+    {
+      c->hnext = head->hnext;
+      head->hnext = c;
+    }
+  else
+    {
+      c->hnext = NULL;
+      g_hash_table_insert (corner_hash, c, c);
+    }
+  c->box.X1 = c->x;
+  c->box.Y1 = c->y;
+  c->box.X2 = c->x + 1;
+  c->box.Y2 = c->y + 1;
+  r_insert_entry (corner_tree, &c->box, 0);
+}
+
+static void
+unhash_corner (corner_s * c)
+{
+  corner_s *head = corners_at (c->x, c->y);
+  if (head == c)
+    {
+      g_hash_table_remove (corner_hash, c);
+      if (c->hnext)
+	g_hash_table_insert (corner_hash, c->hnext, c->hnext);
+    }
+  else
+    {
+      while (head && head->hnext != c)
+	head = head->hnext;
+      if (head)
+	head->hnext = c->hnext;
+    }
+  c->hnext = NULL;
+  r_delete_entry (corner_tree, &c->box);
+}
+
+/*!
+ * \brief Note that a corner changed, so that the passes look at it
+ * and its neighbours again.
+ */
+static void
+touch_corner (corner_s * c)
+{
+  if (touched)
+    g_ptr_array_add (touched, c);
+}
+
+static void
+add_work (GPtrArray * work, corner_s * c)
+{
+  if (DELETED (c) || c->mark == work_mark)
+    return;
+  c->mark = work_mark;
+  g_ptr_array_add (work, c);
+}
+
+/*!
+ * \brief Collect the corners a pass should look at.
+ *
+ * If \p since is NULL or -1, that is every corner.  Otherwise it is
+ * where the pass last left the log of changed corners, and only the
+ * corners changed since then, and the corners at the other ends of
+ * their lines, are collected.  \p since is moved to the end of the
+ * log.  The caller frees the array.
+ */
+static GPtrArray *
+work_corners (int *since)
 {
+  GPtrArray *work = g_ptr_array_new ();
   corner_s *c;
-  for (c = corners; c; c = c->next)
+  guint i;
+  int j;
+
+  work_mark++;
+  if (since == NULL || *since < 0)
     {
-      if (DELETED (c))
-	continue;
-      if (c->x != x || c->y != y)
-	continue;
-      if (!(c->layer == -1 || intersecting_layers (c->layer, l)))
-	continue;
-      return c;
+      for (c = corners; c; c = c->next)
+	add_work (work, c);
     }
-  return 0;
+  else
+    for (i = *since; i < touched->len; i++)
+      {
+	c = (corner_s *) touched->pdata[i];
+	if (DELETED (c))
+	  continue;
+	add_work (work, c);
+	for (j = 0; j < c->n_lines; j++)
+	  add_work (work, c->lines[j]->s == c
+		    ? c->lines[j]->e : c->lines[j]->s);
+      }
+  if (since)
+    *since = touched->len;
+  return work;
+}
+
+static void
+index_line (line_s * l)
+{
+  l->box.X1 = MIN (l->s->x, l->e->x);
+  l->box.Y1 = MIN (l->s->y, l->e->y);
+  l->box.X2 = MAX (l->s->x, l->e->x) + 1;
+  l->box.Y2 = MAX (l->s->y, l->e->y) + 1;
+  if (l->line->Thickness > max_line_thick)
+    max_line_thick = l->line->Thickness;
+  r_insert_entry (line_tree, &l->box, 0);
+}
+
+static void
+unindex_line (line_s * l)
+{
+  r_delete_entry (line_tree, &l->box);
+}
+
+static int
+collect_line (const BoxType * b, void *cl)
+{
+  line_s *l = (line_s *) b;
+  if (DELETED (l))
+    return 0;
+  g_ptr_array_add ((GPtrArray *) cl, l);
+  return 1;
+}
+
+/*!
+ * \brief Return the lines whose end points span a box overlapping
+ * x1,y1 - x2,y2.
+ *
+ * The array is reused by the next call.
+ */
+static GPtrArray *
+lines_near (int x1, int y1, int x2, int y2)
+{
+  static GPtrArray *near = NULL;
+  BoxType b;
+
+  if (near == NULL)
+    near = g_ptr_array_new ();
+  g_ptr_array_set_size (near, 0);
+  b.X1 = x1;
+  b.Y1 = y1;
+  b.X2 = x2 + 1;
+  b.Y2 = y2 + 1;
+  r_search (line_tree, &b, NULL, collect_line, near);
+  return near;
+}
+
+static int
+collect_corner (const BoxType * b, void *cl)
+{
+  corner_s *c = (corner_s *) b;
+  if (DELETED (c))
+    return 0;
+  g_ptr_array_add ((GPtrArray *) cl, c);
+  return 1;
+}
+
+/*!
+ * \brief Return the corners within x1,y1 - x2,y2.
+ *
+ * The array is reused by the next call.
+ */
+static GPtrArray *
+corners_near (int x1, int y1, int x2, int y2)
+{
+  static GPtrArray *near = NULL;
+  BoxType b;
+
+  if (near == NULL)
+    near = g_ptr_array_new ();
+  g_ptr_array_set_size (near, 0);
+  b.X1 = x1;
+  b.Y1 = y1;
+  b.X2 = x2 + 1;
+  b.Y2 = y2 + 1;
+  r_search (corner_tree, &b, NULL, collect_corner, near);
+  return near;
 }
 
 static corner_s *
-find_corner (int x, int y, int l)
+find_corner_if (int x, int y, int l)
 {
   corner_s *c;
-  for (c = corners; c; c = c->next)
+  for (c = corners_at (x, y); c; c = c->hnext)
     {
       if (DELETED (c))
 	continue;
-      if (c->x != x || c->y != y)
-	continue;
       if (!(c->layer == -1 || intersecting_layers (c->layer, l)))
 	continue;
       return c;
     }
+  return 0;
+}
+
+static corner_s *
+find_corner (int x, int y, int l)
+{
+  corner_s *c = find_corner_if (x, y, l);
+  if (c)
+    return c;
   c = (corner_s *) malloc (sizeof (corner_s));
   c->next = corners;
   corners = c;
@@ -506,8 +726,12 @@ find_corner (int x, int y, int l)
   c->pad = 0;
   c->pin = 0;
   c->layer = l;
+  c->miter = 0;
+  c->mark = 0;
   c->n_lines = 0;
   c->lines = (line_s **) malloc (INC * sizeof (line_s *));
+  hash_corner (c);
+  touch_corner (c);
   return c;
 }
 
@@ -519,6 +743,7 @@ add_line_to_corner (line_s * l, corner_s * c)
   c->lines = (line_s **) realloc (c->lines, n * sizeof (line_s *));
   c->lines[c->n_lines] = l;
   c->n_lines++;
+  touch_corner (c);
   dprintf ("add_line_to_corner %#mD\n", c->x, c->y);
 }
 
@@ -526,28 +751,13 @@ static LineType *
 create_pcb_line (int layer, int x1, int y1, int x2, int y2,
 		 int thick, int clear, FlagType flags)
 {
-  char *from, *to;
   LineType *nl;
   LayerType *lyr = LAYER_PTR (layer);
 
-  from = (char *) lyr->Line;
   nl = CreateNewLineOnLayer (PCB->Data->Layer + layer,
 			     x1, y1, x2, y2, thick, clear, flags);
   AddObjectToCreateUndoList (LINE_TYPE, lyr, nl, nl);
 
-  to = (char *) lyr->Line;
-  if (from != to)
-    {
-      line_s *lp;
-      for (lp = lines; lp; lp = lp->next)
-	{
-	  if (DELETED (lp))
-	    continue;
-	  if ((char *) (lp->line) >= from
-	      && (char *) (lp->line) <= from + lyr->LineN * sizeof (LineType))
-	    lp->line = (LineType *) ((char *) (lp->line) + (to - from));
-	}
-    }
   return nl;
 }
 
@@ -598,6 +808,7 @@ new_line (corner_s * s, corner_s * e, int layer, LineType * example)
     }
   add_line_to_corner (ls, s);
   add_line_to_corner (ls, e);
+  index_line (ls);
   check (s, ls);
   check (e, ls);
 }
@@ -720,6 +931,15 @@ corner_radius (corner_s * c)
   return diam;
 }
 
+/*!
+ * \brief The largest corner_radius () any corner can have.
+ */
+static int
+max_corner_radius (void)
+{
+  return (djmax (max_line_thick, max_pv_thick) + 1) / 2;
+}
+
 #if 0
 /* Not used */
 static int
@@ -763,7 +983,10 @@ remove_line (line_s * l)
   if (l->line)
     RemoveLine (layer, l->line);
 
+  unindex_line (l);
   DELETE (l);
+  touch_corner (l->s);
+  touch_corner (l->e);
 
   for (i = 0, j = 0; i < l->s->n_lines; i++)
     if (l->s->lines[i] != l)
@@ -787,6 +1010,8 @@ move_line_to_layer (line_s * l, int layer)
 
   MoveObjectToLayer (LINE_TYPE, ls, l->line, 0, ld, 0);
   l->layer = layer;
+  touch_corner (l->s);
+  touch_corner (l->e);
 }
 
 static void
@@ -794,6 +1019,7 @@ remove_via_at (corner_s * c)
 {
   RemoveObject (VIA_TYPE, c->via, 0, 0);
   c->via = 0;
+  touch_corner (c);
 }
 
 static void
@@ -812,6 +1038,7 @@ remove_corner (corner_s * c2)
     }
   if (next_corner == c2)
     next_corner = c2->next;
+  unhash_corner (c2);
   free (c2->lines);
   c2->lines = 0;
   DELETE (c2);
@@ -827,10 +1054,12 @@ merge_corners (corner_s * c1, corner_s * c2)
   for (i = 0; i < c2->n_lines; i++)
     {
       add_line_to_corner (c2->lines[i], c1);
+      unindex_line (c2->lines[i]);
       if (c2->lines[i]->s == c2)
 	c2->lines[i]->s = c1;
       if (c2->lines[i]->e == c2)
 	c2->lines[i]->e = c1;
+      index_line (c2->lines[i]);
     }
   if (c1->via && c2->via)
     remove_via_at (c2);
@@ -858,8 +1087,15 @@ move_corner (corner_s * c, int x, int y)
     dj_abort ("move_corner: has pin or pad\n");
   dprintf ("move_corner %p from %#mD to %#mD\n", (void *) c, c->x, c->y, x, y);
   pad = find_corner_if (x, y, c->layer);
+  for (i = 0; i < c->n_lines; i++)
+    unindex_line (c->lines[i]);
+  unhash_corner (c);
   c->x = x;
   c->y = y;
+  hash_corner (c);
+  touch_corner (c);
+  for (i = 0; i < c->n_lines; i++)
+    index_line (c->lines[i]);
   via = c->via;
   if (via)
     {
@@ -983,7 +1219,11 @@ split_line (line_s * l, corner_s * c)
   for (i = 0; i < l->e->n_lines; i++)
     if (l->e->lines[i] == l)
       l->e->lines[i] = ls;
+  touch_corner (l->e);
+  unindex_line (l);
   l->e = c;
+  index_line (l);
+  index_line (ls);
   add_line_to_corner (l, c);
   add_line_to_corner (ls, c);
 
@@ -1252,10 +1492,12 @@ orthopull_1 (corner_s * c, int fdir, int rdir, int any_sel)
   static int lm = 0;
   int i, li, ln, cn, snap;
   line_s *l = 0;
+  GPtrArray *near = NULL;
+  guint ni;
   corner_s *c2, *cb;
   int adir = 0, sdir = 0, pull;
   int saw_sel = 0, saw_auto = 0;
-  int max, len = 0, r1 = 0, r2;
+  int max, len = 0, r1 = 0, r2, cr;
   rect_s rr;
   int edir = 0, done;
 
@@ -1394,11 +1636,13 @@ orthopull_1 (corner_s * c, int fdir, int rdir, int any_sel)
   rr.y2 += SB + 1;
 
   snap = 0;
-  for (cb = corners; cb; cb = cb->next)
+  /* only corners within their radius of rr can get in the way */
+  cr = max_corner_radius ();
+  near = corners_near (rr.x1 - cr, rr.y1 - cr, rr.x2 + cr, rr.y2 + cr);
+  for (ni = 0; ni < near->len; ni++)
     {
       int sep;
-      if (DELETED (cb))
-	continue;
+      cb = (corner_s *) near->pdata[ni];
       r1 = corner_radius (cb);
       if (cb->net == c->net && !cb->pad)
 	continue;
@@ -1448,10 +1692,33 @@ orthopull_1 (corner_s * c, int fdir, int rdir, int any_sel)
 	}
     }
 
-  /* We must now check every line segment against our corners.  */
-  for (l = lines; l; l = l->next)
+  /* We must now check every line segment near our corners.  Lines
+     further away than max can't shorten it.  */
+  {
+    int reach, rmax = 0;
+    for (i = 0; i < cn; i++)
+      rmax = djmax (rmax, corner_radius (cs[i]));
+    reach = MAX (max, 0) + max_line_thick + SB + rmax + 1;
+    switch (edir)
+      {
+      case UP:
+	near = lines_near (c->x, c->y - reach, c2->x, c->y);
+	break;
+      case DOWN:
+	near = lines_near (c->x, c->y, c2->x, c->y + reach);
+	break;
+      case LEFT:
+	near = lines_near (c->x - reach, c->y, c->x, c2->y);
+	break;
+      case RIGHT:
+	near = lines_near (c->x, c->y, c->x + reach, c2->y);
+	break;
+      }
+  }
+  for (ni = 0; ni < near->len; ni++)
     {
       int o, x1, x2, y1, y2;
+      l = (line_s *) near->pdata[ni];
       if (DELETED (l))
 	continue;
       dprintf ("check line %#mD to %#mD\n", l->s->x, l->s->y, l->e->x, l->e->y);
@@ -1639,36 +1906,27 @@ orthopull_1 (corner_s * c, int fdir, int rdir, int any_sel)
  * trace length.
  */
 static int
-orthopull ()
+orthopull (int *since)
 {
   int any_sel = any_line_selected ();
+  GPtrArray *work = work_corners (since);
   corner_s *c;
   int rv = 0;
+  guint i;
 
-  for (c = corners; c;)
+  for (i = 0; i < work->len; i++)
     {
+      c = (corner_s *) work->pdata[i];
       if (DELETED (c))
 	continue;
       if (c->pin || c->pad)
-	{
-	  c = c->next;
-	  continue;
-	}
-      next_corner = c;
+	continue;
       rv += orthopull_1 (c, RIGHT, LEFT, any_sel);
-      if (c != next_corner)
-	{
-	  c = next_corner;
-	  continue;
-	}
+      if (DELETED (c))
+	continue;
       rv += orthopull_1 (c, DOWN, UP, any_sel);
-      if (c != next_corner)
-	{
-	  c = next_corner;
-	  continue;
-	}
-      c = c->next;
     }
+  g_ptr_array_free (work, TRUE);
   if (rv)
     pcb_printf ("orthopull: %ml mils saved\n", rv);
   return rv;
@@ -1839,15 +2097,18 @@ simple_corner (corner_s * c)
  * \brief Look for sequences of simple corners we can reduce.
  */
 static int
-unjaggy_once ()
+unjaggy_once (int *since)
 {
   int rv = 0;
-  corner_s *c, *c0, *c1, *cc;
+  GPtrArray *work = work_corners (since);
+  corner_s *c = NULL, *c0, *c1, *cc;
   int l, w, sel = any_line_selected ();
   int o0, o1, s0, s1;
   rect_s rr, rp;
-  for (c = corners; c; c = c->next)
+  guint i;
+  for (i = 0; i < work->len; i++)
     {
+      c = (corner_s *) work->pdata[i];
       if (DELETED (c))
 	continue;
       if (!simple_corner (c))
@@ -1929,18 +2190,27 @@ unjaggy_once ()
       rv++;
       check (c, 0);
     }
+  g_ptr_array_free (work, TRUE);
   rv += simple_optimizations ();
   check (c, 0);
   return rv;
 }
 
+/*!
+ * \brief Repeat unjaggy_once () while it finds something.
+ *
+ * Rounds after the first only look again at what the previous ones
+ * changed; see work_corners () for \p since.
+ */
 static int
-unjaggy ()
+unjaggy (int *since)
 {
-  int i, r = 0, j;
+  int i, r = 0, j, first = -1;
+  if (since == NULL)
+    since = &first;
   for (i = 0; i < 100; i++)
     {
-      j = unjaggy_once ();
+      j = unjaggy_once (since);
       if (j == 0)
 	break;
       r += j;
@@ -1955,22 +2225,26 @@ unjaggy ()
  * nudge via to eliminate one or more of them.
  */
 static int
-vianudge ()
+vianudge (int *since)
 {
   int rv = 0;
+  GPtrArray *work = work_corners (since), *near;
   corner_s *c, *c2, *c3;
   line_s *l;
   unsigned char directions[MAX_LAYER];
   unsigned char counts[MAX_LAYER];
+  guint wi, ni;
 
   memset (directions, 0, sizeof (directions));
   memset (counts, 0, sizeof (counts));
 
-  for (c = corners; c; c = c->next)
+  for (wi = 0; wi < work->len; wi++)
     {
       int o, i, vr, cr, oboth;
       int len = 0, saved = 0;
 
+      c = (corner_s *) work->pdata[wi];
+
       if (DELETED (c))
 	continue;
 
@@ -2030,10 +2304,12 @@ vianudge ()
 
       /* Now look for clearance in the new position */
       vr = c->via->Thickness / 2 + SB + 1;
-      for (c3 = corners; c3; c3 = c3->next)
+      cr = max_corner_radius ();
+      near = corners_near (c2->x - vr - cr, c2->y - vr - cr,
+			   c2->x + vr + cr, c2->y + vr + cr);
+      for (ni = 0; ni < near->len; ni++)
 	{
-	  if (DELETED (c3))
-	    continue;
+	  c3 = (corner_s *) near->pdata[ni];
 	  if ((c3->net != c->net && (c3->pin || c3->via)) || c3->pad)
 	    {
 	      cr = corner_radius (c3);
@@ -2041,8 +2317,13 @@ vianudge ()
 		goto vianudge_continue;
 	    }
 	}
-      for (l = lines; l; l = l->next)
+      near = lines_near (c2->x - vr - max_line_thick / 2,
+			 c2->y - vr - max_line_thick / 2,
+			 c2->x + vr + max_line_thick / 2,
+			 c2->y + vr + max_line_thick / 2);
+      for (ni = 0; ni < near->len; ni++)
 	{
+	  l = (line_s *) near->pdata[ni];
 	  if (DELETED (l))
 	    continue;
 	  if (l->s->net != c->net)
@@ -2065,6 +2346,7 @@ vianudge ()
     vianudge_continue:
       continue;
     }
+  g_ptr_array_free (work, TRUE);
 
   if (rv)
     pcb_printf ("vianudge: %ml mils saved\n", rv);
@@ -2184,13 +2466,14 @@ automagic ()
 {
   int more = 1, oldmore = 0;
   int toomany = 100;
+  int unjaggy_since = -1, orthopull_since = -1, vianudge_since = -1;
   while (more != oldmore && --toomany)
     {
       oldmore = more;
       more += debumpify ();
-      more += unjaggy ();
-      more += orthopull ();
-      more += vianudge ();
+      more += unjaggy (&unjaggy_since);
+      more += orthopull (&orthopull_since);
+      more += vianudge (&vianudge_since);
       more += viatrim ();
     }
   return more - 1;
@@ -2203,6 +2486,8 @@ miter ()
   int done, progress;
   int sel = any_line_selected ();
   int saved = 0;
+  GPtrArray *pending = g_ptr_array_new ();
+  guint i, n;
 
   for (c = corners; c; c = c->next)
     {
@@ -2216,18 +2501,31 @@ miter ()
 	  if (ORIENT (o1) != ORIENT (o2)
 	      && o1 != DIAGONAL && o2 != DIAGONAL
 	      && c->lines[0]->line->Thickness == c->lines[1]->line->Thickness)
-	    c->miter = -1;
+	    {
+	      c->miter = -1;
+	      g_ptr_array_add (pending, c);
+	    }
 	}
     }
 
+  /* Only the corners still waiting to be mitered are looked at again. */
   done = 0;
   progress = 1;
   while (!done && progress)
     {
       done = 1;
       progress = 0;
-      for (c = corners; c; c = c->next)
+      for (i = 0, n = 0; i < pending->len; i++)
+	{
+	  c = (corner_s *) pending->pdata[i];
+	  if (DELETED (c) || c->miter != -1)
+	    continue;
+	  pending->pdata[n++] = c;
+	}
+      g_ptr_array_set_size (pending, n);
+      for (i = 0; i < pending->len; i++)
 	{
+	  c = (corner_s *) pending->pdata[i];
 	  if (DELETED (c))
 	    continue;
 	  if (c->miter == -1)
@@ -2395,6 +2693,7 @@ miter ()
 	    }
 	}
     }
+  g_ptr_array_free (pending, TRUE);
   return saved;
 }
 
@@ -2994,6 +3293,17 @@ After miter:
 
 %end-doc */
 
+static void
+free_indexes ()
+{
+  g_hash_table_destroy (corner_hash);
+  corner_hash = NULL;
+  r_destroy_tree (&line_tree);
+  r_destroy_tree (&corner_tree);
+  g_ptr_array_free (touched, TRUE);
+  touched = NULL;
+}
+
 static int
 ActionDJopt (int argc, char **argv, Coord x, Coord y)
 {
@@ -3005,6 +3315,12 @@ ActionDJopt (int argc, char **argv, Coord x, Coord y)
 
   lines = 0;
   corners = 0;
+  corner_hash = g_hash_table_new (corner_hash_func, corner_equal);
+  line_tree = r_create_tree (NULL, 0, 0);
+  corner_tree = r_create_tree (NULL, 0, 0);
+  max_line_thick = 0;
+  max_pv_thick = 0;
+  touched = g_ptr_array_new ();
 
   grok_layer_groups ();
 
@@ -3013,6 +3329,7 @@ ActionDJopt (int argc, char **argv, Coord x, Coord y)
   {
     c = find_corner (pin->X, pin->Y, -1);
     c->pin = pin;
+    max_pv_thick = djmax (max_pv_thick, pin->Thickness);
   }
   END_LOOP;
   PAD_LOOP (element);
@@ -3031,6 +3348,7 @@ ActionDJopt (int argc, char **argv, Coord x, Coord y)
     ls->line = (LineType *) pad;
     add_line_to_corner (ls, ls->s);
     add_line_to_corner (ls, ls->e);
+    index_line (ls);
 
   }
   END_LOOP;
@@ -3043,6 +3361,7 @@ ActionDJopt (int argc, char **argv, Coord x, Coord y)
   {
     c = find_corner (via->X, via->Y, -1);
     c->via = via;
+    max_pv_thick = djmax (max_pv_thick, via->Thickness);
   }
   END_LOOP;
   check (0, 0);
@@ -3081,6 +3400,7 @@ ActionDJopt (int argc, char **argv, Coord x, Coord y)
 	  add_line_to_corner (ls, ls->s);
 	  add_line_to_corner (ls, ls->e);
 	  ls->layer = layn;
+	  index_line (ls);
 	}
       END_LOOP;
     }
@@ -3097,15 +3417,15 @@ ActionDJopt (int argc, char **argv, Coord x, Coord y)
   if (NSTRCMP (arg, "debumpify") == 0)
     saved += debumpify ();
   else if (NSTRCMP (arg, "unjaggy") == 0)
-    saved += unjaggy ();
+    saved += unjaggy (NULL);
   else if (NSTRCMP (arg, "simple") == 0)
     saved += simple_optimizations ();
   else if (NSTRCMP (arg, "vianudge") == 0)
-    saved += vianudge ();
+    saved += vianudge (NULL);
   else if (NSTRCMP (arg, "viatrim") == 0)
     saved += viatrim ();
   else if (NSTRCMP (arg, "orthopull") == 0)
-    saved += orthopull ();
+    saved += orthopull (NULL);
   else if (NSTRCMP (arg, "auto") == 0)
     saved += automagic ();
   else if (NSTRCMP (arg, "miter") == 0)
@@ -3115,12 +3435,14 @@ ActionDJopt (int argc, char **argv, Coord x, Coord y)
   else
     {
       printf ("unknown command: %s\n", arg);
+      free_indexes ();
       return 1;
     }
 
   padcleaner ();
 
   check (0, 0);
+  free_indexes ();
   if (saved)
     IncrementUndoSerialNumber ();
   return 0;
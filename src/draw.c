@@ -45,6 +45,7 @@
 #include "error.h"
 #include "mymem.h"
 #include "misc.h"
+#include "perf.h"
 #include "rotate.h"
 #include "rtree.h"
 #include "search.h"
@@ -72,13 +73,18 @@
 /* ---------------------------------------------------------------------------
  * some local identifiers
  */
-static BoxType Block = {MAXINT, MAXINT, -MAXINT, -MAXINT};
+/* Areas to be redrawn by the next Draw (), see AddPart () */
+#define MAX_DIRTY_RECTS 16
+static BoxType dirty_rects[MAX_DIRTY_RECTS];
+static int n_dirty_rects = 0;
 
 static int doing_pinout = 0;
 static bool doing_assy = false;
 
 static int current_layergroup; /* used by via_callback */
 
+static char *current_object_color; /* last colour picked by set_object_color */
+
 /* ---------------------------------------------------------------------------
  * some local prototypes
  */
@@ -100,6 +106,7 @@ set_object_color (AnyObjectType *obj, char *warn_color, char *selected_color,
   else if (found_color     != NULL && TEST_FLAG (FOUNDFLAG,     obj)) color = found_color;
   else                                                                color = normal_color;
 
+  current_object_color = color;
   gui->graphics->set_color (Output.fgGC, color);
 }
 
@@ -109,18 +116,240 @@ set_layer_object_color (LayerType *layer, AnyObjectType *obj)
   set_object_color (obj, NULL, layer->SelectedColor, PCB->ConnectedColor, PCB->FoundColor, layer->Color);
 }
 
+/* ---------------------------------------------------------------------------
+ * Level of detail.
+ *
+ * When a GUI is zoomed out, many objects cover less than a pixel and text
+ * is too small to read.  Such objects are drawn as coarse coverage
+ * rectangles, at most one per screen pixel and colour, and text is
+ * replaced by a single stroke.  Exporters always get the full detail.
+ */
+
+/* Objects smaller than this many pixels are drawn as coverage rectangles */
+#define LOD_MIN_PIXELS 1
+/* Text shorter than this many pixels is drawn as a single stroke */
+#define LOD_TEXT_PIXELS 4
+
+static GHashTable *lod_cells = NULL;
+
+/*!
+ * \brief Whether objects too small to see may be simplified.
+ *
+ * The GL renderer asks this too, for its sub-pixel circles, contour
+ * vertices and polygon holes.
+ */
+bool
+DrawLevelOfDetail (void)
+{
+  return gui->gui && Settings.LevelOfDetail && !doing_pinout;
+}
+
+static bool
+lod_too_small (Coord size)
+{
+  return DrawLevelOfDetail () && size < LOD_MIN_PIXELS * pixel_slop;
+}
+
+static bool
+lod_text_too_small (Coord height)
+{
+  return DrawLevelOfDetail () && height < LOD_TEXT_PIXELS * pixel_slop;
+}
+
+/*!
+ * \brief Forget which pixels were covered by coarse primitives.
+ *
+ * Called at the start of every pass where sub-pixel objects may be merged.
+ */
+static void
+lod_reset (void)
+{
+  if (lod_cells != NULL)
+    g_hash_table_remove_all (lod_cells);
+}
+
+struct lod_cell {
+  Coord x, y;
+  const char *color;
+};
+
+static guint
+lod_cell_hash (gconstpointer key)
+{
+  const struct lod_cell *cell = key;
+  return (guint)cell->x * 73856093u ^ (guint)cell->y * 19349663u ^
+         GPOINTER_TO_UINT (cell->color);
+}
+
+static gboolean
+lod_cell_equal (gconstpointer a, gconstpointer b)
+{
+  const struct lod_cell *ca = a;
+  const struct lod_cell *cb = b;
+  return ca->x == cb->x && ca->y == cb->y && ca->color == cb->color;
+}
+
+/*!
+ * \brief Draw a sub-pixel object as a pixel sized rectangle, unless that
+ * pixel was already covered in the same colour.
+ */
+static void
+lod_draw_coverage (hidGC gc, const char *color, Coord x, Coord y)
+{
+  struct lod_cell key, *cell;
+  Coord px = pixel_slop > 0 ? pixel_slop : 1;
+
+  if (lod_cells == NULL)
+    lod_cells = g_hash_table_new_full (lod_cell_hash, lod_cell_equal, g_free, NULL);
+
+  key.x = x / px;
+  key.y = y / px;
+  key.color = color;
+
+  if (g_hash_table_lookup (lod_cells, &key) != NULL)
+    return;
+
+  cell = g_new (struct lod_cell, 1);
+  *cell = key;
+  g_hash_table_insert (lod_cells, cell, cell);
+
+  gui->graphics->fill_rect (gc, key.x * px, key.y * px,
+                                (key.x + 1) * px, (key.y + 1) * px);
+}
+
+/*!
+ * \brief Draw text too small to read as one stroke along its baseline.
+ */
+static void
+lod_draw_text (hidGC gc, TextType *text)
+{
+  BoxType *b = &text->BoundingBox;
+  Coord w = b->X2 - b->X1;
+  Coord h = b->Y2 - b->Y1;
+
+  gui->graphics->set_line_cap (gc, Square_Cap);
+  if (w >= h)
+    {
+      gui->graphics->set_line_width (gc, h / 3);
+      gui->graphics->draw_line (gc, b->X1, (b->Y1 + b->Y2) / 2,
+                                    b->X2, (b->Y1 + b->Y2) / 2);
+    }
+  else
+    {
+      gui->graphics->set_line_width (gc, w / 3);
+      gui->graphics->draw_line (gc, (b->X1 + b->X2) / 2, b->Y1,
+                                    (b->X1 + b->X2) / 2, b->Y2);
+    }
+}
+
+static bool
+lod_text (hidGC gc, TextType *text)
+{
+  Coord w = text->BoundingBox.X2 - text->BoundingBox.X1;
+  Coord h = text->BoundingBox.Y2 - text->BoundingBox.Y1;
+
+  if (!lod_text_too_small (MIN (w, h)))
+    return false;
+
+  if (lod_too_small (MAX (w, h)))
+    return true;
+
+  lod_draw_text (gc, text);
+  return true;
+}
+
+static double
+box_area (const BoxType *box)
+{
+  return (double)(box->X2 - box->X1) * (double)(box->Y2 - box->Y1);
+}
+
+/*!
+ * \brief Area that merging two boxes would redraw needlessly.
+ *
+ * Overlapping boxes count their common part only once, so the result
+ * may be negative, in which case merging saves work.
+ */
+static double
+merge_waste (const BoxType *a, const BoxType *b)
+{
+  BoxType u;
+
+  u.X1 = MIN (a->X1, b->X1);
+  u.Y1 = MIN (a->Y1, b->Y1);
+  u.X2 = MAX (a->X2, b->X2);
+  u.Y2 = MAX (a->Y2, b->Y2);
+
+  return box_area (&u) - box_area (a) - box_area (b);
+}
+
+static void
+merge_box (BoxType *dst, const BoxType *src)
+{
+  dst->X1 = MIN (dst->X1, src->X1);
+  dst->Y1 = MIN (dst->Y1, src->Y1);
+  dst->X2 = MAX (dst->X2, src->X2);
+  dst->Y2 = MAX (dst->Y2, src->Y2);
+}
+
+/*!
+ * \brief Merge dirty rectangles for which that wastes little.
+ *
+ * Merging can make a rectangle overlap others, so repeat until nothing
+ * changes.  There are at most MAX_DIRTY_RECTS rectangles, so the
+ * quadratic passes are cheap.
+ */
+static void
+coalesce_dirty_rects (void)
+{
+  bool merged;
+  int i, j;
+
+  do
+    {
+      merged = false;
+      for (i = 0; i < n_dirty_rects; i++)
+        for (j = i + 1; j < n_dirty_rects; j++)
+          if (merge_waste (&dirty_rects[i], &dirty_rects[j]) <= 0.)
+            {
+              merge_box (&dirty_rects[i], &dirty_rects[j]);
+              dirty_rects[j--] = dirty_rects[--n_dirty_rects];
+              merged = true;
+            }
+    }
+  while (merged);
+}
+
 /*!
  * \brief Adds the update rect to the update region.
+ *
+ * The region is kept as a short list of rectangles, so that changes in
+ * distant parts of the board don't redraw everything between them.  A
+ * rectangle is merged into an existing one when that adds no more
+ * area than the two cover; once the list is full it goes to the one it
+ * grows least.
  */
 static void
 AddPart (void *b)
 {
   BoxType *box = (BoxType *) b;
+  double waste, best_waste = 0.;
+  int i, best = -1;
 
-  Block.X1 = MIN (Block.X1, box->X1);
-  Block.X2 = MAX (Block.X2, box->X2);
-  Block.Y1 = MIN (Block.Y1, box->Y1);
-  Block.Y2 = MAX (Block.Y2, box->Y2);
+  for (i = 0; i < n_dirty_rects; i++)
+    {
+      waste = merge_waste (&dirty_rects[i], box);
+      if (best < 0 || waste < best_waste)
+        {
+          best = i;
+          best_waste = waste;
+        }
+    }
+
+  if (best >= 0 && (best_waste <= 0. || n_dirty_rects == MAX_DIRTY_RECTS))
+    merge_box (&dirty_rects[best], box);
+  else
+    dirty_rects[n_dirty_rects++] = *box;
 }
 
 /*!
@@ -129,12 +358,21 @@ AddPart (void *b)
 void
 Draw (void)
 {
-  if (Block.X1 <= Block.X2 && Block.Y1 <= Block.Y2)
-    gui->invalidate_lr (Block.X1, Block.X2, Block.Y1, Block.Y2);
+  int i;
+
+  if (n_dirty_rects == 0)
+    return;
 
-  /* shrink the update block */
-  Block.X1 = Block.Y1 =  MAXINT;
-  Block.X2 = Block.Y2 = -MAXINT;
+  coalesce_dirty_rects ();
+
+  if (gui->invalidate_rects != NULL)
+    gui->invalidate_rects (dirty_rects, n_dirty_rects);
+  else
+    for (i = 0; i < n_dirty_rects; i++)
+      gui->invalidate_lr (dirty_rects[i].X1, dirty_rects[i].X2,
+                          dirty_rects[i].Y1, dirty_rects[i].Y2);
+
+  n_dirty_rects = 0;
 }
 
 /*!
@@ -153,6 +391,10 @@ _draw_pv_name (PinType *pv)
   bool vert;
   TextType text;
 
+  /* The name is scaled to the pin, so it is unreadable if the pin is */
+  if (lod_text_too_small (pv->Thickness))
+    return;
+
   if (!pv->Name || !pv->Name[0])
     text.TextString = EMPTY (pv->Number);
   else
@@ -190,6 +432,12 @@ _draw_pv_name (PinType *pv)
 static void
 _draw_pv (PinType *pv, bool draw_hole)
 {
+  if (lod_too_small (pv->Thickness))
+    {
+      lod_draw_coverage (Output.fgGC, current_object_color, pv->X, pv->Y);
+      return;
+    }
+
   if (TEST_FLAG (THINDRAWFLAG, PCB))
     gui->graphics->thindraw_pcb_pv (Output.fgGC, Output.fgGC, pv, draw_hole, false);
   else if (!ViaIsOnAnyVisibleLayer (pv))
@@ -223,7 +471,10 @@ static void
 draw_pin (PinType *pin, bool draw_hole)
 {
   if (doing_pinout)
-    gui->graphics->set_color (Output.fgGC, PCB->PinColor);
+    {
+      current_object_color = PCB->PinColor;
+      gui->graphics->set_color (Output.fgGC, PCB->PinColor);
+    }
   else
     set_object_color ((AnyObjectType *)pin,
                       PCB->WarnColor, PCB->PinSelectedColor,
@@ -243,7 +494,10 @@ static void
 draw_via (PinType *via, bool draw_hole)
 {
   if (doing_pinout)
-    gui->graphics->set_color (Output.fgGC, PCB->ViaColor);
+    {
+      current_object_color = PCB->ViaColor;
+      gui->graphics->set_color (Output.fgGC, PCB->ViaColor);
+    }
   else
     set_object_color ((AnyObjectType *)via,
                       PCB->WarnColor, PCB->ViaSelectedColor,
@@ -279,6 +533,9 @@ draw_pad_name (PadType *pad)
   bool vert;
   TextType text;
 
+  if (lod_text_too_small (pad->Thickness))
+    return;
+
   if (!pad->Name || !pad->Name[0])
     text.TextString = EMPTY (pad->Number);
   else
@@ -337,6 +594,15 @@ draw_pad (PadType *pad)
                       PCB->PinSelectedColor, PCB->ConnectedColor, PCB->FoundColor,
                       FRONT (pad) ? PCB->PinColor : PCB->InvisibleObjectsColor);
 
+  if (lod_too_small (MAX (pad->BoundingBox.X2 - pad->BoundingBox.X1,
+                          pad->BoundingBox.Y2 - pad->BoundingBox.Y1)))
+    {
+      lod_draw_coverage (Output.fgGC, current_object_color,
+                         (pad->Point1.X + pad->Point2.X) / 2,
+                         (pad->Point1.Y + pad->Point2.Y) / 2);
+      return;
+    }
+
   _draw_pad (Output.fgGC, pad, false, false);
 
   if (doing_pinout || TEST_FLAG (DISPLAYNAMEFLAG, pad))
@@ -368,6 +634,8 @@ draw_element_name (ElementType *element)
     gui->graphics->set_color (Output.fgGC, PCB->ElementColor);
   else
     gui->graphics->set_color (Output.fgGC, PCB->InvisibleObjectsColor);
+  if (lod_text (Output.fgGC, &ELEMENT_TEXT (PCB, element)))
+    return;
   gui->graphics->draw_pcb_text (Output.fgGC, &ELEMENT_TEXT (PCB, element), PCB->minSlk);
 }
 
@@ -456,6 +724,10 @@ via_ok:
   if (!via_visible_on_layer_group (pv))
      return 1;
 
+  /* The hole of a sub-pixel pin or via can't be seen */
+  if (lod_too_small (pv->Thickness))
+    return 1;
+
   if (TEST_FLAG (THINDRAWFLAG, PCB))
     {
       if (!TEST_FLAG (HOLEFLAG, pv))
@@ -663,6 +935,7 @@ DrawEverything (const BoxType *drawn_area)
 	  r_search (PCB->Data->name_tree[NAME_INDEX (PCB)], drawn_area, NULL, name_callback, &side);
 	  DrawLayer (&(PCB->Data->Layer[max_copper_layer + side]), drawn_area);
 	}
+      lod_reset ();
       r_search (PCB->Data->pad_tree, drawn_area, NULL, pad_callback, &side);
       gui->end_layer ();
     }
@@ -802,18 +1075,18 @@ DrawEMark (ElementType *e, Coord X, Coord Y, bool invisible)
   if (!PCB->InvisibleObjectsOn && invisible)
     return;
 
-  if (e->Pin != NULL)
+  if (e->PinN != 0)
     {
-      PinType *pin0 = e->Pin->data;
+      PinType *pin0 = (PinType *) FirstObjectInList (&e->Pin);
       if (TEST_FLAG (HOLEFLAG, pin0))
 	mark_size = MIN (mark_size, pin0->DrillingHole / 2);
       else
 	mark_size = MIN (mark_size, pin0->Thickness / 2);
     }
 
-  if (e->Pad != NULL)
+  if (e->PadN != 0)
     {
-      PadType *pad0 = e->Pad->data;
+      PadType *pad0 = (PadType *) FirstObjectInList (&e->Pad);
       mark_size = MIN (mark_size, pad0->Thickness / 2);
     }
 
@@ -849,6 +1122,8 @@ DrawPPV (int group, const BoxType *drawn_area)
   int bottom_group = GetLayerGroupNumberBySide (BOTTOM_SIDE);
   int side;
 
+  lod_reset ();
+
   if (PCB->PinOn || !gui->gui)
     {
       /* draw element pins */
@@ -1091,6 +1366,8 @@ text_callback (const BoxType * b, void *cl)
     min_silk_line = PCB->minSlk;
   else
     min_silk_line = PCB->minWid;
+  if (lod_text (Output.fgGC, text))
+    return 1;
   gui->graphics->draw_pcb_text (Output.fgGC, text, min_silk_line);
   return 1;
 }
@@ -1682,6 +1959,7 @@ void
 hid_expose_callback (HID * hid, BoxType * region, void *item)
 {
   HID *old_gui = gui;
+  PERF_SPAN_BEGIN (expose, "draw", "expose");
 
   gui = hid;
   Output.fgGC = gui->graphics->make_gc ();
@@ -1704,4 +1982,5 @@ hid_expose_callback (HID * hid, BoxType * region, void *item)
   gui->graphics->destroy_gc (Output.bgGC);
   gui->graphics->destroy_gc (Output.pmGC);
   gui = old_gui;
+  PERF_SPAN_END (expose);
 }
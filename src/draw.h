@@ -76,5 +76,6 @@ void DrawSilk (int side, const BoxType *drawn_area);
 void DrawMask (int side, const BoxType *drawn_area);
 void DrawHoles (bool draw_plated, bool draw_unplated, const BoxType *drawn_area, Cardinal g_from, Cardinal g_to);
 void PrintAssembly (int side, const BoxType *drawn_area);
+bool DrawLevelOfDetail (void);
 
 #endif
@@ -43,6 +43,7 @@
 #include "misc.h" /* SaveStackAndVisibility */
 #include "object_list.h"
 #include "pcb-printf.h" /* Units */
+#include "perf.h" /* PERF_SPAN_BEGIN */
 /* PlowsPolygon, original_polygon, LinePoly, ArcPoly, Touching */
 #include "polygon.h" 
 #include "undo.h" /* Lock/Unlock Undo*/
@@ -715,6 +716,7 @@ DRCAll (void)
   int tmpcnt;
   int nopastecnt = 0;
   struct drc_info info;
+  PERF_SPAN_BEGIN (drc, "drc", "DRCAll");
   
   if (!drc_violation_list)
   {
@@ -1089,6 +1091,7 @@ DRCAll (void)
                        nopastecnt), nopastecnt);
   }
   object_list_delete(vobjs);
+  PERF_SPAN_END (drc);
   return drcerr_count;
 }
 
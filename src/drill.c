@@ -44,12 +44,15 @@
 #include <dmalloc.h>
 #endif
 
-/*
- * some local prototypes
+/*!
+ * \brief A pin or via waiting to be sorted into its drill set.
  */
-static void FillDrill (DrillType *, ElementType *, PinType *);
-static void InitializeDrill (DrillType *, PinType *, ElementType *);
-
+typedef struct
+{
+  ElementType *Element; /*!< The element of a pin, NULL for a via. */
+  PinType *Pin;
+  Cardinal Index; /*!< Board order, to keep the sort stable. */
+} HoleType;
 
 static void
 FillDrill (DrillType *Drill, ElementType *Element, PinType *Pin)
@@ -78,138 +81,77 @@ FillDrill (DrillType *Drill, ElementType *Element, PinType *Pin)
     Drill->UnplatedCount++;
 }
 
-static void
-InitializeDrill (DrillType *drill, PinType *pin, ElementType *element)
-{
-  void *ptr;
-
-  drill->DrillSize = pin->DrillingHole;
-  drill->ElementN = 0;
-  drill->ViaCount = 0;
-  drill->PinCount = 0;
-  drill->UnplatedCount = 0;
-  drill->ElementMax = 0;
-  drill->Element = NULL;
-  drill->PinN = 0;
-  drill->Pin = NULL;
-  drill->PinMax = 0;
-  ptr = (void *) GetDrillPinMemory (drill);
-  *((PinType **) ptr) = pin;
-  if (element)
-    {
-      ptr = (void *) GetDrillElementMemory (drill);
-      *((ElementType **) ptr) = element;
-      drill->PinCount = 1;
-    }
-  else
-    drill->ViaCount = 1;
-  if (TEST_FLAG (HOLEFLAG, pin))
-    drill->UnplatedCount = 1;
-}
-
+/*!
+ * \brief Order holes by drill size, keeping pins before vias and
+ * either in board order within a size.
+ */
 static int
-DrillQSort (const void *va, const void *vb)
+HoleQSort (const void *va, const void *vb)
 {
-  DrillType *a = (DrillType *) va;
-  DrillType *b = (DrillType *) vb;
-  return a->DrillSize - b->DrillSize;
+  const HoleType *a = (const HoleType *) va;
+  const HoleType *b = (const HoleType *) vb;
+
+  if (a->Pin->DrillingHole != b->Pin->DrillingHole)
+    return a->Pin->DrillingHole < b->Pin->DrillingHole ? -1 : 1;
+  return a->Index < b->Index ? -1 : a->Index > b->Index;
 }
 
+/*!
+ * \brief Collect the pins and vias of top into sets of equal drill
+ * size, smallest first.
+ *
+ * The holes are sorted by size once, instead of searching the list of
+ * drill sizes for every pin.
+ */
 DrillInfoType *
 GetDrillInfo (DataType *top)
 {
   DrillInfoType *AllDrills;
   DrillType *Drill = NULL;
-  DrillType savedrill, swapdrill;
-  bool DrillFound = false;
-  bool NewDrill;
+  HoleType *holes;
+  Cardinal n = 0, i;
 
   AllDrills = (DrillInfoType *)calloc (1, sizeof (DrillInfoType));
+  ELEMENT_LOOP (top);
+  {
+    n += element->PinN;
+  }
+  END_LOOP;
+  n += top->ViaN;
+  if (n == 0)
+    return (AllDrills);
+
+  holes = (HoleType *)malloc (n * sizeof (HoleType));
+  n = 0;
   ALLPIN_LOOP (top);
   {
-    if (!DrillFound)
-      {
-	DrillFound = true;
-	Drill = GetDrillInfoDrillMemory (AllDrills);
-	InitializeDrill (Drill, pin, element);
-      }
-    else
-      {
-	if (Drill->DrillSize == pin->DrillingHole)
-	  FillDrill (Drill, element, pin);
-	else
-	  {
-	    NewDrill = false;
-	    DRILL_LOOP (AllDrills);
-	    {
-	      if (drill->DrillSize == pin->DrillingHole)
-		{
-		  Drill = drill;
-		  FillDrill (Drill, element, pin);
-		  break;
-		}
-	      else if (drill->DrillSize > pin->DrillingHole)
-		{
-		  if (!NewDrill)
-		    {
-		      NewDrill = true;
-		      InitializeDrill (&swapdrill, pin, element);
-		      Drill = GetDrillInfoDrillMemory (AllDrills);
-		      Drill->DrillSize = pin->DrillingHole + 1;
-		      Drill = drill;
-		    }
-		  savedrill = *drill;
-		  *drill = swapdrill;
-		  swapdrill = savedrill;
-		}
-	    }
-	    END_LOOP;
-	    if (AllDrills->Drill[AllDrills->DrillN - 1].DrillSize <
-		pin->DrillingHole)
-	      {
-		Drill = GetDrillInfoDrillMemory (AllDrills);
-		InitializeDrill (Drill, pin, element);
-	      }
-	  }
-      }
+    holes[n].Element = element;
+    holes[n].Pin = pin;
+    holes[n].Index = n;
+    n++;
   }
   ENDALL_LOOP;
   VIA_LOOP (top);
   {
-    if (!DrillFound)
-      {
-	DrillFound = true;
-	Drill = GetDrillInfoDrillMemory (AllDrills);
-	Drill->DrillSize = via->DrillingHole;
-	FillDrill (Drill, NULL, via);
-      }
-    else
-      {
-	if (Drill->DrillSize != via->DrillingHole)
-	  {
-	    DRILL_LOOP (AllDrills);
-	    {
-	      if (drill->DrillSize == via->DrillingHole)
-		{
-		  Drill = drill;
-		  FillDrill (Drill, NULL, via);
-		  break;
-		}
-	    }
-	    END_LOOP;
-	    if (Drill->DrillSize != via->DrillingHole)
-	      {
-		Drill = GetDrillInfoDrillMemory (AllDrills);
-		Drill->DrillSize = via->DrillingHole;
-		FillDrill (Drill, NULL, via);
-	      }
-	  }
-	else
-	  FillDrill (Drill, NULL, via);
-      }
+    holes[n].Element = NULL;
+    holes[n].Pin = via;
+    holes[n].Index = n;
+    n++;
   }
   END_LOOP;
-  qsort (AllDrills->Drill, AllDrills->DrillN, sizeof (DrillType), DrillQSort);
+  qsort (holes, n, sizeof (HoleType), HoleQSort);
+
+  for (i = 0; i < n; i++)
+    {
+      if (Drill == NULL || Drill->DrillSize != holes[i].Pin->DrillingHole)
+	{
+	  Drill = GetDrillInfoDrillMemory (AllDrills);
+	  Drill->DrillSize = holes[i].Pin->DrillingHole;
+	}
+      FillDrill (Drill, holes[i].Element, holes[i].Pin);
+    }
+
+  free (holes);
   return (AllDrills);
 }
 
@@ -92,6 +92,7 @@
 #include "mymem.h"
 #include "parse_l.h"
 #include "pcb-printf.h"
+#include "perf.h"
 #include "polygon.h"
 #include "rats.h"
 #include "remove.h"
@@ -415,6 +416,8 @@ real_load_pcb (char *Filename, bool revert)
   char *new_filename;
   PCBType *newPCB = CreateNewPCB ();
   PCBType *oldPCB;
+  guint64 load_start = perf_now (), parse_start;
+  bool parsed;
 #ifdef DEBUG
   double elapsed;
   clock_t start, end;
@@ -431,7 +434,10 @@ real_load_pcb (char *Filename, bool revert)
   newPCB->Font.Valid = false;
 
   /* new data isn't added to the undo list */
-  if (!ParsePCB (PCB, new_filename))
+  parse_start = perf_now ();
+  parsed = !ParsePCB (PCB, new_filename);
+  perf_end (perf_stat ("load", "parse"), parse_start);
+  if (parsed)
     {
       RemovePCB (oldPCB);
 
@@ -494,6 +500,7 @@ real_load_pcb (char *Filename, bool revert)
 		new_filename, elapsed);
 #endif
 
+      perf_end (perf_stat ("load", "real_load_pcb"), load_start);
       return (0);
     }
   PCB = oldPCB;
@@ -644,18 +651,17 @@ WritePCBFontData (FILE * FP)
 static void
 WriteViaData (FILE * FP, DataType *Data)
 {
-  GList *iter;
   /* write information about vias */
-  for (iter = Data->Via; iter != NULL; iter = g_list_next (iter))
-    {
-      PinType *via = iter->data;
-      pcb_fprintf (FP, "Via[%mr %mr %mr %mr %mr %mr ", via->X, via->Y,
-                   via->Thickness, via->Clearance, via->Mask, via->DrillingHole);
-      if ((via->BuriedFrom != 0) || (via->BuriedTo != 0))
-        fprintf (FP, "%d %d ", via->BuriedFrom, via->BuriedTo);
-      PrintQuotedString (FP, (char *)EMPTY (via->Name));
-      fprintf (FP, " %s]\n", F2S (via, VIA_TYPE));
-    }
+  VIA_LOOP (Data);
+  {
+    pcb_fprintf (FP, "Via[%mr %mr %mr %mr %mr %mr ", via->X, via->Y,
+		 via->Thickness, via->Clearance, via->Mask, via->DrillingHole);
+    if ((via->BuriedFrom != 0) || (via->BuriedTo != 0))
+      fprintf (FP, "%d %d ", via->BuriedFrom, via->BuriedTo);
+    PrintQuotedString (FP, (char *)EMPTY (via->Name));
+    fprintf (FP, " %s]\n", F2S (via, VIA_TYPE));
+  }
+  END_LOOP;
 }
 
 /*!
@@ -664,16 +670,15 @@ WriteViaData (FILE * FP, DataType *Data)
 static void
 WritePCBRatData (FILE * FP)
 {
-  GList *iter;
   /* write information about rats */
-  for (iter = PCB->Data->Rat; iter != NULL; iter = g_list_next (iter))
-    {
-      RatType *line = iter->data;
-      pcb_fprintf (FP, "Rat[%mr %mr %d %mr %mr %d ",
-                   line->Point1.X, line->Point1.Y, line->group1,
-                   line->Point2.X, line->Point2.Y, line->group2);
-      fprintf (FP, " %s]\n", F2S (line, RATLINE_TYPE));
-    }
+  RAT_LOOP (PCB->Data);
+  {
+    pcb_fprintf (FP, "Rat[%mr %mr %d %mr %mr %d ",
+		 line->Point1.X, line->Point1.Y, line->group1,
+		 line->Point2.X, line->Point2.Y, line->group2);
+    fprintf (FP, " %s]\n", F2S (line, RATLINE_TYPE));
+  }
+  END_LOOP;
 }
 
 /*!
@@ -715,81 +720,79 @@ WritePCBNetlistData (FILE * FP)
 static void
 WriteElementData (FILE * FP, DataType *Data)
 {
-  GList *n, *p;
-  for (n = Data->Element; n != NULL; n = g_list_next (n))
+  ELEMENT_LOOP (Data);
+  {
+    /* only non empty elements */
+    if (!element->LineN && !element->PinN && !element->ArcN
+	&& !element->PadN)
+      continue;
+    /* the coordinates and text-flags are the same for
+     * both names of an element
+     */
+    fprintf (FP, "\nElement[%s ", F2S (element, ELEMENT_TYPE));
+    PrintQuotedString (FP, (char *)EMPTY (DESCRIPTION_NAME (element)));
+    fputc (' ', FP);
+    PrintQuotedString (FP, (char *)EMPTY (NAMEONPCB_NAME (element)));
+    fputc (' ', FP);
+    PrintQuotedString (FP, (char *)EMPTY (VALUE_NAME (element)));
+    pcb_fprintf (FP, " %mr %mr %mr %mr %d %d %s]\n(\n",
+		 element->MarkX, element->MarkY,
+		 DESCRIPTION_TEXT (element).X - element->MarkX,
+		 DESCRIPTION_TEXT (element).Y - element->MarkY,
+		 DESCRIPTION_TEXT (element).Direction,
+		 DESCRIPTION_TEXT (element).Scale,
+		 F2S (&(DESCRIPTION_TEXT (element)), ELEMENTNAME_TYPE));
+    WriteAttributeList (FP, &element->Attributes, "\t");
+    PIN_LOOP (element);
     {
-      ElementType *element = n->data;
-
-      /* only non empty elements */
-      if (!element->LineN && !element->PinN && !element->ArcN
-	  && !element->PadN)
-	continue;
-      /* the coordinates and text-flags are the same for
-       * both names of an element
-       */
-      fprintf (FP, "\nElement[%s ", F2S (element, ELEMENT_TYPE));
-      PrintQuotedString (FP, (char *)EMPTY (DESCRIPTION_NAME (element)));
-      fputc (' ', FP);
-      PrintQuotedString (FP, (char *)EMPTY (NAMEONPCB_NAME (element)));
-      fputc (' ', FP);
-      PrintQuotedString (FP, (char *)EMPTY (VALUE_NAME (element)));
-      pcb_fprintf (FP, " %mr %mr %mr %mr %d %d %s]\n(\n",
-                   element->MarkX, element->MarkY,
-                   DESCRIPTION_TEXT (element).X - element->MarkX,
-                   DESCRIPTION_TEXT (element).Y - element->MarkY,
-                   DESCRIPTION_TEXT (element).Direction,
-                   DESCRIPTION_TEXT (element).Scale,
-                   F2S (&(DESCRIPTION_TEXT (element)), ELEMENTNAME_TYPE));
-      WriteAttributeList (FP, &element->Attributes, "\t");
-      for (p = element->Pin; p != NULL; p = g_list_next (p))
-	{
-	  PinType *pin = p->data;
-          pcb_fprintf (FP, "\tPin[%mr %mr %mr %mr %mr %mr ",
-                       pin->X - element->MarkX,
-                       pin->Y - element->MarkY,
-                       pin->Thickness, pin->Clearance,
-                       pin->Mask, pin->DrillingHole);
-	  PrintQuotedString (FP, (char *)EMPTY (pin->Name));
-	  fprintf (FP, " ");
-	  PrintQuotedString (FP, (char *)EMPTY (pin->Number));
-	  fprintf (FP, " %s]\n", F2S (pin, PIN_TYPE));
-	}
-      for (p = element->Pad; p != NULL; p = g_list_next (p))
-	{
-	  PadType *pad = p->data;
-          pcb_fprintf (FP, "\tPad[%mr %mr %mr %mr %mr %mr %mr ",
-                       pad->Point1.X - element->MarkX,
-                       pad->Point1.Y - element->MarkY,
-                       pad->Point2.X - element->MarkX,
-                       pad->Point2.Y - element->MarkY,
-                       pad->Thickness, pad->Clearance, pad->Mask);
-	  PrintQuotedString (FP, (char *)EMPTY (pad->Name));
-	  fprintf (FP, " ");
-	  PrintQuotedString (FP, (char *)EMPTY (pad->Number));
-	  fprintf (FP, " %s]\n", F2S (pad, PAD_TYPE));
-	}
-      for (p = element->Line; p != NULL; p = g_list_next (p))
-	{
-	  LineType *line = p->data;
-          pcb_fprintf (FP, "\tElementLine [%mr %mr %mr %mr %mr]\n",
-                       line->Point1.X - element->MarkX,
-                       line->Point1.Y - element->MarkY,
-                       line->Point2.X - element->MarkX,
-                       line->Point2.Y - element->MarkY,
-                       line->Thickness);
-	}
-      for (p = element->Arc; p != NULL; p = g_list_next (p))
-	{
-	  ArcType *arc = p->data;
-          pcb_fprintf (FP, "\tElementArc [%mr %mr %mr %mr %ma %ma %mr]\n",
-                       arc->X - element->MarkX,
-                       arc->Y - element->MarkY,
-                       arc->Width, arc->Height,
-                       arc->StartAngle, arc->Delta,
-                       arc->Thickness);
-	}
-      fputs ("\n\t)\n", FP);
+      pcb_fprintf (FP, "\tPin[%mr %mr %mr %mr %mr %mr ",
+		   pin->X - element->MarkX,
+		   pin->Y - element->MarkY,
+		   pin->Thickness, pin->Clearance,
+		   pin->Mask, pin->DrillingHole);
+      PrintQuotedString (FP, (char *)EMPTY (pin->Name));
+      fprintf (FP, " ");
+      PrintQuotedString (FP, (char *)EMPTY (pin->Number));
+      fprintf (FP, " %s]\n", F2S (pin, PIN_TYPE));
+    }
+    END_LOOP;
+    PAD_LOOP (element);
+    {
+      pcb_fprintf (FP, "\tPad[%mr %mr %mr %mr %mr %mr %mr ",
+		   pad->Point1.X - element->MarkX,
+		   pad->Point1.Y - element->MarkY,
+		   pad->Point2.X - element->MarkX,
+		   pad->Point2.Y - element->MarkY,
+		   pad->Thickness, pad->Clearance, pad->Mask);
+      PrintQuotedString (FP, (char *)EMPTY (pad->Name));
+      fprintf (FP, " ");
+      PrintQuotedString (FP, (char *)EMPTY (pad->Number));
+      fprintf (FP, " %s]\n", F2S (pad, PAD_TYPE));
+    }
+    END_LOOP;
+    ELEMENTLINE_LOOP (element);
+    {
+      pcb_fprintf (FP, "\tElementLine [%mr %mr %mr %mr %mr]\n",
+		   line->Point1.X - element->MarkX,
+		   line->Point1.Y - element->MarkY,
+		   line->Point2.X - element->MarkX,
+		   line->Point2.Y - element->MarkY,
+		   line->Thickness);
+    }
+    END_LOOP;
+    ELEMENTARC_LOOP (element);
+    {
+      pcb_fprintf (FP, "\tElementArc [%mr %mr %mr %mr %ma %ma %mr]\n",
+		   arc->X - element->MarkX,
+		   arc->Y - element->MarkY,
+		   arc->Width, arc->Height,
+		   arc->StartAngle, arc->Delta,
+		   arc->Thickness);
     }
+    END_LOOP;
+    fputs ("\n\t)\n", FP);
+  }
+  END_LOOP;
 }
 
 /*!
@@ -798,7 +801,6 @@ WriteElementData (FILE * FP, DataType *Data)
 static void
 WriteLayerData (FILE * FP, Cardinal Number, LayerType *layer)
 {
-  GList *n;
   /* write information about non empty layers */
   if (layer->LineN || layer->ArcN || layer->TextN || layer->PolygonN ||
       (layer->Name && *layer->Name))
@@ -808,65 +810,65 @@ WriteLayerData (FILE * FP, Cardinal Number, LayerType *layer)
       fprintf (FP, " \"%s\")\n(\n", layertype_to_string (layer->Type));
       WriteAttributeList (FP, &layer->Attributes, "\t");
 
-      for (n = layer->Line; n != NULL; n = g_list_next (n))
-	{
-	  LineType *line = n->data;
-          pcb_fprintf (FP, "\tLine[%mr %mr %mr %mr %mr %mr %s]\n",
-                       line->Point1.X, line->Point1.Y,
-                       line->Point2.X, line->Point2.Y,
-                       line->Thickness, line->Clearance,
-                       F2S (line, LINE_TYPE));
-	}
-      for (n = layer->Arc; n != NULL; n = g_list_next (n))
-	{
-	  ArcType *arc = n->data;
-          pcb_fprintf (FP, "\tArc[%mr %mr %mr %mr %mr %mr %ma %ma %s]\n",
-                       arc->X, arc->Y, arc->Width,
-                       arc->Height, arc->Thickness,
-                       arc->Clearance, arc->StartAngle,
-                       arc->Delta, F2S (arc, ARC_TYPE));
-	}
-      for (n = layer->Text; n != NULL; n = g_list_next (n))
-	{
-	  TextType *text = n->data;
-          pcb_fprintf (FP, "\tText[%mr %mr %d %d ",
-                       text->X, text->Y,
-                       text->Direction, text->Scale);
-	  PrintQuotedString (FP, (char *)EMPTY (text->TextString));
-	  fprintf (FP, " %s]\n", F2S (text, TEXT_TYPE));
-	}
-      for (n = layer->Polygon; n != NULL; n = g_list_next (n))
-	{
-	  PolygonType *polygon = n->data;
-	  int p, i = 0;
-	  Cardinal hole = 0;
-	  fprintf (FP, "\tPolygon(%s)\n\t(", F2S (polygon, POLYGON_TYPE));
-	  for (p = 0; p < polygon->PointN; p++)
-	    {
-	      PointType *point = &polygon->Points[p];
-
-	      if (hole < polygon->HoleIndexN &&
-		  p == polygon->HoleIndex[hole])
-		{
-		  if (hole > 0)
-		    fputs ("\n\t\t)", FP);
-		  fputs ("\n\t\tHole (", FP);
-		  hole++;
-		  i = 0;
-		}
-
-	      if (i++ % 5 == 0)
-		{
-		  fputs ("\n\t\t", FP);
-		  if (hole)
-		    fputs ("\t", FP);
-		}
-              pcb_fprintf (FP, "[%mr %mr] ", point->X, point->Y);
-	    }
-	  if (hole > 0)
-	    fputs ("\n\t\t)", FP);
-	  fputs ("\n\t)\n", FP);
-	}
+      LINE_LOOP (layer);
+      {
+	pcb_fprintf (FP, "\tLine[%mr %mr %mr %mr %mr %mr %s]\n",
+		     line->Point1.X, line->Point1.Y,
+		     line->Point2.X, line->Point2.Y,
+		     line->Thickness, line->Clearance,
+		     F2S (line, LINE_TYPE));
+      }
+      END_LOOP;
+      ARC_LOOP (layer);
+      {
+	pcb_fprintf (FP, "\tArc[%mr %mr %mr %mr %mr %mr %ma %ma %s]\n",
+		     arc->X, arc->Y, arc->Width,
+		     arc->Height, arc->Thickness,
+		     arc->Clearance, arc->StartAngle,
+		     arc->Delta, F2S (arc, ARC_TYPE));
+      }
+      END_LOOP;
+      TEXT_LOOP (layer);
+      {
+	pcb_fprintf (FP, "\tText[%mr %mr %d %d ",
+		     text->X, text->Y,
+		     text->Direction, text->Scale);
+	PrintQuotedString (FP, (char *)EMPTY (text->TextString));
+	fprintf (FP, " %s]\n", F2S (text, TEXT_TYPE));
+      }
+      END_LOOP;
+      POLYGON_LOOP (layer);
+      {
+	int p, i = 0;
+	Cardinal hole = 0;
+	fprintf (FP, "\tPolygon(%s)\n\t(", F2S (polygon, POLYGON_TYPE));
+	for (p = 0; p < polygon->PointN; p++)
+	  {
+	    PointType *point = &polygon->Points[p];
+
+	    if (hole < polygon->HoleIndexN &&
+		p == polygon->HoleIndex[hole])
+	      {
+		if (hole > 0)
+		  fputs ("\n\t\t)", FP);
+		fputs ("\n\t\tHole (", FP);
+		hole++;
+		i = 0;
+	      }
+
+	    if (i++ % 5 == 0)
+	      {
+		fputs ("\n\t\t", FP);
+		if (hole)
+		  fputs ("\t", FP);
+	      }
+	    pcb_fprintf (FP, "[%mr %mr] ", point->X, point->Y);
+	  }
+	if (hole > 0)
+	  fputs ("\n\t\t)", FP);
+	fputs ("\n\t)\n", FP);
+      }
+      END_LOOP;
       fputs (")\n", FP);
     }
 }
@@ -92,6 +92,7 @@
 #include "rtree.h"
 #include "polygon.h"
 #include "pcb-printf.h"
+#include "perf.h"
 #include "search.h"
 #include "set.h"
 #include "undo.h"
@@ -2133,7 +2134,6 @@ LookupLOConnectionsToArc (ArcType *Arc, Cardinal LayerGroup, int flag, bool AndR
     {
       Cardinal layer_no;
       LayerType *layer;
-      GList *i;
 
       layer_no = PCB->LayerGroups.Entries[LayerGroup][entry];
       layer = LAYER_PTR (layer_no);
@@ -2158,13 +2158,13 @@ LookupLOConnectionsToArc (ArcType *Arc, Cardinal LayerGroup, int flag, bool AndR
             return true;
 
           /* now check all polygons */
-          for (i = layer->Polygon; i != NULL; i = g_list_next (i))
-            {
-              PolygonType *polygon = i->data;
-              if (!TEST_FLAG (flag, polygon) && IsArcInPolygon (Arc, polygon)
-                  && ADD_POLYGON_TO_LIST (layer_no, polygon, flag))
-                return true;
-            }
+          POLYGON_LOOP (layer);
+          {
+	    if (!TEST_FLAG (flag, polygon) && IsArcInPolygon (Arc, polygon)
+		&& ADD_POLYGON_TO_LIST (layer_no, polygon, flag))
+	      return true;
+          }
+          END_LOOP;
         }
       else
         {
@@ -2310,14 +2310,13 @@ LookupLOConnectionsToLine (LineType *Line, Cardinal LayerGroup,
           /* now check all polygons */
           if (PolysTo)
             {
-              GList *i;
-              for (i = layer->Polygon; i != NULL; i = g_list_next (i))
-                {
-                  PolygonType *polygon = i->data;
-                  if (!TEST_FLAG (flag, polygon) && IsLineInPolygon (Line, polygon)
-                      && ADD_POLYGON_TO_LIST (layer_no, polygon, flag))
-                    return true;
-                }
+              POLYGON_LOOP (layer);
+              {
+		if (!TEST_FLAG (flag, polygon) && IsLineInPolygon (Line, polygon)
+		    && ADD_POLYGON_TO_LIST (layer_no, polygon, flag))
+		  return true;
+              }
+              END_LOOP;
             }
         }
       else
@@ -2728,17 +2727,15 @@ LookupLOConnectionsToPolygon (PolygonType *Polygon, Cardinal LayerGroup, int fla
       /* handle normal layers */
       if (layer_no < max_copper_layer)
         {
-          GList *i;
-
           /* check all polygons */
-          for (i = layer->Polygon; i != NULL; i = g_list_next (i))
-            {
-              PolygonType *polygon = i->data;
-              if (!TEST_FLAG (flag, polygon)
-                  && IsPolygonInPolygon (polygon, Polygon)
-                  && ADD_POLYGON_TO_LIST (layer_no, polygon, flag))
-                return true;
-            }
+          POLYGON_LOOP (layer);
+          {
+	    if (!TEST_FLAG (flag, polygon)
+		&& IsPolygonInPolygon (polygon, Polygon)
+		&& ADD_POLYGON_TO_LIST (layer_no, polygon, flag))
+	      return true;
+          }
+          END_LOOP;
 
           info.layer = layer_no;
           /* check all lines */
@@ -3134,6 +3131,7 @@ LookupConnection (Coord X, Coord Y, bool AndDraw, Coord Range, int flag,
   void *ptr1, *ptr2, *ptr3;
   char *name;
   int type;
+  PERF_SPAN_BEGIN (lookup, "find", "LookupConnection");
 
   /* check if there are any pins or pads at that position */
 
@@ -3150,7 +3148,10 @@ LookupConnection (Coord X, Coord Y, bool AndDraw, Coord Range, int flag,
         LOOKUP_MORE & ~(AndRats ? 0 : RATLINE_TYPE),
         &ptr1, &ptr2, &ptr3, X, Y, Range);
       if (type == NO_TYPE)
-        return;
+        {
+          PERF_SPAN_END (lookup);
+          return;
+        }
       if (type & SILK_TYPE)
         {
           int laynum = GetLayerNumber (PCB->Data,
@@ -3158,7 +3159,10 @@ LookupConnection (Coord X, Coord Y, bool AndDraw, Coord Range, int flag,
 
           /* don't mess with non-conducting objects! */
           if (laynum >= max_copper_layer || ((LayerType *)ptr1)->no_drc)
-            return;
+            {
+              PERF_SPAN_END (lookup);
+              return;
+            }
         }
     }
 
@@ -3183,6 +3187,7 @@ LookupConnection (Coord X, Coord Y, bool AndDraw, Coord Range, int flag,
   if (AndDraw && Settings.RingBellWhenFinished)
     gui->beep ();
   FreeConnectionLookupMemory ();
+  PERF_SPAN_END (lookup);
 }
 
 void 
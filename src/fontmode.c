@@ -196,7 +196,6 @@ FontSave (int argc, char **argv, Coord Ux, Coord Uy)
   FontType *font;
   SymbolType *symbol;
   int i;
-  GList *ii;
   LayerType *lfont, *lwidth;
 
   font = &PCB->Font;
@@ -210,50 +209,50 @@ FontSave (int argc, char **argv, Coord Ux, Coord Uy)
       font->Symbol[i].Width = 0;
     }
 
-  for (ii = lfont->Line; ii != NULL; ii = g_list_next (ii))
-    {
-      LineType *l = ii->data;
-      Coord x1 = l->Point1.X;
-      Coord y1 = l->Point1.Y;
-      Coord x2 = l->Point2.X;
-      Coord y2 = l->Point2.Y;
-      Coord ox, oy;
-      int s;
-
-      s = XYtoSym (x1, y1);
-      ox = (s % 16 + 1) * CELL_SIZE;
-      oy = (s / 16 + 1) * CELL_SIZE;
-      symbol = &PCB->Font.Symbol[s];
-
-      x1 -= ox;
-      y1 -= oy;
-      x2 -= ox;
-      y2 -= oy;
-
-      if (symbol->Width < x1)
-	symbol->Width = x1;
-      if (symbol->Width < x2)
-	symbol->Width = x2;
-      symbol->Valid = 1;
-
-      CreateNewLineInSymbol (symbol, x1, y1, x2, y2, l->Thickness);
-    }
-
-  for (ii = lwidth->Line; ii != NULL; ii = g_list_next (ii))
-    {
-      LineType *l = ii->data;
-      Coord x1 = l->Point1.X;
-      Coord y1 = l->Point1.Y;
-      Coord ox, s;
-
-      s = XYtoSym (x1, y1);
-      ox = (s % 16 + 1) * CELL_SIZE;
-      symbol = &PCB->Font.Symbol[s];
-
-      x1 -= ox;
-
-      symbol->Delta = x1 - symbol->Width;
-    }
+  OBJECT_LIST_LOOP (lfont->Line, LineType, l);
+  {
+    Coord x1 = l->Point1.X;
+    Coord y1 = l->Point1.Y;
+    Coord x2 = l->Point2.X;
+    Coord y2 = l->Point2.Y;
+    Coord ox, oy;
+    int s;
+
+    s = XYtoSym (x1, y1);
+    ox = (s % 16 + 1) * CELL_SIZE;
+    oy = (s / 16 + 1) * CELL_SIZE;
+    symbol = &PCB->Font.Symbol[s];
+
+    x1 -= ox;
+    y1 -= oy;
+    x2 -= ox;
+    y2 -= oy;
+
+    if (symbol->Width < x1)
+      symbol->Width = x1;
+    if (symbol->Width < x2)
+      symbol->Width = x2;
+    symbol->Valid = 1;
+
+    CreateNewLineInSymbol (symbol, x1, y1, x2, y2, l->Thickness);
+  }
+  END_LOOP;
+
+  OBJECT_LIST_LOOP (lwidth->Line, LineType, l);
+  {
+    Coord x1 = l->Point1.X;
+    Coord y1 = l->Point1.Y;
+    Coord ox, s;
+
+    s = XYtoSym (x1, y1);
+    ox = (s % 16 + 1) * CELL_SIZE;
+    symbol = &PCB->Font.Symbol[s];
+
+    x1 -= ox;
+
+    symbol->Delta = x1 - symbol->Width;
+  }
+  END_LOOP;
 
   SetFontInfo (font);
   
@@ -169,6 +169,7 @@ typedef unsigned char BYTE;
 	BoxType		BoundingBox;	\
 	long int	ID;		\
 	FlagType	Flags;		\
+	Cardinal	ListSlot;	/* where in its ObjectListType */ \
 	//	struct LibraryEntryType *net
 
 /* Lines, pads, and rats all use this so they can be cross-cast.  */
@@ -245,6 +246,24 @@ typedef struct {
   ANYOBJECTFIELDS;
 } AnyObjectType;
 
+/*!
+ * \brief The objects of one type on a layer, in an element or in a
+ * data set.
+ *
+ * Pointers to the objects in the order they were added, in one array.
+ * Removing an object leaves a NULL hole, so the other objects keep
+ * their slots while a loop walks the list; CompactObjectList ()
+ * squeezes the holes out when nothing is walking it.  Each object
+ * remembers its slot in ListSlot, which makes removal O(1).
+ */
+typedef struct
+{
+  Cardinal PtrN; /*!< Slots in use, holes included. */
+  Cardinal PtrMax; /*!< Slots allocated. */
+  Cardinal Holes; /*!< Slots of removed objects. */
+  void **Ptr;
+} ObjectListType;
+
 /*!
  * \brief A line/polygon point.
  */
@@ -332,10 +351,10 @@ typedef struct
   Cardinal TextN; /*!< Labels. */
   Cardinal PolygonN; /*!< Polygons. */
   Cardinal ArcN; /*!< Arcs. */
-  GList *Line;
-  GList *Text;
-  GList *Polygon;
-  GList *Arc;
+  ObjectListType Line;
+  ObjectListType Text;
+  ObjectListType Polygon;
+  ObjectListType Arc;
   rtree_t *line_tree, *text_tree, *polygon_tree, *arc_tree;
   bool On; /*!< Visible flag. */
   char *Color, /*!< Color. */
@@ -413,10 +432,10 @@ typedef struct
   Cardinal PadN; /*!< Number of pads. */
   Cardinal LineN; /*!< Number of lines. */
   Cardinal ArcN; /*!< Number of arcs. */
-  GList *Pin;
-  GList *Pad;
-  GList *Line;
-  GList *Arc;
+  ObjectListType Pin;
+  ObjectListType Pad;
+  ObjectListType Line;
+  ObjectListType Arc;
   BoxType VBox;
   AttributeListType Attributes;
 } ElementType;
@@ -459,9 +478,9 @@ typedef struct
   Cardinal ElementN; /*!< Number of elements. */
   Cardinal RatN; /*!< Number of rat-lines. */
   int LayerN; /*!< Number of layers in this board. */
-  GList *Via;
-  GList *Element;
-  GList *Rat;
+  ObjectListType Via;
+  ObjectListType Element;
+  ObjectListType Rat;
   rtree_t *via_tree, *element_tree, *pin_tree, *pad_tree, *name_tree[3],	/* for element names */
    *rat_tree;
   struct PCBType *pcb;
@@ -781,6 +800,10 @@ typedef struct
     Mode, /*!< Currently active mode. */
     BufferNumber; /*!< Number of the current buffer. */
   int BackupInterval; /*!< Time between two backups in seconds. */
+  int AutorouteJobs; /*!< Nets the autorouter may route in parallel. */
+  int AutorouteAttempts; /*!< Perturbed routing attempts to keep the best of. */
+  int AutorouteTimeLimit; /*!< Seconds the routing attempts may take. */
+  int AutoplaceChains; /*!< Parallel tempering chains of the autoplacer. */
   char *DefaultLayerName[MAX_LAYER],
    *FontCommand, /*!< Command for font file loading. */
    *FileCommand, /*!< Command for file loading. */
@@ -809,7 +832,10 @@ typedef struct
    *FabAuthor, /*!< Full name of author for FAB drawings. */
    *GnetlistProgram, /*!< gnetlist program name. */
    *MakeProgram, /*!< make program name. */
-   *InitialLayerStack; /*!< If set, the initial layer stack is set to this. */
+   *InitialLayerStack, /*!< If set, the initial layer stack is set to this. */
+   *AutorouteProfile, /*!< File for the autorouter's JSON profile. */
+   *PerfJson, /*!< File for the performance counters at exit. */
+   *PerfTrace; /*!< File for the Chrome trace of timed spans. */
   Coord PinoutOffsetX; /*!< Offset of origin (X value). */
   Coord PinoutOffsetY; /*!< Offset of origin (Y value). */
   Coord PinoutTextOffsetX; /*!< Offset of text from pin center (X value). */
@@ -825,6 +851,7 @@ typedef struct
     SaveInTMP, /*!< Always save data in /tmp. */
     SaveMetricOnly, /*!< Save with mm suffix only, not mil/mm hybrid. */
     DrawGrid, /*!< Draw grid points. */
+    LevelOfDetail, /*!< Simplify objects too small to see when zoomed out. */
     RatWarn, /*!< Rats nest has set warnings. */
     StipplePolygons, /*!< Draw polygons with stipple. */
     AllDirectionLines, /*!< Enable lines to all directions. */
@@ -53,14 +53,21 @@ typedef struct heap_struct heap_t;
 heap_t *heap_create ();
 void heap_destroy (heap_t ** heap);
 void heap_free (heap_t * heap, void (*funcfree) (void *));
+void heap_reserve (heap_t * heap, int size);
 
 /* -- mutation -- */
 void heap_insert (heap_t * heap, cost_t cost, void *data);
 void *heap_remove_smallest (heap_t * heap);
 void *heap_replace (heap_t * heap, cost_t cost, void *data);
+void heap_append (heap_t * heap, cost_t cost, void *data);
+void heap_build (heap_t * heap);
 
 /* -- interrogation -- */
 int heap_is_empty (heap_t * heap);
 int heap_size (heap_t * heap);
 
+#ifdef PCB_UNIT_TEST
+void heap_register_tests (void);
+#endif /* PCB_UNIT_TEST */
+
 #endif /* PCB_HEAP_H */
@@ -140,6 +140,9 @@ extern "C"
       /*!< Short description that sometimes accompanies the name.  */
     const char *syntax;
       /*!< Full allowed syntax; use \\n to separate lines.  */
+    struct PerfStat *perf;
+      /*!< Timing statistics, looked up by the first call.  Leave this
+       * out of the initializer.  */
   } HID_Action;
 
   extern void hid_register_action (HID_Action *);
@@ -456,6 +459,12 @@ typedef enum
 
     void (*invalidate_all) (void);
 
+    void (*invalidate_rects) (const struct BoxType *rects_, int n_rects_);
+      /*!< Optional.  Redraw several areas of the board at once, given as
+       * \p n_rects boxes.  When this is NULL, invalidate_lr () is called
+       * for each of them.
+       */
+
     void (*notify_crosshair_change) (bool changes_complete);
 
     void (*notify_mark_change) (bool changes_complete);
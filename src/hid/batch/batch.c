@@ -42,12 +42,29 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <ctype.h>
+#include <errno.h>
+
+#if defined(HAVE_SYS_SOCKET_H) && defined(HAVE_SYS_UN_H) \
+    && defined(HAVE_POLL_H) && defined(HAVE_SYS_WAIT_H) && defined(HAVE_FORK)
+#define BATCH_SERVER 1
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#endif
 
 #include "global.h"
+#include "create.h"
 #include "crosshair.h"
 #include "hid.h"
 #include "data.h"
+#include "error.h"
 #include "misc.h"
+#include "undo.h"
 #include "hid.h"
 #include "hid_draw.h"
 #include "../hidint.h"
@@ -67,6 +84,8 @@ typedef struct hid_gc_struct
   int nothing_interesting_here;
 } hid_gc_struct;
 
+static HID batch_hid;
+
 static HID_Attribute *
 batch_get_export_options (int *n_ret)
 {
@@ -152,12 +171,649 @@ REGISTER_ACTIONS (batch_action_list)
 
 /* ----------------------------------------------------------------------------- */
 
+static char *server_path = NULL;
+static int server_readers = 4;
+
+HID_Attribute batch_attribute_list[] = {
+/* %start-doc options "23 Batch Options"
+@ftable @code
+@item --server <path>
+Instead of reading actions from standard input, serve them on the Unix
+socket @var{path}.  Every line a client sends is a context name and an
+action string, as in @samp{b1 LoadFrom(Layout,foo.pcb)}.  Each context
+keeps its own board and undo history; the board starts out empty the
+first time the name is used, and @samp{default} is the board given on
+the command line.  Every line is answered with one line of JSON
+holding the request's number on that connection, the context, the
+return code of the actions and what they printed.  Clients may send
+any number of lines before reading the replies, which come back in
+order.  Blank lines and lines starting with @samp{#} are ignored.
+Dialogs are answered with their defaults.  @code{Quit} stops the
+server once the requests already running have answered and every reply
+has been sent; a socket left at @var{path} by an earlier server is
+replaced, but nothing else is.
+@end ftable
+%end-doc
+*/
+  {"server", "Serve actions on this Unix socket",
+   HID_String, 0, 0, {0, 0, 0}, 0, &server_path},
+#define HA_server 0
+
+/* %start-doc options "23 Batch Options"
+@ftable @code
+@item --server-readers <num>
+How many requests made only of read-only actions (@code{DRC},
+@code{Export}, @code{Help}, @code{Info}, @code{Report}) the server runs
+at once.  Each one runs in a forked copy of the server, so they see the
+board as it was when they started and cannot change it.  All other
+requests run one at a time in the server itself.  Default is 4; 0 runs
+every request in the server.
+@end ftable
+%end-doc
+*/
+  {"server-readers", "Read-only requests to run in parallel",
+   HID_Integer, 0, 64, {4, 0, 0}, 0, &server_readers},
+#define HA_server_readers 1
+};
+
+REGISTER_ATTRIBUTES (batch_attribute_list)
+
+#ifdef BATCH_SERVER
+
+/*!
+ * \brief A board the server keeps loaded for its clients.
+ */
+typedef struct
+{
+  char *name;
+  PCBType *pcb;
+  UndoStateType *undo; /*!< Its undo history while another is current. */
+} ServerContext;
+
+/*!
+ * \brief A client connection.
+ */
+typedef struct
+{
+  int fd;
+  GString *in; /*!< Received, not yet handled. */
+  GString *out; /*!< Replies not yet sent. */
+  int seq; /*!< Requests handled so far. */
+  bool eof; /*!< The client has closed its end. */
+  pid_t reader; /*!< Forked reader answering the current request, or 0. */
+  int reader_fd; /*!< Where the reader's reply comes from. */
+  size_t reader_bytes; /*!< How much of it came so far. */
+  char *reader_context;
+} ServerClient;
+
+static GHashTable *contexts;
+static ServerContext *current_context;
+static int listen_fd = -1;
+static GPtrArray *clients;
+static int readers_running = 0;
+static bool server_quitting = false;
+
+/* Requests made only of these may run in a forked reader: whatever
+   they do to the board is thrown away with the reader.  */
+static const char *read_only_actions[] = {
+  "DRC", "Export", "Help", "Info", "Report", NULL
+};
+
+/*!
+ * \brief Append str to s as a JSON string.
+ *
+ * Layouts and their messages aren't necessarily UTF-8.  Bytes that
+ * don't start a valid UTF-8 sequence are taken to be Latin-1 and
+ * escaped, so the reply is valid JSON whatever the board holds.
+ */
+static void
+json_append_string (GString *s, const char *str)
+{
+  g_string_append_c (s, '"');
+  while (*str)
+    {
+      unsigned char ch = *str;
+
+      if (ch == '"' || ch == '\\')
+	g_string_append_printf (s, "\\%c", ch);
+      else if (ch < ' ')
+	g_string_append_printf (s, "\\u%04x", ch);
+      else if (ch >= 0x80)
+	{
+	  const char *next = g_utf8_next_char (str);
+
+	  if (g_utf8_get_char_validated (str, next - str) < (gunichar) -2)
+	    {
+	      g_string_append_len (s, str, next - str);
+	      str = next;
+	      continue;
+	    }
+	  g_string_append_printf (s, "\\u%04x", ch);
+	}
+      else
+	g_string_append_c (s, ch);
+      str++;
+    }
+  g_string_append_c (s, '"');
+}
+
+static void
+server_reply (GString *out, int id, const char *context, int status,
+	      const char *output)
+{
+  g_string_append_printf (out, "{\"id\": %d, \"context\": ", id);
+  json_append_string (out, context);
+  g_string_append_printf (out, ", \"status\": %d, \"output\": ", status);
+  json_append_string (out, output);
+  g_string_append (out, "}\n");
+}
+
+/*!
+ * \brief Check whether every action in an action string is in
+ * read_only_actions.
+ *
+ * Anything that doesn't parse the way hid_parse_actions () would is
+ * not read-only, and is left for it to complain about.
+ */
+static bool
+actions_read_only (const char *s)
+{
+  while (1)
+    {
+      const char *name;
+      char quote = 0;
+      size_t len;
+      int i;
+
+      while (*s && (isspace ((int) *s) || *s == ';'))
+	s++;
+      if (!*s)
+	return true;
+      for (name = s; *s && !isspace ((int) *s) && *s != '('; s++)
+	;
+      len = s - name;
+      for (i = 0; read_only_actions[i]; i++)
+	if (strlen (read_only_actions[i]) == len
+	    && strncasecmp (read_only_actions[i], name, len) == 0)
+	  break;
+      if (read_only_actions[i] == NULL)
+	return false;
+      while (*s && isspace ((int) *s))
+	s++;
+      if (*s != '(')
+	return *s == '\0';
+      for (s++; *s && (quote || *s != ')'); s++)
+	if (*s == '\\' && quote != '\'' && s[1])
+	  s++;
+	else if (*s == '"' || *s == '\'')
+	  quote = quote == *s ? 0 : (quote ? quote : *s);
+      if (!*s)
+	return false;
+      s++;
+    }
+}
+
+/*!
+ * \brief Run an action string, collecting what it prints in Output.
+ */
+static int
+server_run_actions (const char *actions, GString *output)
+{
+  FILE *tmp = tmpfile ();
+  char buf[4096];
+  size_t n;
+  int saved, ret;
+
+  if (tmp == NULL)
+    return hid_parse_actions (actions);
+  fflush (stdout);
+  saved = dup (1);
+  dup2 (fileno (tmp), 1);
+  ret = hid_parse_actions (actions);
+  fflush (stdout);
+  dup2 (saved, 1);
+  close (saved);
+  rewind (tmp);
+  while ((n = fread (buf, 1, sizeof (buf), tmp)) > 0)
+    g_string_append_len (output, buf, n);
+  fclose (tmp);
+  return ret;
+}
+
+/*!
+ * \brief Make the named context's board the current PCB, creating an
+ * empty one for a new name.
+ */
+static void
+server_switch (const char *name)
+{
+  ServerContext *ctx = (ServerContext *) g_hash_table_lookup (contexts, name);
+
+  if (ctx == current_context)
+    return;
+  /* LoadFrom() and New() replace PCB, so pick it up only now */
+  current_context->pcb = PCB;
+  /* undo.c keeps one history for the whole process, so set this
+     board's aside until it is current again */
+  current_context->undo = DetachUndoList ();
+  if (ctx == NULL)
+    {
+      ctx = g_new0 (ServerContext, 1);
+      ctx->name = g_strdup (name);
+      ctx->pcb = CreateNewPCB ();
+      CreateNewPCBPost (ctx->pcb, 1);
+      g_hash_table_insert (contexts, ctx->name, ctx);
+    }
+  PCB = ctx->pcb;
+  AttachUndoList (ctx->undo);
+  ctx->undo = NULL;
+  current_context = ctx;
+  hid_action ("PCBChanged");
+}
+
+/*!
+ * \brief In a forked reader, close the descriptors it inherited from
+ * the server.
+ *
+ * Otherwise a client the server hangs up on would not see EOF until
+ * every reader forked meanwhile had exited.
+ */
+static void
+server_close_inherited (void)
+{
+  guint i;
+
+  close (listen_fd);
+  for (i = 0; i < clients->len; i++)
+    {
+      ServerClient *c = (ServerClient *) g_ptr_array_index (clients, i);
+
+      close (c->fd);
+      if (c->reader)
+	close (c->reader_fd);
+    }
+}
+
+static void
+write_full (int fd, const char *buf, size_t len)
+{
+  while (len > 0)
+    {
+      ssize_t n = write (fd, buf, len);
+
+      if (n < 0 && errno == EINTR)
+	continue;
+      if (n <= 0)
+	return;
+      buf += n;
+      len -= n;
+    }
+}
+
+/*!
+ * \brief Handle one request line: "context actions".
+ *
+ * Read-only requests go to a forked reader while there are fewer than
+ * server_readers of them; the client's later requests wait until the
+ * reader has answered, so replies stay in order.  The reader switches
+ * to the context itself, leaving the server's current board and undo
+ * history alone.
+ */
+static void
+server_request (ServerClient *c, char *line)
+{
+  GString *output;
+  char *actions;
+  int status;
+  int pipefd[2];
+
+  line = g_strstrip (line);
+  if (*line == '\0' || *line == '#')
+    return;
+  c->seq++;
+  for (actions = line; *actions && !isspace ((int) *actions); actions++)
+    ;
+  if (*actions)
+    *actions++ = '\0';
+
+  if (readers_running < server_readers && actions_read_only (actions)
+      && pipe (pipefd) == 0)
+    {
+      fflush (stdout);
+      c->reader = fork ();
+      if (c->reader == 0)
+	{
+	  GString *reply = g_string_new ("");
+
+	  close (pipefd[0]);
+	  server_close_inherited ();
+	  server_switch (line);
+	  output = g_string_new ("");
+	  status = server_run_actions (actions, output);
+	  server_reply (reply, c->seq, line, status, output->str);
+	  write_full (pipefd[1], reply->str, reply->len);
+	  _exit (0);
+	}
+      close (pipefd[1]);
+      if (c->reader > 0)
+	{
+	  c->reader_fd = pipefd[0];
+	  c->reader_bytes = 0;
+	  c->reader_context = g_strdup (line);
+	  readers_running++;
+	  return;
+	}
+      close (pipefd[0]);
+      c->reader = 0;
+    }
+
+  server_switch (line);
+  output = g_string_new ("");
+  status = server_run_actions (actions, output);
+  server_reply (c->out, c->seq, line, status, output->str);
+  g_string_free (output, TRUE);
+}
+
+static void
+server_read_reader (ServerClient *c)
+{
+  char buf[4096];
+  ssize_t n = read (c->reader_fd, buf, sizeof (buf));
+
+  if (n > 0)
+    {
+      g_string_append_len (c->out, buf, n);
+      c->reader_bytes += n;
+      return;
+    }
+  if (n < 0 && (errno == EINTR || errno == EAGAIN))
+    return;
+  close (c->reader_fd);
+  waitpid (c->reader, NULL, 0);
+  if (c->reader_bytes == 0)
+    server_reply (c->out, c->seq, c->reader_context, -1,
+		  "reader exited without replying\n");
+  g_free (c->reader_context);
+  c->reader = 0;
+  readers_running--;
+}
+
+static void
+server_read_client (ServerClient *c)
+{
+  char buf[4096];
+  ssize_t n = read (c->fd, buf, sizeof (buf));
+
+  if (n > 0)
+    g_string_append_len (c->in, buf, n);
+  else if (n == 0 || (errno != EINTR && errno != EAGAIN))
+    c->eof = true;
+}
+
+static void
+server_write_client (ServerClient *c)
+{
+  ssize_t n = write (c->fd, c->out->str, c->out->len);
+
+  if (n > 0)
+    g_string_erase (c->out, 0, n);
+  else if (n < 0 && errno != EINTR && errno != EAGAIN)
+    {
+      /* nobody is listening any more */
+      g_string_truncate (c->out, 0);
+      c->eof = true;
+    }
+}
+
+static void
+server_handle_lines (ServerClient *c)
+{
+  char *nl;
+
+  while (!c->reader && !server_quitting
+	 && (nl = (char *) memchr (c->in->str, '\n', c->in->len)) != NULL)
+    {
+      char *line = g_strndup (c->in->str, nl - c->in->str);
+
+      g_string_erase (c->in, 0, nl - c->in->str + 1);
+      server_request (c, line);
+      g_free (line);
+    }
+  /* a last line without a newline */
+  if (c->eof && !c->reader && !server_quitting && c->in->len)
+    {
+      char *line = g_strndup (c->in->str, c->in->len);
+
+      g_string_truncate (c->in, 0);
+      server_request (c, line);
+      g_free (line);
+    }
+}
+
+static int
+server_confirm_dialog (char *msg, ...)
+{
+  return 1;
+}
+
+static int
+server_close_confirm_dialog ()
+{
+  return HID_CLOSE_CONFIRM_OK;
+}
+
+static char *
+server_prompt_for (const char *msg, const char *default_string)
+{
+  return strdup (default_string ? default_string : "");
+}
+
+static char *
+server_fileselect (const char *title, const char *descr,
+		   char *default_file, char *default_ext,
+		   const char *history_tag, int flags)
+{
+  return default_file ? strdup (default_file) : NULL;
+}
+
+/*!
+ * \brief Quit() while serving: stop once the replies are out, rather
+ * than exit () under the clients' feet.
+ */
+static int
+server_quit (int argc, char **argv, Coord x, Coord y)
+{
+  server_quitting = true;
+  return 0;
+}
+
+static void
+server_free_client (ServerClient *c)
+{
+  close (c->fd);
+  g_string_free (c->in, TRUE);
+  g_string_free (c->out, TRUE);
+  g_free (c);
+}
+
+/*!
+ * \brief Serve action requests on the --server socket until Quit.
+ *
+ * Quit stops the server once every request already running has
+ * answered and all the replies, the one to Quit included, are sent.
+ */
+static void
+batch_serve (void)
+{
+  struct sockaddr_un addr;
+  struct stat st;
+  struct pollfd *fds = NULL;
+  HID_Action *quit;
+  int (*quit_cb) (int, char **, Coord, Coord) = NULL;
+  guint i;
+
+  if (strlen (server_path) >= sizeof (addr.sun_path))
+    {
+      Message (_("Socket path %s is too long\n"), server_path);
+      return;
+    }
+  /* a socket left by an earlier server may go, anything else stays */
+  if (lstat (server_path, &st) == 0)
+    {
+      if (!S_ISSOCK (st.st_mode))
+	{
+	  Message (_("%s exists and is not a socket\n"), server_path);
+	  return;
+	}
+      unlink (server_path);
+    }
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, server_path);
+  listen_fd = socket (AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd < 0
+      || bind (listen_fd, (struct sockaddr *) &addr, sizeof (addr)) < 0
+      || listen (listen_fd, 16) < 0)
+    {
+      Message (_("Can't listen on %s: %s\n"), server_path, strerror (errno));
+      return;
+    }
+  signal (SIGPIPE, SIG_IGN);
+  clients = g_ptr_array_new ();
+
+  /* nobody is at the terminal to answer */
+  batch_hid.confirm_dialog = server_confirm_dialog;
+  batch_hid.close_confirm_dialog = server_close_confirm_dialog;
+  batch_hid.prompt_for = server_prompt_for;
+  batch_hid.fileselect = server_fileselect;
+  quit = hid_find_action ("Quit");
+  if (quit)
+    {
+      quit_cb = quit->trigger_cb;
+      quit->trigger_cb = server_quit;
+    }
+
+  contexts = g_hash_table_new (g_str_hash, g_str_equal);
+  current_context = g_new0 (ServerContext, 1);
+  current_context->name = g_strdup ("default");
+  current_context->pcb = PCB;
+  g_hash_table_insert (contexts, current_context->name, current_context);
+
+  Message (_("Serving actions on %s\n"), server_path);
+  fflush (stdout);
+
+  while (1)
+    {
+      guint polled = clients->len;
+      nfds_t nfds = 0;
+
+      if (server_quitting)
+	{
+	  /* done once nothing is running and every reply went out */
+	  for (i = 0; i < polled; i++)
+	    {
+	      ServerClient *c = (ServerClient *) g_ptr_array_index (clients, i);
+
+	      if (c->reader || c->out->len)
+		break;
+	    }
+	  if (i == polled)
+	    break;
+	}
+
+      /* the listening socket, then each client's socket and reader */
+      fds = g_renew (struct pollfd, fds, 1 + 2 * polled);
+      fds[nfds].fd = server_quitting ? -1 : listen_fd;
+      fds[nfds++].events = POLLIN;
+      for (i = 0; i < polled; i++)
+	{
+	  ServerClient *c = (ServerClient *) g_ptr_array_index (clients, i);
+	  bool reading = !c->eof && !server_quitting;
+
+	  fds[nfds].fd = !reading && c->out->len == 0 ? -1 : c->fd;
+	  fds[nfds++].events = (reading ? POLLIN : 0)
+	    | (c->out->len ? POLLOUT : 0);
+	  /* poll () skips negative descriptors */
+	  fds[nfds].fd = c->reader ? c->reader_fd : -1;
+	  fds[nfds++].events = POLLIN;
+	}
+      if (poll (fds, nfds, -1) < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  Message (_("poll failed: %s\n"), strerror (errno));
+	  break;
+	}
+
+      if (fds[0].revents & POLLIN)
+	{
+	  int fd = accept (listen_fd, NULL, NULL);
+
+	  if (fd >= 0)
+	    {
+	      ServerClient *c = g_new0 (ServerClient, 1);
+
+	      fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK);
+	      c->fd = fd;
+	      c->in = g_string_new ("");
+	      c->out = g_string_new ("");
+	      g_ptr_array_add (clients, c);
+	    }
+	}
+
+      for (i = 0; i < polled; i++)
+	{
+	  ServerClient *c = (ServerClient *) g_ptr_array_index (clients, i);
+
+	  if (c->reader && fds[2 + 2 * i].revents)
+	    server_read_reader (c);
+	  if (fds[1 + 2 * i].revents & (POLLIN | POLLHUP | POLLERR))
+	    server_read_client (c);
+	  server_handle_lines (c);
+	  if (c->out->len)
+	    server_write_client (c);
+	}
+
+      /* drop clients that are gone and have nothing left in flight */
+      for (i = polled; i-- > 0;)
+	{
+	  ServerClient *c = (ServerClient *) g_ptr_array_index (clients, i);
+
+	  if (c->eof && !c->reader && c->out->len == 0)
+	    {
+	      server_free_client (c);
+	      g_ptr_array_remove_index (clients, i);
+	    }
+	}
+    }
+
+  for (i = 0; i < clients->len; i++)
+    server_free_client ((ServerClient *) g_ptr_array_index (clients, i));
+  g_ptr_array_free (clients, TRUE);
+  if (quit)
+    quit->trigger_cb = quit_cb;
+  close (listen_fd);
+  unlink (server_path);
+  g_free (fds);
+}
+#endif /* BATCH_SERVER */
+
 static void
 batch_do_export (HID_Attr_Val * options)
 {
   int interactive;
   char line[1000];
 
+  if (server_path && *server_path)
+    {
+#ifdef BATCH_SERVER
+      batch_serve ();
+#else
+      Message (_("This pcb was built without server support.\n"));
+#endif
+      return;
+    }
+
   if (isatty (0))
     interactive = 1;
   else
@@ -359,7 +1015,6 @@ batch_show_item (void *item)
 
 #include "dolists.h"
 
-static HID batch_hid;
 static HID_DRAW batch_graphics;
 
 void
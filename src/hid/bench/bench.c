@@ -0,0 +1,768 @@
+/*!
+ * \file src/hid/bench/bench.c
+ *
+ * \brief Offscreen rendering benchmark.
+ *
+ * Loads a board, replays a script of viewport rectangles through
+ * hid_expose_callback() into a counting "null" draw HID and reports the
+ * time spent per frame together with the number of primitives emitted
+ * on each layer.  Nothing is rasterised and no display is needed, so
+ * the numbers reflect the cost of the core drawing code (draw.c and the
+ * common draw helpers) rather than that of a particular toolkit.
+ *
+ * Optionally the PNG exporter is timed as well, for a figure which
+ * includes real rasterisation.
+ *
+ * <hr>
+ *
+ * <h1><b>Copyright.</b></h1>\n
+ *
+ * PCB, interactive printed circuit board design
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * <hr>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "global.h"
+#include "data.h"
+#include "error.h"
+#include "misc.h"
+#include "draw.h"
+
+#include "hid.h"
+#include "hid_draw.h"
+#include "hid/common/hidnogui.h"
+#include "hid/common/draw_helpers.h"
+#include "../hidint.h"
+
+#ifdef HAVE_LIBDMALLOC
+#include <dmalloc.h>
+#endif
+
+static HID_Attribute bench_options[] = {
+/* %start-doc options "95 Render Benchmark"
+@ftable @code
+@item --benchfile <string>
+Name of the benchmark report file.  Use @samp{-} for standard output.
+Parameter @code{<string>} can include a path.
+@end ftable
+%end-doc
+*/
+  {"benchfile", "Name of the benchmark report file",
+   HID_String, 0, 0, {0, 0, 0}, 0, 0},
+#define HA_benchfile 0
+
+/* %start-doc options "95 Render Benchmark"
+@ftable @code
+@item --frames <num>
+Number of frames rendered for every viewport.  Defaults to 10.
+@end ftable
+%end-doc
+*/
+  {"frames", "Frames rendered per viewport",
+   HID_Integer, 1, 10000, {10, 0, 0}, 0, 0},
+#define HA_frames 1
+
+/* %start-doc options "95 Render Benchmark"
+@ftable @code
+@item --viewports <string>
+Name of a file listing the viewports to render, one per line as
+@samp{x1 y1 x2 y2}.  Each coordinate may carry a unit suffix, e.g.
+@samp{0mm 0mm 25.4mm 12.7mm}; bare numbers are in centi-mils.
+Empty lines and lines starting with @samp{#} are ignored.  Without
+this option the whole board is rendered, followed by zooms into its
+centre and its four quadrants.
+@end ftable
+%end-doc
+*/
+  {"viewports", "File listing the viewports to render",
+   HID_String, 0, 0, {0, 0, 0}, 0, 0},
+#define HA_viewports 2
+
+/* %start-doc options "95 Render Benchmark"
+@ftable @code
+@item --png
+Also time the PNG exporter, rendering the whole board with its default
+options once per frame.
+@end ftable
+%end-doc
+*/
+  {"png", "Also time the PNG exporter",
+   HID_Boolean, 0, 0, {0, 0, 0}, 0, 0},
+#define HA_png 3
+};
+
+#define NUM_OPTIONS (sizeof(bench_options)/sizeof(bench_options[0]))
+
+static HID_Attr_Val bench_values[NUM_OPTIONS];
+
+/*!
+ * \brief Primitive counts for one layer.
+ */
+typedef struct
+{
+  char *name;
+  unsigned long lines;
+  unsigned long arcs;
+  unsigned long rects;
+  unsigned long circles;
+  unsigned long polygons;
+  unsigned long polygon_points;
+  unsigned long fill_rects;
+} layer_stats;
+
+/*!
+ * \brief Count and time spent in one of the object level draw hooks.
+ *
+ * These correspond to the draw.c r-tree callbacks (line_callback,
+ * arc_callback, text_callback, poly_callback, pad_callback,
+ * pin_callback and via_callback) which dispatch to them.
+ */
+typedef struct
+{
+  const char *name;
+  unsigned long calls;
+  double seconds;
+} object_stats;
+
+enum
+{
+  OBJ_LINE, OBJ_ARC, OBJ_TEXT, OBJ_POLYGON, OBJ_PAD, OBJ_PV, NUM_OBJ
+};
+
+static object_stats objects[NUM_OBJ] = {
+  {"line"}, {"arc"}, {"text"}, {"polygon"}, {"pad"}, {"pin/via"}
+};
+
+/* Layers appear in drawing order; the hash only speeds up lookup.  */
+static GPtrArray *layers = NULL;
+static GHashTable *layers_by_name = NULL;
+static layer_stats *cur_layer = NULL;
+
+static GTimer *hook_timer = NULL;
+static int hook_depth = 0;
+
+static HID bench_hid;
+static HID_DRAW bench_graphics;
+static HID_DRAW bench_common;
+
+typedef struct hid_gc_struct
+{
+  int width;
+} hid_gc_struct;
+
+static layer_stats *
+find_layer (const char *name)
+{
+  layer_stats *ls;
+
+  ls = (layer_stats *) g_hash_table_lookup (layers_by_name, name);
+  if (ls == NULL)
+    {
+      ls = g_new0 (layer_stats, 1);
+      ls->name = g_strdup (name);
+      g_ptr_array_add (layers, ls);
+      g_hash_table_insert (layers_by_name, ls->name, ls);
+    }
+  return ls;
+}
+
+static void
+reset_stats (void)
+{
+  int i;
+
+  for (i = 0; i < layers->len; i++)
+    {
+      layer_stats *ls = (layer_stats *) g_ptr_array_index (layers, i);
+      char *name = ls->name;
+
+      memset (ls, 0, sizeof (layer_stats));
+      ls->name = name;
+    }
+  for (i = 0; i < NUM_OBJ; i++)
+    {
+      objects[i].calls = 0;
+      objects[i].seconds = 0;
+    }
+}
+
+/*!
+ * \brief Decide which layers are drawn.
+ *
+ * This mirrors the visibility rules of the GTK HID, so that the
+ * benchmark draws what an interactive user would see.
+ */
+static int
+bench_set_layer (const char *name, int group, int empty)
+{
+  int idx = group;
+  int visible = 0;
+
+  if (idx >= 0 && idx < max_group)
+    {
+      int n = PCB->LayerGroups.Number[group];
+      for (idx = 0; idx < n-1; idx ++)
+	{
+	  int ni = PCB->LayerGroups.Entries[group][idx];
+	  if (ni >= 0 && ni < max_copper_layer + SILK_LAYER
+	      && PCB->Data->Layer[ni].On)
+	    break;
+	}
+      idx = PCB->LayerGroups.Entries[group][idx];
+    }
+
+  if (idx >= 0 && idx < max_copper_layer + SILK_LAYER)
+    visible = PCB->Data->Layer[idx].On;
+  else if (idx < 0)
+    {
+      switch (SL_TYPE (idx))
+	{
+	case SL_INVISIBLE:
+	  visible = PCB->InvisibleObjectsOn;
+	  break;
+	case SL_MASK:
+	  visible = SL_MYSIDE (idx) && TEST_FLAG (SHOWMASKFLAG, PCB);
+	  break;
+	case SL_SILK:
+	  visible = SL_MYSIDE (idx) && PCB->ElementOn;
+	  break;
+	case SL_PDRILL:
+	case SL_UDRILL:
+	  visible = 1;
+	  break;
+	case SL_RATS:
+	  visible = PCB->RatOn;
+	  break;
+	}
+    }
+
+  /* copper groups come without a name; count them under their layer's */
+  if (name == NULL)
+    name = idx >= 0 && idx < max_copper_layer + SILK_LAYER
+      ? PCB->Data->Layer[idx].Name : NULL;
+  if (visible)
+    cur_layer = find_layer (EMPTY (name));
+  return visible;
+}
+
+static hidGC
+bench_make_gc (void)
+{
+  return (hidGC) g_new0 (hid_gc_struct, 1);
+}
+
+static void
+bench_destroy_gc (hidGC gc)
+{
+  g_free (gc);
+}
+
+static void
+bench_use_mask (enum mask_mode mode)
+{
+}
+
+static void
+bench_set_color (hidGC gc, const char *name)
+{
+}
+
+static void
+bench_set_line_cap (hidGC gc, EndCapStyle style)
+{
+}
+
+static void
+bench_set_line_width (hidGC gc, Coord width)
+{
+  gc->width = width;
+}
+
+static void
+bench_set_draw_xor (hidGC gc, int xor_)
+{
+}
+
+/* Primitives drawn before the first set_layer() call (e.g. the
+   board outline) are charged to a pseudo layer.  */
+#define CUR_LAYER (cur_layer ? cur_layer : (cur_layer = find_layer ("(none)")))
+
+static void
+bench_draw_line (hidGC gc, Coord x1, Coord y1, Coord x2, Coord y2)
+{
+  CUR_LAYER->lines ++;
+}
+
+static void
+bench_draw_arc (hidGC gc, Coord cx, Coord cy, Coord width, Coord height,
+		Angle start_angle, Angle end_angle)
+{
+  CUR_LAYER->arcs ++;
+}
+
+static void
+bench_draw_rect (hidGC gc, Coord x1, Coord y1, Coord x2, Coord y2)
+{
+  CUR_LAYER->rects ++;
+}
+
+static void
+bench_fill_circle (hidGC gc, Coord cx, Coord cy, Coord radius)
+{
+  CUR_LAYER->circles ++;
+}
+
+static void
+bench_fill_polygon (hidGC gc, int n_coords, Coord *x, Coord *y)
+{
+  CUR_LAYER->polygons ++;
+  CUR_LAYER->polygon_points += n_coords;
+}
+
+static void
+bench_fill_rect (hidGC gc, Coord x1, Coord y1, Coord x2, Coord y2)
+{
+  CUR_LAYER->fill_rects ++;
+}
+
+/* The object level hooks are timed around the common helpers which
+   do the actual work.  Only the outermost hook is charged, so that
+   e.g. the strokes of a text object are not counted again as lines.  */
+#define HOOK_BEGIN(obj) \
+  double hook_start = 0; \
+  if (hook_depth++ == 0) \
+    { \
+      objects[obj].calls ++; \
+      hook_start = g_timer_elapsed (hook_timer, NULL); \
+    }
+#define HOOK_END(obj) \
+  if (--hook_depth == 0) \
+    objects[obj].seconds += g_timer_elapsed (hook_timer, NULL) - hook_start
+
+static void
+bench_draw_pcb_line (hidGC gc, LineType *line)
+{
+  HOOK_BEGIN (OBJ_LINE);
+  bench_common.draw_pcb_line (gc, line);
+  HOOK_END (OBJ_LINE);
+}
+
+static void
+bench_draw_pcb_arc (hidGC gc, ArcType *arc)
+{
+  HOOK_BEGIN (OBJ_ARC);
+  bench_common.draw_pcb_arc (gc, arc);
+  HOOK_END (OBJ_ARC);
+}
+
+static void
+bench_draw_pcb_text (hidGC gc, TextType *text, Coord min_line_width)
+{
+  HOOK_BEGIN (OBJ_TEXT);
+  bench_common.draw_pcb_text (gc, text, min_line_width);
+  HOOK_END (OBJ_TEXT);
+}
+
+static void
+bench_draw_pcb_polygon (hidGC gc, PolygonType *poly, const BoxType *clip_box)
+{
+  HOOK_BEGIN (OBJ_POLYGON);
+  bench_common.draw_pcb_polygon (gc, poly, clip_box);
+  HOOK_END (OBJ_POLYGON);
+}
+
+static void
+bench_fill_pcb_pad (hidGC gc, PadType *pad, bool clip, bool mask)
+{
+  HOOK_BEGIN (OBJ_PAD);
+  bench_common.fill_pcb_pad (gc, pad, clip, mask);
+  HOOK_END (OBJ_PAD);
+}
+
+static void
+bench_thindraw_pcb_pad (hidGC gc, PadType *pad, bool clip, bool mask)
+{
+  HOOK_BEGIN (OBJ_PAD);
+  bench_common.thindraw_pcb_pad (gc, pad, clip, mask);
+  HOOK_END (OBJ_PAD);
+}
+
+static void
+bench_fill_pcb_pv (hidGC fg_gc, hidGC bg_gc, PinType *pv, bool drawHole,
+		   bool mask)
+{
+  HOOK_BEGIN (OBJ_PV);
+  bench_common.fill_pcb_pv (fg_gc, bg_gc, pv, drawHole, mask);
+  HOOK_END (OBJ_PV);
+}
+
+static void
+bench_thindraw_pcb_pv (hidGC fg_gc, hidGC bg_gc, PinType *pv, bool drawHole,
+		       bool mask)
+{
+  HOOK_BEGIN (OBJ_PV);
+  bench_common.thindraw_pcb_pv (fg_gc, bg_gc, pv, drawHole, mask);
+  HOOK_END (OBJ_PV);
+}
+
+/*!
+ * \brief Build the default viewport script.
+ *
+ * The whole board, then zooms by factors of two into its centre, then
+ * pans across its four quadrants.
+ */
+static GArray *
+default_viewports (void)
+{
+  GArray *viewports = g_array_new (FALSE, FALSE, sizeof (BoxType));
+  Coord cx = PCB->MaxWidth / 2;
+  Coord cy = PCB->MaxHeight / 2;
+  BoxType box;
+  int i;
+
+  box.X1 = 0;
+  box.Y1 = 0;
+  box.X2 = PCB->MaxWidth;
+  box.Y2 = PCB->MaxHeight;
+  g_array_append_val (viewports, box);
+
+  for (i = 1; i <= 6; i++)
+    {
+      Coord hw = PCB->MaxWidth >> (i + 1);
+      Coord hh = PCB->MaxHeight >> (i + 1);
+
+      box.X1 = cx - hw;
+      box.Y1 = cy - hh;
+      box.X2 = cx + hw;
+      box.Y2 = cy + hh;
+      g_array_append_val (viewports, box);
+    }
+
+  for (i = 0; i < 4; i++)
+    {
+      box.X1 = (i & 1) ? cx : 0;
+      box.Y1 = (i & 2) ? cy : 0;
+      box.X2 = box.X1 + cx;
+      box.Y2 = box.Y1 + cy;
+      g_array_append_val (viewports, box);
+    }
+
+  return viewports;
+}
+
+/*!
+ * \brief Read a viewport script, returns NULL on error.
+ */
+static GArray *
+load_viewports (const char *filename)
+{
+  GArray *viewports;
+  FILE *fp;
+  char line[1024];
+  int lineno = 0;
+
+  if ((fp = fopen (filename, "r")) == NULL)
+    {
+      Message (_("Cannot open viewport file \"%s\" for reading\n"), filename);
+      return NULL;
+    }
+
+  viewports = g_array_new (FALSE, FALSE, sizeof (BoxType));
+  while (fgets (line, sizeof (line), fp) != NULL)
+    {
+      char **words;
+      BoxType box;
+      Coord c[4];
+      int i, n;
+
+      lineno ++;
+      g_strstrip (line);
+      if (line[0] == '\0' || line[0] == '#')
+	continue;
+
+      words = g_strsplit_set (line, " \t", -1);
+      for (i = n = 0; words[i] != NULL && n < 4; i++)
+	{
+	  if (*words[i] == '\0')
+	    continue;
+	  c[n++] = GetValue (words[i], NULL, NULL);
+	}
+      g_strfreev (words);
+
+      if (n != 4)
+	{
+	  Message (_("%s:%d: expected \"x1 y1 x2 y2\"\n"), filename, lineno);
+	  continue;
+	}
+
+      box.X1 = MIN (c[0], c[2]);
+      box.Y1 = MIN (c[1], c[3]);
+      box.X2 = MAX (c[0], c[2]);
+      box.Y2 = MAX (c[1], c[3]);
+      g_array_append_val (viewports, box);
+    }
+  fclose (fp);
+
+  return viewports;
+}
+
+static void
+report_frames (FILE *fp, int frames, double total, double min, double max)
+{
+  fprintf (fp, "  frames %d  total %.3f ms  avg %.3f ms  min %.3f ms  max %.3f ms\n",
+	   frames, total * 1000.0, total * 1000.0 / frames,
+	   min * 1000.0, max * 1000.0);
+}
+
+/*!
+ * \brief Print the per frame primitive counts of the last viewport.
+ */
+static void
+report_primitives (FILE *fp, int frames)
+{
+  int i;
+
+  for (i = 0; i < NUM_OBJ; i++)
+    if (objects[i].calls)
+      fprintf (fp, "  object %-10s %10lu per frame  %9.3f ms per frame\n",
+	       objects[i].name, objects[i].calls / frames,
+	       objects[i].seconds * 1000.0 / frames);
+
+  for (i = 0; i < layers->len; i++)
+    {
+      layer_stats *ls = (layer_stats *) g_ptr_array_index (layers, i);
+
+      if (ls->lines + ls->arcs + ls->rects + ls->circles + ls->polygons
+	  + ls->fill_rects == 0)
+	continue;
+      fprintf (fp, "  layer %-16s lines %lu arcs %lu rects %lu circles %lu"
+	       " polygons %lu (%lu points) fill-rects %lu\n",
+	       ls->name, ls->lines / frames, ls->arcs / frames,
+	       ls->rects / frames, ls->circles / frames,
+	       ls->polygons / frames, ls->polygon_points / frames,
+	       ls->fill_rects / frames);
+    }
+}
+
+static void
+bench_png (FILE *fp, int frames)
+{
+  HID *png = hid_find_exporter ("png");
+  GTimer *timer;
+  double total = 0, min = G_MAXDOUBLE, max = 0;
+  int i;
+
+  if (png == NULL)
+    {
+      Message (_("The png exporter is not available\n"));
+      return;
+    }
+
+  timer = g_timer_new ();
+  for (i = 0; i < frames; i++)
+    {
+      double t;
+
+      g_timer_start (timer);
+      png->do_export (NULL);
+      t = g_timer_elapsed (timer, NULL);
+      total += t;
+      min = MIN (min, t);
+      max = MAX (max, t);
+    }
+  g_timer_destroy (timer);
+
+  fprintf (fp, "png export (whole board)\n");
+  report_frames (fp, frames, total, min, max);
+}
+
+static HID_Attribute *
+bench_get_export_options (int *n)
+{
+  static char *last_bench_filename = 0;
+
+  if (PCB)
+    derive_default_filename (PCB->Filename, &bench_options[HA_benchfile],
+			     ".bench", &last_bench_filename);
+
+  if (n)
+    *n = NUM_OPTIONS;
+  return bench_options;
+}
+
+static void
+bench_do_export (HID_Attr_Val * options)
+{
+  const char *filename;
+  GArray *viewports;
+  GTimer *timer;
+  FILE *fp;
+  int frames;
+  int i, v;
+
+  if (!options)
+    {
+      bench_get_export_options (0);
+      for (i = 0; i < NUM_OPTIONS; i++)
+	bench_values[i] = bench_options[i].default_val;
+      options = bench_values;
+    }
+
+  frames = MAX (options[HA_frames].int_value, 1);
+
+  if (options[HA_viewports].str_value)
+    viewports = load_viewports (options[HA_viewports].str_value);
+  else
+    viewports = default_viewports ();
+  if (viewports == NULL)
+    return;
+
+  filename = options[HA_benchfile].str_value;
+  if (!filename)
+    filename = "pcb-out.bench";
+  if (strcmp (filename, "-") == 0)
+    fp = stdout;
+  else if ((fp = fopen (filename, "w")) == NULL)
+    {
+      Message (_("Cannot open file %s for writing\n"), filename);
+      g_array_free (viewports, TRUE);
+      return;
+    }
+
+  layers = g_ptr_array_new ();
+  layers_by_name = g_hash_table_new (g_str_hash, g_str_equal);
+  hook_timer = g_timer_new ();
+  timer = g_timer_new ();
+
+  fprintf (fp, "# pcb render benchmark: %s\n",
+	   PCB->Filename ? PCB->Filename : "(unnamed)");
+
+  for (v = 0; v < viewports->len; v++)
+    {
+      BoxType *region = &g_array_index (viewports, BoxType, v);
+      double total = 0, min = G_MAXDOUBLE, max = 0;
+
+      reset_stats ();
+      for (i = 0; i < frames; i++)
+	{
+	  double t;
+
+	  cur_layer = NULL;
+	  g_timer_start (timer);
+	  hid_expose_callback (&bench_hid, region, 0);
+	  t = g_timer_elapsed (timer, NULL);
+	  total += t;
+	  min = MIN (min, t);
+	  max = MAX (max, t);
+	}
+
+      fprintf (fp, "viewport %d  %.4f %.4f %.4f %.4f mm\n", v + 1,
+	       COORD_TO_MM (region->X1), COORD_TO_MM (region->Y1),
+	       COORD_TO_MM (region->X2), COORD_TO_MM (region->Y2));
+      report_frames (fp, frames, total, min, max);
+      report_primitives (fp, frames);
+    }
+
+  if (options[HA_png].int_value)
+    bench_png (fp, frames);
+
+  if (fp != stdout)
+    fclose (fp);
+
+  g_timer_destroy (timer);
+  g_timer_destroy (hook_timer);
+  hook_timer = NULL;
+  for (i = 0; i < layers->len; i++)
+    {
+      layer_stats *ls = (layer_stats *) g_ptr_array_index (layers, i);
+      g_free (ls->name);
+      g_free (ls);
+    }
+  g_ptr_array_free (layers, TRUE);
+  g_hash_table_destroy (layers_by_name);
+  layers = NULL;
+  layers_by_name = NULL;
+  cur_layer = NULL;
+  g_array_free (viewports, TRUE);
+}
+
+static void
+bench_parse_arguments (int *argc, char ***argv)
+{
+  hid_register_attributes (bench_options,
+			   sizeof (bench_options) / sizeof (bench_options[0]));
+  hid_parse_command_line (argc, argv);
+}
+
+void
+hid_bench_init ()
+{
+  memset (&bench_hid, 0, sizeof (HID));
+  memset (&bench_graphics, 0, sizeof (HID_DRAW));
+
+  common_nogui_init (&bench_hid);
+  common_draw_helpers_init (&bench_graphics);
+
+  bench_hid.struct_size         = sizeof (HID);
+  bench_hid.name                = "bench";
+  bench_hid.description         = "Benchmarks offscreen rendering of the board";
+  bench_hid.exporter            = 1;
+  bench_hid.poly_before         = 1;
+
+  bench_hid.get_export_options  = bench_get_export_options;
+  bench_hid.do_export           = bench_do_export;
+  bench_hid.parse_arguments     = bench_parse_arguments;
+  bench_hid.set_layer           = bench_set_layer;
+
+  bench_hid.graphics            = &bench_graphics;
+
+  bench_graphics.make_gc        = bench_make_gc;
+  bench_graphics.destroy_gc     = bench_destroy_gc;
+  bench_graphics.use_mask       = bench_use_mask;
+  bench_graphics.set_color      = bench_set_color;
+  bench_graphics.set_line_cap   = bench_set_line_cap;
+  bench_graphics.set_line_width = bench_set_line_width;
+  bench_graphics.set_draw_xor   = bench_set_draw_xor;
+  bench_graphics.draw_line      = bench_draw_line;
+  bench_graphics.draw_arc       = bench_draw_arc;
+  bench_graphics.draw_rect      = bench_draw_rect;
+  bench_graphics.fill_circle    = bench_fill_circle;
+  bench_graphics.fill_polygon   = bench_fill_polygon;
+  bench_graphics.fill_rect      = bench_fill_rect;
+
+  /* Keep the common helpers so the timed wrappers can call them.  */
+  bench_common = bench_graphics;
+
+  bench_graphics.draw_pcb_line    = bench_draw_pcb_line;
+  bench_graphics.draw_pcb_arc     = bench_draw_pcb_arc;
+  bench_graphics.draw_pcb_text    = bench_draw_pcb_text;
+  bench_graphics.draw_pcb_polygon = bench_draw_pcb_polygon;
+  bench_graphics.fill_pcb_pad     = bench_fill_pcb_pad;
+  bench_graphics.thindraw_pcb_pad = bench_thindraw_pcb_pad;
+  bench_graphics.fill_pcb_pv      = bench_fill_pcb_pv;
+  bench_graphics.thindraw_pcb_pv  = bench_thindraw_pcb_pv;
+
+  hid_register_hid (&bench_hid);
+}
@@ -10,6 +10,8 @@
 #include "global.h"
 #include "data.h"
 #include "error.h"
+#include "mymem.h"
+#include "perf.h"
 
 #include "hid.h"
 #include "../hidint.h"
@@ -212,6 +214,7 @@ hid_actionv (const char *name, int argc, char **argv)
   Coord x = 0, y = 0;
   int i, ret;
   HID_Action *a, *old_action;
+  guint64 start;
 
   if (!name)
     return 1;
@@ -240,9 +243,20 @@ hid_actionv (const char *name, int argc, char **argv)
   
   old_action     = current_action;
   current_action = a;
+  start = perf_begin (&a->perf, "action", a->name);
   ret = current_action->trigger_cb (argc, argv, x, y);
+  perf_end (a->perf, start);
   current_action = old_action;
-  
+
+  /* Nothing walks the object lists between top level actions, so this
+     is where the holes left by removed objects get squeezed out.  */
+  if (old_action == NULL && PCB != NULL)
+    {
+      CompactDataLists (PCB->Data);
+      for (i = 0; i < MAX_BUFFER; i++)
+        CompactDataLists (Buffers[i].Data);
+    }
+
   return ret;
 }
 
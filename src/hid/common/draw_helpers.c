@@ -2,6 +2,7 @@
 #include "hid.h"
 #include "hid_draw.h"
 #include "data.h" /* For global "PCB" variable */
+#include "misc.h" /* For FontGeneration() */
 #include "rotate.h" /* For RotateLineLowLevel() */
 #include "polygon.h"
 #include "draw_helpers.h"
@@ -37,15 +38,85 @@ common_draw_pcb_arc (hidGC gc, ArcType *arc)
 }
 
 /* ---------------------------------------------------------------------------
- * drawing routine for text objects
+ * text outline cache
+ *
+ * Walking the font symbols and scaling, rotating and mirroring each
+ * stroke is most of the cost of drawing text, and boards repeat the
+ * same designators at the same size and direction over and over.  The
+ * transformed strokes of a string are therefore kept, relative to the
+ * text position, keyed by everything except that position.  Editing a
+ * text changes its key; the cache is emptied whenever FontGeneration ()
+ * says a font was loaded or edited since it was filled.
  */
+
+#define MAX_CACHED_TEXTS 8192
+
+typedef struct
+{
+  char *string;
+  FontType *font;
+  int scale;
+  BYTE direction;
+  bool on_solder;
+} text_key;
+
+typedef struct
+{
+  text_key key;
+  GArray *lines; /* LineType, before min_line_width and offset */
+  GArray *boxes; /* BoxType, default symbols for missing glyphs */
+} text_outline;
+
+static GHashTable *text_cache = NULL;
+static guint text_cache_font_generation = 0;
+
+static guint
+text_key_hash (gconstpointer data)
+{
+  const text_key *key = data;
+
+  return g_str_hash (key->string) ^ (guint)key->scale * 2654435761u ^
+         (guint)key->direction << 28 ^ (guint)key->on_solder << 30;
+}
+
+static gboolean
+text_key_equal (gconstpointer a, gconstpointer b)
+{
+  const text_key *ka = a, *kb = b;
+
+  return ka->font == kb->font && ka->scale == kb->scale &&
+         ka->direction == kb->direction && ka->on_solder == kb->on_solder &&
+         strcmp (ka->string, kb->string) == 0;
+}
+
 static void
-common_draw_pcb_text (hidGC gc, TextType *Text, Coord min_line_width)
+text_outline_free (gpointer data)
+{
+  text_outline *outline = data;
+
+  g_free (outline->key.string);
+  g_array_free (outline->lines, TRUE);
+  g_array_free (outline->boxes, TRUE);
+  g_slice_free (text_outline, outline);
+}
+
+/*!
+ * \brief Scale, rotate and mirror the strokes of a text, relative to
+ * its position.
+ */
+static text_outline *
+build_text_outline (TextType *Text, const text_key *key)
 {
   Coord x = 0;
   unsigned char *string = (unsigned char *) Text->TextString;
   Cardinal n;
-  FontType *font = &PCB->Font;
+  FontType *font = key->font;
+  text_outline *outline = g_slice_new (text_outline);
+
+  outline->key = *key;
+  outline->key.string = g_strdup (key->string);
+  outline->lines = g_array_new (FALSE, FALSE, sizeof (LineType));
+  outline->boxes = g_array_new (FALSE, FALSE, sizeof (BoxType));
 
   while (string && *string)
     {
@@ -64,27 +135,20 @@ common_draw_pcb_text (hidGC gc, TextType *Text, Coord min_line_width)
               newline.Point2.X = SCALE_TEXT (newline.Point2.X + x, Text->Scale);
               newline.Point2.Y = SCALE_TEXT (newline.Point2.Y, Text->Scale);
               newline.Thickness = SCALE_TEXT (newline.Thickness, Text->Scale / 2);
-              if (newline.Thickness < min_line_width)
-                newline.Thickness = min_line_width;
 
               RotateLineLowLevel (&newline, 0, 0, Text->Direction);
 
               /* the labels of SMD objects on the bottom
                * side haven't been swapped yet, only their offset
                */
-              if (TEST_FLAG (ONSOLDERFLAG, Text))
+              if (key->on_solder)
                 {
                   newline.Point1.X = SWAP_SIGN_X (newline.Point1.X);
                   newline.Point1.Y = SWAP_SIGN_Y (newline.Point1.Y);
                   newline.Point2.X = SWAP_SIGN_X (newline.Point2.X);
                   newline.Point2.Y = SWAP_SIGN_Y (newline.Point2.Y);
                 }
-              /* add offset and draw line */
-              newline.Point1.X += Text->X;
-              newline.Point1.Y += Text->Y;
-              newline.Point2.X += Text->X;
-              newline.Point2.Y += Text->Y;
-              gui->graphics->draw_pcb_line (gc, &newline);
+              g_array_append_val (outline->lines, newline);
             }
 
           /* move on to next cursor position */
@@ -93,7 +157,7 @@ common_draw_pcb_text (hidGC gc, TextType *Text, Coord min_line_width)
       else
         {
           /* the default symbol is a filled box */
-          BoxType defaultsymbol = PCB->Font.DefaultSymbol;
+          BoxType defaultsymbol = font->DefaultSymbol;
           Coord size = (defaultsymbol.X2 - defaultsymbol.X1) * 6 / 5;
 
           defaultsymbol.X1 = SCALE_TEXT (defaultsymbol.X1 + x, Text->Scale);
@@ -102,21 +166,79 @@ common_draw_pcb_text (hidGC gc, TextType *Text, Coord min_line_width)
           defaultsymbol.Y2 = SCALE_TEXT (defaultsymbol.Y2, Text->Scale);
 
           RotateBoxLowLevel (&defaultsymbol, 0, 0, Text->Direction);
-
-          /* add offset and draw box */
-          defaultsymbol.X1 += Text->X;
-          defaultsymbol.Y1 += Text->Y;
-          defaultsymbol.X2 += Text->X;
-          defaultsymbol.Y2 += Text->Y;
-          gui->graphics->fill_rect (gc,
-                                    defaultsymbol.X1, defaultsymbol.Y1,
-                                    defaultsymbol.X2, defaultsymbol.Y2);
+          g_array_append_val (outline->boxes, defaultsymbol);
 
           /* move on to next cursor position */
           x += size;
         }
       string++;
     }
+
+  return outline;
+}
+
+/* ---------------------------------------------------------------------------
+ * drawing routine for text objects
+ */
+static void
+common_draw_pcb_text (hidGC gc, TextType *Text, Coord min_line_width)
+{
+  text_key key;
+  text_outline *outline;
+  guint i;
+
+  if (Text->TextString == NULL)
+    return;
+
+  key.string = Text->TextString;
+  key.font = &PCB->Font;
+  key.scale = Text->Scale;
+  key.direction = Text->Direction;
+  key.on_solder = TEST_FLAG (ONSOLDERFLAG, Text) != 0;
+
+  if (text_cache == NULL)
+    text_cache = g_hash_table_new_full (text_key_hash, text_key_equal,
+                                        NULL, text_outline_free);
+  if (text_cache_font_generation != FontGeneration ())
+    {
+      g_hash_table_remove_all (text_cache);
+      text_cache_font_generation = FontGeneration ();
+    }
+
+  outline = g_hash_table_lookup (text_cache, &key);
+  if (outline == NULL)
+    {
+      if (g_hash_table_size (text_cache) >= MAX_CACHED_TEXTS)
+        g_hash_table_remove_all (text_cache);
+
+      outline = build_text_outline (Text, &key);
+      g_hash_table_insert (text_cache, &outline->key, outline);
+    }
+
+  for (i = 0; i < outline->lines->len; i++)
+    {
+      LineType newline = g_array_index (outline->lines, LineType, i);
+
+      if (newline.Thickness < min_line_width)
+        newline.Thickness = min_line_width;
+
+      /* add offset and draw line */
+      newline.Point1.X += Text->X;
+      newline.Point1.Y += Text->Y;
+      newline.Point2.X += Text->X;
+      newline.Point2.Y += Text->Y;
+      gui->graphics->draw_pcb_line (gc, &newline);
+    }
+
+  for (i = 0; i < outline->boxes->len; i++)
+    {
+      BoxType *box = &g_array_index (outline->boxes, BoxType, i);
+
+      /* add offset and draw box */
+      gui->graphics->fill_rect (gc,
+                                box->X1 + Text->X, box->Y1 + Text->Y,
+                                box->X2 + Text->X, box->Y2 + Text->Y);
+    }
 }
 
 static void
@@ -200,6 +322,17 @@ fill_clipped_contour (hidGC gc, PLINE *pl, const BoxType *clip_box)
   POLYAREA *draw_piece;
   int x;
 
+  /* Pieces wholly outside or inside the clip box need no clipping */
+  if (pl->xmax < clip_box->X1 || pl->xmin > clip_box->X2 ||
+      pl->ymax < clip_box->Y1 || pl->ymin > clip_box->Y2)
+    return;
+  if (pl->xmin >= clip_box->X1 && pl->xmax <= clip_box->X2 &&
+      pl->ymin >= clip_box->Y1 && pl->ymax <= clip_box->Y2)
+    {
+      fill_contour (gc, pl);
+      return;
+    }
+
   clip_poly = RectPoly (clip_box->X1, clip_box->X2,
                         clip_box->Y1, clip_box->Y2);
   poly_CopyContour (&pl_copy, pl);
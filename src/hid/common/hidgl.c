@@ -82,6 +82,8 @@
 triangle_buffer buffer;
 float global_depth = 0;
 
+static void flush_deferred (void);
+
 static void
 hidgl_init_triangle_array (triangle_buffer *buffer)
 {
@@ -92,6 +94,18 @@ hidgl_init_triangle_array (triangle_buffer *buffer)
 void
 hidgl_flush_triangles (triangle_buffer *buffer)
 {
+  /* Buffers belonging to render threads just spill into their arrays */
+  if (buffer->spill != NULL)
+    {
+      g_array_append_vals (buffer->spill, buffer->triangle_array,
+                           buffer->coord_comp_count);
+      buffer->triangle_count = 0;
+      buffer->coord_comp_count = 0;
+      return;
+    }
+
+  flush_deferred ();
+
   if (buffer->triangle_count == 0)
     return;
 
@@ -201,7 +215,8 @@ int calc_slices (float pix_radius, float sweep_angle)
 
 #define MIN_TRIANGLES_PER_CAP 3
 #define MAX_TRIANGLES_PER_CAP 90
-static void draw_cap (Coord width, Coord x, Coord y, Angle angle, double scale)
+static void
+emit_cap (triangle_buffer *tb, Coord width, Coord x, Coord y, Angle angle, double scale)
 {
   float last_capx, last_capy;
   float capx, capy;
@@ -215,21 +230,21 @@ static void draw_cap (Coord width, Coord x, Coord y, Angle angle, double scale)
   if (slices > MAX_TRIANGLES_PER_CAP)
     slices = MAX_TRIANGLES_PER_CAP;
 
-  hidgl_ensure_triangle_space (&buffer, slices);
+  hidgl_ensure_triangle_space (tb, slices);
 
   last_capx =  radius * cosf (angle * M_PI / 180.) + x;
   last_capy = -radius * sinf (angle * M_PI / 180.) + y;
   for (i = 0; i < slices; i++) {
     capx =  radius * cosf (angle * M_PI / 180. + ((float)(i + 1)) * M_PI / (float)slices) + x;
     capy = -radius * sinf (angle * M_PI / 180. + ((float)(i + 1)) * M_PI / (float)slices) + y;
-    hidgl_add_triangle (&buffer, last_capx, last_capy, capx, capy, x, y);
+    hidgl_add_triangle (tb, last_capx, last_capy, capx, capy, x, y);
     last_capx = capx;
     last_capy = capy;
   }
 }
 
-void
-hidgl_draw_line (int cap, Coord width, Coord x1, Coord y1, Coord x2, Coord y2, double scale)
+static void
+emit_line (triangle_buffer *tb, int cap, Coord width, Coord x1, Coord y1, Coord x2, Coord y2, double scale)
 {
   double angle;
   double deltax, deltay, length;
@@ -277,27 +292,27 @@ hidgl_draw_line (int cap, Coord width, Coord x1, Coord y1, Coord x2, Coord y2, d
       break;
   }
 
-  hidgl_ensure_triangle_space (&buffer, 2);
-  hidgl_add_triangle (&buffer, x1 - wdx, y1 - wdy,
-                               x2 - wdx, y2 - wdy,
-                               x2 + wdx, y2 + wdy);
-  hidgl_add_triangle (&buffer, x1 - wdx, y1 - wdy,
-                               x2 + wdx, y2 + wdy,
-                               x1 + wdx, y1 + wdy);
+  hidgl_ensure_triangle_space (tb, 2);
+  hidgl_add_triangle (tb, x1 - wdx, y1 - wdy,
+                          x2 - wdx, y2 - wdy,
+                          x2 + wdx, y2 + wdy);
+  hidgl_add_triangle (tb, x1 - wdx, y1 - wdy,
+                          x2 + wdx, y2 + wdy,
+                          x1 + wdx, y1 + wdy);
 
   /* Don't bother capping hairlines */
   if (circular_caps && !hairline)
     {
-      draw_cap (width, x1, y1, angle + 90., scale);
-      draw_cap (width, x2, y2, angle - 90., scale);
+      emit_cap (tb, width, x1, y1, angle + 90., scale);
+      emit_cap (tb, width, x2, y2, angle - 90., scale);
     }
 }
 
 #define MIN_SLICES_PER_ARC 6
 #define MAX_SLICES_PER_ARC 360
-void
-hidgl_draw_arc (Coord width, Coord x, Coord y, Coord rx, Coord ry,
-                Angle start_angle, Angle delta_angle, double scale)
+static void
+emit_arc (triangle_buffer *tb, Coord width, Coord x, Coord y, Coord rx, Coord ry,
+          Angle start_angle, Angle delta_angle, double scale)
 {
   float last_inner_x, last_inner_y;
   float last_outer_x, last_outer_y;
@@ -338,7 +353,7 @@ hidgl_draw_arc (Coord width, Coord x, Coord y, Coord rx, Coord ry,
   if (slices > MAX_SLICES_PER_ARC)
     slices = MAX_SLICES_PER_ARC;
 
-  hidgl_ensure_triangle_space (&buffer, 2 * slices);
+  hidgl_ensure_triangle_space (tb, 2 * slices);
 
   angle_incr_rad = delta_angle_rad / (float)slices;
 
@@ -351,12 +366,12 @@ hidgl_draw_arc (Coord width, Coord x, Coord y, Coord rx, Coord ry,
     sin_ang = sinf (start_angle_rad + ((float)(i)) * angle_incr_rad);
     inner_x = -inner_r * cos_ang + x;  inner_y = inner_r * sin_ang + y;
     outer_x = -outer_r * cos_ang + x;  outer_y = outer_r * sin_ang + y;
-    hidgl_add_triangle (&buffer, last_inner_x, last_inner_y,
-                                 last_outer_x, last_outer_y,
-                                 outer_x, outer_y);
-    hidgl_add_triangle (&buffer, last_inner_x, last_inner_y,
-                                 inner_x, inner_y,
-                                 outer_x, outer_y);
+    hidgl_add_triangle (tb, last_inner_x, last_inner_y,
+                            last_outer_x, last_outer_y,
+                            outer_x, outer_y);
+    hidgl_add_triangle (tb, last_inner_x, last_inner_y,
+                            inner_x, inner_y,
+                            outer_x, outer_y);
     last_inner_x = inner_x;  last_inner_y = inner_y;
     last_outer_x = outer_x;  last_outer_y = outer_y;
   }
@@ -365,28 +380,17 @@ hidgl_draw_arc (Coord width, Coord x, Coord y, Coord rx, Coord ry,
   if (hairline)
     return;
 
-  draw_cap (width, x + rx * -cosf (start_angle_rad),
+  emit_cap (tb, width, x + rx * -cosf (start_angle_rad),
                    y + rx *  sinf (start_angle_rad),
                    start_angle, scale);
-  draw_cap (width, x + rx * -cosf (start_angle_rad + delta_angle_rad),
+  emit_cap (tb, width, x + rx * -cosf (start_angle_rad + delta_angle_rad),
                    y + rx *  sinf (start_angle_rad + delta_angle_rad),
                    start_angle + delta_angle + 180., scale);
 }
 
-void
-hidgl_draw_rect (Coord x1, Coord y1, Coord x2, Coord y2)
-{
-  glBegin (GL_LINE_LOOP);
-  glVertex3f (x1, y1, global_depth);
-  glVertex3f (x1, y2, global_depth);
-  glVertex3f (x2, y2, global_depth);
-  glVertex3f (x2, y1, global_depth);
-  glEnd ();
-}
-
-
-void
-hidgl_fill_circle (Coord vx, Coord vy, Coord vr, double scale)
+static void
+emit_circle (triangle_buffer *tb, Coord vx, Coord vy, Coord vr, double scale,
+             bool lod)
 {
 #define MIN_TRIANGLES_PER_CIRCLE 6
 #define MAX_TRIANGLES_PER_CIRCLE 360
@@ -395,6 +399,15 @@ hidgl_fill_circle (Coord vx, Coord vy, Coord vr, double scale)
   int slices;
   int i;
 
+  /* Below a pixel, the shape of the circle can't be seen */
+  if (lod && vr < scale)
+    {
+      hidgl_ensure_triangle_space (tb, 2);
+      hidgl_add_triangle (tb, vx - vr, vy - vr, vx - vr, vy + vr, vx + vr, vy + vr);
+      hidgl_add_triangle (tb, vx + vr, vy - vr, vx + vr, vy + vr, vx - vr, vy - vr);
+      return;
+    }
+
   slices = calc_slices (vr / scale, 2 * M_PI);
 
   if (slices < MIN_TRIANGLES_PER_CIRCLE)
@@ -403,7 +416,7 @@ hidgl_fill_circle (Coord vx, Coord vy, Coord vr, double scale)
   if (slices > MAX_TRIANGLES_PER_CIRCLE)
     slices = MAX_TRIANGLES_PER_CIRCLE;
 
-  hidgl_ensure_triangle_space (&buffer, slices);
+  hidgl_ensure_triangle_space (tb, slices);
 
   last_x = vx + vr;
   last_y = vy;
@@ -412,12 +425,274 @@ hidgl_fill_circle (Coord vx, Coord vy, Coord vr, double scale)
     float x, y;
     x = radius * cosf (((float)(i + 1)) * 2. * M_PI / (float)slices) + vx;
     y = radius * sinf (((float)(i + 1)) * 2. * M_PI / (float)slices) + vy;
-    hidgl_add_triangle (&buffer, vx, vy, last_x, last_y, x, y);
+    hidgl_add_triangle (tb, vx, vy, last_x, last_y, x, y);
     last_x = x;
     last_y = y;
   }
 }
 
+/* ---------------------------------------------------------------------------
+ * Deferred primitive generation.
+ *
+ * When more than one render thread is configured, lines, arcs and circles
+ * are not triangulated immediately but queued.  The queue is drained when
+ * the triangle buffer is flushed, i.e. before any GL state change, so the
+ * order of triangles relative to state changes is unaffected.  Large queues
+ * are split into chunks which worker threads triangulate into private
+ * vertex arrays.  Only the final submission of those arrays, in chunk
+ * order, uses the GL context.
+ */
+
+enum {
+  PRIM_LINE,
+  PRIM_ARC,
+  PRIM_CIRCLE
+};
+
+typedef struct {
+  int type;
+  int cap;
+  Coord width;
+  Coord x1, y1, x2, y2;     /*!< For circles and arcs, x2 and y2 are radii. */
+  Angle start_angle, delta_angle;
+  double scale;
+  bool lod;                 /*!< simplify what is smaller than scale. */
+} hidgl_primitive;
+
+typedef struct {
+  hidgl_primitive *prims;
+  int n_prims;
+  triangle_buffer *tb;
+  GArray *vertices;
+} prim_chunk;
+
+/* Below this many queued primitives, threading costs more than it saves */
+#define MIN_PARALLEL_PRIMITIVES 1024
+#define MAX_RENDER_THREADS 16
+
+static int render_threads = 1;
+static GArray *deferred = NULL;
+static GThreadPool *render_pool = NULL;
+static GAsyncQueue *render_done = NULL;
+static prim_chunk chunks[MAX_RENDER_THREADS];
+
+static void
+emit_primitive (triangle_buffer *tb, hidgl_primitive *p)
+{
+  switch (p->type)
+    {
+    case PRIM_LINE:
+      emit_line (tb, p->cap, p->width, p->x1, p->y1, p->x2, p->y2, p->scale);
+      break;
+    case PRIM_ARC:
+      emit_arc (tb, p->width, p->x1, p->y1, p->x2, p->y2,
+                p->start_angle, p->delta_angle, p->scale);
+      break;
+    case PRIM_CIRCLE:
+      emit_circle (tb, p->x1, p->y1, p->x2, p->scale, p->lod);
+      break;
+    }
+}
+
+static void
+generate_chunk (gpointer data, gpointer user_data)
+{
+  prim_chunk *chunk = data;
+  int i;
+
+  for (i = 0; i < chunk->n_prims; i++)
+    emit_primitive (chunk->tb, &chunk->prims[i]);
+
+  /* Spill what is left into the chunk's vertex array */
+  hidgl_flush_triangles (chunk->tb);
+
+  g_async_queue_push (render_done, chunk);
+}
+
+static void
+submit_vertices (GArray *vertices)
+{
+  if (vertices->len == 0)
+    return;
+
+  glEnableClientState (GL_VERTEX_ARRAY);
+  glVertexPointer (3, GL_FLOAT, 0, vertices->data);
+  glDrawArrays (GL_TRIANGLES, 0, vertices->len / 3);
+  glDisableClientState (GL_VERTEX_ARRAY);
+
+  g_array_set_size (vertices, 0);
+}
+
+static void
+flush_deferred (void)
+{
+  hidgl_primitive *prims;
+  int n_prims, n_chunks, per_chunk, i;
+
+  if (deferred == NULL || deferred->len == 0)
+    return;
+
+  prims = (hidgl_primitive *)deferred->data;
+  n_prims = deferred->len;
+
+  if (render_threads < 2 || n_prims < MIN_PARALLEL_PRIMITIVES)
+    {
+      /* Emitting may flush the buffer, which must find the queue empty */
+      GArray *queue = deferred;
+
+      deferred = NULL;
+      for (i = 0; i < n_prims; i++)
+        emit_primitive (&buffer, &prims[i]);
+      g_array_set_size (queue, 0);
+      deferred = queue;
+      return;
+    }
+
+  n_chunks = render_threads;
+  per_chunk = (n_prims + n_chunks - 1) / n_chunks;
+
+  for (i = 0; i < n_chunks; i++)
+    {
+      chunks[i].prims = prims + i * per_chunk;
+      chunks[i].n_prims = MAX (0, MIN (per_chunk, n_prims - i * per_chunk));
+      g_thread_pool_push (render_pool, &chunks[i], NULL);
+    }
+
+  for (i = 0; i < n_chunks; i++)
+    g_async_queue_pop (render_done);
+
+  /* Submit in chunk order, keeping the output deterministic */
+  for (i = 0; i < n_chunks; i++)
+    submit_vertices (chunks[i].vertices);
+
+  g_array_set_size (deferred, 0);
+}
+
+/*!
+ * \brief Set the number of threads used to triangulate primitives.
+ *
+ * \return the number of threads actually used.
+ */
+int
+hidgl_set_render_threads (int threads)
+{
+  int i;
+
+  threads = MAX (1, MIN (threads, MAX_RENDER_THREADS));
+
+  /* Anything queued so far must be drawn by the current configuration */
+  flush_deferred ();
+
+  if (threads > 1 && render_pool == NULL)
+    {
+      render_done = g_async_queue_new ();
+      render_pool = g_thread_pool_new (generate_chunk, NULL,
+                                       MAX_RENDER_THREADS, FALSE, NULL);
+      if (render_pool == NULL)
+        return render_threads;
+
+      for (i = 0; i < MAX_RENDER_THREADS; i++)
+        {
+          chunks[i].tb = g_new0 (triangle_buffer, 1);
+          chunks[i].vertices = g_array_new (FALSE, FALSE, sizeof (GLfloat));
+          chunks[i].tb->spill = chunks[i].vertices;
+        }
+    }
+
+  if (threads > 1 && deferred == NULL)
+    deferred = g_array_new (FALSE, FALSE, sizeof (hidgl_primitive));
+
+  render_threads = threads;
+  return render_threads;
+}
+
+int
+hidgl_get_render_threads (void)
+{
+  return render_threads;
+}
+
+static hidgl_primitive *
+defer_primitive (int type)
+{
+  hidgl_primitive *p;
+
+  g_array_set_size (deferred, deferred->len + 1);
+  p = &g_array_index (deferred, hidgl_primitive, deferred->len - 1);
+  p->type = type;
+  return p;
+}
+
+void
+hidgl_draw_line (int cap, Coord width, Coord x1, Coord y1, Coord x2, Coord y2, double scale)
+{
+  hidgl_primitive *p;
+
+  if (render_threads < 2)
+    {
+      emit_line (&buffer, cap, width, x1, y1, x2, y2, scale);
+      return;
+    }
+
+  p = defer_primitive (PRIM_LINE);
+  p->cap = cap;
+  p->width = width;
+  p->x1 = x1;  p->y1 = y1;
+  p->x2 = x2;  p->y2 = y2;
+  p->scale = scale;
+}
+
+void
+hidgl_draw_arc (Coord width, Coord x, Coord y, Coord rx, Coord ry,
+                Angle start_angle, Angle delta_angle, double scale)
+{
+  hidgl_primitive *p;
+
+  if (render_threads < 2)
+    {
+      emit_arc (&buffer, width, x, y, rx, ry, start_angle, delta_angle, scale);
+      return;
+    }
+
+  p = defer_primitive (PRIM_ARC);
+  p->width = width;
+  p->x1 = x;   p->y1 = y;
+  p->x2 = rx;  p->y2 = ry;
+  p->start_angle = start_angle;
+  p->delta_angle = delta_angle;
+  p->scale = scale;
+}
+
+void
+hidgl_fill_circle (Coord vx, Coord vy, Coord vr, double scale, bool lod)
+{
+  hidgl_primitive *p;
+
+  if (render_threads < 2)
+    {
+      emit_circle (&buffer, vx, vy, vr, scale, lod);
+      return;
+    }
+
+  p = defer_primitive (PRIM_CIRCLE);
+  p->x1 = vx;  p->y1 = vy;
+  p->x2 = vr;
+  p->scale = scale;
+  p->lod = lod;
+}
+
+void
+hidgl_draw_rect (Coord x1, Coord y1, Coord x2, Coord y2)
+{
+  glBegin (GL_LINE_LOOP);
+  glVertex3f (x1, y1, global_depth);
+  glVertex3f (x1, y2, global_depth);
+  glVertex3f (x2, y2, global_depth);
+  glVertex3f (x2, y1, global_depth);
+  glEnd ();
+}
+
+
 #define MAX_COMBINED_MALLOCS 2500
 static void *combined_to_free [MAX_COMBINED_MALLOCS];
 static int combined_num_to_free = 0;
@@ -576,10 +851,12 @@ hidgl_fill_polygon (int n_coords, Coord *x, Coord *y)
 
 void
 tesselate_contour (GLUtesselator *tobj, PLINE *contour, GLdouble *vertices,
-                   double scale)
+                   double scale, bool lod)
 {
   VNODE *vn = &contour->head;
   int offset = 0;
+  int remaining = contour->Count;
+  Coord last_x, last_y;
 
   /* If the contour is round, and hidgl_fill_circle would use
    * less slices than we have vertices to draw it, then call
@@ -588,19 +865,33 @@ tesselate_contour (GLUtesselator *tobj, PLINE *contour, GLdouble *vertices,
   if (contour->is_round) {
     double slices = calc_slices (contour->radius / scale, 2 * M_PI);
     if (slices < contour->Count) {
-      hidgl_fill_circle (contour->cx, contour->cy, contour->radius, scale);
+      hidgl_fill_circle (contour->cx, contour->cy, contour->radius, scale, lod);
       return;
     }
   }
 
   gluTessBeginPolygon (tobj, NULL);
   gluTessBeginContour (tobj);
+  last_x = vn->point[0];
+  last_y = vn->point[1];
   do {
+    /* Simplify the outline at low zoom: vertices closer than a pixel to
+     * the previous one are dropped, keeping enough to form a triangle.
+     */
+    if (lod && offset >= 3 * 3 && remaining > 3 &&
+        fabs (vn->point[0] - last_x) < scale &&
+        fabs (vn->point[1] - last_y) < scale)
+      {
+        remaining--;
+        continue;
+      }
     vertices [0 + offset] = vn->point[0];
     vertices [1 + offset] = vn->point[1];
     vertices [2 + offset] = 0.;
     gluTessVertex (tobj, &vertices [offset], &vertices [offset]);
     offset += 3;
+    last_x = vn->point[0];
+    last_y = vn->point[1];
   } while ((vn = vn->next) != &contour->head);
   gluTessEndContour (tobj);
   gluTessEndPolygon (tobj);
@@ -610,6 +901,7 @@ struct do_hole_info {
   GLUtesselator *tobj;
   GLdouble *vertices;
   double scale;
+  bool lod;
 };
 
 static int
@@ -623,7 +915,13 @@ do_hole (const BoxType *b, void *cl)
     return 0;
   }
 
-  tesselate_contour (info->tobj, curc, info->vertices, info->scale);
+  /* Holes smaller than a pixel can't be seen */
+  if (info->lod &&
+      curc->xmax - curc->xmin < info->scale &&
+      curc->ymax - curc->ymin < info->scale)
+    return 0;
+
+  tesselate_contour (info->tobj, curc, info->vertices, info->scale, info->lod);
   return 1;
 }
 
@@ -632,7 +930,7 @@ static int dirty_bits = 0;
 static int assigned_bits = 0;
 
 static void
-fill_polyarea (POLYAREA *pa, const BoxType *clip_box, double scale)
+fill_polyarea (POLYAREA *pa, const BoxType *clip_box, double scale, bool lod)
 {
   int vertex_count = 0;
   PLINE *contour;
@@ -640,6 +938,7 @@ fill_polyarea (POLYAREA *pa, const BoxType *clip_box, double scale)
   int stencil_bit;
 
   info.scale = scale;
+  info.lod = lod;
   global_scale = scale;
 
   stencil_bit = hidgl_assign_clear_stencil_bit ();
@@ -692,7 +991,7 @@ fill_polyarea (POLYAREA *pa, const BoxType *clip_box, double scale)
   /* Drawing operations as masked to areas where the stencil buffer is '0' */
 
   /* Draw the polygon outer */
-  tesselate_contour (info.tobj, pa->contours, info.vertices, scale);
+  tesselate_contour (info.tobj, pa->contours, info.vertices, scale, lod);
 
   hidgl_flush_triangles (&buffer);
 
@@ -707,19 +1006,20 @@ fill_polyarea (POLYAREA *pa, const BoxType *clip_box, double scale)
 }
 
 void
-hidgl_fill_pcb_polygon (PolygonType *poly, const BoxType *clip_box, double scale)
+hidgl_fill_pcb_polygon (PolygonType *poly, const BoxType *clip_box,
+                        double scale, bool lod)
 {
   if (poly->Clipped == NULL)
     return;
 
-  fill_polyarea (poly->Clipped, clip_box, scale);
+  fill_polyarea (poly->Clipped, clip_box, scale, lod);
 
   if (TEST_FLAG (FULLPOLYFLAG, poly))
     {
       POLYAREA *pa;
 
       for (pa = poly->Clipped->f; pa != poly->Clipped; pa = pa->f)
-        fill_polyarea (pa, clip_box, scale);
+        fill_polyarea (pa, clip_box, scale, lod);
     }
 }
 
@@ -731,6 +1031,274 @@ hidgl_fill_rect (Coord x1, Coord y1, Coord x2, Coord y2)
   hidgl_add_triangle (&buffer, x2, y1, x2, y2, x1, y1);
 }
 
+/* ---------------------------------------------------------------------------
+ * Retained geometry cache.
+ *
+ * The board is split into square tiles whose size is a fixed number of
+ * screen pixels.  The first time a tile is drawn at a given scale, its
+ * geometry (already tessellated triangles, colour and stencil changes) is
+ * compiled into a display list.  Panning just replays the lists of the
+ * visible tiles.  Each tile is clipped to its own bounds with user clip
+ * planes so objects straddling a tile edge are not blended twice.
+ *
+ * Invalidation may happen outside of the GL context, so display lists
+ * which are no longer wanted are only queued here, and deleted on the
+ * next call to hidgl_tile_cache_draw ().
+ */
+
+#define MAX_CACHED_TILES 512
+
+typedef struct {
+  int ix, iy;
+  GLuint list;
+} tile_entry;
+
+static GHashTable *tile_table = NULL;
+static GArray *stale_lists = NULL;
+static Coord tile_cache_size = 0;
+static double tile_cache_scale = 0.;
+static hidgl_tile_cache_stats tile_stats;
+
+static guint
+tile_entry_hash (gconstpointer key)
+{
+  const tile_entry *tile = key;
+  return (guint)tile->ix * 73856093u ^ (guint)tile->iy * 19349663u;
+}
+
+static gboolean
+tile_entry_equal (gconstpointer a, gconstpointer b)
+{
+  const tile_entry *ta = a;
+  const tile_entry *tb = b;
+  return ta->ix == tb->ix && ta->iy == tb->iy;
+}
+
+static void
+tile_entry_destroy (gpointer data)
+{
+  tile_entry *tile = data;
+
+  g_array_append_val (stale_lists, tile->list);
+  g_slice_free (tile_entry, tile);
+}
+
+static void
+tile_box (int ix, int iy, BoxType *box)
+{
+  box->X1 = (Coord)ix * tile_cache_size;
+  box->Y1 = (Coord)iy * tile_cache_size;
+  box->X2 = box->X1 + tile_cache_size;
+  box->Y2 = box->Y1 + tile_cache_size;
+}
+
+static int
+tile_index (Coord c)
+{
+  return (int)floor ((double)c / (double)tile_cache_size);
+}
+
+static void
+delete_stale_lists (void)
+{
+  guint i;
+
+  for (i = 0; i < stale_lists->len; i++)
+    glDeleteLists (g_array_index (stale_lists, GLuint, i), 1);
+
+  g_array_set_size (stale_lists, 0);
+}
+
+/*!
+ * \brief Forget all cached tiles.
+ *
+ * Safe to call outside of the GL context.
+ */
+void
+hidgl_tile_cache_invalidate_all (void)
+{
+  if (tile_table == NULL)
+    return;
+
+  g_hash_table_remove_all (tile_table);
+}
+
+struct invalidate_info {
+  int ix1, iy1, ix2, iy2;
+  bool inside;
+};
+
+static gboolean
+tile_in_range (gpointer key, gpointer value, gpointer user_data)
+{
+  tile_entry *tile = key;
+  struct invalidate_info *info = user_data;
+  bool in_range = tile->ix >= info->ix1 && tile->ix <= info->ix2 &&
+                  tile->iy >= info->iy1 && tile->iy <= info->iy2;
+
+  return in_range == info->inside;
+}
+
+/*!
+ * \brief Forget the cached tiles touching the given board region.
+ *
+ * Safe to call outside of the GL context.
+ */
+void
+hidgl_tile_cache_invalidate_region (const BoxType *region)
+{
+  struct invalidate_info info;
+
+  if (tile_table == NULL || tile_cache_size == 0)
+    return;
+
+  info.ix1 = tile_index (MIN (region->X1, region->X2));
+  info.ix2 = tile_index (MAX (region->X1, region->X2));
+  info.iy1 = tile_index (MIN (region->Y1, region->Y2));
+  info.iy2 = tile_index (MAX (region->Y1, region->Y2));
+  info.inside = true;
+
+  g_hash_table_foreach_remove (tile_table, tile_in_range, &info);
+}
+
+static void
+clear_stencil (void)
+{
+  glStencilMask (~0);
+  glClearStencil (0);
+  glClear (GL_STENCIL_BUFFER_BIT);
+  glStencilMask (0);
+  hidgl_reset_stencil_usage ();
+}
+
+static void
+set_tile_clip_planes (const BoxType *box)
+{
+  GLdouble left[4]   = { 1.,  0., 0., -(GLdouble)box->X1};
+  GLdouble right[4]  = {-1.,  0., 0.,  (GLdouble)box->X2};
+  GLdouble top[4]    = { 0.,  1., 0., -(GLdouble)box->Y1};
+  GLdouble bottom[4] = { 0., -1., 0.,  (GLdouble)box->Y2};
+
+  glClipPlane (GL_CLIP_PLANE0, left);
+  glClipPlane (GL_CLIP_PLANE1, right);
+  glClipPlane (GL_CLIP_PLANE2, top);
+  glClipPlane (GL_CLIP_PLANE3, bottom);
+}
+
+/*!
+ * \brief Draw a board region through the retained geometry cache.
+ *
+ * \param region     board area to be drawn.
+ * \param tile_size  edge length of a cache tile, in board units.
+ * \param scale      board units per pixel; a change drops the cache, as
+ *                   the tessellation depends on it.
+ * \param draw_tile  called to emit the geometry of a tile missing from
+ *                   the cache.
+ *
+ * Must be called with the GL context current.  The stencil buffer is
+ * cleared on return.
+ */
+void
+hidgl_tile_cache_draw (const BoxType *region, Coord tile_size, double scale,
+                       hidgl_tile_draw_fn draw_tile, void *user_data)
+{
+  struct invalidate_info visible;
+  tile_entry key, *tile;
+  BoxType box;
+  int ix, iy;
+
+  if (tile_table == NULL)
+    {
+      tile_table = g_hash_table_new_full (tile_entry_hash, tile_entry_equal,
+                                          tile_entry_destroy, NULL);
+      stale_lists = g_array_new (FALSE, FALSE, sizeof (GLuint));
+    }
+
+  if (tile_size < 1)
+    tile_size = 1;
+
+  if (tile_size != tile_cache_size || scale != tile_cache_scale)
+    {
+      hidgl_tile_cache_invalidate_all ();
+      tile_cache_size = tile_size;
+      tile_cache_scale = scale;
+    }
+
+  visible.ix1 = tile_index (region->X1);
+  visible.ix2 = tile_index (region->X2);
+  visible.iy1 = tile_index (region->Y1);
+  visible.iy2 = tile_index (region->Y2);
+
+  /* Keep the cache bounded by dropping what is off-screen */
+  if (g_hash_table_size (tile_table) > MAX_CACHED_TILES)
+    {
+      visible.inside = false;
+      g_hash_table_foreach_remove (tile_table, tile_in_range, &visible);
+    }
+
+  delete_stale_lists ();
+
+  glEnable (GL_CLIP_PLANE0);
+  glEnable (GL_CLIP_PLANE1);
+  glEnable (GL_CLIP_PLANE2);
+  glEnable (GL_CLIP_PLANE3);
+
+  for (iy = visible.iy1; iy <= visible.iy2; iy++)
+    for (ix = visible.ix1; ix <= visible.ix2; ix++)
+      {
+        tile_box (ix, iy, &box);
+        set_tile_clip_planes (&box);
+
+        key.ix = ix;
+        key.iy = iy;
+        tile = g_hash_table_lookup (tile_table, &key);
+
+        if (tile != NULL)
+          {
+            glCallList (tile->list);
+            tile_stats.hits++;
+            continue;
+          }
+
+        tile = g_slice_new (tile_entry);
+        tile->ix = ix;
+        tile->iy = iy;
+        tile->list = glGenLists (1);
+
+        glNewList (tile->list, GL_COMPILE_AND_EXECUTE);
+        /* Each tile starts from a clean stencil buffer, as it may be
+         * replayed after any other tile.
+         */
+        clear_stencil ();
+        draw_tile (&box, user_data);
+        hidgl_flush_triangles (&buffer);
+        glEndList ();
+
+        g_hash_table_insert (tile_table, tile, tile);
+        tile_stats.misses++;
+      }
+
+  glDisable (GL_CLIP_PLANE0);
+  glDisable (GL_CLIP_PLANE1);
+  glDisable (GL_CLIP_PLANE2);
+  glDisable (GL_CLIP_PLANE3);
+
+  clear_stencil ();
+  tile_stats.tiles = g_hash_table_size (tile_table);
+}
+
+/*!
+ * \brief Retrieve the cache counters, then reset the hit / miss counts.
+ */
+void
+hidgl_tile_cache_get_stats (hidgl_tile_cache_stats *stats)
+{
+  tile_stats.tiles = tile_table == NULL ? 0 : g_hash_table_size (tile_table);
+  *stats = tile_stats;
+  tile_stats.hits = 0;
+  tile_stats.misses = 0;
+}
+
 void
 hidgl_init (void)
 {
@@ -32,6 +32,7 @@ typedef struct {
   GLfloat triangle_array [3 * 3 * TRIANGLE_ARRAY_SIZE];
   unsigned int triangle_count;
   unsigned int coord_comp_count;
+  GArray *spill; /*!< If set, flushing appends here instead of drawing. */
 } triangle_buffer;
 
 extern triangle_buffer buffer;
@@ -74,11 +75,28 @@ void hidgl_set_depth (float depth);
 void hidgl_draw_line (int cap, Coord width, Coord x1, Coord y1, Coord x2, Coord y2, double scale);
 void hidgl_draw_arc (Coord width, Coord vx, Coord vy, Coord vrx, Coord vry, Angle start_angle, Angle delta_angle, double scale);
 void hidgl_draw_rect (Coord x1, Coord y1, Coord x2, Coord y2);
-void hidgl_fill_circle (Coord vx, Coord vy, Coord vr, double scale);
+void hidgl_fill_circle (Coord vx, Coord vy, Coord vr, double scale, bool lod);
 void hidgl_fill_polygon (int n_coords, Coord *x, Coord *y);
-void hidgl_fill_pcb_polygon (PolygonType *poly, const BoxType *clip_box, double scale);
+void hidgl_fill_pcb_polygon (PolygonType *poly, const BoxType *clip_box, double scale, bool lod);
 void hidgl_fill_rect (Coord x1, Coord y1, Coord x2, Coord y2);
 
+typedef void (*hidgl_tile_draw_fn) (const BoxType *tile, void *user_data);
+
+typedef struct {
+  unsigned long hits;   /*!< tiles replayed from the cache. */
+  unsigned long misses; /*!< tiles which had to be (re)built. */
+  unsigned int tiles;   /*!< tiles currently held in the cache. */
+} hidgl_tile_cache_stats;
+
+void hidgl_tile_cache_draw (const BoxType *region, Coord tile_size, double scale,
+                            hidgl_tile_draw_fn draw_tile, void *user_data);
+void hidgl_tile_cache_invalidate_all (void);
+void hidgl_tile_cache_invalidate_region (const BoxType *region);
+void hidgl_tile_cache_get_stats (hidgl_tile_cache_stats *stats);
+
+int hidgl_set_render_threads (int threads);
+int hidgl_get_render_threads (void);
+
 void hidgl_init (void);
 void hidgl_start_render (void);
 void hidgl_finish_render (void);
@@ -39,6 +39,7 @@
 
 #include "crosshair.h"
 #include "clip.h"
+#include "error.h"
 #include "../hidint.h"
 #include "gui.h"
 #include "hid/common/draw_helpers.h"
@@ -68,6 +69,25 @@ typedef struct render_priv {
   int attached_invalidate_depth;
   int mark_invalidate_depth;
 
+  /* Repaint timing, see ghid_report_render_stats () */
+  GTimer *frame_timer;
+  unsigned long frames;
+  double frame_time_total;
+  double frame_time_max;
+
+  /* Cache of rendered board tiles, see redraw_region () */
+  GHashTable *tiles;
+  GdkPixmap *tile_mask;
+  double tile_coord_per_px;
+  bool tile_flip_x;
+  bool tile_flip_y;
+  unsigned long tile_hits;
+  unsigned long tile_misses;
+
+  /* Partial repaints, see invalidate_box () */
+  unsigned long edits;
+  double edit_pixels;
+
   /* Feature for leading the user to a particular location */
   guint lead_user_timeout;
   GTimer *lead_user_timer;
@@ -742,37 +762,16 @@ ghid_fill_rect (hidGC gc, Coord x1, Coord y1, Coord x2, Coord y2)
 }
 
 /*!
- * \brief Redraw a region of the pcb workspace
+ * \brief Draw the board into priv->clip_rect of gport->drawable.
+ *
+ * This covers the dead area around the board, the background, and
+ * everything drawn by hid_expose_callback () and the grid.
  */
 static void
-redraw_region (GdkRectangle *rect)
+draw_board_area (render_priv *priv)
 {
   int eleft, eright, etop, ebottom;
   BoxType region; /* section to draw in PCB coordinates */
-  render_priv *priv = gport->render_priv;
-
-  if (!gport->pixmap)
-    return;
-
-  if (rect != NULL)
-    { /* draw the region passed as an argument */
-      priv->clip_rect = *rect;
-      priv->clip = true;
-    }
-  else
-    { /* specified region was null, draw the entire area */
-      priv->clip_rect.x = 0;
-      priv->clip_rect.y = 0;
-      priv->clip_rect.width = gport->width;
-      priv->clip_rect.height = gport->height;
-      priv->clip = false;
-    }
-
-  /* set the clip to prevent changes to anything outside the region */
-  set_clip (priv, priv->bg_gc);
-  set_clip (priv, priv->offlimits_gc);
-  set_clip (priv, priv->mask_gc);
-  set_clip (priv, priv->grid_gc);
 
   /* Compute the PCB coordinates of the area to redraw */
   /* Find the upper and lower corners of the drawing area */
@@ -840,8 +839,301 @@ redraw_region (GdkRectangle *rect)
 
   /* Draw all of the PCB stuff, elements, traces, etc. */
   hid_expose_callback (&ghid_hid, &region, 0);
-  
+
   ghid_graphics.draw_grid (&region);
+}
+
+/* Tile cache
+ *
+ * The board is rendered at the current zoom into square pixmaps, aligned
+ * to a grid of TILE_SIZE_PX screen pixels in (possibly flipped) board
+ * space.  A repaint copies the tiles covering the area to the backing
+ * pixmap and only renders those missing from the cache, so panning
+ * mostly blits, and an edit, which invalidates the board area it
+ * touched, re-renders just the tiles under it.  A change of zoom or of
+ * the viewing side drops all tiles.
+ */
+
+#define TILE_SIZE_PX 256
+#define MAX_CACHED_TILES 128
+
+typedef struct {
+  int ix, iy;
+  GdkPixmap *pixmap;
+} tile_entry;
+
+static guint
+tile_entry_hash (gconstpointer key)
+{
+  const tile_entry *tile = key;
+  return (guint)tile->ix * 73856093u ^ (guint)tile->iy * 19349663u;
+}
+
+static gboolean
+tile_entry_equal (gconstpointer a, gconstpointer b)
+{
+  const tile_entry *ta = a;
+  const tile_entry *tb = b;
+  return ta->ix == tb->ix && ta->iy == tb->iy;
+}
+
+static void
+tile_entry_destroy (gpointer data)
+{
+  tile_entry *tile = data;
+
+  g_object_unref (tile->pixmap);
+  g_slice_free (tile_entry, tile);
+}
+
+/*!
+ * \brief Floor division, for tile indices of negative pixel positions.
+ */
+static int
+tile_index (int px)
+{
+  return px >= 0 ? px / TILE_SIZE_PX : -((-px - 1) / TILE_SIZE_PX) - 1;
+}
+
+struct tile_range {
+  int ix1, iy1, ix2, iy2;
+  bool inside;
+};
+
+static gboolean
+tile_in_range (gpointer key, gpointer value, gpointer user_data)
+{
+  tile_entry *tile = key;
+  struct tile_range *range = user_data;
+  bool in_range = tile->ix >= range->ix1 && tile->ix <= range->ix2 &&
+                  tile->iy >= range->iy1 && tile->iy <= range->iy2;
+
+  return in_range == range->inside;
+}
+
+/*!
+ * \brief Render one tile into a new pixmap.
+ *
+ * The drawing routines work on gport, so it is pointed at the tile for
+ * the duration, the same way ghid_render_pixmap () does it.
+ */
+static GdkPixmap *
+render_tile (render_priv *priv, int ix, int iy)
+{
+  GdkPixmap *pixmap;
+  GdkPixmap *save_pixmap, *save_mask;
+  GdkDrawable *save_drawable;
+  view_data save_view;
+  int save_width, save_height;
+  double zoom = gport->view.coord_per_px;
+
+  if (priv->tile_mask == NULL)
+    priv->tile_mask = gdk_pixmap_new (0, TILE_SIZE_PX, TILE_SIZE_PX, 1);
+
+  pixmap = gdk_pixmap_new (gport->pixmap, TILE_SIZE_PX, TILE_SIZE_PX, -1);
+
+  save_pixmap = gport->pixmap;
+  save_mask = gport->mask;
+  save_drawable = gport->drawable;
+  save_view = gport->view;
+  save_width = gport->width;
+  save_height = gport->height;
+
+  gport->pixmap = pixmap;
+  gport->drawable = pixmap;
+  gport->mask = priv->tile_mask;
+  gport->width = TILE_SIZE_PX;
+  gport->height = TILE_SIZE_PX;
+  gport->view.x0 = (Coord)ix * TILE_SIZE_PX * zoom;
+  gport->view.y0 = (Coord)iy * TILE_SIZE_PX * zoom;
+  gport->view.width = TILE_SIZE_PX * zoom;
+  gport->view.height = TILE_SIZE_PX * zoom;
+
+  priv->clip_rect.x = 0;
+  priv->clip_rect.y = 0;
+  priv->clip_rect.width = TILE_SIZE_PX;
+  priv->clip_rect.height = TILE_SIZE_PX;
+
+  draw_board_area (priv);
+
+  gport->pixmap = save_pixmap;
+  gport->mask = save_mask;
+  gport->drawable = save_drawable;
+  gport->view = save_view;
+  gport->width = save_width;
+  gport->height = save_height;
+
+  return pixmap;
+}
+
+/*!
+ * \brief Copy the board tiles covering priv->clip_rect to the backing
+ * pixmap, rendering those not in the cache.
+ */
+static void
+draw_tiles (render_priv *priv)
+{
+  GdkRectangle area = priv->clip_rect;
+  struct tile_range visible;
+  tile_entry key, *tile;
+  int ox, oy;
+  int ix, iy;
+
+  if (priv->tiles == NULL)
+    priv->tiles = g_hash_table_new_full (tile_entry_hash, tile_entry_equal,
+                                         tile_entry_destroy, NULL);
+
+  if (gport->view.coord_per_px != priv->tile_coord_per_px ||
+      gport->view.flip_x != priv->tile_flip_x ||
+      gport->view.flip_y != priv->tile_flip_y)
+    {
+      g_hash_table_remove_all (priv->tiles);
+      priv->tile_coord_per_px = gport->view.coord_per_px;
+      priv->tile_flip_x = gport->view.flip_x;
+      priv->tile_flip_y = gport->view.flip_y;
+    }
+
+  /* Pixel offset of the view in the tile grid */
+  ox = floor (gport->view.x0 / gport->view.coord_per_px);
+  oy = floor (gport->view.y0 / gport->view.coord_per_px);
+
+  visible.ix1 = tile_index (ox + area.x);
+  visible.iy1 = tile_index (oy + area.y);
+  visible.ix2 = tile_index (ox + area.x + area.width);
+  visible.iy2 = tile_index (oy + area.y + area.height);
+
+  /* Keep the cache bounded by dropping what is off-screen */
+  if (g_hash_table_size (priv->tiles) > MAX_CACHED_TILES)
+    {
+      struct tile_range screen;
+
+      screen.ix1 = tile_index (ox);
+      screen.iy1 = tile_index (oy);
+      screen.ix2 = tile_index (ox + gport->width);
+      screen.iy2 = tile_index (oy + gport->height);
+      screen.inside = false;
+      g_hash_table_foreach_remove (priv->tiles, tile_in_range, &screen);
+    }
+
+  /* Tiles are rendered whole and unclipped */
+  priv->clip = false;
+  set_clip (priv, priv->bg_gc);
+  set_clip (priv, priv->offlimits_gc);
+  set_clip (priv, priv->mask_gc);
+  set_clip (priv, priv->grid_gc);
+
+  for (iy = visible.iy1; iy <= visible.iy2; iy++)
+    for (ix = visible.ix1; ix <= visible.ix2; ix++)
+      {
+        key.ix = ix;
+        key.iy = iy;
+        if (g_hash_table_lookup (priv->tiles, &key) != NULL)
+          {
+            priv->tile_hits++;
+            continue;
+          }
+
+        tile = g_slice_new (tile_entry);
+        tile->ix = ix;
+        tile->iy = iy;
+        tile->pixmap = render_tile (priv, ix, iy);
+        g_hash_table_insert (priv->tiles, tile, tile);
+        priv->tile_misses++;
+      }
+
+  /* Only touch the area being redrawn, the XOR overlays live elsewhere */
+  gdk_gc_set_clip_rectangle (priv->bg_gc, &area);
+
+  for (iy = visible.iy1; iy <= visible.iy2; iy++)
+    for (ix = visible.ix1; ix <= visible.ix2; ix++)
+      {
+        key.ix = ix;
+        key.iy = iy;
+        tile = g_hash_table_lookup (priv->tiles, &key);
+        gdk_draw_drawable (gport->pixmap, priv->bg_gc, tile->pixmap,
+                           0, 0,
+                           ix * TILE_SIZE_PX - ox, iy * TILE_SIZE_PX - oy,
+                           TILE_SIZE_PX, TILE_SIZE_PX);
+      }
+
+  priv->clip_rect = area;
+}
+
+/*!
+ * \brief Forget all cached tiles.
+ */
+static void
+drop_tiles (render_priv *priv)
+{
+  if (priv->tiles != NULL)
+    g_hash_table_remove_all (priv->tiles);
+}
+
+/*!
+ * \brief Forget the cached tiles touching a region of the board.
+ */
+static void
+drop_tiles_in_region (render_priv *priv,
+                      Coord left, Coord right, Coord top, Coord bottom)
+{
+  struct tile_range range;
+  double x1, x2, y1, y2;
+
+  if (priv->tiles == NULL || priv->tile_coord_per_px == 0.)
+    return;
+
+  /* Pixels in the tile grid, one pixel beyond to allow for rounding */
+  x1 = SIDE_X (left) / priv->tile_coord_per_px;
+  x2 = SIDE_X (right) / priv->tile_coord_per_px;
+  y1 = SIDE_Y (top) / priv->tile_coord_per_px;
+  y2 = SIDE_Y (bottom) / priv->tile_coord_per_px;
+
+  range.ix1 = tile_index (floor (MIN (x1, x2)) - 1);
+  range.ix2 = tile_index (ceil (MAX (x1, x2)) + 1);
+  range.iy1 = tile_index (floor (MIN (y1, y2)) - 1);
+  range.iy2 = tile_index (ceil (MAX (y1, y2)) + 1);
+  range.inside = true;
+
+  g_hash_table_foreach_remove (priv->tiles, tile_in_range, &range);
+}
+
+/*!
+ * \brief Redraw a region of the pcb workspace
+ */
+static void
+redraw_region (GdkRectangle *rect)
+{
+  render_priv *priv = gport->render_priv;
+  GdkRectangle screen = {0, 0, gport->width, gport->height};
+  double frame_time;
+
+  if (!gport->pixmap)
+    return;
+
+  if (rect != NULL)
+    { /* draw the part of the region passed as an argument on screen */
+      if (!gdk_rectangle_intersect (rect, &screen, &priv->clip_rect))
+        return;
+    }
+  else
+    { /* specified region was null, draw the entire area */
+      priv->clip_rect.x = 0;
+      priv->clip_rect.y = 0;
+      priv->clip_rect.width = gport->width;
+      priv->clip_rect.height = gport->height;
+    }
+
+  g_timer_start (priv->frame_timer);
+
+  draw_tiles (priv);
+
+  priv->clip = (rect != NULL);
+
+  /* set the clip to prevent changes to anything outside the region */
+  set_clip (priv, priv->bg_gc);
+  set_clip (priv, priv->offlimits_gc);
+  set_clip (priv, priv->mask_gc);
+  set_clip (priv, priv->grid_gc);
 
   /* In some cases we are called with the crosshair still off */
   if (priv->attached_invalidate_depth == 0)
@@ -858,11 +1150,21 @@ redraw_region (GdkRectangle *rect)
 
   /* Reset the clip for bg_gc, as it is used outside this function */
   gdk_gc_set_clip_mask (priv->bg_gc, NULL);
+
+  frame_time = g_timer_elapsed (priv->frame_timer, NULL);
+  priv->frames++;
+  priv->frame_time_total += frame_time;
+  priv->frame_time_max = MAX (priv->frame_time_max, frame_time);
 }
 
-void
-ghid_invalidate_lr (Coord left, Coord right, Coord top, Coord bottom)
+/*!
+ * \brief Redraw a board area in the backing pixmap, without updating
+ * the screen.
+ */
+static void
+invalidate_box (Coord left, Coord right, Coord top, Coord bottom)
 {
+  render_priv *priv = gport->render_priv;
   Coord dleft, dright, dtop, dbottom;
   Coord minx, maxx, miny, maxy;
   GdkRectangle rect;
@@ -882,7 +1184,34 @@ ghid_invalidate_lr (Coord left, Coord right, Coord top, Coord bottom)
   rect.width = maxx - minx;
   rect.height = maxy - miny;
 
+  drop_tiles_in_region (priv, left, right, top, bottom);
   redraw_region (&rect);
+
+  /* Count what is on screen */
+  minx = MAX (minx, 0);
+  miny = MAX (miny, 0);
+  maxx = MIN (maxx, gport->width);
+  maxy = MIN (maxy, gport->height);
+  if (maxx > minx && maxy > miny)
+    priv->edit_pixels += (double)(maxx - minx) * (double)(maxy - miny);
+}
+
+void
+ghid_invalidate_lr (Coord left, Coord right, Coord top, Coord bottom)
+{
+  gport->render_priv->edits++;
+  invalidate_box (left, right, top, bottom);
+  ghid_screen_update ();
+}
+
+void
+ghid_invalidate_rects (const BoxType *rects, int n_rects)
+{
+  int i;
+
+  gport->render_priv->edits++;
+  for (i = 0; i < n_rects; i++)
+    invalidate_box (rects[i].X1, rects[i].X2, rects[i].Y1, rects[i].Y2);
   ghid_screen_update ();
 }
 
@@ -890,10 +1219,65 @@ ghid_invalidate_lr (Coord left, Coord right, Coord top, Coord bottom)
 void
 ghid_invalidate_all ()
 {
+  drop_tiles (gport->render_priv);
   redraw_region (NULL);
   ghid_screen_update ();
 }
 
+void
+ghid_invalidate_view (void)
+{
+  redraw_region (NULL);
+  ghid_screen_update ();
+}
+
+int
+ghid_set_render_threads (int threads)
+{
+  /* Drawing with GDK is single threaded */
+  return 1;
+}
+
+int
+ghid_get_render_threads (void)
+{
+  return 1;
+}
+
+void
+ghid_report_render_stats (void)
+{
+  render_priv *priv = gport->render_priv;
+
+  if (priv->frames == 0)
+    Message (_("No frames drawn since the last report\n"));
+  else
+    Message (_("%lu repaints, %.2f ms average, %.2f ms worst\n"),
+             priv->frames,
+             1000. * priv->frame_time_total / priv->frames,
+             1000. * priv->frame_time_max);
+
+  if (priv->tiles != NULL)
+    Message (_("%lu tiles reused, %lu rendered, %u cached\n"),
+             priv->tile_hits, priv->tile_misses,
+             g_hash_table_size (priv->tiles));
+
+  if (priv->edits > 0)
+    Message (_("%lu partial repaints, %.0f pixels each on average "
+               "(%.1f%% of the view)\n"),
+             priv->edits, priv->edit_pixels / priv->edits,
+             100. * priv->edit_pixels / priv->edits /
+             ((double)gport->width * gport->height));
+
+  priv->edits = 0;
+  priv->edit_pixels = 0.;
+  priv->tile_hits = 0;
+  priv->tile_misses = 0;
+  priv->frames = 0;
+  priv->frame_time_total = 0.;
+  priv->frame_time_max = 0.;
+}
+
 void
 ghid_notify_crosshair_change (bool changes_complete)
 {
@@ -914,7 +1298,7 @@ ghid_notify_crosshair_change (bool changes_complete)
        * As we know the crosshair will have been shown already, we must
        * repaint the entire view to be sure not to leave an artaefact.
        */
-      ghid_invalidate_all ();
+      ghid_invalidate_view ();
       return;
     }
 
@@ -952,7 +1336,7 @@ ghid_notify_mark_change (bool changes_complete)
        * As we know the mark will have been shown already, we must
        * repaint the entire view to be sure not to leave an artaefact.
        */
-      ghid_invalidate_all ();
+      ghid_invalidate_view ();
       return;
     }
 
@@ -1095,6 +1479,7 @@ ghid_init_renderer (int *argc, char ***argv, GHidPort *port)
   /* Init any GC's required */
   port->render_priv = g_new0 (render_priv, 1);
   port->render_priv->crosshair_gc = gui->graphics->make_gc ();
+  port->render_priv->frame_timer = g_timer_new ();
 }
 
 void
@@ -1104,6 +1489,11 @@ ghid_shutdown_renderer (GHidPort *port)
 
   gui->graphics->destroy_gc (priv->crosshair_gc);
   ghid_cancel_lead_user ();
+  g_timer_destroy (priv->frame_timer);
+  if (priv->tiles != NULL)
+    g_hash_table_destroy (priv->tiles);
+  if (priv->tile_mask != NULL)
+    g_object_unref (priv->tile_mask);
   g_free (port->render_priv);
   port->render_priv = NULL;
 }
@@ -1395,7 +1785,7 @@ lead_user_cb (gpointer data)
   double elapsed_time;
 
   /* Queue a redraw */
-  ghid_invalidate_all ();
+  ghid_invalidate_view ();
 
   /* Update radius */
   elapsed_time = g_timer_elapsed (priv->lead_user_timer, NULL);
@@ -1437,7 +1827,7 @@ ghid_cancel_lead_user (void)
     g_timer_destroy (priv->lead_user_timer);
 
   if (priv->lead_user)
-    ghid_invalidate_all ();
+    ghid_invalidate_view ();
 
   priv->lead_user_timeout = 0;
   priv->lead_user_timer = NULL;
@@ -6,6 +6,8 @@
 
 #include "crosshair.h"
 #include "clip.h"
+#include "draw.h"
+#include "error.h"
 #include "../hidint.h"
 #include "gui.h"
 #include "gui-pinout-preview.h"
@@ -69,6 +71,16 @@ typedef struct render_priv {
   double current_alpha_mult;
   GTimer *time_since_expose;
 
+  /* Frame timing, see ghid_report_render_stats () */
+  GTimer *frame_timer;
+  unsigned long frames;
+  double frame_time_total;
+  double frame_time_max;
+
+  /* Partial invalidations, see count_edit_pixels () */
+  unsigned long edits;
+  double edit_pixels;
+
   /* Feature for leading the user to a particular location */
   guint lead_user_timeout;
   GTimer *lead_user_timer;
@@ -571,7 +583,8 @@ ghid_fill_circle (hidGC gc, Coord cx, Coord cy, Coord radius)
 {
   USE_GC (gc);
 
-  hidgl_fill_circle (cx, cy, radius, gport->view.coord_per_px);
+  hidgl_fill_circle (cx, cy, radius, gport->view.coord_per_px,
+                     DrawLevelOfDetail ());
 }
 
 
@@ -588,7 +601,8 @@ ghid_fill_pcb_polygon (hidGC gc, PolygonType *poly, const BoxType *clip_box)
 {
   USE_GC (gc);
 
-  hidgl_fill_pcb_polygon (poly, clip_box, gport->view.coord_per_px);
+  hidgl_fill_pcb_polygon (poly, clip_box, gport->view.coord_per_px,
+                          DrawLevelOfDetail ());
 }
 
 void
@@ -608,15 +622,67 @@ ghid_fill_rect (hidGC gc, Coord x1, Coord y1, Coord x2, Coord y2)
   hidgl_fill_rect (x1, y1, x2, y2);
 }
 
+/*!
+ * \brief Account for the on-screen pixels of an invalidated board area.
+ *
+ * The frame is still composited whole, but only the geometry tiles
+ * under these areas are built again.
+ */
+static void
+count_edit_pixels (const BoxType *region)
+{
+  render_priv *priv = gport->render_priv;
+  int x1 = Vx (region->X1), x2 = Vx (region->X2);
+  int y1 = Vy (region->Y1), y2 = Vy (region->Y2);
+  int minx = MAX (MIN (x1, x2), 0);
+  int maxx = MIN (MAX (x1, x2), gport->width);
+  int miny = MAX (MIN (y1, y2), 0);
+  int maxy = MIN (MAX (y1, y2), gport->height);
+
+  if (maxx > minx && maxy > miny)
+    priv->edit_pixels += (double)(maxx - minx) * (double)(maxy - miny);
+}
+
 void
 ghid_invalidate_lr (Coord left, Coord right, Coord top, Coord bottom)
 {
-  ghid_invalidate_all ();
+  BoxType region;
+
+  region.X1 = left;
+  region.X2 = right;
+  region.Y1 = top;
+  region.Y2 = bottom;
+
+  gport->render_priv->edits++;
+  count_edit_pixels (&region);
+  hidgl_tile_cache_invalidate_region (&region);
+  ghid_invalidate_view ();
+}
+
+void
+ghid_invalidate_rects (const BoxType *rects, int n_rects)
+{
+  int i;
+
+  gport->render_priv->edits++;
+  for (i = 0; i < n_rects; i++)
+    {
+      count_edit_pixels (&rects[i]);
+      hidgl_tile_cache_invalidate_region (&rects[i]);
+    }
+  ghid_invalidate_view ();
 }
 
-#define MAX_ELAPSED (50. / 1000.) /* 50ms */
 void
 ghid_invalidate_all ()
+{
+  hidgl_tile_cache_invalidate_all ();
+  ghid_invalidate_view ();
+}
+
+#define MAX_ELAPSED (50. / 1000.) /* 50ms */
+void
+ghid_invalidate_view (void)
 {
   render_priv *priv = gport->render_priv;
   double elapsed = g_timer_elapsed (priv->time_since_expose, NULL);
@@ -635,7 +701,7 @@ ghid_notify_crosshair_change (bool changes_complete)
     return;
 
   /* FIXME: We could just invalidate the bounds of the crosshair attached objects? */
-  if (changes_complete) ghid_invalidate_all ();
+  if (changes_complete) ghid_invalidate_view ();
 }
 
 void
@@ -646,7 +712,7 @@ ghid_notify_mark_change (bool changes_complete)
     return;
 
   /* FIXME: We could just invalidate the bounds of the mark? */
-  if (changes_complete) ghid_invalidate_all ();
+  if (changes_complete) ghid_invalidate_view ();
 }
 
 static void
@@ -784,6 +850,7 @@ ghid_init_renderer (int *argc, char ***argv, GHidPort *port)
   port->render_priv->crosshair_gc = gui->graphics->make_gc ();
 
   priv->time_since_expose = g_timer_new ();
+  priv->frame_timer = g_timer_new ();
 
   gtk_gl_init(argc, argv);
 
@@ -797,6 +864,8 @@ ghid_init_renderer (int *argc, char ***argv, GHidPort *port)
       return; /* Should we abort? */
     }
 
+  hidgl_set_render_threads (g_get_num_processors ());
+
   /* Setup HID function pointers specific to the GL renderer*/
   ghid_hid.end_layer = ghid_end_layer;
   ghid_graphics.fill_pcb_polygon = ghid_fill_pcb_polygon;
@@ -810,6 +879,8 @@ ghid_shutdown_renderer (GHidPort *port)
 
   gui->graphics->destroy_gc (priv->crosshair_gc);
   ghid_cancel_lead_user ();
+  g_timer_destroy (priv->time_since_expose);
+  g_timer_destroy (priv->frame_timer);
   g_free (port->render_priv);
   port->render_priv = NULL;
 }
@@ -867,6 +938,69 @@ ghid_screen_update (void)
 {
 }
 
+/* Size of a retained geometry tile, in screen pixels */
+#define TILE_SIZE_PX 256
+
+static void
+draw_board_tile (const BoxType *tile, void *user_data)
+{
+  render_priv *priv = user_data;
+  BoxType region = *tile;
+
+  /* The tile's display list must record its own colour changes, as it
+   * may be replayed after any other tile.
+   */
+  free (priv->current_colorname);
+  priv->current_colorname = NULL;
+  ghid_invalidate_current_gc ();
+
+  hid_expose_callback (&ghid_hid, &region, 0);
+}
+
+int
+ghid_set_render_threads (int threads)
+{
+  return hidgl_set_render_threads (threads);
+}
+
+int
+ghid_get_render_threads (void)
+{
+  return hidgl_get_render_threads ();
+}
+
+void
+ghid_report_render_stats (void)
+{
+  render_priv *priv = gport->render_priv;
+  hidgl_tile_cache_stats stats;
+
+  hidgl_tile_cache_get_stats (&stats);
+
+  if (priv->frames == 0)
+    Message (_("No frames drawn since the last report\n"));
+  else
+    Message (_("%lu frames, %.2f ms average, %.2f ms worst\n"
+               "Geometry tiles: %lu replayed, %lu built, %u cached\n"),
+             priv->frames,
+             1000. * priv->frame_time_total / priv->frames,
+             1000. * priv->frame_time_max,
+             stats.hits, stats.misses, stats.tiles);
+
+  if (priv->edits > 0)
+    Message (_("%lu partial invalidations, %.0f pixels each on average "
+               "(%.1f%% of the view)\n"),
+             priv->edits, priv->edit_pixels / priv->edits,
+             100. * priv->edit_pixels / priv->edits /
+             ((double)gport->width * gport->height));
+
+  priv->edits = 0;
+  priv->edit_pixels = 0.;
+  priv->frames = 0;
+  priv->frame_time_total = 0.;
+  priv->frame_time_max = 0.;
+}
+
 #define Z_NEAR 3.0
 gboolean
 ghid_drawing_area_expose_cb (GtkWidget *widget,
@@ -881,6 +1015,9 @@ ghid_drawing_area_expose_cb (GtkWidget *widget,
   Coord new_x, new_y;
   Coord min_depth;
   Coord max_depth;
+  double frame_time;
+
+  g_timer_start (priv->frame_timer);
 
   gtk_widget_get_allocation (widget, &allocation);
 
@@ -1012,12 +1149,13 @@ ghid_drawing_area_expose_cb (GtkWidget *widget,
 
   ghid_draw_bg_image ();
 
-  ghid_invalidate_current_gc ();
-  hid_expose_callback (&ghid_hid, &region, 0);
-  hidgl_flush_triangles (&buffer);
+  hidgl_tile_cache_draw (&region, TILE_SIZE_PX * port->view.coord_per_px,
+                         port->view.coord_per_px, draw_board_tile, priv);
 
   ghid_graphics.draw_grid (&region);
 
+  free (priv->current_colorname);
+  priv->current_colorname = NULL;
   ghid_invalidate_current_gc ();
 
   DrawAttached (priv->crosshair_gc);
@@ -1032,6 +1170,11 @@ ghid_drawing_area_expose_cb (GtkWidget *widget,
   hidgl_finish_render ();
   ghid_end_drawing (port, widget);
 
+  frame_time = g_timer_elapsed (priv->frame_timer, NULL);
+  priv->frames++;
+  priv->frame_time_total += frame_time;
+  priv->frame_time_max = MAX (priv->frame_time_max, frame_time);
+
   g_timer_start (priv->time_since_expose);
 
   return FALSE;
@@ -1564,7 +1707,7 @@ void
 ghid_view_2d (void *ball, gboolean view_2d, gpointer userdata)
 {
   global_view_2d = view_2d;
-  ghid_invalidate_all ();
+  ghid_invalidate_view ();
 }
 
 void
@@ -1587,7 +1730,7 @@ ghid_port_rotate (void *ball, float *quarternion, gpointer userdata)
   printf ("\n");
 #endif
 
-  ghid_invalidate_all ();
+  ghid_invalidate_view ();
 }
 
 
@@ -1642,7 +1785,7 @@ lead_user_cb (gpointer data)
   double elapsed_time;
 
   /* Queue a redraw */
-  ghid_invalidate_all ();
+  ghid_invalidate_view ();
 
   /* Update radius */
   elapsed_time = g_timer_elapsed (priv->lead_user_timer, NULL);
@@ -1684,7 +1827,7 @@ ghid_cancel_lead_user (void)
     g_timer_destroy (priv->lead_user_timer);
 
   if (priv->lead_user)
-    ghid_invalidate_all ();
+    ghid_invalidate_view ();
 
   priv->lead_user_timeout = 0;
   priv->lead_user_timer = NULL;
@@ -1692,7 +1692,11 @@ Export (int argc, char **argv, Coord x, Coord y)
 /* ------------------------------------------------------------ */
 
 static const char benchmark_syntax[] =
-"Benchmark()\n";
+"Benchmark()\n"
+"Benchmark(Pan)\n"
+"Benchmark(Fit)\n"
+"Benchmark(Threads, [max])\n"
+"Benchmark(Stats)";
 
 static const char benchmark_help[] =
 N_("Report the amount of redraws per second.");
@@ -1705,24 +1709,130 @@ entry dialog.
 @noindent This action reports the number of redraws per second on the command
 line interface.
 
+@table @code
+
+@item Pan
+Pan the view across the board, a quarter of the screen width at a
+time, and back again, and report the time taken by each frame.  Only
+the view changes between frames, so this measures how well the
+renderer reuses its previous work.
+
+@item Fit
+Zoom to fit the whole board, then redraw it from scratch a number of
+times and report the time taken by each frame.
+
+@item Threads
+Render the whole board offscreen a number of times with 1, 2, 4, ... up
+to @var{max} (default 8) render threads, and report the time per frame
+for each.  Renderers which can't use threads stop after one thread.
+
+@item Stats
+Report the frame times collected by the renderer since the last report.
+
+@end table
+
 %end-doc */
 
+#define BENCHMARK_PAN_STEPS 40
+#define BENCHMARK_FIT_FRAMES 20
+#define BENCHMARK_OFFSCREEN_FRAMES 10
 static int
 Benchmark (int argc, char **argv, Coord x, Coord y)
 {
   int i = 0;
   time_t start, end;
   GdkDisplay *display;
+  GdkWindow *window = gtk_widget_get_window (gport->drawing_area);
 
   display = gdk_drawable_get_display (gport->drawable);
 
+  if (argc > 0 && strcasecmp (argv[0], "Stats") == 0)
+    {
+      ghid_report_render_stats ();
+      return 0;
+    }
+
+  if (argc > 0 && strcasecmp (argv[0], "Pan") == 0)
+    {
+      Coord step = gport->view.width / 4;
+
+      /* Start from a fresh set of counters, with a warm view */
+      ghid_invalidate_all ();
+      gdk_window_process_updates (window, FALSE);
+      gdk_display_sync (display);
+      ghid_report_render_stats ();
+
+      for (i = 0; i < BENCHMARK_PAN_STEPS; i++)
+        {
+          ghid_pan_view_rel (i < BENCHMARK_PAN_STEPS / 2 ? step : -step, 0);
+          gdk_window_process_updates (window, FALSE);
+          gdk_display_sync (display);
+        }
+
+      ghid_report_render_stats ();
+      return 0;
+    }
+
+  if (argc > 0 && strcasecmp (argv[0], "Threads") == 0)
+    {
+      int max_threads = argc > 1 ? atoi (argv[1]) : 8;
+      int saved_threads = ghid_get_render_threads ();
+      int threads;
+      double zoom = MAX ((double)PCB->MaxWidth  / gport->width,
+                         (double)PCB->MaxHeight / gport->height);
+      GTimer *timer = g_timer_new ();
+
+      for (threads = 1; threads <= max_threads; threads *= 2)
+        {
+          if (ghid_set_render_threads (threads) != threads)
+            break;
+
+          g_timer_start (timer);
+          for (i = 0; i < BENCHMARK_OFFSCREEN_FRAMES; i++)
+            {
+              GdkPixmap *pixmap;
+
+              pixmap = ghid_render_pixmap (PCB->MaxWidth / 2, PCB->MaxHeight / 2,
+                                           zoom, gport->width, gport->height,
+                                           gdk_drawable_get_depth (gport->drawable));
+              if (pixmap != NULL)
+                g_object_unref (pixmap);
+            }
+          gdk_display_sync (display);
+
+          Message (_("%d render threads: %.2f ms per frame\n"), threads,
+                   1000. * g_timer_elapsed (timer, NULL) / BENCHMARK_OFFSCREEN_FRAMES);
+        }
+
+      ghid_set_render_threads (saved_threads);
+      g_timer_destroy (timer);
+      return 0;
+    }
+
+  if (argc > 0 && strcasecmp (argv[0], "Fit") == 0)
+    {
+      ghid_zoom_view_fit ();
+      gdk_window_process_updates (window, FALSE);
+      gdk_display_sync (display);
+      ghid_report_render_stats ();
+
+      for (i = 0; i < BENCHMARK_FIT_FRAMES; i++)
+        {
+          ghid_invalidate_all ();
+          gdk_window_process_updates (window, FALSE);
+          gdk_display_sync (display);
+        }
+
+      ghid_report_render_stats ();
+      return 0;
+    }
+
   gdk_display_sync (display);
   time (&start);
   do
     {
       ghid_invalidate_all ();
-      gdk_window_process_updates (gtk_widget_get_window (gport->drawing_area),
-                                  FALSE);
+      gdk_window_process_updates (window, FALSE);
       time (&end);
       i++;
     }
@@ -2338,6 +2448,7 @@ hid_gtk_init ()
   ghid_hid.parse_arguments          = ghid_parse_arguments;
   ghid_hid.invalidate_lr            = ghid_invalidate_lr;
   ghid_hid.invalidate_all           = ghid_invalidate_all;
+  ghid_hid.invalidate_rects         = ghid_invalidate_rects;
   ghid_hid.notify_crosshair_change  = ghid_notify_crosshair_change;
   ghid_hid.notify_mark_change       = ghid_notify_mark_change;
   ghid_hid.set_layer                = ghid_set_layer;
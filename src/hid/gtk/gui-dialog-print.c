@@ -36,6 +36,7 @@
 
 #include "gui.h"
 #include "pcb-printf.h"
+#include "perf.h"
 
 #ifdef HAVE_LIBDMALLOC
 #include <dmalloc.h>
@@ -366,6 +367,7 @@ ghid_dialog_print (HID *hid)
   int n = 0;
   int i;
   HID_Attr_Val * results = NULL;
+  guint64 start;
 
   /* signal the initial export select dialog that it should close */
   if (export_dialog)
@@ -390,7 +392,9 @@ ghid_dialog_print (HID *hid)
 	  
     }
 
+  start = perf_now ();
   exporter->do_export (results);
+  perf_end (perf_stat ("export", exporter->name), start);
   
   for (i = 0; i < n; i++)
     {
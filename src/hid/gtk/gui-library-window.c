@@ -61,6 +61,7 @@
 #include "buffer.h"
 #include "data.h"
 #include "set.h"
+#include "mymem.h"
 
 #include <gdk/gdkkeysyms.h>
 
@@ -414,7 +415,7 @@ out:
 
   /* update the preview with new symbol data */
   g_object_set (library_window->preview,
-		"element-data", PASTEBUFFER->Data->Element->data, NULL);
+		"element-data", FirstObjectInList (&PASTEBUFFER->Data->Element), NULL);
 }
 
 /*! \brief If there is only one toplevel node, expand it. */
@@ -62,7 +62,7 @@ ghid_port_ranges_changed (void)
   gport->view.x0 = gtk_adjustment_get_value (h_adj);
   gport->view.y0 = gtk_adjustment_get_value (v_adj);
 
-  ghid_invalidate_all ();
+  ghid_invalidate_view ();
 }
 
 /* Do scrollbar scaling based on current port drawing area size and
@@ -174,7 +174,7 @@ ghid_port_key_release_cb (GtkWidget * drawing_area, GdkEventKey * kev,
     ghid_note_event_location (NULL);
 
   AdjustAttachedObjects ();
-  ghid_invalidate_all ();
+  ghid_invalidate_view ();
   g_idle_add (ghid_idle_cb, NULL);
   return FALSE;
 }
@@ -313,7 +313,7 @@ ghid_port_button_press_cb (GtkWidget * drawing_area,
 
   do_mouse_action(ev->button, mk);
 
-  ghid_invalidate_all ();
+  ghid_invalidate_view ();
   ghid_window_set_name_label (PCB->Name);
   ghid_set_status_line_label ();
   if (!gport->panning)
@@ -336,7 +336,7 @@ ghid_port_button_release_cb (GtkWidget * drawing_area,
   do_mouse_action(ev->button, mk + M_Release);
 
   AdjustAttachedObjects ();
-  ghid_invalidate_all ();
+  ghid_invalidate_view ();
 
   ghid_window_set_name_label (PCB->Name);
   ghid_set_status_line_label ();
@@ -1826,10 +1826,6 @@ ghid_parse_arguments (int *argc, char ***argv)
     }
 #endif
 
-  /* Threads aren't used in PCB, but this call would go here.
-   */
-  /* g_thread_init (NULL); */
-
   /*
    * Prevent gtk_init() and gtk_init_check() from automatically calling
    * setlocale (LC_ALL, "") which would undo LC_NUMERIC handling in main().
@@ -496,6 +496,11 @@ void ghid_fill_polygon (hidGC gc, int n_coords, Coord *x, Coord *y);
 void ghid_fill_rect (hidGC gc, Coord x1, Coord y1, Coord x2, Coord y2);
 void ghid_invalidate_lr (Coord left, Coord right, Coord top, Coord bottom);
 void ghid_invalidate_all ();
+void ghid_invalidate_rects (const BoxType *rects, int n_rects);
+void ghid_invalidate_view (void);
+void ghid_report_render_stats (void);
+int ghid_set_render_threads (int threads);
+int ghid_get_render_threads (void);
 void ghid_notify_crosshair_change (bool changes_complete);
 void ghid_notify_mark_change (bool changes_complete);
 void ghid_init_renderer (int *, char ***, GHidPort *);
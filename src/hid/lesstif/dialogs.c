@@ -15,6 +15,7 @@
 #include "crosshair.h"
 #include "misc.h"
 #include "pcb-printf.h"
+#include "perf.h"
 
 #include "hid.h"
 #include "../hidint.h"
@@ -1009,6 +1010,7 @@ Print (int argc, char **argv, Coord x, Coord y)
   HID *printer;
   HID_Attr_Val *vals;
   int n;
+  guint64 start;
 
   printer = hid_find_printer ();
   if (!printer)
@@ -1023,7 +1025,9 @@ Print (int argc, char **argv, Coord x, Coord y)
       free (vals);
       return 1;
     }
+  start = perf_now ();
   printer->do_export (vals);
+  perf_end (perf_stat ("export", printer->name), start);
   free (vals);
   return 0;
 }
@@ -1087,6 +1091,7 @@ Export (int argc, char **argv, Coord x, Coord y)
   HID *printer, **hids;
   HID_Attr_Val *vals;
   int n, i;
+  guint64 start;
   Widget prev = 0;
   Widget w;
 
@@ -1141,7 +1146,9 @@ Export (int argc, char **argv, Coord x, Coord y)
       free (vals);
       return 1;
     }
+  start = perf_now ();
   printer->do_export (vals);
+  perf_end (perf_stat ("export", printer->name), start);
   free (vals);
   exporter = NULL;
   return 0;
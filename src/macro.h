@@ -158,6 +158,17 @@
  */
 #define END_LOOP  }} while (0)
 
+/* Walk the objects of an ObjectListType, skipping the holes.  Objects
+ * may be removed, and added, while the list is walked. */
+#define OBJECT_LIST_LOOP(list, type, obj) do {                      \
+  Cardinal __slot;                                                  \
+  Cardinal n = (Cardinal) -1;                                       \
+  for (__slot = 0; __slot < (list).PtrN; __slot++) {                \
+    type *obj = (type *) (list).Ptr[__slot];                        \
+    if (obj == NULL)                                                \
+      continue;                                                     \
+    n++;
+
 #define STYLE_LOOP(top)  do {                                       \
         Cardinal n;                                                 \
         RouteStyleType *style;                                      \
@@ -165,13 +176,7 @@
         {                                                           \
                 style = &(top)->RouteStyle[n]
 
-#define VIA_LOOP(top) do {                                          \
-  GList *__iter, *__next;                                           \
-  Cardinal n = 0;                                                   \
-  for (__iter = (top)->Via, __next = g_list_next (__iter);          \
-       __iter != NULL;                                              \
-       __iter = __next, __next = g_list_next (__iter), n++) {       \
-    PinType *via = __iter->data;
+#define VIA_LOOP(top) OBJECT_LIST_LOOP ((top)->Via, PinType, via)
 
 #define DRILL_LOOP(top) do             {               \
         Cardinal        n;                                      \
@@ -201,21 +206,9 @@
         {                                                       \
                 connection = & (net)->Connection[n]
 
-#define ELEMENT_LOOP(top) do {                                      \
-  GList *__iter, *__next;                                           \
-  Cardinal n = 0;                                                   \
-  for (__iter = (top)->Element, __next = g_list_next (__iter);      \
-       __iter != NULL;                                              \
-       __iter = __next, __next = g_list_next (__iter), n++) {       \
-    ElementType *element = __iter->data;
-
-#define RAT_LOOP(top) do {                                          \
-  GList *__iter, *__next;                                           \
-  Cardinal n = 0;                                                   \
-  for (__iter = (top)->Rat, __next = g_list_next (__iter);          \
-       __iter != NULL;                                              \
-       __iter = __next, __next = g_list_next (__iter), n++) {       \
-    RatType *line = __iter->data;
+#define ELEMENT_LOOP(top) OBJECT_LIST_LOOP ((top)->Element, ElementType, element)
+
+#define RAT_LOOP(top) OBJECT_LIST_LOOP ((top)->Rat, RatType, line)
 
 #define	ELEMENTTEXT_LOOP(element) do { 	\
 	Cardinal	n;				\
@@ -232,69 +225,21 @@
 	{							\
 		textstring = (element)->Name[n].TextString
 
-#define PIN_LOOP(element) do {                                      \
-  GList *__iter, *__next;                                           \
-  Cardinal n = 0;                                                   \
-  for (__iter = (element)->Pin, __next = g_list_next (__iter);      \
-       __iter != NULL;                                              \
-       __iter = __next, __next = g_list_next (__iter), n++) {       \
-    PinType *pin = __iter->data;
-
-#define PAD_LOOP(element) do {                                      \
-  GList *__iter, *__next;                                           \
-  Cardinal n = 0;                                                   \
-  for (__iter = (element)->Pad, __next = g_list_next (__iter);      \
-       __iter != NULL;                                              \
-       __iter = __next, __next = g_list_next (__iter), n++) {       \
-    PadType *pad = __iter->data;
-
-#define ARC_LOOP(element) do {                                      \
-  GList *__iter, *__next;                                           \
-  Cardinal n = 0;                                                   \
-  for (__iter = (element)->Arc, __next = g_list_next (__iter);      \
-       __iter != NULL;                                              \
-       __iter = __next, __next = g_list_next (__iter), n++) {       \
-    ArcType *arc = __iter->data;
-
-#define ELEMENTLINE_LOOP(element) do {                              \
-  GList *__iter, *__next;                                           \
-  Cardinal n = 0;                                                   \
-  for (__iter = (element)->Line, __next = g_list_next (__iter);     \
-       __iter != NULL;                                              \
-       __iter = __next, __next = g_list_next (__iter), n++) {       \
-    LineType *line = __iter->data;
-
-#define ELEMENTARC_LOOP(element) do {                               \
-  GList *__iter, *__next;                                           \
-  Cardinal n = 0;                                                   \
-  for (__iter = (element)->Arc, __next = g_list_next (__iter);      \
-       __iter != NULL;                                              \
-       __iter = __next, __next = g_list_next (__iter), n++) {       \
-    ArcType *arc = __iter->data;
-
-#define LINE_LOOP(layer) do {                                       \
-  GList *__iter, *__next;                                           \
-  Cardinal n = 0;                                                   \
-  for (__iter = (layer)->Line, __next = g_list_next (__iter);       \
-       __iter != NULL;                                              \
-       __iter = __next, __next = g_list_next (__iter), n++) {       \
-    LineType *line = __iter->data;
-
-#define TEXT_LOOP(layer) do {                                       \
-  GList *__iter, *__next;                                           \
-  Cardinal n = 0;                                                   \
-  for (__iter = (layer)->Text, __next = g_list_next (__iter);       \
-       __iter != NULL;                                              \
-       __iter = __next, __next = g_list_next (__iter), n++) {       \
-    TextType *text = __iter->data;
-
-#define POLYGON_LOOP(layer) do {                                    \
-  GList *__iter, *__next;                                           \
-  Cardinal n = 0;                                                   \
-  for (__iter = (layer)->Polygon, __next = g_list_next (__iter);    \
-       __iter != NULL;                                              \
-       __iter = __next, __next = g_list_next (__iter), n++) {       \
-    PolygonType *polygon = __iter->data;
+#define PIN_LOOP(element) OBJECT_LIST_LOOP ((element)->Pin, PinType, pin)
+
+#define PAD_LOOP(element) OBJECT_LIST_LOOP ((element)->Pad, PadType, pad)
+
+#define ARC_LOOP(element) OBJECT_LIST_LOOP ((element)->Arc, ArcType, arc)
+
+#define ELEMENTLINE_LOOP(element) OBJECT_LIST_LOOP ((element)->Line, LineType, line)
+
+#define ELEMENTARC_LOOP(element) OBJECT_LIST_LOOP ((element)->Arc, ArcType, arc)
+
+#define LINE_LOOP(layer) OBJECT_LIST_LOOP ((layer)->Line, LineType, line)
+
+#define TEXT_LOOP(layer) OBJECT_LIST_LOOP ((layer)->Text, TextType, text)
+
+#define POLYGON_LOOP(layer) OBJECT_LIST_LOOP ((layer)->Polygon, PolygonType, polygon)
 
 #define	POLYGONPOINT_LOOP(polygon) do	{	\
 	Cardinal			n;		\
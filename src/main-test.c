@@ -37,6 +37,7 @@
 #include "global.h"
 #include "pcb-printf.h"
 #include "object_list.h"
+#include "heap.h"
 
 int
 main (int argc, char *argv[])
@@ -44,6 +45,7 @@ main (int argc, char *argv[])
   initialize_units ();
   pcb_printf_register_tests ();
   object_list_register_tests ();
+  heap_register_tests ();
 
   g_test_init (&argc, &argv, NULL);
   g_test_run ();
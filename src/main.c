@@ -65,6 +65,7 @@
 #include "polygon.h"
 #include "gettext.h"
 #include "pcb-printf.h"
+#include "perf.h"
 #include "strflags.h"
 
 #include "hid/common/actions.h"
@@ -1106,6 +1107,98 @@ The default value is @code{60}.
   ISET (BackupInterval, 60, "backup-interval",
   "Time between automatic backups in seconds. Set to 0 to disable"),
 
+/* %start-doc options "1 General Options"
+@ftable @code
+@item --autoroute-jobs <num>
+Number of nets the autorouter may route in parallel, each in a child
+process.  Nets are routed in batches of nets which do not overlap; the
+result does not depend on the number of jobs, but may differ from a
+serial run.  The default value is @code{1}, which routes serially.
+@end ftable
+%end-doc
+*/
+  ISET (AutorouteJobs, 1, "autoroute-jobs",
+  "Number of nets the autorouter may route in parallel"),
+
+/* %start-doc options "1 General Options"
+@ftable @code
+@item --autoroute-attempts <num>
+Number of attempts the autorouter makes at once, each in a child
+process with its own net order and via, conflict and jog costs.  The
+attempt with the fewest failed connections, and of those the lowest
+cost, is put on the board.  The default value is @code{1}, which makes
+a single ordinary attempt.
+@end ftable
+%end-doc
+*/
+  ISET (AutorouteAttempts, 1, "autoroute-attempts",
+  "Number of routing attempts to keep the best of"),
+
+/* %start-doc options "1 General Options"
+@ftable @code
+@item --autoroute-time-limit <seconds>
+Time the routing attempts of @code{--autoroute-attempts} may take.
+Attempts still running then are stopped and the best finished one is
+used.  The default value is @code{0}, which means no limit.
+@end ftable
+%end-doc
+*/
+  ISET (AutorouteTimeLimit, 0, "autoroute-time-limit",
+  "Seconds the routing attempts may take"),
+
+/* %start-doc options "1 General Options"
+@ftable @code
+@item --autoplace-chains <num>
+Number of chains @code{AutoPlaceSelected} runs at once by parallel
+tempering, each in a child process at its own temperature.  Chains at
+neighboring temperatures swap from time to time, and the best placement
+any chain finds is used.  The default value is @code{1}, which anneals
+with a single chain.
+@end ftable
+%end-doc
+*/
+  ISET (AutoplaceChains, 1, "autoplace-chains",
+  "Number of parallel tempering chains of the autoplacer"),
+
+/* %start-doc options "1 General Options"
+@ftable @code
+@item --autoroute-profile <string>
+File the autorouter writes a JSON profile to: the time, edges
+expanded, search heap peak and via search blocker lookups of every
+net, and the totals of every pass.  @code{AutoRoute(Replay)} writes its
+runs there too.  Empty by default, which turns profiling off.
+@end ftable
+%end-doc
+*/
+  SSET (AutorouteProfile, "", "autoroute-profile",
+  "File to write an autorouter profile to"),
+
+/* %start-doc options "1 General Options"
+@ftable @code
+@item --perf-json <string>
+File the performance counters are written to as JSON when pcb exits:
+the calls, total and longest time of every timed span, and the sum of
+every counter.  @code{Report(Perf)} shows the same figures while pcb
+runs.  Empty by default.
+@end ftable
+%end-doc
+*/
+  SSET (PerfJson, "", "perf-json",
+  "File to write the performance counters to at exit"),
+
+/* %start-doc options "1 General Options"
+@ftable @code
+@item --perf-trace <string>
+File to write every timed span of 10 microseconds or more to, in the
+Chrome trace event format.  Load it into @code{chrome://tracing} or
+Perfetto to see what a slow action spent its time on.  Empty by
+default.
+@end ftable
+%end-doc
+*/
+  SSET (PerfTrace, "", "perf-trace",
+  "File to write a Chrome trace of timed spans to"),
+
 /* %start-doc options "4 Layer Names"
 @ftable @code
 @item --layer-name-1 <string>
@@ -1476,6 +1569,20 @@ If set, draw the grid at start-up.
 */
   BSET (DrawGrid, 0, "draw-grid", "If set, draw the grid at start-up"),
 
+/* %start-doc options "2 General GUI Options"
+@ftable @code
+@item --level-of-detail
+If set, objects smaller than a pixel are drawn as plain dots and text
+too small to read is drawn as a single stroke when zoomed out.  The
+OpenGL renderer also fills sub-pixel circles with a square, leaves out
+polygon holes smaller than a pixel and drops outline vertices closer
+than a pixel to each other.  Defaults to on.
+@end ftable
+%end-doc
+*/
+  BSET (LevelOfDetail, 1, "level-of-detail",
+       "If set, simplify objects too small to see when zoomed out"),
+
 /* %start-doc options "2 General GUI Options"
 @ftable @code
 @item --clear-line
@@ -2078,7 +2185,7 @@ main (int argc, char *argv[])
     copyright ();
 
   settings_post_process ();
-
+  perf_init ();
 
   if (show_actions)
     {
@@ -2137,6 +2244,9 @@ main (int argc, char *argv[])
    */
   leaky_init ();
 
+  /* Write the --perf-json file on the way out, exporters included. */
+  atexit (perf_uninit);
+
   /* Register a function to be called when the program terminates.
    * This makes sure that data is saved even if LEX/YACC routines
    * abort the program.
@@ -2168,7 +2278,10 @@ main (int argc, char *argv[])
 
   if (gui->printer || gui->exporter)
     {
+      guint64 start = perf_now ();
+
       gui->do_export (0);
+      perf_end (perf_stat ("export", gui->name), start);
       exit (0);
     }
 
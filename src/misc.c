@@ -893,6 +893,21 @@ CenterDisplay (Coord X, Coord Y, bool warp_pointer)
   PCB->Grid = save_grid;
 }
 
+/* bumped by SetFontInfo (), see FontGeneration () */
+static guint font_generation = 0;
+
+/*!
+ * \brief Number of times a font was set up so far.
+ *
+ * Callers caching anything built from the glyphs of a font can compare
+ * this to find out whether a font was loaded or edited in the meantime.
+ */
+guint
+FontGeneration (void)
+{
+  return font_generation;
+}
+
 /*!
  * \brief Transforms symbol coordinates so that the left edge of each
  * symbol is at the zero position.
@@ -963,6 +978,9 @@ SetFontInfo (FontType *Ptr)
   Ptr->DefaultSymbol.X1 = Ptr->DefaultSymbol.Y1 = 0;
   Ptr->DefaultSymbol.X2 = Ptr->DefaultSymbol.X1 + Ptr->MaxWidth;
   Ptr->DefaultSymbol.Y2 = Ptr->DefaultSymbol.Y1 + Ptr->MaxHeight;
+
+  /* Drawn text may have used the old glyphs */
+  font_generation++;
 }
 
 static Coord
@@ -68,6 +68,7 @@ void CountHolesEx (int *, int *, const BoxType *, Cardinal, Cardinal);
 BoxType * GetDataBoundingBox (DataType *);
 void CenterDisplay (Coord, Coord, bool warp_pointer);
 void SetFontInfo (FontType *);
+guint FontGeneration (void);
 char *make_route_string (RouteStyleType rs[], int n_styles);
 int ParseGroupString (char *, LayerGroupType *, int * /* LayerN */);
 int ParseRouteString (char *, RouteStyleType *, const char *);
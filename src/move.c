@@ -436,9 +436,9 @@ MoveLineToLayerLowLevel (LayerType *Source, LineType *line,
 {
   r_delete_entry (Source->line_tree, (BoxType *)line);
 
-  Source->Line = g_list_remove (Source->Line, line);
+  RemoveObjectFromList (&Source->Line, line);
   Source->LineN --;
-  Destination->Line = g_list_append (Destination->Line, line);
+  AddObjectToList (&Destination->Line, line);
   Destination->LineN ++;
 
   if (!Destination->line_tree)
@@ -456,9 +456,9 @@ MoveArcToLayerLowLevel (LayerType *Source, ArcType *arc,
 {
   r_delete_entry (Source->arc_tree, (BoxType *)arc);
 
-  Source->Arc = g_list_remove (Source->Arc, arc);
+  RemoveObjectFromList (&Source->Arc, arc);
   Source->ArcN --;
-  Destination->Arc = g_list_append (Destination->Arc, arc);
+  AddObjectToList (&Destination->Arc, arc);
   Destination->ArcN ++;
 
   if (!Destination->arc_tree)
@@ -650,9 +650,9 @@ MoveTextToLayerLowLevel (LayerType *Source, TextType *text,
   RestoreToPolygon (PCB->Data, TEXT_TYPE, Source, text);
   r_delete_entry (Source->text_tree, (BoxType *)text);
 
-  Source->Text = g_list_remove (Source->Text, text);
+  RemoveObjectFromList (&Source->Text, text);
   Source->TextN --;
-  Destination->Text = g_list_append (Destination->Text, text);
+  AddObjectToList (&Destination->Text, text);
   Destination->TextN ++;
 
   if (GetLayerGroupNumberBySide (BOTTOM_SIDE) ==
@@ -705,9 +705,9 @@ MovePolygonToLayerLowLevel (LayerType *Source, PolygonType *polygon,
 {
   r_delete_entry (Source->polygon_tree, (BoxType *)polygon);
 
-  Source->Polygon = g_list_remove (Source->Polygon, polygon);
+  RemoveObjectFromList (&Source->Polygon, polygon);
   Source->PolygonN --;
-  Destination->Polygon = g_list_append (Destination->Polygon, polygon);
+  AddObjectToList (&Destination->Polygon, polygon);
   Destination->PolygonN ++;
 
   if (!Destination->polygon_tree)
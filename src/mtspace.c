@@ -83,8 +83,24 @@ mtspacebox_t;
 struct mtspace
 {
   rtree_t *ftree, *etree, *otree;
+  /* the blocker found for each box searched in the matching tree, see
+   * find_blocker () */
+  GHashTable *fmemo, *ememo, *omemo;
+  unsigned long lookups, hits;
 };
 
+/*!
+ * \brief Key of the blocker memos.
+ */
+struct memo_key
+{
+  BoxType box;
+  Coord keepaway;
+};
+
+/* a memo is thrown away when it grows this big */
+#define MEMO_MAX 65536
+
 typedef union
 {
   vector_t * v;
@@ -103,10 +119,19 @@ struct vetting
   Coord radius;
   Coord keepaway;
   CheapPointType desired;
+  struct vetting *next_spare;
 };
 
 #define SPECIAL 823157
 
+/* finished vetting_t's kept for reuse, with their empty heaps or
+ * vectors; see mtsFreeWork () */
+#define MAX_SPARES 32
+static vetting_t *spare_heap_work, *spare_vec_work;
+static int spare_count;
+
+static void destroy_work (vetting_t * work, bool use_heap);
+
 mtspacebox_t *
 mtspace_create_box (const BoxType * box, Coord keepaway)
 {
@@ -120,6 +145,27 @@ mtspace_create_box (const BoxType * box, Coord keepaway)
   return mtsb;
 }
 
+static guint
+memo_key_hash (gconstpointer k)
+{
+  const struct memo_key *key = (const struct memo_key *) k;
+  guint h = (guint) key->box.X1;
+  h = h * 31 + (guint) key->box.Y1;
+  h = h * 31 + (guint) key->box.X2;
+  h = h * 31 + (guint) key->box.Y2;
+  return h * 31 + (guint) key->keepaway;
+}
+
+static gboolean
+memo_key_equal (gconstpointer a, gconstpointer b)
+{
+  const struct memo_key *ka = (const struct memo_key *) a;
+  const struct memo_key *kb = (const struct memo_key *) b;
+  return ka->box.X1 == kb->box.X1 && ka->box.Y1 == kb->box.Y1 &&
+    ka->box.X2 == kb->box.X2 && ka->box.Y2 == kb->box.Y2 &&
+    ka->keepaway == kb->keepaway;
+}
+
 /*!
  * \brief Create an "empty space" representation with a shrunken
  * boundary.
@@ -134,6 +180,13 @@ mtspace_create (void)
   mtspace->ftree = r_create_tree (NULL, 0, 0);
   mtspace->etree = r_create_tree (NULL, 0, 0);
   mtspace->otree = r_create_tree (NULL, 0, 0);
+  mtspace->fmemo = g_hash_table_new_full (memo_key_hash, memo_key_equal,
+					  g_free, NULL);
+  mtspace->ememo = g_hash_table_new_full (memo_key_hash, memo_key_equal,
+					  g_free, NULL);
+  mtspace->omemo = g_hash_table_new_full (memo_key_hash, memo_key_equal,
+					  g_free, NULL);
+  mtspace->lookups = mtspace->hits = 0;
   /* done! */
   return mtspace;
 }
@@ -148,7 +201,23 @@ mtspace_destroy (mtspace_t ** mtspacep)
   r_destroy_tree (&(*mtspacep)->ftree);
   r_destroy_tree (&(*mtspacep)->etree);
   r_destroy_tree (&(*mtspacep)->otree);
+  g_hash_table_destroy ((*mtspacep)->fmemo);
+  g_hash_table_destroy ((*mtspacep)->ememo);
+  g_hash_table_destroy ((*mtspacep)->omemo);
   free (*mtspacep);
+  while (spare_heap_work)
+    {
+      vetting_t *work = spare_heap_work;
+      spare_heap_work = work->next_spare;
+      destroy_work (work, true);
+    }
+  while (spare_vec_work)
+    {
+      vetting_t *work = spare_vec_work;
+      spare_vec_work = work->next_spare;
+      destroy_work (work, false);
+    }
+  spare_count = 0;
   *mtspacep = NULL;
 }
 
@@ -192,6 +261,20 @@ which_tree (mtspace_t * mtspace, mtspace_type_t which)
     }
 }
 
+static GHashTable *
+which_memo (mtspace_t * mtspace, mtspace_type_t which)
+{
+  switch (which)
+    {
+    case FIXED:
+      return mtspace->fmemo;
+    case EVEN:
+      return mtspace->ememo;
+    default:
+      return mtspace->omemo;
+    }
+}
+
 /*!
  * \brief Add a space-filler to the empty space representation.
  *
@@ -204,6 +287,7 @@ mtspace_add (mtspace_t * mtspace, const BoxType * box, mtspace_type_t which,
 {
   mtspacebox_t *filler = mtspace_create_box (box, keepaway);
   r_insert_entry (which_tree (mtspace, which), (const BoxType *) filler, 1);
+  g_hash_table_remove_all (which_memo (mtspace, which));
 }
 
 /*!
@@ -229,6 +313,7 @@ mtspace_remove (mtspace_t * mtspace,
       r_search (cl.tree, &small_search, NULL, mts_remove_one, &cl);
       assert (0);		/* didn't find it?? */
     }
+  g_hash_table_remove_all (which_memo (mtspace, which));
 }
 
 struct query_closure
@@ -240,10 +325,12 @@ struct query_closure
   Coord radius, keepaway;
   jmp_buf env;
   bool touch_is_vec;
+  mtspacebox_t *blocker;
 };
 
 static inline void
-heap_append (heap_t *heap, CheapPointType *desired, BoxType *newone)
+heap_insert_by_distance (heap_t *heap, CheapPointType *desired,
+                         BoxType *newone)
 {
   CheapPointType p = *desired;
   assert (desired);
@@ -255,7 +342,7 @@ static inline void
 append (struct query_closure * qc, BoxType *newone)
 { 
   if (qc->desired)
-    heap_append (qc->checking.h, qc->desired, newone);
+    heap_insert_by_distance (qc->checking.h, qc->desired, newone);
   else
     vector_append (qc->checking.v, newone);
 }
@@ -263,8 +350,8 @@ append (struct query_closure * qc, BoxType *newone)
 /*!
  * \brief We found some space filler that may intersect this query.
  *
- * First check if it does intersect, then break it into overlaping
- * regions that don't intersect this box.
+ * Check if it does intersect; the first one that does blocks the
+ * query box.
  */
 static int
 query_one (const BoxType * box, void *cl)
@@ -285,6 +372,58 @@ query_one (const BoxType * box, void *cl)
       qc->cbox->Y1 + shrink >= mtsb->box.Y2 ||
       qc->cbox->Y2 - shrink <= mtsb->box.Y1)
     return 0;
+  qc->blocker = mtsb;
+  longjmp (qc->env, 1);
+  return 1;			/* never reached */
+}
+
+/*!
+ * \brief Find the space filler in one of the trees that blocks the
+ * query box, or NULL if the box is empty there.
+ *
+ * Via searches keep asking about the same boxes, so the answer is
+ * remembered until something is added to or removed from that tree.
+ */
+static mtspacebox_t *
+find_blocker (struct query_closure *qc, mtspace_t * mtspace,
+	      mtspace_type_t which)
+{
+  GHashTable *memo = which_memo (mtspace, which);
+  struct memo_key key, *newkey;
+  gpointer found;
+
+  key.box = *qc->cbox;
+  key.keepaway = qc->keepaway;
+  mtspace->lookups++;
+  if (g_hash_table_lookup_extended (memo, &key, NULL, &found))
+    {
+      mtspace->hits++;
+      return (mtspacebox_t *) found;
+    }
+  qc->blocker = NULL;
+  if (setjmp (qc->env) == 0)
+    r_search (which_tree (mtspace, which), qc->cbox, NULL, query_one, qc);
+  if (g_hash_table_size (memo) >= MEMO_MAX)
+    g_hash_table_remove_all (memo);
+  newkey = g_new (struct memo_key, 1);
+  *newkey = key;
+  g_hash_table_insert (memo, newkey, qc->blocker);
+  return qc->blocker;
+}
+
+/*!
+ * \brief Break the query box into the pieces that don't intersect the
+ * space filler blocking it.
+ */
+static void
+split_one (struct query_closure *qc, mtspacebox_t * mtsb)
+{
+  Coord shrink;
+  /* we need to satisfy the larger of the two keepaways */
+  if (qc->keepaway > mtsb->keepaway)
+    shrink = mtsb->keepaway;
+  else
+    shrink = qc->keepaway;
   /* ok, we do touch this box, now create up to 4 boxes that don't */
   if (mtsb->box.Y1 > qc->cbox->Y1 + shrink)	/* top region exists */
     {
@@ -352,12 +491,10 @@ query_one (const BoxType * box, void *cl)
       if (qc->touch_is_vec || !qc->desired)
         vector_append (qc->touching.v, qc->cbox);
       else
-        heap_append (qc->touching.h, qc->desired, qc->cbox);
+        heap_insert_by_distance (qc->touching.h, qc->desired, qc->cbox);
     }
   else
     free (qc->cbox);		/* done with this one */
-  longjmp (qc->env, 1);
-  return 1;			/* never reached */
 }
 
 /*!
@@ -373,73 +510,133 @@ query_one (const BoxType * box, void *cl)
  * found an empty area.
  */
 static void
-qloop (struct query_closure *qc, rtree_t * tree, heap_or_vector res, bool is_vec)
+qloop (struct query_closure *qc, mtspace_t * mtspace, mtspace_type_t which,
+       heap_or_vector res, bool is_vec)
 {
   BoxType *cbox;
-#ifndef NDEBUG
-  int n;
-#endif
+  mtspacebox_t *blocker;
   while (!(qc->desired ? heap_is_empty (qc->checking.h) : vector_is_empty (qc->checking.v)))
     {
       cbox = qc->desired ? (BoxType *)heap_remove_smallest (qc->checking.h) : (BoxType *)vector_remove_last (qc->checking.v);
-      if (setjmp (qc->env) == 0)
+      assert (box_is_good (cbox));
+      qc->cbox = cbox;
+      blocker = find_blocker (qc, mtspace, which);
+      if (blocker)
 	{
-	  assert (box_is_good (cbox));
-	  qc->cbox = cbox;
-#ifndef NDEBUG
-	  n =
-#endif
-	    r_search (tree, cbox, NULL, query_one, qc);
-	  assert (n == 0);
-	  /* nothing intersected with this tree, put it in the result vector */
-          if (is_vec)
+	  split_one (qc, blocker);
+	  continue;
+	}
+      /* nothing intersected with this tree, put it in the result vector */
+      if (is_vec)
+	vector_append (res.v, cbox);
+      else
+	{
+	  if (qc->desired)
+	    heap_insert_by_distance (res.h, qc->desired, cbox);
+	  else
 	    vector_append (res.v, cbox);
-          else
-            {
-              if (qc->desired)
-                heap_append (res.h, qc->desired, cbox);
-              else
-	        vector_append (res.v, cbox);
-            }
-	  return;		/* found one - perhaps one answer is good enough */
 	}
+      return;		/* found one - perhaps one answer is good enough */
     }
 }
 
+/*!
+ * \brief Get a vetting structure with empty heaps (if \p use_heap) or
+ * vectors, reusing a finished one when there is one.
+ */
+static vetting_t *
+get_work (bool use_heap)
+{
+  vetting_t **spares = use_heap ? &spare_heap_work : &spare_vec_work;
+  vetting_t *work = *spares;
+
+  if (work)
+    {
+      *spares = work->next_spare;
+      spare_count--;
+      return work;
+    }
+  work = (vetting_t *) malloc (sizeof (vetting_t));
+  work->next_spare = NULL;
+  if (use_heap)
+    {
+      work->untested.h = heap_create ();
+      work->no_fix.h = heap_create ();
+      work->hi_candidate.h = heap_create ();
+      work->no_hi.h =heap_create ();
+      assert (work->untested.h && work->no_fix.h &&
+              work->no_hi.h && work->hi_candidate.h);
+    }
+  else
+    {
+      work->untested.v = vector_create ();
+      work->no_fix.v = vector_create ();
+      work->hi_candidate.v = vector_create ();
+      work->no_hi.v = vector_create ();
+      assert (work->untested.v && work->no_fix.v &&
+              work->no_hi.v && work->hi_candidate.v);
+    }
+  return work;
+}
+
+static void
+destroy_work (vetting_t * work, bool use_heap)
+{
+  if (use_heap)
+    {
+       heap_destroy (&work->untested.h);
+       heap_destroy (&work->no_fix.h);
+       heap_destroy (&work->no_hi.h);
+       heap_destroy (&work->hi_candidate.h);
+    }
+  else
+    {
+       vector_destroy (&work->untested.v);
+       vector_destroy (&work->no_fix.v);
+       vector_destroy (&work->no_hi.v);
+       vector_destroy (&work->hi_candidate.v);
+    }
+  free (work);
+}
+
 /*!
  * \brief Free the memory used by the vetting structure.
+ *
+ * The regions it holds are freed; the structure itself is kept for the
+ * next query.
  */
 void
 mtsFreeWork (vetting_t ** w)
 {
   vetting_t *work = (*w);
-  if (work->desired.X != -SPECIAL || work->desired.Y != -SPECIAL)
+  bool use_heap = work->desired.X != -SPECIAL || work->desired.Y != -SPECIAL;
+  if (use_heap)
     {
        heap_free (work->untested.h, free);
-       heap_destroy (&work->untested.h);
        heap_free (work->no_fix.h, free);
-       heap_destroy (&work->no_fix.h);
        heap_free (work->no_hi.h, free);
-       heap_destroy (&work->no_hi.h);
        heap_free (work->hi_candidate.h, free);
-       heap_destroy (&work->hi_candidate.h);
     }
   else
     {
        while (!vector_is_empty (work->untested.v))
          free (vector_remove_last (work->untested.v));
-       vector_destroy (&work->untested.v);
        while (!vector_is_empty (work->no_fix.v))
          free (vector_remove_last (work->no_fix.v));
-       vector_destroy (&work->no_fix.v);
        while (!vector_is_empty (work->no_hi.v))
          free (vector_remove_last (work->no_hi.v));
-       vector_destroy (&work->no_hi.v);
        while (!vector_is_empty (work->hi_candidate.v))
          free (vector_remove_last (work->hi_candidate.v));
-       vector_destroy (&work->hi_candidate.v);
     }
-  free (work);
+  if (spare_count < MAX_SPARES)
+    {
+      vetting_t **spares = use_heap ? &spare_heap_work : &spare_vec_work;
+      work->next_spare = *spares;
+      *spares = work;
+      spare_count++;
+    }
+  else
+    destroy_work (work, use_heap);
   (*w) = NULL;
 }
 
@@ -489,30 +686,18 @@ mtspace_query_rect (mtspace_t * mtspace, const BoxType * region,
       assert(vector_is_empty (free_space_vec));
       assert(vector_is_empty (lo_conflict_space_vec));
       assert(vector_is_empty (hi_conflict_space_vec));
-      work = (vetting_t *) malloc (sizeof (vetting_t));
+      work = get_work (desired != NULL);
       work->keepaway = keepaway;
       work->radius = radius;
       cbox = (BoxType *) malloc (sizeof (BoxType));
       *cbox = bloat_box (region, keepaway + radius);
       if (desired)
         {
-          work->untested.h = heap_create ();
-          work->no_fix.h = heap_create ();
-          work->hi_candidate.h = heap_create ();
-          work->no_hi.h =heap_create ();
-          assert (work->untested.h && work->no_fix.h &&
-                  work->no_hi.h && work->hi_candidate.h);
           heap_insert (work->untested.h, 0, cbox);
           work->desired = *desired;
         }
       else
         {
-          work->untested.v = vector_create ();
-          work->no_fix.v = vector_create ();
-          work->hi_candidate.v = vector_create ();
-          work->no_hi.v = vector_create ();
-          assert (work->untested.v && work->no_fix.v &&
-                  work->no_hi.v && work->hi_candidate.v);
           vector_append (work->untested.v, cbox);
           work->desired.X = work->desired.Y = -SPECIAL;
         }
@@ -533,7 +718,7 @@ mtspace_query_rect (mtspace_t * mtspace, const BoxType * region,
        */
       qc.checking = work->untested;
       qc.touching.v = NULL;
-      qloop (&qc, mtspace->ftree, work->no_fix, false);
+      qloop (&qc, mtspace, FIXED, work->no_fix, false);
       /* search the hi-conflict tree placing intersectors in the
        * hi_candidate vector (if conflicts are allowed) and
        * placing empty regions in the no_hi vector.
@@ -541,7 +726,7 @@ mtspace_query_rect (mtspace_t * mtspace, const BoxType * region,
       qc.checking.v = work->no_fix.v;
       qc.touching.v = with_conflicts ? work->hi_candidate.v : NULL;
       qc.touch_is_vec = false;
-      qloop (&qc, is_odd ? mtspace->otree : mtspace->etree, work->no_hi, false);
+      qloop (&qc, mtspace, is_odd ? ODD : EVEN, work->no_hi, false);
       /* search the lo-conflict tree placing intersectors in the
        * lo-conflict answer vector (if conflicts allowed) and
        * placing emptry regions in the free-space answer vector.
@@ -550,7 +735,7 @@ mtspace_query_rect (mtspace_t * mtspace, const BoxType * region,
 /* XXX lo_conflict_space_vec will be treated like a heap! */
       qc.touching.v = (with_conflicts ? lo_conflict_space_vec : NULL);
       qc.touch_is_vec = true;
-      qloop (&qc, is_odd ? mtspace->etree : mtspace->otree, temporary, true);
+      qloop (&qc, mtspace, is_odd ? EVEN : ODD, temporary, true);
 
       /* qloop (&qc, is_odd ? mtspace->etree : mtspace->otree, (heap_or_vector)free_space_vec, true); */
       if (!vector_is_empty (free_space_vec))
@@ -576,8 +761,7 @@ mtspace_query_rect (mtspace_t * mtspace, const BoxType * region,
 	  heap_or_vector temporary = {hi_conflict_space_vec};
 	  qc.checking = work->hi_candidate;
 	  qc.touching.v = NULL;
-	  qloop (&qc, is_odd ? mtspace->etree : mtspace->otree,
-		 temporary, true);
+	  qloop (&qc, mtspace, is_odd ? EVEN : ODD, temporary, true);
 
 	  /* qloop (&qc, is_odd ? mtspace->etree : mtspace->otree, */
 	  /* 	 (heap_or_vector)hi_conflict_space_vec, true); */
@@ -606,6 +790,18 @@ mtspace_query_rect (mtspace_t * mtspace, const BoxType * region,
   return work;
 }
 
+/*!
+ * \brief Report how many blocker searches were made and how many of
+ * them were answered from the memos.
+ */
+void
+mtspace_memo_stats (mtspace_t * mtspace, unsigned long *lookups,
+		    unsigned long *hits)
+{
+  *lookups = mtspace->lookups;
+  *hits = mtspace->hits;
+}
+
 int
 mtsBoxCount (vetting_t * w)
 {
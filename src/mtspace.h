@@ -76,6 +76,8 @@ vetting_t *mtspace_query_rect (mtspace_t * mtspace, const BoxType * region,
                                CheapPointType *desired);
 
 void mtsFreeWork (vetting_t **);
+void mtspace_memo_stats (mtspace_t * mtspace, unsigned long *lookups,
+                         unsigned long *hits);
 int mtsBoxCount (vetting_t *);
 
 #endif /* ! PCB_MTSPACE_H */
@@ -56,17 +56,6 @@
  */
 static void DSRealloc (DynamicStringType *, size_t);
 
-
-/* This API is quite new, provide a version here */
-#if !GLIB_CHECK_VERSION (2, 28, 0)
-static void
-g_list_free_full (GList *list, GDestroyNotify free_func)
-{
-  g_list_foreach (list, (GFunc) free_func, NULL);
-  g_list_free (list);
-}
-#endif
-
 /*!
  * \brief Get the next slot for a rubberband connection.
  *
@@ -115,6 +104,144 @@ FreePointerListMemory (PointerListType *list)
   memset (list, 0, sizeof (PointerListType));
 }
 
+/*!
+ * \brief Add an object to the end of an object list.
+ */
+void
+AddObjectToList (ObjectListType *list, void *obj)
+{
+  if (list->PtrN >= list->PtrMax)
+    {
+      list->PtrMax = STEP_POINT + (2 * list->PtrMax);
+      list->Ptr = (void **)realloc (list->Ptr, list->PtrMax * sizeof (void *));
+    }
+  ((AnyObjectType *) obj)->ListSlot = list->PtrN;
+  list->Ptr[list->PtrN++] = obj;
+}
+
+/*!
+ * \brief Take an object out of an object list, leaving a hole.
+ *
+ * The object's ListSlot normally says where it is; should it be stale,
+ * say from a struct copy, the list is searched from the end.
+ */
+void
+RemoveObjectFromList (ObjectListType *list, void *obj)
+{
+  Cardinal slot = ((AnyObjectType *) obj)->ListSlot;
+
+  if (slot >= list->PtrN || list->Ptr[slot] != obj)
+    {
+      for (slot = list->PtrN; slot-- > 0;)
+	if (list->Ptr[slot] == obj)
+	  break;
+      if (slot == (Cardinal) -1)
+	return;
+    }
+  list->Ptr[slot] = NULL;
+  list->Holes++;
+  /* holes at the end go right away */
+  while (list->PtrN > 0 && list->Ptr[list->PtrN - 1] == NULL)
+    {
+      list->PtrN--;
+      list->Holes--;
+    }
+}
+
+/*!
+ * \brief First object in an object list, or NULL if it is empty.
+ */
+void *
+FirstObjectInList (ObjectListType *list)
+{
+  Cardinal slot;
+
+  for (slot = 0; slot < list->PtrN; slot++)
+    if (list->Ptr[slot] != NULL)
+      return list->Ptr[slot];
+  return NULL;
+}
+
+/*!
+ * \brief Last object in an object list, or NULL if it is empty.
+ *
+ * RemoveObjectFromList () never leaves a hole at the end.
+ */
+void *
+LastObjectInList (ObjectListType *list)
+{
+  return list->PtrN > 0 ? list->Ptr[list->PtrN - 1] : NULL;
+}
+
+/*!
+ * \brief Squeeze the holes out of an object list.
+ *
+ * Must not be called while a loop walks the list: the objects move to
+ * other slots.
+ */
+void
+CompactObjectList (ObjectListType *list)
+{
+  Cardinal from, to = 0;
+
+  if (list->Holes == 0)
+    return;
+  for (from = 0; from < list->PtrN; from++)
+    if (list->Ptr[from] != NULL)
+      {
+	((AnyObjectType *) list->Ptr[from])->ListSlot = to;
+	list->Ptr[to++] = list->Ptr[from];
+      }
+  list->PtrN = to;
+  list->Holes = 0;
+}
+
+/*!
+ * \brief Free an object list, and the objects in it with \p free_func.
+ */
+void
+FreeObjectList (ObjectListType *list, GDestroyNotify free_func)
+{
+  Cardinal slot;
+
+  for (slot = 0; slot < list->PtrN; slot++)
+    if (list->Ptr[slot] != NULL)
+      free_func (list->Ptr[slot]);
+  free (list->Ptr);
+  memset (list, 0, sizeof (ObjectListType));
+}
+
+/*!
+ * \brief Squeeze the holes out of the object lists of a data set, once
+ * there are as many holes as objects.
+ *
+ * Like CompactObjectList (), this must only be called when no loop
+ * walks any of them.
+ */
+void
+CompactDataLists (DataType *data)
+{
+  int i;
+
+#define COMPACT(list) \
+  if ((list).Holes > 0 && (list).Holes >= (list).PtrN - (list).Holes) \
+    CompactObjectList (&(list))
+
+  if (data == NULL)
+    return;
+  COMPACT (data->Via);
+  COMPACT (data->Element);
+  COMPACT (data->Rat);
+  for (i = 0; i < MAX_ALL_LAYER; i++)
+    {
+      COMPACT (data->Layer[i].Line);
+      COMPACT (data->Layer[i].Arc);
+      COMPACT (data->Layer[i].Text);
+      COMPACT (data->Layer[i].Polygon);
+    }
+#undef COMPACT
+}
+
 /*!
  * \brief Get the next slot for a box.
  *
@@ -215,7 +342,7 @@ GetPinMemory (ElementType *element)
   PinType *new_obj;
 
   new_obj = g_slice_new0 (PinType);
-  element->Pin = g_list_append (element->Pin, new_obj);
+  AddObjectToList (&element->Pin, new_obj);
   element->PinN ++;
 
   return new_obj;
@@ -238,7 +365,7 @@ GetPadMemory (ElementType *element)
   PadType *new_obj;
 
   new_obj = g_slice_new0 (PadType);
-  element->Pad = g_list_append (element->Pad, new_obj);
+  AddObjectToList (&element->Pad, new_obj);
   element->PadN ++;
 
   return new_obj;
@@ -261,7 +388,7 @@ GetViaMemory (DataType *data)
   PinType *new_obj;
 
   new_obj = g_slice_new0 (PinType);
-  data->Via = g_list_append (data->Via, new_obj);
+  AddObjectToList (&data->Via, new_obj);
   data->ViaN ++;
 
   return new_obj;
@@ -284,7 +411,7 @@ GetRatMemory (DataType *data)
   RatType *new_obj;
 
   new_obj = g_slice_new0 (RatType);
-  data->Rat = g_list_append (data->Rat, new_obj);
+  AddObjectToList (&data->Rat, new_obj);
   data->RatN ++;
 
   return new_obj;
@@ -307,7 +434,7 @@ GetLineMemory (LayerType *layer)
   LineType *new_obj;
 
   new_obj = g_slice_new0 (LineType);
-  layer->Line = g_list_append (layer->Line, new_obj);
+  AddObjectToList (&layer->Line, new_obj);
   layer->LineN ++;
 
   return new_obj;
@@ -330,7 +457,7 @@ GetArcMemory (LayerType *layer)
   ArcType *new_obj;
 
   new_obj = g_slice_new0 (ArcType);
-  layer->Arc = g_list_append (layer->Arc, new_obj);
+  AddObjectToList (&layer->Arc, new_obj);
   layer->ArcN ++;
 
   return new_obj;
@@ -353,7 +480,7 @@ GetTextMemory (LayerType *layer)
   TextType *new_obj;
 
   new_obj = g_slice_new0 (TextType);
-  layer->Text = g_list_append (layer->Text, new_obj);
+  AddObjectToList (&layer->Text, new_obj);
   layer->TextN ++;
 
   return new_obj;
@@ -376,7 +503,7 @@ GetPolygonMemory (LayerType *layer)
   PolygonType *new_obj;
 
   new_obj = g_slice_new0 (PolygonType);
-  layer->Polygon = g_list_append (layer->Polygon, new_obj);
+  AddObjectToList (&layer->Polygon, new_obj);
   layer->PolygonN ++;
 
   return new_obj;
@@ -446,7 +573,7 @@ GetElementMemory (DataType *data)
 
   if (data != NULL)
     {
-      data->Element = g_list_append (data->Element, new_obj);
+      AddObjectToList (&data->Element, new_obj);
       data->ElementN ++;
     }
 
@@ -697,10 +824,10 @@ FreeElementMemory (ElementType *element)
   }
   END_LOOP;
 
-  g_list_free_full (element->Pin,  (GDestroyNotify)FreePin);
-  g_list_free_full (element->Pad,  (GDestroyNotify)FreePad);
-  g_list_free_full (element->Line, (GDestroyNotify)FreeLine);
-  g_list_free_full (element->Arc,  (GDestroyNotify)FreeArc);
+  FreeObjectList (&element->Pin, (GDestroyNotify)FreePin);
+  FreeObjectList (&element->Pad, (GDestroyNotify)FreePad);
+  FreeObjectList (&element->Line, (GDestroyNotify)FreeLine);
+  FreeObjectList (&element->Arc, (GDestroyNotify)FreeArc);
 
   FreeAttributeListMemory (&element->Attributes);
   memset (element, 0, sizeof (ElementType));
@@ -722,6 +849,8 @@ FreePCBMemory (PCBType *pcb)
   free (pcb->PrintFilename);
   FreeDataMemory (pcb->Data);
   free (pcb->Data);
+  /* NetlistChanged () below ends in CompactDataLists () */
+  pcb->Data = NULL;
   /* release font symbols */
   for (i = 0; i <= MAX_FONTPOSITION; i++)
     free (pcb->Font.Symbol[i].Line);
@@ -749,14 +878,14 @@ FreeDataMemory (DataType *data)
     free (via->Name);
   }
   END_LOOP;
-  g_list_free_full (data->Via, (GDestroyNotify)FreeVia);
+  FreeObjectList (&data->Via, (GDestroyNotify)FreeVia);
   ELEMENT_LOOP (data);
   {
     FreeElementMemory (element);
   }
   END_LOOP;
-  g_list_free_full (data->Element, (GDestroyNotify)FreeElement);
-  g_list_free_full (data->Rat, (GDestroyNotify)FreeRat);
+  FreeObjectList (&data->Element, (GDestroyNotify)FreeElement);
+  FreeObjectList (&data->Rat, (GDestroyNotify)FreeRat);
 
   for (layer = data->Layer, i = 0; i < MAX_ALL_LAYER; layer++, i++)
     {
@@ -774,15 +903,15 @@ FreeDataMemory (DataType *data)
           free (line->Number);
       }
       END_LOOP;
-      g_list_free_full (layer->Line, (GDestroyNotify)FreeLine);
-      g_list_free_full (layer->Arc, (GDestroyNotify)FreeArc);
-      g_list_free_full (layer->Text, (GDestroyNotify)FreeText);
+      FreeObjectList (&layer->Line, (GDestroyNotify)FreeLine);
+      FreeObjectList (&layer->Arc, (GDestroyNotify)FreeArc);
+      FreeObjectList (&layer->Text, (GDestroyNotify)FreeText);
       POLYGON_LOOP (layer);
       {
         FreePolygonMemory (polygon);
       }
       END_LOOP;
-      g_list_free_full (layer->Polygon, (GDestroyNotify)FreePolygon);
+      FreeObjectList (&layer->Polygon, (GDestroyNotify)FreePolygon);
       if (layer->line_tree)
         r_destroy_tree (&layer->line_tree);
       if (layer->arc_tree)
@@ -101,6 +101,13 @@ void FreeNetMemory (NetType *);
 void FreeDataMemory (DataType *);
 void FreeLibraryMemory (LibraryType *);
 void FreePointerListMemory (PointerListType *);
+void AddObjectToList (ObjectListType *, void *);
+void RemoveObjectFromList (ObjectListType *, void *);
+void *FirstObjectInList (ObjectListType *);
+void *LastObjectInList (ObjectListType *);
+void CompactObjectList (ObjectListType *);
+void FreeObjectList (ObjectListType *, GDestroyNotify);
+void CompactDataLists (DataType *);
 void DSAddCharacter (DynamicStringType *, char);
 void DSAddString (DynamicStringType *, const char *);
 void DSClearString (DynamicStringType *);
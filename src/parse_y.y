@@ -766,7 +766,7 @@ pcbdefinition
 			  /* This case is when we load a footprint with file->open, or from the command line */
 			  CreateNewPCBPost (yyPCB, 0);
 			  ParseGroupString("1,c:2,s", &yyPCB->LayerGroups, &yyData->LayerN);
-			  e = yyPCB->Data->Element->data; /* we know there's only one */
+			  e = (ElementType *) FirstObjectInList (&yyPCB->Data->Element); /* we know there's only one */
 			  PCB = yyPCB;
 			  MoveElementLowLevel (yyPCB->Data, e, -e->BoundingBox.X1, -e->BoundingBox.Y1);
 			  PCB = pcb_save;
@@ -0,0 +1,343 @@
+/*!
+ * \file src/perf.c
+ *
+ * \brief Whole-program performance counters and trace spans.
+ *
+ * A span times a stretch of code with the monotonic clock and adds it
+ * to the statistics of its call site: the number of calls, the total
+ * and the longest time.  A counter just adds up numbers.  Both are
+ * always compiled in; a span costs two clock reads.
+ *
+ * Report(Perf) shows the statistics so far, --perf-json writes them
+ * out when pcb exits, and --perf-trace writes every span of 10 us or
+ * more as a Chrome trace event, for chrome://tracing or Perfetto.
+ *
+ * Only the main thread and the main process are counted: worker
+ * threads and the children the routers and the batch server fork
+ * would race on the statistics and the trace file.
+ *
+ * <hr>
+ *
+ * <h1><b>Copyright.</b></h1>\n
+ *
+ * PCB, interactive printed circuit board design
+ *
+ * Copyright (C) 2026 PCB Contributors (see ChangeLog for details)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include "global.h"
+#include "data.h"
+#include "error.h"
+#include "perf.h"
+
+#ifdef HAVE_LIBDMALLOC
+#include <dmalloc.h>
+#endif
+
+/* shorter spans are counted but left out of the trace */
+#define TRACE_MIN_US 10
+
+struct PerfStat
+{
+  char *cat, *name;
+  bool span; /* timed, rather than a counter */
+  unsigned long calls;
+  guint64 count; /* sum of a counter */
+  guint64 total, max; /* microseconds */
+};
+
+static GHashTable *stats = NULL; /* "cat/name" -> PerfStat */
+static GPtrArray *all_stats = NULL;
+static GThread *main_thread = NULL;
+static FILE *trace = NULL;
+static bool trace_first;
+static guint64 epoch;
+#ifdef HAVE_UNISTD_H
+static pid_t main_pid;
+#endif
+
+/*!
+ * \brief Find or make the statistics of span or counter "name" in
+ * category "cat".
+ */
+PerfStat *
+perf_stat (const char *cat, const char *name)
+{
+  char *key = g_strconcat (cat, "/", name, NULL);
+  PerfStat *st;
+
+  if (stats == NULL)
+    {
+      stats = g_hash_table_new (g_str_hash, g_str_equal);
+      all_stats = g_ptr_array_new ();
+    }
+  st = (PerfStat *) g_hash_table_lookup (stats, key);
+  if (st != NULL)
+    {
+      g_free (key);
+      return st;
+    }
+  st = g_new0 (PerfStat, 1);
+  st->cat = g_strdup (cat);
+  st->name = g_strdup (name);
+  g_hash_table_insert (stats, key, st);
+  g_ptr_array_add (all_stats, st);
+  return st;
+}
+
+/*!
+ * \brief Microseconds on the monotonic clock.
+ */
+guint64
+perf_now (void)
+{
+  return (guint64) g_get_monotonic_time ();
+}
+
+static bool
+perf_counting (void)
+{
+  return main_thread == NULL || g_thread_self () == main_thread;
+}
+
+guint64
+perf_begin (PerfStat **site, const char *cat, const char *name)
+{
+  /* other threads leave the table alone, see perf_end () */
+  if (*site == NULL && perf_counting ())
+    *site = perf_stat (cat, name);
+  return perf_now ();
+}
+
+static void
+json_string (FILE *fp, const char *s)
+{
+  putc ('"', fp);
+  for (; *s; s++)
+    if (*s == '"' || *s == '\\')
+      fprintf (fp, "\\%c", *s);
+    else if ((unsigned char) *s < ' ')
+      fprintf (fp, "\\u%04x", *s);
+    else
+      putc (*s, fp);
+  putc ('"', fp);
+}
+
+/*!
+ * \brief End a span that perf_begin () or perf_now () started.
+ */
+void
+perf_end (PerfStat *st, guint64 start)
+{
+  guint64 dur;
+
+  if (st == NULL || !perf_counting ())
+    return;
+  dur = perf_now () - start;
+  st->span = true;
+  st->calls++;
+  st->total += dur;
+  if (dur > st->max)
+    st->max = dur;
+
+  if (trace == NULL || dur < TRACE_MIN_US)
+    return;
+#ifdef HAVE_UNISTD_H
+  /* a forked child would scribble over our trace */
+  if (getpid () != main_pid)
+    return;
+#endif
+  fputs (trace_first ? "\n{\"name\": " : ",\n{\"name\": ", trace);
+  trace_first = false;
+  json_string (trace, st->name);
+  fputs (", \"cat\": ", trace);
+  json_string (trace, st->cat);
+  fprintf (trace, ", \"ph\": \"X\", \"ts\": %" G_GUINT64_FORMAT
+	   ", \"dur\": %" G_GUINT64_FORMAT ", \"pid\": 1, \"tid\": 1}",
+	   start - epoch, dur);
+}
+
+void
+perf_count (PerfStat **site, const char *cat, const char *name,
+	    unsigned long n)
+{
+  if (!perf_counting ())
+    return;
+  if (*site == NULL)
+    *site = perf_stat (cat, name);
+  (*site)->calls++;
+  (*site)->count += n;
+}
+
+static int
+stat_cmp (gconstpointer va, gconstpointer vb)
+{
+  const PerfStat *a = *(const PerfStat **) va;
+  const PerfStat *b = *(const PerfStat **) vb;
+  int c = strcmp (a->cat, b->cat);
+
+  if (c)
+    return c;
+  if (a->total != b->total)
+    return a->total > b->total ? -1 : 1;
+  return strcmp (a->name, b->name);
+}
+
+/*!
+ * \brief Append a table of all spans and counters to report, by
+ * category and then by total time.
+ */
+void
+perf_report (GString *report)
+{
+  guint i;
+
+  if (all_stats == NULL || all_stats->len == 0)
+    {
+      g_string_append (report, _("Nothing has been measured yet.\n"));
+      return;
+    }
+  g_ptr_array_sort (all_stats, stat_cmp);
+  g_string_append_printf (report, "%-8s %-24s %10s %12s %10s %10s\n",
+			  _("category"), _("name"), _("calls"),
+			  _("total ms"), _("mean us"), _("max us"));
+  for (i = 0; i < all_stats->len; i++)
+    {
+      PerfStat *st = (PerfStat *) g_ptr_array_index (all_stats, i);
+
+      if (st->calls == 0)
+	continue;
+      if (st->span)
+	g_string_append_printf (report, "%-8s %-24s %10lu %12.3f %10.1f %10"
+				G_GUINT64_FORMAT "\n", st->cat, st->name,
+				st->calls, st->total / 1000.,
+				(double) st->total / st->calls, st->max);
+      else
+	g_string_append_printf (report, "%-8s %-24s %10lu %12s %10s %10s"
+				"  count %" G_GUINT64_FORMAT "\n",
+				st->cat, st->name, st->calls, "", "", "",
+				st->count);
+    }
+}
+
+/*!
+ * \brief Start all statistics over.
+ */
+void
+perf_reset (void)
+{
+  guint i;
+
+  if (all_stats == NULL)
+    return;
+  for (i = 0; i < all_stats->len; i++)
+    {
+      PerfStat *st = (PerfStat *) g_ptr_array_index (all_stats, i);
+
+      st->calls = 0;
+      st->count = st->total = st->max = 0;
+    }
+}
+
+/*!
+ * \brief Open the --perf-trace file.  Call once the settings are known.
+ */
+void
+perf_init (void)
+{
+  main_thread = g_thread_self ();
+#ifdef HAVE_UNISTD_H
+  main_pid = getpid ();
+#endif
+  epoch = perf_now ();
+  if (Settings.PerfTrace && *Settings.PerfTrace)
+    {
+      trace = fopen (Settings.PerfTrace, "w");
+      if (trace == NULL)
+	Message (_("Can't open trace file %s\n"), Settings.PerfTrace);
+      else
+	{
+	  fputs ("{\"traceEvents\": [", trace);
+	  trace_first = true;
+	}
+    }
+}
+
+/*!
+ * \brief Close the trace and write the --perf-json file.  Registered
+ * with atexit ().
+ */
+void
+perf_uninit (void)
+{
+  FILE *fp;
+  bool first = true;
+  guint i;
+
+#ifdef HAVE_UNISTD_H
+  if (getpid () != main_pid)
+    return;
+#endif
+  if (trace != NULL)
+    {
+      fputs ("\n]}\n", trace);
+      fclose (trace);
+      trace = NULL;
+    }
+  if (!Settings.PerfJson || !*Settings.PerfJson)
+    return;
+  fp = fopen (Settings.PerfJson, "w");
+  if (fp == NULL)
+    {
+      fprintf (stderr, _("Can't write %s\n"), Settings.PerfJson);
+      return;
+    }
+  fputs ("{\"stats\": [", fp);
+  for (i = 0; all_stats != NULL && i < all_stats->len; i++)
+    {
+      PerfStat *st = (PerfStat *) g_ptr_array_index (all_stats, i);
+
+      /* looked up, but never finished: Quit (), for one */
+      if (st->calls == 0)
+	continue;
+      fputs (first ? "\n{\"category\": " : ",\n{\"category\": ", fp);
+      first = false;
+      json_string (fp, st->cat);
+      fputs (", \"name\": ", fp);
+      json_string (fp, st->name);
+      if (st->span)
+	fprintf (fp, ", \"calls\": %lu, \"total_us\": %" G_GUINT64_FORMAT
+		 ", \"max_us\": %" G_GUINT64_FORMAT "}",
+		 st->calls, st->total, st->max);
+      else
+	fprintf (fp, ", \"calls\": %lu, \"count\": %" G_GUINT64_FORMAT "}",
+		 st->calls, st->count);
+    }
+  fputs ("\n]}\n", fp);
+  fclose (fp);
+}
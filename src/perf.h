@@ -0,0 +1,67 @@
+/*!
+ * \file src/perf.h
+ *
+ * \brief Prototypes for the performance counters.
+ *
+ * <hr>
+ *
+ * <h1><b>Copyright.</b></h1>\n
+ *
+ * PCB, interactive printed circuit board design
+ *
+ * Copyright (C) 2026 PCB Contributors (see ChangeLog for details)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef PCB_PERF_H
+#define PCB_PERF_H
+
+#include <glib.h>
+
+typedef struct PerfStat PerfStat;
+
+PerfStat *perf_stat (const char *, const char *);
+guint64 perf_now (void);
+guint64 perf_begin (PerfStat **, const char *, const char *);
+void perf_end (PerfStat *, guint64);
+void perf_count (PerfStat **, const char *, const char *, unsigned long);
+void perf_report (GString *);
+void perf_reset (void);
+void perf_init (void);
+void perf_uninit (void);
+
+/*!
+ * \brief Time the code up to the matching PERF_SPAN_END () as span
+ * "name" in category "cat".
+ *
+ * Both must be string constants; the statistics are looked up once per
+ * call site.  A span left by return or longjmp () is not counted.
+ */
+#define PERF_SPAN_BEGIN(var, cat, name)			\
+  static PerfStat *var##_perf = NULL;			\
+  guint64 var##_start = perf_begin (&var##_perf, cat, name)
+
+#define PERF_SPAN_END(var) perf_end (var##_perf, var##_start)
+
+/*!
+ * \brief Add n to the counter "name" in category "cat".
+ */
+#define PERF_COUNT(cat, name, n) do {			\
+  static PerfStat *perf_site = NULL;			\
+  perf_count (&perf_site, cat, name, n);		\
+} while (0)
+
+#endif
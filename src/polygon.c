@@ -96,6 +96,7 @@
 #include "misc.h"
 #include "move.h"
 #include "pcb-printf.h"
+#include "perf.h"
 #include "polygon.h"
 #include "remove.h"
 #include "rtree.h"
@@ -1266,8 +1267,13 @@ static bool inhibit = false;
 int
 InitClip (DataType *Data, LayerType *layer, PolygonType * p)
 {
+  PERF_SPAN_BEGIN (clip, "polygon", "InitClip");
+
   if (inhibit)
-    return 0;
+    {
+      PERF_SPAN_END (clip);
+      return 0;
+    }
 
   /* Clear any existing data. */
   if (p->Clipped)
@@ -1280,7 +1286,10 @@ InitClip (DataType *Data, LayerType *layer, PolygonType * p)
    * hole free. If we have one, we need to clear it. */
   poly_FreeContours (&p->NoHoles);
   if (!p->Clipped)
-    return 0;
+    {
+      PERF_SPAN_END (clip);
+      return 0;
+    }
   assert (poly_Valid (p->Clipped));
 
   /* If the polygon is clearing, we need to add all of the object cutouts. */
@@ -1288,6 +1297,7 @@ InitClip (DataType *Data, LayerType *layer, PolygonType * p)
     clearPoly (Data, layer, p, NULL, 0);
   else
     p->NoHolesValid = 0;
+  PERF_SPAN_END (clip);
   return 1;
 }
 
@@ -1865,20 +1875,109 @@ r_NoHolesPolygonDicer (POLYAREA * pa,
     }
 }
 
+struct window_holes
+{
+  PLINE *outer;
+  POLYAREA *holes;
+};
+
+static int
+window_hole_cb (const BoxType * b, void *cl)
+{
+  struct window_holes *wh = (struct window_holes *) cl;
+  PLINE *hole = (PLINE *) b;
+  PLINE *copy;
+  POLYAREA *piece;
+
+  if (hole == wh->outer)
+    return 0;
+  if (!poly_CopyContour (&copy, hole))
+    return 0;
+  /* The hole becomes an island, subtracted from the window below */
+  poly_InvContour (copy);
+  piece = poly_Create ();
+  poly_InclContour (piece, copy);
+  poly_M_Incl (&wh->holes, piece);
+  return 1;
+}
+
+/*!
+ * \brief Extract the part of a POLYAREA piece within a clip box.
+ *
+ * Only the contours near the box are copied: the contour r-tree finds
+ * the holes touching the box, and the outer contour's segment r-tree
+ * tells whether the outline crosses the box at all.  When it does not,
+ * the box is either wholly inside the piece (and stands in for the
+ * outline) or wholly outside it.  The cost of drawing a zoomed-in view
+ * of a board-sized pour is thus proportional to what is on screen
+ * rather than to the whole pour.
+ *
+ * Returns a newly allocated POLYAREA list, or NULL if nothing of the
+ * piece lies within the box.
+ */
+static POLYAREA *
+window_polyarea (POLYAREA *pa, const BoxType *clip)
+{
+  PLINE *outer = pa->contours;
+  POLYAREA *window;
+  struct window_holes wh;
+
+  if (clip->X2 <= clip->X1 || clip->Y2 <= clip->Y1)
+    return NULL;
+  if (outer->xmax < clip->X1 || outer->xmin > clip->X2 ||
+      outer->ymax < clip->Y1 || outer->ymin > clip->Y2)
+    return NULL;
+
+  if (r_region_is_empty (outer->tree, clip))
+    {
+      Vector v;
+
+      v[0] = clip->X1 + (clip->X2 - clip->X1) / 2;
+      v[1] = clip->Y1 + (clip->Y2 - clip->Y1) / 2;
+      if (!poly_InsideContour (outer, v))
+        return NULL;
+      window = RectPoly (clip->X1, clip->X2, clip->Y1, clip->Y2);
+    }
+  else
+    {
+      PLINE *copy;
+
+      if (!poly_CopyContour (&copy, outer))
+        return NULL;
+      window = poly_Create ();
+      poly_InclContour (window, copy);
+      poly_Boolean_free (window,
+                         RectPoly (clip->X1, clip->X2, clip->Y1, clip->Y2),
+                         &window, PBO_ISECT);
+    }
+  if (window == NULL)
+    return NULL;
+
+  wh.outer = outer;
+  wh.holes = NULL;
+  r_search (pa->contour_tree, clip, NULL, window_hole_cb, &wh);
+  if (wh.holes != NULL)
+    poly_Boolean_free (window, wh.holes, &window, PBO_SUB);
+
+  return window;
+}
+
 void
 NoHolesPolygonDicer (PolygonType *p, const BoxType * clip,
                      void (*emit) (PLINE *, void *), void *user_data)
 {
   POLYAREA *main_contour, *cur, *next;
 
-  main_contour = poly_Create ();
-  /* copy the main poly only */
-  poly_Copy1 (main_contour, p->Clipped);
-  /* clip to the bounding box */
   if (clip)
     {
-      POLYAREA *cbox = RectPoly (clip->X1, clip->X2, clip->Y1, clip->Y2);
-      poly_Boolean_free (main_contour, cbox, &main_contour, PBO_ISECT);
+      /* only the main poly, and only what lies within the clip box */
+      main_contour = window_polyarea (p->Clipped, clip);
+    }
+  else
+    {
+      main_contour = poly_Create ();
+      /* copy the main poly only */
+      poly_Copy1 (main_contour, p->Clipped);
     }
   if (main_contour == NULL)
     return;
@@ -81,6 +81,7 @@
 
 #include "global.h"
 #include "pcb-printf.h"
+#include "perf.h"
 #include "rtree.h"
 #include "heap.h"
 
@@ -2428,11 +2429,8 @@ poly_Boolean (const POLYAREA * a_org, const POLYAREA * b_org,
   return poly_Boolean_free (a, b, res, action);
 }				/* poly_Boolean */
 
-/*!
- * \brief Just like poly_Boolean but frees the input polys.
- */
-int
-poly_Boolean_free (POLYAREA * ai, POLYAREA * bi, POLYAREA ** res, int action)
+static int
+boolean_free (POLYAREA * ai, POLYAREA * bi, POLYAREA ** res, int action)
 {
   POLYAREA *a = ai, *b = bi;
   PLINE *a_isected = NULL;
@@ -2523,7 +2521,20 @@ poly_Boolean_free (POLYAREA * ai, POLYAREA * bi, POLYAREA ** res, int action)
     }
   assert (!*res || poly_Valid (*res));
   return code;
-}				/* poly_Boolean_free */
+}				/* boolean_free */
+
+/*!
+ * \brief Just like poly_Boolean but frees the input polys.
+ */
+int
+poly_Boolean_free (POLYAREA * ai, POLYAREA * bi, POLYAREA ** res, int action)
+{
+  PERF_SPAN_BEGIN (boolean, "polygon", "poly_Boolean");
+  int code = boolean_free (ai, bi, res, action);
+
+  PERF_SPAN_END (boolean);
+  return code;
+}
 
 static void
 clear_marks (POLYAREA * p)
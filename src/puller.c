@@ -558,13 +558,20 @@ Puller (int argc, char **argv, Coord Ux, Coord Uy)
 /*                          Global Puller                                    */
 
 static const char globalpuller_syntax[] =
-"GlobalPuller()";
+"GlobalPuller([selected|found], [rescan])";
 
 static const char globalpuller_help[] =
 "Pull all traces tight.";
 
 /* %start-doc actions GlobalPuller
 
+Pulls the traces on the current layer tight, or only the selected or
+found ones.  Every line is looked at once; after that, only the lines
+next to a joint that moved are looked at again, along with joints that
+had to wait for another one to be pulled first.  With @code{rescan},
+every line is looked at in every pass until a pass moves nothing, as
+older versions did; the time taken is reported either way.
+
 %end-doc */
 
 /* Ok, here's the deal.  We look for the intersection of two traces.
@@ -608,7 +615,7 @@ static const char globalpuller_help[] =
    is relative to corners and arcs, not absolute directions.
 */
 
-static int nloops, npulled;
+static int nloops, npulled, ntried;
 
 static void
 status ()
@@ -638,6 +645,8 @@ typedef struct Extra {
   End end;
   unsigned char found:1;
   unsigned char deleted:1;
+  unsigned char queued:1; /* set while on work_queue */
+  unsigned char blocked:1; /* set while in waiters */
   int type;
   union {
     LineType *line;
@@ -648,6 +657,13 @@ typedef struct Extra {
 static Extra multi_next;
 static GHashTable *lines;
 static GHashTable *arcs;
+/* Line and arc end points by location; see add_endpoint ().  */
+static GHashTable *endpoints;
+/* Lines whose joints may need pulling again; see queue_line ().  */
+static GQueue *work_queue;
+/* Lines whose joint maybe_pull_1 () deferred, by the pending End that
+   blocked it; see defer_joint ().  */
+static GHashTable *waiters;
 static int did_something;
 static int current_is_top, current_is_bottom;
 
@@ -723,105 +739,93 @@ fix_arc_extra (ArcType *a, Extra *e)
 #endif
 }
 
-typedef struct {
-  void *me;
-  Coord x, y;
-  int is_arc;
-  Extra **extra_ptr;
-} FindPairCallbackStruct;
-
 #define NEAR(a,b) ((a) <= (b) + 2 && (a) >= (b) - 2)
 
-static int
-find_pair_line_callback (const BoxType * b, void *cl)
+/* End points hash to cells of this size, so that points NEAR each
+   other are at most one cell apart.  */
+#define ENDPOINT_CELL 8
+
+static Coord
+endpoint_cell (Coord v)
 {
-  LineType *line = (LineType *) b;
-#if TRACE1
-  Extra *e = LINE2EXTRA (line);
-#endif
-  FindPairCallbackStruct *fpcs = (FindPairCallbackStruct *) cl;
+  return (v < 0 ? v - (ENDPOINT_CELL - 1) : v) / ENDPOINT_CELL;
+}
 
-  if (line == fpcs->me)
-    return 0;
-#ifdef CHECK_LINE_PT_NEG
-  if (line->Point1.X < 0)
-    abort1();
-#endif
-#if TRACE1
-  pcb_printf(" - %p line %#mD or %#mD\n", e, line->Point1.X, line->Point1.Y,
-	 line->Point2.X, line->Point2.Y);
-#endif
-  if ((NEAR (line->Point1.X, fpcs->x) && NEAR (line->Point1.Y, fpcs->y))
-      || (NEAR (line->Point2.X, fpcs->x) && NEAR (line->Point2.Y, fpcs->y)))
+static gint64 *
+endpoint_key (Coord cx, Coord cy)
+{
+  gint64 *key = g_new (gint64, 1);
+  *key = ((gint64) cx << 32) ^ (guint32) cy;
+  return key;
+}
+
+static void
+add_endpoint (Extra *e, Coord x, Coord y)
+{
+  gint64 *key = endpoint_key (endpoint_cell (x), endpoint_cell (y));
+  GSList *list = g_hash_table_lookup (endpoints, key);
+
+  if (list == NULL)
     {
-      if (* fpcs->extra_ptr)
-	{
-#if TRACE1
-	  printf("multiple, was %p\n", *fpcs->extra_ptr);
-#endif
-	  *fpcs->extra_ptr = & multi_next;
-	}
-      else
-	{
-	  *fpcs->extra_ptr = LINE2EXTRA (line);
-#if TRACE1
-	  printf(" - next now %p\n", *fpcs->extra_ptr);
-#endif
-	}
+      g_hash_table_insert (endpoints, key, g_slist_prepend (NULL, e));
+      return;
     }
-  return 0;
+  g_free (key);
+  /* Both ends of a short line may fall in one cell.  */
+  if (list->data == e || (list->next && list->next->data == e))
+    return;
+  /* Add after the head, so that the table keeps the same list.  */
+  list->next = g_slist_prepend (list->next, e);
 }
 
 static int
-find_pair_arc_callback (const BoxType * b, void *cl)
+extra_ends_near (Extra *e, Coord x, Coord y)
 {
-  ArcType *arc = (ArcType *) b;
-  Extra *e = ARC2EXTRA (arc);
-  FindPairCallbackStruct *fpcs = (FindPairCallbackStruct *) cl;
-
-  if (arc == fpcs->me)
-    return 0;
-#if TRACE1
-  pcb_printf(" - %p arc %#mD or %#mD\n", e, e->start.x, e->start.y, e->end.x, e->end.y);
-#endif
-  if ((NEAR (e->start.x, fpcs->x) && NEAR (e->start.y, fpcs->y))
-      || (NEAR (e->end.x, fpcs->x) && NEAR (e->end.y, fpcs->y)))
+  if (EXTRA_IS_LINE (e))
     {
-      if (* fpcs->extra_ptr)
-	{
-#if TRACE1
-	  printf("multiple, was %p\n", *fpcs->extra_ptr);
-#endif
-	  *fpcs->extra_ptr = & multi_next;
-	}
-      else
-	*fpcs->extra_ptr = e;
+      LineType *line = EXTRA2LINE (e);
+      return ((NEAR (line->Point1.X, x) && NEAR (line->Point1.Y, y))
+	      || (NEAR (line->Point2.X, x) && NEAR (line->Point2.Y, y)));
     }
-  return 0;
+  return ((NEAR (e->start.x, x) && NEAR (e->start.y, y))
+	  || (NEAR (e->end.x, x) && NEAR (e->end.y, y)));
 }
 
 static void
 find_pairs_1 (void *me, Extra **e, Coord x, Coord y)
 {
-  FindPairCallbackStruct fpcs;
-  BoxType b;
+  Coord cx, cy;
+  GSList *i;
+  gint64 key;
 
   if (*e)
     return;
 
-  fpcs.me = me;
-  fpcs.extra_ptr = e;
-  fpcs.x = x;
-  fpcs.y = y;
 #if TRACE1
   pcb_printf("looking for %#mD\n", x, y);
 #endif
-  b.X1 = x - 10;
-  b.X2 = x + 10;
-  b.Y1 = y - 10;
-  b.Y2 = y + 10;
-  r_search(CURRENT->line_tree, &b, NULL, find_pair_line_callback, &fpcs);
-  r_search(CURRENT->arc_tree, &b, NULL, find_pair_arc_callback, &fpcs);
+  for (cx = endpoint_cell (x) - 1; cx <= endpoint_cell (x) + 1; cx++)
+    for (cy = endpoint_cell (y) - 1; cy <= endpoint_cell (y) + 1; cy++)
+      {
+	key = ((gint64) cx << 32) ^ (guint32) cy;
+	for (i = g_hash_table_lookup (endpoints, &key); i; i = i->next)
+	  {
+	    Extra *other = i->data;
+	    if ((void *) other->parent.line == me || other == *e)
+	      continue;
+	    if (!extra_ends_near (other, x, y))
+	      continue;
+	    if (*e)
+	      {
+#if TRACE1
+		printf("multiple, was %p\n", *e);
+#endif
+		*e = & multi_next;
+	      }
+	    else
+	      *e = other;
+	  }
+      }
 }
 
 static int
@@ -1057,6 +1061,10 @@ null_multi_next_ends (AnyObjectType *ptr, Extra *extra, void *userdata)
     extra->end.next = NULL;
 }
 
+static void queue_line (Extra *e);
+static void defer_joint (Extra *e, End *blocker);
+static void wake_joints (End *end);
+
 static Extra *
 new_line_extra (LineType *line)
 {
@@ -1064,6 +1072,7 @@ new_line_extra (LineType *line)
   g_hash_table_insert (lines, line, extra);
   extra->parent.line = line;
   extra->type = LINE_TYPE;
+  queue_line (extra);
   return extra;
 }
 
@@ -1089,6 +1098,21 @@ find_pairs ()
     new_line_extra (line);
   } END_LOOP;
 
+  /* Index the end points once; the pairs found are then kept up to
+     date as lines are pulled.  */
+  endpoints = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free,
+				     (GDestroyNotify) g_slist_free);
+  LINE_LOOP (CURRENT); {
+    Extra *e = LINE2EXTRA (line);
+    add_endpoint (e, line->Point1.X, line->Point1.Y);
+    add_endpoint (e, line->Point2.X, line->Point2.Y);
+  } END_LOOP;
+  ARC_LOOP (CURRENT); {
+    Extra *e = ARC2EXTRA (arc);
+    add_endpoint (e, e->start.x, e->start.y);
+    add_endpoint (e, e->end.x, e->end.y);
+  } END_LOOP;
+
   LINE_LOOP (CURRENT); {
     Extra *e = LINE2EXTRA (line);
     if (line->Point1.X >= 0)
@@ -1140,6 +1164,9 @@ find_pairs ()
 
   g_hash_table_foreach (lines, (GHFunc)null_multi_next_ends, NULL);
   g_hash_table_foreach (arcs, (GHFunc)null_multi_next_ends, NULL);
+
+  g_hash_table_destroy (endpoints);
+  endpoints = NULL;
 }
 
 #define PROP_NEXT(e,n,f) 		\
@@ -1972,6 +1999,8 @@ mark_line_for_deletion (LineType *l)
     }
   e->deleted = 1;
   unlink_extras (e);
+  wake_joints (&e->start);
+  wake_joints (&e->end);
 #if TRACE1
   pcb_printf("Marked line %p for deletion %#mD to %#mD\n",
 	 e, l->Point1.X, l->Point1.Y, l->Point2.X, l->Point2.Y);
@@ -1997,6 +2026,8 @@ mark_arc_for_deletion (ArcType *a)
   Extra *e = ARC2EXTRA(a);
   e->deleted = 1;
   unlink_extras (e);
+  wake_joints (&e->start);
+  wake_joints (&e->end);
 #if TRACE1
   printf("Marked arc %p for deletion %ld < %ld\n",
 	 e, a->StartAngle, a->Delta);
@@ -2233,6 +2264,7 @@ maybe_pull_1 (LineType *line)
   if (fp)
     {
       start_extra->end.waiting_for = fp_end;
+      defer_joint (start_extra, fp_end);
       return;
     }
   start_extra->end.pending = 0;
@@ -2517,6 +2549,173 @@ maybe_pull (LineType *line, Extra *e)
     }
 }
 
+/*!
+ * \brief Remember to look at a line's joints again.
+ */
+static void
+queue_line (Extra *e)
+{
+  if (work_queue == NULL || e == NULL || e == &multi_next
+      || !EXTRA_IS_LINE (e) || e->deleted || e->queued)
+    return;
+  e->queued = 1;
+  g_queue_push_tail (work_queue, e);
+}
+
+/*!
+ * \brief Remember that \p e's joint waits for \p blocker to be
+ * pulled first.
+ */
+static void
+defer_joint (Extra *e, End *blocker)
+{
+  if (waiters == NULL || e->blocked)
+    return;
+  e->blocked = 1;
+  g_hash_table_insert (waiters, blocker,
+		       g_slist_prepend (g_hash_table_lookup (waiters, blocker),
+					e));
+}
+
+/*!
+ * \brief Queue the lines whose joints were blocked on \p end again.
+ */
+static void
+wake_joints (End *end)
+{
+  GSList *list, *i;
+
+  if (waiters == NULL
+      || (list = g_hash_table_lookup (waiters, end)) == NULL)
+    return;
+  g_hash_table_remove (waiters, end);
+  for (i = list; i; i = i->next)
+    {
+      Extra *e = i->data;
+
+      e->blocked = 0;
+      queue_line (e);
+    }
+  g_slist_free (list);
+}
+
+static gboolean
+wake_all_cb (gpointer key, gpointer value, gpointer userdata)
+{
+  GSList *i;
+
+  for (i = value; i; i = i->next)
+    {
+      Extra *e = i->data;
+
+      e->blocked = 0;
+      queue_line (e);
+    }
+  g_slist_free (value);
+  return TRUE;
+}
+
+static void
+free_waiters_cb (gpointer key, gpointer value, gpointer userdata)
+{
+  g_slist_free (value);
+}
+
+/*!
+ * \brief Queue a line that moved, and wake the joints blocked on it.
+ */
+static void
+line_moved (Extra *e)
+{
+  if (e == NULL || e == &multi_next)
+    return;
+  wake_joints (&e->start);
+  wake_joints (&e->end);
+  queue_line (e);
+}
+
+/*!
+ * \brief Queue the lines joined to \p e, directly or through an arc,
+ * and wake the joints blocked on them.
+ */
+static void
+queue_neighbours (Extra *e)
+{
+  Extra *n[2];
+  int i;
+
+  n[0] = e->start.next;
+  n[1] = e->end.next;
+  for (i = 0; i < 2; i++)
+    {
+      if (n[i] == NULL || n[i] == &multi_next)
+	continue;
+      if (EXTRA_IS_ARC (n[i]))
+	{
+	  wake_joints (&n[i]->start);
+	  wake_joints (&n[i]->end);
+	  line_moved (n[i]->start.next);
+	  line_moved (n[i]->end.next);
+	}
+      else
+	line_moved (n[i]);
+    }
+}
+
+/*!
+ * \brief Pull every line until nothing moves.
+ *
+ * The first round queues every line.  After that only lines at joints
+ * that moved are queued again, and a joint deferred because a pending
+ * end blocked it is queued when that end, or a line next to it, moves.
+ * Once the queue runs dry, the joints still deferred get one more
+ * round if anything moved since the last one; a round that moves
+ * nothing ends the loop.
+ */
+static void
+pull_worklist ()
+{
+  Extra *e;
+  int before, moved;
+
+  work_queue = g_queue_new ();
+  waiters = g_hash_table_new (NULL, NULL);
+  did_something = 0;
+  LINE_LOOP (CURRENT); {
+    queue_line (LINE2EXTRA (line));
+  } END_LOOP;
+  do
+    {
+      nloops ++;
+      status();
+      moved = 0;
+      while ((e = g_queue_pop_head (work_queue)) != NULL)
+	{
+	  e->queued = 0;
+	  if (e->deleted || !(e->start.next || e->end.next))
+	    continue;
+	  ntried ++;
+	  before = did_something;
+	  maybe_pull (EXTRA2LINE (e), e);
+	  if (did_something != before)
+	    {
+	      moved = 1;
+	      if (!e->deleted)
+		{
+		  line_moved (e);
+		  queue_neighbours (e);
+		}
+	    }
+	}
+      if (moved)
+	g_hash_table_foreach_remove (waiters, wake_all_cb, NULL);
+    }
+  while (!g_queue_is_empty (work_queue));
+  g_hash_table_foreach (waiters, free_waiters_cb, NULL);
+  g_hash_table_destroy (waiters);
+  waiters = NULL;
+}
+
 static void
 validate_pair (Extra *e, End *end)
 {
@@ -2591,16 +2790,25 @@ static int
 GlobalPuller(int argc, char **argv, Coord x, Coord y)
 {
   int select_flags = 0;
+  int rescan = 0;
+  int i;
+  GTimer *timer = g_timer_new ();
 
   setbuf(stdout, 0);
   nloops = 0;
   npulled = 0;
+  ntried = 0;
   Message ("puller! %s\n", argc > 0 ? argv[0] : "");
 
-  if (argc > 0 && strcasecmp (argv[0], "selected") == 0)
-    select_flags = SELECTEDFLAG;
-  if (argc > 0 && strcasecmp (argv[0], "found") == 0)
-    select_flags = FOUNDFLAG;
+  for (i = 0; i < argc; i++)
+    {
+      if (strcasecmp (argv[i], "selected") == 0)
+	select_flags = SELECTEDFLAG;
+      if (strcasecmp (argv[i], "found") == 0)
+	select_flags = FOUNDFLAG;
+      if (strcasecmp (argv[i], "rescan") == 0)
+	rescan = 1;
+    }
 
   Message ("optimizing...\n");
   /* This canonicalizes all the lines, and cleans up near-misses.  */
@@ -2632,7 +2840,12 @@ GlobalPuller(int argc, char **argv, Coord x, Coord y)
 #endif
 
   Message ("pulling...\n");
-  if (setjmp(abort_buf) == 0)
+  if (!rescan)
+    {
+      if (setjmp(abort_buf) == 0)
+	pull_worklist ();
+    }
+  else if (setjmp(abort_buf) == 0)
     {
 #if TRACE0
       int old_did_something = -1;
@@ -2652,7 +2865,10 @@ GlobalPuller(int argc, char **argv, Coord x, Coord y)
 	      abort1();
 #endif
 	    if (e->start.next || e->end.next)
-	      maybe_pull (line, e);
+	      {
+		ntried ++;
+		maybe_pull (line, e);
+	      }
 #if TRACE0
 	    if (did_something != old_did_something)
 	      {
@@ -2693,9 +2909,17 @@ GlobalPuller(int argc, char **argv, Coord x, Coord y)
     }
   END_LOOP;
 
+  if (work_queue)
+    {
+      g_queue_free (work_queue);
+      work_queue = NULL;
+    }
   g_hash_table_unref (lines);
   g_hash_table_unref (arcs);
 
+  Message ("%d loops, %d joints tried, %d pulled in %.2f seconds\n",
+	   nloops, ntried, npulled, g_timer_elapsed (timer, NULL));
+  g_timer_destroy (timer);
   IncrementUndoSerialNumber();
   return 0;
 }
@@ -129,54 +129,51 @@ static bool
 FindPad (char *ElementName, char *PinNum, ConnectionType * conn, bool Same)
 {
   ElementType *element;
-  GList *i;
 
   if ((element = SearchElementByName (PCB->Data, ElementName)) == NULL)
     return false;
 
-  for (i = element->Pad; i != NULL; i = g_list_next (i))
-    {
-      PadType *pad = i->data;
-
-      if (NSTRCMP (PinNum, pad->Number) == 0 &&
-          (!Same || !TEST_FLAG (DRCFLAG, pad)))
-        {
-          conn->type = PAD_TYPE;
-          conn->ptr1 = element;
-          conn->ptr2 = pad;
-          conn->group = TEST_FLAG (ONSOLDERFLAG, pad) ? bottom_group : top_group;
-
-          if (TEST_FLAG (EDGE2FLAG, pad))
-            {
-              conn->X = pad->Point2.X;
-              conn->Y = pad->Point2.Y;
-            }
-          else
-            {
-              conn->X = pad->Point1.X;
-              conn->Y = pad->Point1.Y;
-            }
-          return true;
-        }
-    }
+  PAD_LOOP (element);
+  {
+    if (NSTRCMP (PinNum, pad->Number) == 0 &&
+	(!Same || !TEST_FLAG (DRCFLAG, pad)))
+      {
+	conn->type = PAD_TYPE;
+	conn->ptr1 = element;
+	conn->ptr2 = pad;
+	conn->group = TEST_FLAG (ONSOLDERFLAG, pad) ? bottom_group : top_group;
 
-  for (i = element->Pin; i != NULL; i = g_list_next (i))
-    {
-      PinType *pin = i->data;
+	if (TEST_FLAG (EDGE2FLAG, pad))
+	  {
+	    conn->X = pad->Point2.X;
+	    conn->Y = pad->Point2.Y;
+	  }
+	else
+	  {
+	    conn->X = pad->Point1.X;
+	    conn->Y = pad->Point1.Y;
+	  }
+	return true;
+      }
+  }
+  END_LOOP;
 
-      if (!TEST_FLAG (HOLEFLAG, pin) &&
-          pin->Number && NSTRCMP (PinNum, pin->Number) == 0 &&
-          (!Same || !TEST_FLAG (DRCFLAG, pin)))
-        {
-          conn->type = PIN_TYPE;
-          conn->ptr1 = element;
-          conn->ptr2 = pin;
-          conn->group = bottom_group;        /* any layer will do */
-          conn->X = pin->X;
-          conn->Y = pin->Y;
-          return true;
-        }
-    }
+  PIN_LOOP (element);
+  {
+    if (!TEST_FLAG (HOLEFLAG, pin) &&
+	pin->Number && NSTRCMP (PinNum, pin->Number) == 0 &&
+	(!Same || !TEST_FLAG (DRCFLAG, pin)))
+      {
+	conn->type = PIN_TYPE;
+	conn->ptr1 = element;
+	conn->ptr2 = pin;
+	conn->group = bottom_group;        /* any layer will do */
+	conn->X = pin->X;
+	conn->Y = pin->Y;
+	return true;
+      }
+  }
+  END_LOOP;
 
   return false;
 }
@@ -132,7 +132,7 @@ DestroyVia (PinType *Via)
   r_delete_entry (DestroyTarget->via_tree, (BoxType *) Via);
   free (Via->Name);
 
-  DestroyTarget->Via = g_list_remove (DestroyTarget->Via, Via);
+  RemoveObjectFromList (&DestroyTarget->Via, Via);
   DestroyTarget->ViaN --;
 
   g_slice_free (PinType, Via);
@@ -149,7 +149,7 @@ DestroyLine (LayerType *Layer, LineType *Line)
   r_delete_entry (Layer->line_tree, (BoxType *) Line);
   free (Line->Number);
 
-  Layer->Line = g_list_remove (Layer->Line, Line);
+  RemoveObjectFromList (&Layer->Line, Line);
   Layer->LineN --;
 
   g_slice_free (LineType, Line);
@@ -165,7 +165,7 @@ DestroyArc (LayerType *Layer, ArcType *Arc)
 {
   r_delete_entry (Layer->arc_tree, (BoxType *) Arc);
 
-  Layer->Arc = g_list_remove (Layer->Arc, Arc);
+  RemoveObjectFromList (&Layer->Arc, Arc);
   Layer->ArcN --;
 
   g_slice_free (ArcType, Arc);
@@ -182,7 +182,7 @@ DestroyPolygon (LayerType *Layer, PolygonType *Polygon)
   r_delete_entry (Layer->polygon_tree, (BoxType *) Polygon);
   FreePolygonMemory (Polygon);
 
-  Layer->Polygon = g_list_remove (Layer->Polygon, Polygon);
+  RemoveObjectFromList (&Layer->Polygon, Polygon);
   Layer->PolygonN --;
 
   g_slice_free (PolygonType, Polygon);
@@ -239,7 +239,7 @@ DestroyText (LayerType *Layer, TextType *Text)
   free (Text->TextString);
   r_delete_entry (Layer->text_tree, (BoxType *) Text);
 
-  Layer->Text = g_list_remove (Layer->Text, Text);
+  RemoveObjectFromList (&Layer->Text, Text);
   Layer->TextN --;
 
   g_slice_free (TextType, Text);
@@ -279,7 +279,7 @@ DestroyElement (ElementType *Element)
   END_LOOP;
   FreeElementMemory (Element);
 
-  DestroyTarget->Element = g_list_remove (DestroyTarget->Element, Element);
+  RemoveObjectFromList (&DestroyTarget->Element, Element);
   DestroyTarget->ElementN --;
 
   g_slice_free (ElementType, Element);
@@ -296,7 +296,7 @@ DestroyRat (RatType *Rat)
   if (DestroyTarget->rat_tree)
     r_delete_entry (DestroyTarget->rat_tree, &Rat->BoundingBox);
 
-  DestroyTarget->Rat = g_list_remove (DestroyTarget->Rat, Rat);
+  RemoveObjectFromList (&DestroyTarget->Rat, Rat);
   DestroyTarget->RatN --;
 
   g_slice_free (RatType, Rat);
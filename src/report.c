@@ -58,6 +58,7 @@
 #include "find.h"
 #include "draw.h"
 #include "pcb-printf.h"
+#include "perf.h"
 #ifdef HAVE_REGEX_H
 #include <regex.h>
 #endif
@@ -969,8 +970,30 @@ ReportNetLengthByName (char *tofind, int x, int y)
   return 0;
 }
 
+/*!
+ * \brief Show the performance counters, or start them over.
+ */
+static int
+ReportPerf (int argc, char **argv, Coord x, Coord y)
+{
+  GString *report;
+
+  if (argc == 1 && strcasecmp (argv[0], "Reset") == 0)
+    {
+      perf_reset ();
+      return 0;
+    }
+  if (argc != 0)
+    return 1;
+  report = g_string_new ("");
+  perf_report (report);
+  gui->report_dialog (_("Performance"), report->str);
+  g_string_free (report, TRUE);
+  return 0;
+}
+
 static const char report_syntax[] =
-  N_("Report(Object|DrillReport|FoundPins|NetLength|AllNetLengths|[,name])");
+  N_("Report(Object|DrillReport|FoundPins|NetLength|AllNetLengths|Snap|Perf|[,name])");
 
 static const char report_help[] = N_("Produce various report.");
 
@@ -999,6 +1022,19 @@ The name and length of the net under the crosshair will be reported to
 the message log.  An optional parameter specifies mm, mil, pcb, or in
 units
 
+@item Snap
+The time spent snapping the crosshair to the grid and to objects as it
+moves, and how many object searches the snap cache saved, since the
+last such report.
+
+@item Perf
+The calls, total, mean and longest time of every timed span, and the
+sum of every counter, since pcb started.  Actions, connection lookups,
+DRC runs, polygon clipping, redraws, loads and exports are timed;
+r-tree searches and the rectangles they find are counted.  @code{Report(Perf,Reset)} starts the figures
+over.  See also the @code{--perf-json} and @code{--perf-trace}
+options.
+
 @end table
 
 %end-doc */
@@ -1023,6 +1059,17 @@ Report (int argc, char **argv, Coord x, Coord y)
     return ReportNetLength (argc - 1, argv + 1, x, y);
   else if (strcasecmp (argv[0], "AllNetLengths") == 0)
     return ReportAllNetLengths (argc - 1, argv + 1, x, y);
+  else if (strcasecmp (argv[0], "Snap") == 0)
+    {
+      ReportSnapStats ();
+      return 0;
+    }
+  else if (strcasecmp (argv[0], "Perf") == 0)
+    {
+      if (ReportPerf (argc - 1, argv + 1, x, y) == 0)
+        return 0;
+      AFAIL (report);
+    }
   else if ((strcasecmp (argv[0], "NetLength") == 0) && (argc == 2))
     return ReportNetLengthByName (argv[1], x, y);
   else if (argc == 2)
@@ -52,6 +52,7 @@
 #include <setjmp.h>
 
 #include "mymem.h"
+#include "perf.h"
 
 #include "rtree.h"
 
@@ -78,6 +79,12 @@
 
 #define DELETE_BY_POINTER
 
+/* bumped by every change to any tree, see r_modification_count ().
+ * Trees are also built and searched from worker threads, so this is
+ * only touched with the g_atomic_int_* functions.
+ */
+static gint modification_count = 0;
+
 typedef struct
 {
   const BoxType *bptr;          /* pointer to the box */
@@ -429,6 +436,7 @@ r_create_tree (const BoxType * boxlist[], int N, int manage)
   int i;
 
   assert (N >= 0);
+  g_atomic_int_inc (&modification_count);
   rtree = (rtree_t *)calloc (1, sizeof (*rtree));
   /* start with a single empty leaf node */
   node = (struct rtree_node *)calloc (1, sizeof (*node));
@@ -481,11 +489,24 @@ void
 r_destroy_tree (rtree_t ** rtree)
 {
 
+  g_atomic_int_inc (&modification_count);
   __r_destroy_tree ((*rtree)->root);
   free (*rtree);
   *rtree = NULL;
 }
 
+/*!
+ * \brief Number of changes made to any r-tree so far.
+ *
+ * Callers caching the result of searches can compare this to find out
+ * whether anything was created, inserted or deleted in the meantime.
+ */
+guint
+r_modification_count (void)
+{
+  return (guint) g_atomic_int_get (&modification_count);
+}
+
 typedef struct
 {
   int (*check_it) (const BoxType * region, void *cl);
@@ -580,6 +601,44 @@ __r_search (struct rtree_node *node, const BoxType * query, r_arg * arg)
     }
 }
 
+static int
+r_search_root (rtree_t * rtree, const BoxType * query,
+               int (*check_region) (const BoxType * region, void *cl),
+               int (*found_rectangle) (const BoxType * box, void *cl), void *cl)
+{
+  r_arg arg;
+
+  if (!rtree || rtree->size < 1)
+    return 0;
+  if (query)
+    {
+#ifdef SLOW_ASSERTS
+  assert (__r_tree_is_good (rtree->root));
+#endif
+#ifdef DEBUG
+      if (query->X2 <= query->X1 || query->Y2 <= query->Y1)
+        return 0;
+#endif
+      /* check this box. If it's not touched we're done here */
+      if (rtree->root->box.X1 >= query->X2 ||
+          rtree->root->box.X2 <= query->X1 ||
+          rtree->root->box.Y1 >= query->Y2
+          || rtree->root->box.Y2 <= query->Y1)
+        return 0;
+      arg.check_it = check_region;
+      arg.found_it = found_rectangle;
+      arg.closure = cl;
+      return __r_search (rtree->root, query, &arg);
+    }
+  else
+    {
+      arg.check_it = check_region;
+      arg.found_it = found_rectangle;
+      arg.closure = cl;
+      return __r_search (rtree->root, &rtree->root->box, &arg);
+    }
+}
+
 /*!
  * \brief Parameterized search in the rtree.
  *
@@ -613,37 +672,12 @@ r_search (rtree_t * rtree, const BoxType * query,
           int (*check_region) (const BoxType * region, void *cl),
           int (*found_rectangle) (const BoxType * box, void *cl), void *cl)
 {
-  r_arg arg;
+  int n = r_search_root (rtree, query, check_region, found_rectangle, cl);
 
-  if (!rtree || rtree->size < 1)
-    return 0;
-  if (query)
-    {
-#ifdef SLOW_ASSERTS
-  assert (__r_tree_is_good (rtree->root));
-#endif
-#ifdef DEBUG
-      if (query->X2 <= query->X1 || query->Y2 <= query->Y1)
-        return 0;
-#endif
-      /* check this box. If it's not touched we're done here */
-      if (rtree->root->box.X1 >= query->X2 ||
-          rtree->root->box.X2 <= query->X1 ||
-          rtree->root->box.Y1 >= query->Y2
-          || rtree->root->box.Y2 <= query->Y1)
-        return 0;
-      arg.check_it = check_region;
-      arg.found_it = found_rectangle;
-      arg.closure = cl;
-      return __r_search (rtree->root, query, &arg);
-    }
-  else
-    {
-      arg.check_it = check_region;
-      arg.found_it = found_rectangle;
-      arg.closure = cl;
-      return __r_search (rtree->root, &rtree->root->box, &arg);
-    }
+  /* only counted: searches are many, often short and nest inside each
+     other's callbacks, so timing them would cost more than it tells */
+  PERF_COUNT ("rtree", "r_search", n);
+  return n;
 }
 
 /*!
@@ -1053,6 +1087,7 @@ r_insert_entry (rtree_t * rtree, const BoxType * which, int man)
   assert (which);
   assert (which->X1 <= which->X2);
   assert (which->Y1 <= which->Y2);
+  g_atomic_int_inc (&modification_count);
   /* recursively search the tree for the best leaf node */
   assert (rtree->root);
   __r_insert_node (rtree->root, which, man,
@@ -1179,7 +1214,10 @@ r_delete_entry (rtree_t * rtree, const BoxType * box)
   assert (rtree);
   r = __r_delete (rtree->root, box);
   if (r)
-    rtree->size--;
+    {
+      rtree->size--;
+      g_atomic_int_inc (&modification_count);
+    }
 #ifdef SLOW_ASSERTS
   assert (__r_tree_is_good (rtree->root));
 #endif
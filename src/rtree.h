@@ -46,6 +46,7 @@
 
 rtree_t *r_create_tree (const BoxType * boxlist[], int N, int manage);
 void r_destroy_tree (rtree_t ** rtree);
+guint r_modification_count (void);
 
 bool r_delete_entry (rtree_t * rtree, const BoxType * which);
 void r_insert_entry (rtree_t * rtree, const BoxType * which, int manage);
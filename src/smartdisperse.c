@@ -145,9 +145,8 @@ padorder (ConnectionType *conna, ConnectionType *connb)
   return 0;
 }
 
-/* ewww, these are actually arrays */
-#define ELEMENT_N(DATA,ELT)	((ELT) - (DATA)->Element)
-#define VISITED(ELT)		(visited[ELEMENT_N(PCB->Data, (ELT))])
+/* indexed by the element's slot in PCB->Data->Element */
+#define VISITED(ELT)		(visited[(ELT)->ListSlot])
 #define IS_ELEMENT(CONN)	((CONN)->type == PAD_TYPE || (CONN)->type == PIN_TYPE)
 
 static const char smartdisperse_syntax[] = "SmartDisperse([All|Selected])";
@@ -197,14 +196,14 @@ smartdisperse (int argc, char **argv, Coord x, Coord y)
   }
 
   /* remember which elements we finish with */
-  visited = calloc (PCB->Data->ElementN, sizeof(*visited));
+  visited = calloc (PCB->Data->Element.PtrN, sizeof(*visited));
 
   /* if we're not doing all, mark the unselected elements as "visited" */
   ELEMENT_LOOP (PCB->Data);
   {
     if (! (all || TEST_FLAG (SELECTEDFLAG, element)))
     {
-      visited[n] = 1;
+      VISITED (element) = 1;
     }
   }
   END_LOOP;
@@ -238,10 +237,10 @@ smartdisperse (int argc, char **argv, Coord x, Coord y)
     eb = (ElementType *) connb->ptr1;
 
     /* place this pair if possible */
-    if (VISITED((GList *)ea) || VISITED((GList *)eb))
+    if (VISITED (ea) || VISITED (eb))
       continue;
-    VISITED ((GList *)ea) = 1;
-    VISITED ((GList *)eb) = 1;
+    VISITED (ea) = 1;
+    VISITED (eb) = 1;
 
     /* a weak attempt to get the linked pads side-by-side */
     if (padorder(conna, connb))
@@ -270,9 +269,9 @@ smartdisperse (int argc, char **argv, Coord x, Coord y)
       element = (ElementType *) connection->ptr1;
 
       /* place this one if needed */
-      if (VISITED ((GList *) element))
+      if (VISITED (element))
         continue;
-      VISITED ((GList *) element) = 1;
+      VISITED (element) = 1;
       place (element);
     }
     END_LOOP;
@@ -282,7 +281,7 @@ smartdisperse (int argc, char **argv, Coord x, Coord y)
   /* Place up anything else */
   ELEMENT_LOOP (PCB->Data);
   {
-    if (! visited[n])
+    if (! VISITED (element))
     {
       place (element);
     }
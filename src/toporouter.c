@@ -2719,6 +2719,81 @@ import_clusters(toporouter_t *r)
   FreeNetListListMemory(&nets);
 }
 
+#ifdef GTS_HAVE_THREAD_LOCAL
+typedef struct {
+  toporouter_t *r;
+  GAsyncQueue *done;
+} cdt_jobs_t;
+
+static void
+build_cdt_job(gpointer data, gpointer user_data)
+{
+  cdt_jobs_t *jobs = (cdt_jobs_t *)user_data;
+
+  build_cdt(jobs->r, (toporouter_layer_t *)data);
+  g_async_queue_push(jobs->done, data);
+}
+#endif
+
+/*!
+ * \brief Build the triangulations of the first \p n layers.
+ *
+ * The layers share no GTS objects, so with a thread safe GTS they are
+ * built by a thread each.
+ */
+static void
+build_cdts(toporouter_t *r, guint n)
+{
+  GTimer *timer = g_timer_new();
+  gsize peak;
+  guint i, threads = 1;
+
+  /* report this run's peak, not the largest of any earlier one */
+  gts_object_memory_reset_peak();
+
+#ifdef GTS_HAVE_THREAD_LOCAL
+  threads = MIN(n, g_get_num_processors());
+  if(threads > 1) {
+    GError *error = NULL;
+    cdt_jobs_t jobs;
+    GThreadPool *pool;
+
+    /* GTS creates its classes on first use, which must not race */
+    gts_list_face_class();
+    gts_surface_class();
+    gts_constraint_class();
+    toporouter_vertex_class();
+    toporouter_edge_class();
+    toporouter_constraint_class();
+
+    jobs.r = r;
+    jobs.done = g_async_queue_new();
+    pool = g_thread_pool_new(build_cdt_job, &jobs, threads, TRUE, &error);
+    if(pool) {
+      for(i=0;i<n;i++) 
+        g_thread_pool_push(pool, &r->layers[i], NULL);
+      for(i=0;i<n;i++) 
+        g_async_queue_pop(jobs.done);
+      g_thread_pool_free(pool, FALSE, TRUE);
+      n = 0;
+    }else{
+      g_error_free(error);
+      threads = 1;
+    }
+    g_async_queue_unref(jobs.done);
+  }
+#endif
+
+  for(i=0;i<n;i++) 
+    build_cdt(r, &r->layers[i]);
+
+  gts_object_memory_stats(NULL, &peak);
+  Message(_("Triangulated layers with %u threads in %.2f seconds, "
+            "geometry peaked at %.1f MB\n"), threads,
+          g_timer_elapsed(timer, NULL), peak / 1048576.);
+  g_timer_destroy(timer);
+}
+
 void
 import_geometry(toporouter_t *r) 
 {
@@ -2774,11 +2849,14 @@ import_geometry(toporouter_t *r)
 
 
 
+      cur_layer++;
+    }
+  }
+
 #ifdef DEBUG_IMPORT    
-      printf("building CDT\n");
+  printf("building CDTs\n");
 #endif
-      build_cdt(r, cur_layer);
-  printf("finished\n");
+  build_cdts(r, cur_layer - r->layers);
 /*      {
     int i;
     for(i=0;i<groupcount();i++) {
@@ -2788,11 +2866,8 @@ import_geometry(toporouter_t *r)
     }
   }*/
 #ifdef DEBUG_IMPORT    
-      printf("finished building CDT\n");
+  printf("finished building CDTs\n");
 #endif
-      cur_layer++;
-    }
-  }
   
   r->bboxtree = gts_bb_tree_new(r->bboxes);
  
@@ -7786,8 +7861,21 @@ escape (int argc, char **argv, Coord x, Coord y)
       PinType *via;
       LineType *line;
 
-      PadType *pad0 = element->Pad->data;
-      PadType *pad1 = g_list_next (element->Pad)->data;
+      PadType *pad0 = NULL, *pad1 = NULL;
+
+      /* the pitch comes from the first two pads; skip loners */
+      OBJECT_LIST_LOOP (element->Pad, PadType, epad);
+      {
+        if (!pad0)
+          pad0 = epad;
+        else {
+          pad1 = epad;
+          break;
+        }
+      }
+      END_LOOP;
+      if (!pad1)
+        continue;
 
       pitch = hypot (pad0->Point1.X - pad1->Point1.X, pad0->Point1.Y - pad1->Point1.Y);
 
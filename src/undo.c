@@ -62,6 +62,7 @@
 #include "buffer.h"
 #include "change.h"
 #include "create.h"
+#include "crosshair.h"
 #include "data.h"
 #include "draw.h"
 #include "error.h"
@@ -1129,6 +1130,7 @@ Undo (bool draw)
     }
 
   UnlockUndo ();
+  crosshair_outlines_changed ();
 
   if (error_undoing)
     Message (_("ERROR: Failed to undo some operations\n"));
@@ -1310,6 +1312,7 @@ Redo (bool draw)
   Serial++;
 
   UnlockUndo ();
+  crosshair_outlines_changed ();
 
   if (error_undoing)
     Message (_("ERROR: Failed to redo some operations\n"));
@@ -1370,6 +1373,8 @@ IncrementUndoSerialNumber (void)
       Serial++;
       Bumped = true;
       between_increment_and_restore = true;
+      /* an element being moved may have been edited in place */
+      crosshair_outlines_changed ();
       return Serial;
     }
   return -1;
@@ -1440,6 +1445,67 @@ ClearUndoList (bool Force)
   Serial = 1;
 }
 
+/*!
+ * \brief The undo history of one board, set aside by DetachUndoList ().
+ */
+struct undo_state
+{
+  DataType *RemoveList;
+  UndoListType *UndoList;
+  int Serial;
+  int SavedSerial;
+  size_t UndoN;
+  size_t RedoN;
+  size_t UndoMax;
+};
+
+/*!
+ * \brief Takes the undo history away, leaving an empty one.
+ *
+ * For callers switching between boards, which each keep their own
+ * history.  Hand the result back with AttachUndoList ().
+ */
+UndoStateType *
+DetachUndoList (void)
+{
+  UndoStateType *state = (UndoStateType *) malloc (sizeof (UndoStateType));
+
+  state->RemoveList = RemoveList;
+  state->UndoList = UndoList;
+  state->Serial = Serial;
+  state->SavedSerial = SavedSerial;
+  state->UndoN = UndoN;
+  state->RedoN = RedoN;
+  state->UndoMax = UndoMax;
+  RemoveList = NULL;
+  UndoList = NULL;
+  UndoN = UndoMax = RedoN = 0;
+  Serial = 1;
+  return state;
+}
+
+/*!
+ * \brief Replaces the undo history with one from DetachUndoList ().
+ *
+ * The current history is released; state is consumed.  NULL gives an
+ * empty history.
+ */
+void
+AttachUndoList (UndoStateType *state)
+{
+  ClearUndoList (true);
+  if (state == NULL)
+    return;
+  RemoveList = state->RemoveList;
+  UndoList = state->UndoList;
+  Serial = state->Serial;
+  SavedSerial = state->SavedSerial;
+  UndoN = state->UndoN;
+  RedoN = state->RedoN;
+  UndoMax = state->UndoMax;
+  free (state);
+}
+
 /*!
  * \brief Adds an object to the list of clearpoly objects.
  */
@@ -37,6 +37,8 @@
 
 #include "global.h"
 
+typedef struct undo_state UndoStateType;
+
 #define DRAW_FLAGS  (RATFLAG | SELECTEDFLAG | SQUAREFLAG |    \
                      HIDENAMEFLAG | HOLEFLAG | OCTAGONFLAG |  \
                      CONNECTEDFLAG | FOUNDFLAG | CLEARLINEFLAG)
@@ -50,6 +52,8 @@ int SaveUndoSerialNumber (void);
 int RestoreUndoSerialNumber (void);
 int MergeUndoSerialRange (int, int);
 void ClearUndoList (bool);
+UndoStateType *DetachUndoList (void);
+void AttachUndoList (UndoStateType *);
 void MoveObjectToRemoveUndoList (int, void *, void *, void *);
 void AddObjectToRemovePointUndoList (int, void *, void *, Cardinal);
 void AddObjectToInsertPointUndoList (int, void *, void *, void *);
@@ -0,0 +1,176 @@
+#!/bin/sh
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of version 2 of the GNU General Public License as
+#  published by the Free Software Foundation
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+#  MA 02110-1301 USA.
+
+usage() {
+cat <<EOF
+
+$0 -- Run the pcb benchmark suite
+
+$0 -h|--help
+$0 [-o | --output file] [board1 [board2[ ...]]]
+
+OVERVIEW
+
+Each benchmark board is generated by tools/genboard.py, loaded by pcb
+and put through inputs/bench.script (save, DRC, connection lookup,
+rats nest and an autoroute of a small region), then through every
+exporter and the offscreen render benchmark.  pcb times all of this
+with its performance counters, see --perf-json.
+
+The counters of every run are collected into one JSON file for trend
+tracking:
+
+  {"boards": [{"board": "small", "generator": "--layers 2 ...",
+               "runs": [{"run": "core", "status": 0,
+                         "perf": {"stats": [...]}}, ...]}, ...]}
+
+A run that failed has a non-zero status and a null "perf".
+
+OPTIONS
+
+-o | --output <file>   :  Write the results to <file> instead of
+                          outputs/bench.json.
+
+BOARDS
+
+The boards are named in the list below.  Without names, these are
+run: ${DEFAULT_BOARDS}.  The large board takes far longer than the
+others to load, mostly in polygon clipping, so it only runs when it
+is named.
+
+EOF
+sed -n 's/^\([a-z]*\)|\(.*\)$/  \1: \2/p' << EOF
+${BOARDS}
+EOF
+cat <<EOF
+
+ENVIRONMENT
+
+PCB               the pcb to run, ../../../src/pcbtest.sh by default
+PYTHON            python interpreter, python3 by default
+BENCH_EXPORTERS   exporters to time, "${BENCH_EXPORTERS}"
+                  by default; those not built into pcb just fail
+
+EOF
+}
+
+# name|genboard.py arguments
+BOARDS="small|--layers 2 --elements 50 --via-density 10 --pours 2 --nets 40
+medium|--layers 4 --elements 400 --via-density 20 --pours 4 --nets 300
+large|--layers 8 --elements 2000 --via-density 30 --pours 8 --nets 1500"
+DEFAULT_BOARDS="small medium"
+
+srcdir=${srcdir:-.}
+PCB=${PCB:-../../../src/pcbtest.sh}
+PYTHON=${PYTHON:-python3}
+BENCH_EXPORTERS=${BENCH_EXPORTERS:-bom gcode gerber gsvit IPC-D-356 nelma png ps eps}
+
+INDIR=${srcdir}/inputs
+OUTDIR=outputs
+results=${OUTDIR}/bench.json
+
+while test $# -ne 0 ; do
+	case $1 in
+		-h|--help)
+			usage
+			exit 0
+			;;
+		-o|--output)
+			results="$2"
+			shift 2
+			;;
+		-*)
+			echo "unknown option: $1"
+			exit 1
+			;;
+		*)
+			break
+			;;
+	esac
+done
+
+all_boards="$*"
+if test "X${all_boards}" = "X" ; then
+	all_boards=${DEFAULT_BOARDS}
+fi
+
+# absolute paths, as pcb runs in the board's directory
+case ${srcdir} in
+	/*) abs_srcdir=${srcdir} ;;
+	*) abs_srcdir=`pwd`/${srcdir} ;;
+esac
+
+mkdir -p ${OUTDIR}
+tmp=${OUTDIR}/bench.json.tmp
+
+# add the perf-json file $1 of run $2 with exit status $3 to the results
+add_run() {
+	test ${first_run} = yes || echo "," >> ${tmp}
+	first_run=no
+	printf '    {"run": "%s", "status": %d, "perf": ' "$2" $3 >> ${tmp}
+	if test $3 -eq 0 -a -s "$1" ; then
+		cat "$1" >> ${tmp}
+	else
+		echo "null" >> ${tmp}
+	fi
+	printf '    }' >> ${tmp}
+}
+
+echo '{"boards": [' > ${tmp}
+first_board=yes
+for b in ${all_boards} ; do
+	args=`echo "${BOARDS}" | sed -n "s/^${b}|//p"`
+	if test "X${args}" = "X" ; then
+		echo "unknown board ${b}"
+		exit 1
+	fi
+
+	rundir=${OUTDIR}/bench-${b}
+	rm -rf ${rundir}
+	mkdir -p ${rundir}
+	echo "Generating ${b}: ${args}"
+	${PYTHON} ${abs_srcdir}/tools/genboard.py ${args} -o ${rundir}/${b}.pcb \
+		|| exit 1
+	cp ${INDIR}/bench.script ${rundir}
+
+	test ${first_board} = yes || echo "," >> ${tmp}
+	first_board=no
+	printf '{"board": "%s", "generator": "%s", "runs": [\n' \
+		"${b}" "${args}" >> ${tmp}
+	first_run=yes
+
+	echo "  core passes"
+	(cd ${rundir} && ${PCB} --perf-json core.json \
+		--action-script bench.script ${b}.pcb > core.log 2>&1)
+	add_run ${rundir}/core.json core $?
+
+	for e in ${BENCH_EXPORTERS} ; do
+		echo "  export ${e}"
+		(cd ${rundir} && ${PCB} -x ${e} --perf-json export-${e}.json \
+			${b}.pcb > export-${e}.log 2>&1)
+		add_run ${rundir}/export-${e}.json "export ${e}" $?
+	done
+
+	echo "  offscreen render"
+	(cd ${rundir} && ${PCB} -x bench --benchfile render.txt \
+		--perf-json render.json ${b}.pcb > render.log 2>&1)
+	add_run ${rundir}/render.json render $?
+
+	printf '\n]}' >> ${tmp}
+done
+echo ']}' >> ${tmp}
+mv ${tmp} ${results}
+echo "Results in ${results}"
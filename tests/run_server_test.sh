@@ -0,0 +1,157 @@
+#!/bin/sh
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of version 2 of the GNU General Public License as
+#  published by the Free Software Foundation
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+#  MA 02110-1301 USA.
+#
+# Test the batch HID's --server mode.  A client pipelines requests for
+# two contexts over one connection and checks that every reply is valid
+# JSON, that the replies come back in order and that each context kept
+# its own board.  An edit must still be undoable after another context
+# was used in between.  A second client then sends Quit; the server has to
+# answer it, exit cleanly and remove its socket.  Last, a --server path
+# that isn't a socket must be left alone.
+#
+# Exits 77, "skipped" to automake, without python or when pcb's GUI
+# isn't the batch HID.
+
+srcdir=${srcdir:-.}
+PCB=${PCB:-../src/pcbtest.sh}
+PYTHON=${PYTHON:-python3}
+
+if ! ${PYTHON} -c 'import json, socket' > /dev/null 2>&1 ; then
+	echo "$0: no ${PYTHON}, skipping"
+	exit 77
+fi
+
+# the first GUI listed is the one pcb runs
+gui=`${PCB} --help 2>&1 | sed -n '/^Available GUI hid/{n;s/^[ 	]*\([^ 	]*\).*/\1/p;q;}'`
+if test "X${gui}" != "Xbatch" ; then
+	echo "$0: pcb's GUI is ${gui:-unknown}, not batch, skipping"
+	exit 77
+fi
+
+case ${srcdir} in
+	/*) abs_srcdir=${srcdir} ;;
+	*) abs_srcdir=`pwd`/${srcdir} ;;
+esac
+
+rundir=outputs/server
+rm -rf ${rundir}
+mkdir -p ${rundir}
+sock=${rundir}/pcb.sock
+
+${PCB} --server ${sock} > ${rundir}/server.log 2>&1 &
+server=$!
+
+${PYTHON} - ${sock} ${abs_srcdir}/inputs <<'EOF'
+import json, os, socket, sys, time
+
+path, inputs = sys.argv[1:]
+
+def connect():
+    for i in range(100):
+        try:
+            s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            s.connect(path)
+            return s
+        except OSError:
+            s.close()
+            time.sleep(0.1)
+    sys.exit("no server on %s" % path)
+
+def replies(s, n):
+    data = b""
+    while data.count(b"\n") < n:
+        chunk = s.recv(4096)
+        if not chunk:
+            break
+        data += chunk
+    # strict UTF-8, as a JSON reader would insist on
+    return [json.loads(line.decode("utf-8"))
+            for line in data.splitlines()]
+
+requests = [
+    ("one", "LoadFrom(Layout,%s/circles.pcb)" % inputs),
+    ("two", "LoadFrom(Layout,%s/clearance.pcb)" % inputs),
+    ("one", "Info()"),
+    ("two", "Info()"),
+    ("one", "Info()"),
+]
+s = connect()
+s.sendall(b"".join(("%s %s\n" % r).encode() for r in requests))
+got = replies(s, len(requests))
+s.close()
+if len(got) != len(requests):
+    sys.exit("%d replies to %d requests" % (len(got), len(requests)))
+for i, (r, g) in enumerate(zip(requests, got)):
+    if g["id"] != i + 1 or g["context"] != r[0] or g["status"] != 0:
+        sys.exit("request %d %s: bad reply %r" % (i + 1, r, g))
+for i, board in ((2, "circles.pcb"), (3, "clearance.pcb"),
+                 (4, "circles.pcb")):
+    if board not in got[i]["output"]:
+        sys.exit("request %d: %s is not loaded: %r"
+                 % (i + 1, board, got[i]["output"]))
+
+requests = [
+    ("three", "LoadFrom(Layout,%s/clearance.pcb)" % inputs),
+    ("three", "Select(All); ChangeSize(SelectedVias,+1mil)"),
+    ("four", "LoadFrom(Layout,%s/circles.pcb)" % inputs),
+    ("three", "Undo()"),
+]
+s = connect()
+s.sendall(b"".join(("%s %s\n" % r).encode() for r in requests))
+got = replies(s, len(requests))
+s.close()
+if len(got) != len(requests) or any(g["status"] != 0 for g in got):
+    sys.exit("bad replies to the undo requests: %r" % got)
+if "Nothing to undo" in got[3]["output"]:
+    sys.exit("switching contexts lost the undo history: %r" % got[3])
+
+s = connect()
+s.sendall(b"default Quit()\n")
+got = replies(s, 1)
+if len(got) != 1 or got[0]["id"] != 1 or got[0]["status"] != 0:
+    sys.exit("bad reply to Quit: %r" % got)
+if s.recv(1):
+    sys.exit("more than one reply to Quit")
+EOF
+rc=$?
+
+if test $rc -ne 0 ; then
+	kill ${server} 2> /dev/null
+	wait ${server}
+	echo "FAIL: server replies"
+	exit 1
+fi
+wait ${server}
+rc=$?
+if test $rc -ne 0 ; then
+	echo "FAIL: server exited with ${rc}"
+	exit 1
+fi
+if test -e ${sock} ; then
+	echo "FAIL: ${sock} was left behind"
+	exit 1
+fi
+
+echo "keep me" > ${sock}
+${PCB} --server ${sock} > ${rundir}/refuse.log 2>&1
+if test "`cat ${sock}`" != "keep me" \
+	|| ! grep "is not a socket" ${rundir}/refuse.log > /dev/null ; then
+	echo "FAIL: --server replaced a file that isn't a socket"
+	exit 1
+fi
+
+echo "PASS: server"
+exit 0
@@ -0,0 +1,358 @@
+#!/usr/bin/env python3
+#
+# genboard.py -- write a synthetic board for the benchmark suite
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of version 2 of the GNU General Public License as
+#  published by the Free Software Foundation
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+#  MA 02110-1301 USA.
+#
+# The board is a grid of DIP8 and SO8 parts with outlines on the silk,
+# a netlist that mostly joins nearby pins, and about half of the nets
+# routed, stitching vias and clearing polygon pours.  The same
+# parameters and seed always give the same file with a given version of
+# Python.
+#
+# Every part sits in a square footprint cell, and the cells are
+# separated by channels.  A routed connection leaves each pin on the
+# top layer (the SO8 pads are top only) for a track in the channel
+# beside the part, runs along that vertical channel on an odd layer to
+# a horizontal channel, and along the horizontal channel on an even
+# layer, with a via wherever it changes layer.  Tracks are handed out
+# so that no two nets ever overlap on a track, and a connection that
+# finds no free track is left to the rats nest.  The stitching vias sit
+# on the center lines of the channels, which no track comes near.
+#
+# A handful of nets named R01, R02, ... join the parts in the top left
+# corner and are left unrouted, for timing the autorouter on a small
+# region with Select(NetByName, R.*) and AutoRoute(SelectedRats).  No
+# trace, via or pour comes near that region.
+
+import argparse
+import math
+import os
+import random
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import pcb
+
+FOOT = (-40, 340)   # mil, footprint cell of a part around its origin
+CHANNEL = 400       # mil between two footprint cells
+CELL = FOOT[1] - FOOT[0] + CHANNEL
+TRACKS = (50, 100, 150)   # offsets of the tracks from either channel edge
+LANE = CHANNEL // 2       # center line of a channel, for stitching vias
+KEEP = 40           # mil between the ends of different nets on a track
+VIA = dict(th=36, cl=20, mask=42, drill=15)   # meets the board's DRC rules
+REGION_PARTS = 4    # parts in the autoroute region
+REGION_NETS = 6
+
+
+def dip8(e):
+  for i in range(4):
+    e.objects.append(pcb.pcb_pin(0, i * 100, str(i + 1),
+                                 fl=["square"] if i == 0 else []))
+    e.objects.append(pcb.pcb_pin(300, 300 - i * 100, str(i + 5)))
+  box = [(-50, -50), (350, -50), (350, 350), (-50, 350)]
+  for i in range(4):
+    (x1, y1), (x2, y2) = box[i], box[(i + 1) % 4]
+    e.objects.append(pcb.pcb_element_line(x1, y1, x2, y2, 10))
+  return [(str(i + 1), 0, i * 100, -1) for i in range(4)] + \
+         [(str(i + 5), 300, 300 - i * 100, 1) for i in range(4)]
+
+
+def so8(e):
+  for i in range(4):
+    e.objects.append(pcb.pcb_pad(-25, i * 50, 25, i * 50, str(i + 1), th=24))
+    e.objects.append(pcb.pcb_pad(215, 150 - i * 50, 265, 150 - i * 50,
+                                 str(i + 5), th=24))
+  box = [(20, -40), (220, -40), (220, 190), (20, 190)]
+  for i in range(4):
+    (x1, y1), (x2, y2) = box[i], box[(i + 1) % 4]
+    e.objects.append(pcb.pcb_element_line(x1, y1, x2, y2, 8))
+  return [(str(i + 1), 0, i * 50, -1) for i in range(4)] + \
+         [(str(i + 5), 240, 150 - i * 50, 1) for i in range(4)]
+
+
+class channels(object):
+  """Tracks of the channels, and which stretches of them are taken.
+
+  Vertical channel c runs left of part column c, horizontal channel h
+  above part row h.  Either half of a channel has its own tracks; in a
+  vertical channel the left half serves the right side pins of the
+  parts on its left and the right half the left side pins of the parts
+  on its right.
+  """
+
+  def __init__(self):
+    self.taken = {}
+
+  def track(self, offset, half, k):
+    """Coordinate of track k of a half of the channel at offset."""
+    if half < 0:
+      return offset + TRACKS[k]
+    return offset + CHANNEL - TRACKS[k]
+
+  def fits(self, key, a, b, net):
+    a, b = min(a, b) - KEEP, max(a, b) + KEEP
+    for c, d, n in self.taken.get(key, []):
+      if n != net and a < d and c < b:
+        return False
+    return True
+
+  def take(self, key, a, b, net):
+    self.taken.setdefault(key, []).append((min(a, b), max(a, b), net))
+
+
+def in_box(box, x1, y1, x2, y2):
+  return min(x1, x2) < box[2] and box[0] < max(x1, x2) and \
+         min(y1, y2) < box[3] and box[1] < max(y1, y2)
+
+
+def route(ch, a, b, net, region):
+  """Plan the connection of terminal a to terminal b of a net.
+
+  Returns the legs as (x1, y1, x2, y2, kind) with kind one of "pin",
+  "v" and "h", and the via positions, or None when there are no free
+  tracks for it.  The tracks are only taken when a plan is found.
+  """
+  (ca, ra, xa, ya, sa), (cb, rb, xb, yb, sb) = a[2:], b[2:]
+  if ra > rb:
+    (ca, ra, xa, ya, sa), (cb, rb, xb, yb, sb) = \
+        (cb, rb, xb, yb, sb), (ca, ra, xa, ya, sa)
+  # the horizontal channel below the upper part when the rows differ,
+  # else the one nearest to the first pin
+  if ra != rb or ya - (CHANNEL + ra * CELL) > (FOOT[1] - FOOT[0]) // 2:
+    h = ra + 1
+  else:
+    h = ra
+
+  for hk in range(2 * len(TRACKS)):
+    hkey = ("h", h, hk)
+    yh = ch.track(h * CELL, -1 if hk % 2 == 0 else 1, hk // 2)
+    ends = []
+    for c, x, y, side in ((ca, xa, ya, sa), (cb, xb, yb, sb)):
+      # the vertical channel beside the pin, and the half of it facing
+      # the part
+      v = c + (1 if side > 0 else 0)
+      half = -side
+      for k in range(len(TRACKS)):
+        if ch.fits(("v", v, half, k), y, yh, net):
+          ends.append((("v", v, half, k), ch.track(v * CELL, half, k), x, y))
+          break
+    if len(ends) == 2 and ch.fits(hkey, ends[0][1], ends[1][1], net):
+      break
+  else:
+    return None
+
+  legs, vias = [], []
+  for key, xt, x, y in ends:
+    legs.append((x, y, xt, y, "pin"))
+    legs.append((xt, y, xt, yh, "v"))
+    vias.append((xt, y))
+    vias.append((xt, yh))
+  legs.append((ends[0][1], yh, ends[1][1], yh, "h"))
+  for x1, y1, x2, y2, kind in legs:
+    if in_box(region, x1 - KEEP, y1 - KEEP, x2 + KEEP, y2 + KEEP):
+      return None
+
+  for key, xt, x, y in ends:
+    ch.take(key, y, yh, net)
+  ch.take(hkey, ends[0][1], ends[1][1], net)
+  return legs, vias
+
+
+def generate(args):
+  rnd = random.Random(args.seed)
+
+  cols = max(1, int(math.ceil(math.sqrt(args.elements))))
+  rows = max(1, int(math.ceil(float(args.elements) / cols)))
+  width = cols * CELL + CHANNEL
+  height = rows * CELL + CHANNEL
+
+  board = pcb.pcb_pcb(width, height, "benchmark board")
+  board.grid = "Grid[25.00mil 0.0000 0.0000 1]"
+  groups = ["1,c"] + [str(i) for i in range(2, args.layers)] + \
+           ["{},s".format(args.layers)]
+  board.groups = 'Groups("{}")'.format(":".join(groups))
+
+  copper = []
+  for i in range(args.layers):
+    if i == 0:
+      name = "top"
+    elif i == args.layers - 1:
+      name = "bottom"
+    else:
+      name = "inner{}".format(i)
+    copper.append(board.add_layer(name=name, ltype="copper"))
+  board.add_layer(name="top silk", ltype="silk")
+  board.add_layer(name="bottom silk", ltype="silk")
+
+  # parts, row by row, each in its footprint cell; terminals remember
+  # where they ended up and which side of the part they are on
+  terminals = []
+  for n in range(args.elements):
+    col, row = n % cols, n // cols
+    x = CHANNEL + col * CELL - FOOT[0]
+    y = CHANNEL + row * CELL - FOOT[0]
+    name = "U{}".format(n + 1)
+    if rnd.random() < 0.5:
+      e = board.add_element(name, x, y, "DIP8")
+      pins = dip8(e)
+    else:
+      e = board.add_element(name, x, y, "SO8")
+      pins = so8(e)
+    for number, dx, dy, side in pins:
+      terminals.append((n, "{}-{}".format(name, number), col, row,
+                        x + dx, y + dy, side))
+
+  # the parts of the autoroute region with the channels around them
+  last = min(REGION_PARTS, args.elements) - 1
+  region = (0, 0, (last % cols + 1) * CELL + CHANNEL,
+            (last // cols + 1) * CELL + CHANNEL)
+
+  # unrouted nets among the parts of the autoroute region
+  region_terms = [t for t in terminals if t[0] < REGION_PARTS]
+  rest = [t for t in terminals if t[0] >= REGION_PARTS]
+  rnd.shuffle(region_terms)
+  for i in range(min(REGION_NETS, len(region_terms) // 2)):
+    net = board.add_net("R{:02d}".format(i + 1))
+    net.connections = [region_terms[2 * i][1], region_terms[2 * i + 1][1]]
+
+  # the other nets join pins within a window of nearby parts
+  window = 64
+  pool = []
+  for i in range(0, len(rest), window):
+    chunk = rest[i:i + window]
+    rnd.shuffle(chunk)
+    pool.extend(chunk)
+
+  nets = min(args.nets, len(pool) // 2)
+  sizes = [2] * nets
+  for i in range(max(0, min(len(pool), 3 * nets) - 2 * nets)):
+    sizes[rnd.randrange(nets)] += 1
+
+  ch = channels()
+  pairs = max(1, args.layers // 2)
+  placed_vias = set()
+  at = 0
+  for i in range(nets):
+    members = pool[at:at + sizes[i]]
+    at += sizes[i]
+    net = board.add_net("N{:05d}".format(i + 1))
+    net.connections = [t[1] for t in members]
+
+    if rnd.random() >= 0.5:
+      continue
+    # horizontal legs on an even layer, vertical ones on the odd layer
+    # above it; pins always leave on the top layer
+    hlayer = copper[2 * (i % pairs)]
+    vlayer = copper[min(2 * (i % pairs) + 1, args.layers - 1)]
+    for a, b in zip(members, members[1:]):
+      plan = route(ch, a, b, i, region)
+      if plan is None:
+        continue
+      legs, vias = plan
+      for x1, y1, x2, y2, kind in legs:
+        if (x1, y1) == (x2, y2):
+          continue
+        layer = {"pin": copper[0], "v": vlayer, "h": hlayer}[kind]
+        layer.objects.append(pcb.pcb_line(x1, y1, x2, y2, 10, 20))
+      for v in vias:
+        if v not in placed_vias:
+          placed_vias.add(v)
+          board.vias.append(pcb.pcb_via(v[0], v[1], **VIA))
+
+  # stitching vias on the center lines of the channels: the vertical
+  # ones beside the parts, the horizontal ones between them, and where
+  # two center lines cross
+  spots = set()
+  for c in range(cols + 1):
+    for r in range(rows + 1):
+      spots.add((c * CELL + LANE, r * CELL + LANE))
+  for c in range(cols + 1):
+    for r in range(rows):
+      for y in range(CHANNEL, CELL, 50):
+        spots.add((c * CELL + LANE, r * CELL + y))
+  for r in range(rows + 1):
+    for c in range(cols):
+      for x in range(CHANNEL, CELL, 50):
+        spots.add((c * CELL + x, r * CELL + LANE))
+  spots = sorted(s for s in spots
+                 if not in_box(region, s[0] - KEEP, s[1] - KEEP,
+                               s[0] + KEEP, s[1] + KEEP))
+  count = min(len(spots), int(args.via_density * width * height / 1e6))
+  for x, y in rnd.sample(spots, count):
+    board.vias.append(pcb.pcb_via(x, y, **VIA))
+
+  # clearing pours, each over a large part of the board but outside the
+  # autoroute region
+  for i in range(args.pours):
+    dx = int(width * rnd.uniform(0.3, 0.6))
+    dy = int(height * rnd.uniform(0.3, 0.6))
+    x = rnd.randrange(width - dx)
+    y = rnd.randrange(height - dy)
+    if in_box(region, x, y, x + dx, y + dy):
+      if rnd.random() < 0.5:
+        x = region[2] + rnd.randrange(max(1, width - dx - region[2]))
+        dx = min(dx, width - x)
+      else:
+        y = region[3] + rnd.randrange(max(1, height - dy - region[3]))
+        dy = min(dy, height - y)
+    if dx <= 0 or dy <= 0:
+      continue
+    poly = pcb.pcb_polygon()
+    poly.rect(x, y, dx, dy)
+    copper[i % args.layers].objects.append(poly)
+
+  return board
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description="Write a synthetic board for the benchmark suite.")
+  parser.add_argument("--layers", type=int, default=4,
+                      help="copper layers, 2 to 16 (default 4)")
+  parser.add_argument("--elements", type=int, default=200,
+                      help="number of parts (default 200)")
+  parser.add_argument("--via-density", type=float, default=20,
+                      help="stitching vias per square inch (default 20)")
+  parser.add_argument("--pours", type=int, default=4,
+                      help="number of polygon pours (default 4)")
+  parser.add_argument("--nets", type=int, default=150,
+                      help="number of nets (default 150)")
+  parser.add_argument("--seed", type=int, default=1,
+                      help="random seed (default 1)")
+  parser.add_argument("-o", "--output", default="-",
+                      help="output file (default standard output)")
+  args = parser.parse_args()
+
+  if args.layers < 2 or args.layers > 16:
+    parser.error("--layers must be between 2 and 16")
+  if args.elements < 1 or args.nets < 0 or args.pours < 0 \
+        or args.via_density < 0:
+    parser.error("counts must not be negative")
+
+  board = generate(args)
+  text = "# genboard.py --layers {} --elements {} --via-density {} " \
+         "--pours {} --nets {} --seed {}\n".format(
+             args.layers, args.elements, args.via_density, args.pours,
+             args.nets, args.seed) + str(board)
+  if args.output == "-":
+    sys.stdout.write(text)
+  else:
+    with open(args.output, "w") as f:
+      f.write(text)
+
+
+if __name__ == "__main__":
+  main()
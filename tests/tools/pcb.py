@@ -14,14 +14,30 @@ class pcb_pcb(object):
     self.groups = 'Groups("1,c:2:3:4:5:6,s:7:8")'
     self.styles = 'Styles["Signal,10.00mil,30.00mil,10.00mil,1.00mil:Power,25.00mil,60.00mil,35.00mil,10.00mil:Fat,40.00mil,60.00mil,35.00mil,10.00mil:Skinny,6.00mil,24.02mil,11.81mil,6.00mil"]'
  
+    self.vias = []
+    self.elements = []
     self.layers = []
+    self.nets = []
 
 
   def __str__(self):
     s = "" + self.header() + "\n"
+    for v in self.vias:
+      s += str(v)
+
+    for e in self.elements:
+      s += str(e)
+
     for l in self.layers:
       s += str(l)
 
+    if self.nets:
+      s += "NetList()\n(\n"
+      for n in self.nets:
+        s += str(n)
+
+      s += ")\n"
+
     return s
 
 
@@ -41,6 +57,16 @@ class pcb_pcb(object):
     return self.layers[-1]
 
 
+  def add_element(self, name, x, y, desc=""):
+    self.elements.append(pcb_element(name, x, y, desc))
+    return self.elements[-1]
+
+
+  def add_net(self, name, style="Signal"):
+    self.nets.append(pcb_net(name, style))
+    return self.nets[-1]
+
+
 class pcb_line(object):
   def __init__(self, x1=0, y1=0, x2=None, y2=None, th=10, cl=2, fl=None):
     self.units = "mil"
@@ -201,3 +227,128 @@ class pcb_text(object):
     return s
 
 
+
+
+class pcb_via(object):
+  def __init__(self, x=0, y=0, th=30, cl=10, mask=36, drill=15, fl=None):
+    self.units = "mil"
+    self.x = x
+    self.y = y
+    self.thickness = th
+    self.clearance = cl
+    self.mask = mask
+    self.drill = drill
+    self.flags = [] if fl is None else fl
+
+
+  def __str__(self):
+    s = "Via["
+    for val in [self.x, self.y, self.thickness, self.clearance,
+                self.mask, self.drill]:
+      s += "{}{} ".format(val, self.units)
+
+    s += '"" "' + ",".join(self.flags) + '"'
+    s += "]\n"
+    return s
+
+
+class pcb_pin(object):
+  def __init__(self, x=0, y=0, number="1", th=60, cl=20, mask=66, drill=30,
+               fl=None):
+    self.units = "mil"
+    self.x = x
+    self.y = y
+    self.number = number
+    self.thickness = th
+    self.clearance = cl
+    self.mask = mask
+    self.drill = drill
+    self.flags = [] if fl is None else fl
+
+
+  def __str__(self):
+    s = "  Pin["
+    for val in [self.x, self.y, self.thickness, self.clearance,
+                self.mask, self.drill]:
+      s += "{}{} ".format(val, self.units)
+
+    s += '"{}" "{}" "{}"'.format(self.number, self.number,
+                                 ",".join(self.flags))
+    s += "]\n"
+    return s
+
+
+class pcb_pad(object):
+  def __init__(self, x1=0, y1=0, x2=None, y2=None, number="1", th=20, cl=10,
+               mask=26, fl=None):
+    self.units = "mil"
+    self.x1 = x1
+    self.y1 = y1
+    self.x2 = x1 if x2 is None else x2
+    self.y2 = y1 if y2 is None else y2
+    self.number = number
+    self.thickness = th
+    self.clearance = cl
+    self.mask = mask
+    self.flags = ["square"] if fl is None else fl
+
+
+  def __str__(self):
+    s = "  Pad["
+    for val in [self.x1, self.y1, self.x2, self.y2,
+                self.thickness, self.clearance, self.mask]:
+      s += "{}{} ".format(val, self.units)
+
+    s += '"{}" "{}" "{}"'.format(self.number, self.number,
+                                 ",".join(self.flags))
+    s += "]\n"
+    return s
+
+
+class pcb_element_line(pcb_line):
+  def __str__(self):
+    s = "  ElementLine["
+    for val in [self.x1, self.y1, self.x2, self.y2, self.thickness]:
+      s += "{}{} ".format(val, self.units)
+
+    s += "]\n"
+    return s
+
+
+class pcb_element(object):
+  def __init__(self, name, x=0, y=0, desc=""):
+    self.units = "mil"
+    self.name = name
+    self.desc = desc
+    self.x = x
+    self.y = y
+    self.flags = []
+
+    self.objects = []
+
+
+  def __str__(self):
+    s = 'Element["{}" "{}" "{}" "" {}{} {}{} 0{} -50{} 0 100 ""]\n(\n'.format(
+            ",".join(self.flags), self.desc, self.name,
+            self.x, self.units, self.y, self.units, self.units, self.units)
+    for o in self.objects:
+      s += str(o)
+
+    s += ")\n"
+    return s
+
+
+class pcb_net(object):
+  def __init__(self, name, style="Signal"):
+    self.name = name
+    self.style = style
+    self.connections = []
+
+
+  def __str__(self):
+    s = '  Net("{}" "{}")\n  (\n'.format(self.name, self.style)
+    for c in self.connections:
+      s += '    Connect("{}")\n'.format(c)
+
+    s += "  )\n"
+    return s